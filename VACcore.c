@@ -0,0 +1,787 @@
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+#include "VACcore.h"
+
+#include <math.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <fcntl.h>
+#include <stdio.h>
+#endif
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Volume
+//==================================================================================================
+
+//	10^(kVolume_MinDB / 20), anything at or below it reads as kVolume_MinDB
+#define                             kVolume_MinAmplitude                6.3095734448e-4f
+
+//	20 log10(2), log2(10) / 20, and the octaves in the whole control range, (kVolume_MaxDB -
+//	kVolume_MinDB) log2(10) / 20
+#define                             kVolume_DecibelsPerOctave           6.0205999133f
+#define                             kVolume_OctavesPerDecibel           0.1660964047f
+#define                             kVolume_OctavesPerScalar            10.6301699036f
+
+//	x has to be a positive normal float. The mantissa is folded into [sqrt(1/2), sqrt(2)), where
+//	log2(m) = 2 atanh(t) / ln(2) with t = (m - 1) / (m + 1) and |t| < 0.172, so the odd series up to
+//	t^9 leaves a truncation error under 1e-9 and the result is as good as the float arithmetic.
+static inline float volume_log2(float x)
+{
+    uint32_t theBits;
+    memcpy(&theBits, &x, sizeof(theBits));
+
+    //	bias the split by half a mantissa so that it lands on sqrt(2) instead of 2
+    uint32_t theShifted = theBits + (0x3F800000 - 0x3F3504F3);
+    float theExponent = (float)((int32_t)(theShifted >> 23) - 127);
+    theBits = (theShifted & 0x007FFFFF) + 0x3F3504F3;
+
+    float theMantissa;
+    memcpy(&theMantissa, &theBits, sizeof(theMantissa));
+
+    float t = (theMantissa - 1.0f) / (theMantissa + 1.0f);
+    float t2 = t * t;
+    float theSeries = 0.3205988979f;
+    theSeries = theSeries * t2 + 0.4121985831f;
+    theSeries = theSeries * t2 + 0.5770780164f;
+    theSeries = theSeries * t2 + 0.9617966939f;
+    theSeries = theSeries * t2 + 2.8853900818f;
+    return theExponent + t * theSeries;
+}
+
+//	x is clamped to the normal range. It is split at the nearest integer, so the fraction is within
+//	half an octave and the Taylor series of 2^f up to f^7 is off by less than 5e-9 relative.
+static inline float volume_exp2(float x)
+{
+    x = (x > -126.0f) ? x : -126.0f;
+    x = (x < 127.0f) ? x : 127.0f;
+
+    //	offset so that the truncating conversion rounds to nearest
+    float theWhole = (float)((int32_t)(x + 128.5f) - 128);
+    float f = (x - theWhole) * 0.6931471806f;
+
+    float thePower = 1.0f / 5040.0f;
+    thePower = thePower * f + 1.0f / 720.0f;
+    thePower = thePower * f + 1.0f / 120.0f;
+    thePower = thePower * f + 1.0f / 24.0f;
+    thePower = thePower * f + 1.0f / 6.0f;
+    thePower = thePower * f + 0.5f;
+    thePower = thePower * f + 1.0f;
+    thePower = thePower * f + 1.0f;
+
+    uint32_t theBits = (uint32_t)((int32_t)theWhole + 127) << 23;
+    float theScale;
+    memcpy(&theScale, &theBits, sizeof(theScale));
+    return thePower * theScale;
+}
+
+static inline float volume_to_decibel_fast(float volume)
+{
+    float theDecibel = kVolume_DecibelsPerOctave * volume_log2((volume > kVolume_MinAmplitude) ? volume : 1.0f);
+    return (volume > kVolume_MinAmplitude) ? theDecibel : kVolume_MinDB;
+}
+
+static inline float volume_from_decibel_fast(float decibel)
+{
+    float theVolume = volume_exp2(decibel * kVolume_OctavesPerDecibel);
+    return (decibel > kVolume_MinDB) ? theVolume : 0.0f;
+}
+
+static inline float volume_to_scalar_fast(float volume)
+{
+    return (volume_to_decibel_fast(volume) - kVolume_MinDB) / (kVolume_MaxDB - kVolume_MinDB);
+}
+
+//	Scaled up from the bottom of the range rather than through decibels, whose rounding near
+//	kVolume_MinDB would otherwise add another 2e-7 to the relative error.
+static inline float volume_from_scalar_fast(float scalar)
+{
+    float theVolume = kVolume_MinAmplitude * volume_exp2(scalar * kVolume_OctavesPerScalar);
+    return (scalar > 0.0f) ? theVolume : 0.0f;
+}
+
+float volume_to_decibel(float volume)
+{
+    return volume_to_decibel_fast(volume);
+}
+
+float volume_from_decibel(float decibel)
+{
+    return volume_from_decibel_fast(decibel);
+}
+
+float volume_to_scalar(float volume)
+{
+    return volume_to_scalar_fast(volume);
+}
+
+float volume_from_scalar(float scalar)
+{
+    return volume_from_scalar_fast(scalar);
+}
+
+void volume_to_decibel_batch(float* out, const float* in, uint32_t count)
+{
+    for(uint32_t i = 0; i < count; i++)
+    {
+        out[i] = volume_to_decibel_fast(in[i]);
+    }
+}
+
+void volume_from_decibel_batch(float* out, const float* in, uint32_t count)
+{
+    for(uint32_t i = 0; i < count; i++)
+    {
+        out[i] = volume_from_decibel_fast(in[i]);
+    }
+}
+
+void volume_to_scalar_batch(float* out, const float* in, uint32_t count)
+{
+    for(uint32_t i = 0; i < count; i++)
+    {
+        out[i] = volume_to_scalar_fast(in[i]);
+    }
+}
+
+void volume_from_scalar_batch(float* out, const float* in, uint32_t count)
+{
+    for(uint32_t i = 0; i < count; i++)
+    {
+        out[i] = volume_from_scalar_fast(in[i]);
+    }
+}
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Clock
+//==================================================================================================
+
+static uint64_t greatest_common_divisor(uint64_t a, uint64_t b)
+{
+    while(b != 0)
+    {
+        uint64_t theRemainder = a % b;
+        a = b;
+        b = theRemainder;
+    }
+    return a;
+}
+
+//	value * numerator / denominator rounded down, without forming value * numerator
+static uint64_t scale_exact(uint64_t value, uint64_t numerator, uint64_t denominator)
+{
+    uint64_t theWhole = numerator / denominator;
+    uint64_t theFraction = numerator % denominator;
+    return (value * theWhole) + (((value % denominator) * theFraction) / denominator) + ((value / denominator) * theFraction);
+}
+
+static void device_clock_publish(struct DeviceClock* clock, uint64_t anchor_host_time, uint64_t ticks_numerator, uint64_t ticks_denominator)
+{
+    uint32_t theSequence = atomic_load_explicit(&clock->sequence, memory_order_relaxed);
+    atomic_store_explicit(&clock->sequence, theSequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&clock->anchor_host_time, anchor_host_time, memory_order_relaxed);
+    atomic_store_explicit(&clock->ticks_numerator, ticks_numerator, memory_order_relaxed);
+    atomic_store_explicit(&clock->ticks_denominator, ticks_denominator, memory_order_relaxed);
+
+    atomic_store_explicit(&clock->sequence, theSequence + 2, memory_order_release);
+}
+
+void device_clock_set_rate(struct DeviceClock* clock, uint32_t timebase_numerator, uint32_t timebase_denominator, uint32_t sample_rate, uint64_t current_host_time)
+{
+    //	ticks per frame = (1e9 / sample_rate) ns per frame / (numerator / denominator) ns per tick
+    uint64_t theNumerator = 1000000000ull * timebase_denominator;
+    uint64_t theDenominator = (uint64_t)timebase_numerator * sample_rate;
+    uint64_t theDivisor = greatest_common_divisor(theNumerator, theDenominator);
+
+    device_clock_publish(clock, current_host_time, theNumerator / theDivisor, theDenominator / theDivisor);
+}
+
+void device_clock_reset(struct DeviceClock* clock, uint64_t current_host_time)
+{
+    device_clock_publish(clock, current_host_time, atomic_load_explicit(&clock->ticks_numerator, memory_order_relaxed), atomic_load_explicit(&clock->ticks_denominator, memory_order_relaxed));
+}
+
+uint64_t device_clock_host_ticks_for_frames(const struct DeviceClock* clock, uint64_t frames)
+{
+    return scale_exact(frames, atomic_load_explicit(&clock->ticks_numerator, memory_order_relaxed), atomic_load_explicit(&clock->ticks_denominator, memory_order_relaxed));
+}
+
+uint64_t device_clock_frames_for_host_ticks(const struct DeviceClock* clock, uint64_t host_ticks)
+{
+    return scale_exact(host_ticks, atomic_load_explicit(&clock->ticks_denominator, memory_order_relaxed), atomic_load_explicit(&clock->ticks_numerator, memory_order_relaxed));
+}
+
+//	Takes a consistent snapshot of the anchor and the ratio, retrying while a writer is mid-publication,
+//	and returns the sequence it was taken at.
+static uint32_t device_clock_load(const struct DeviceClock* clock, uint64_t* out_anchor_host_time, uint64_t* out_ticks_numerator, uint64_t* out_ticks_denominator)
+{
+    for(;;)
+    {
+        uint32_t theSequence = atomic_load_explicit(&clock->sequence, memory_order_acquire);
+        *out_anchor_host_time = atomic_load_explicit(&clock->anchor_host_time, memory_order_relaxed);
+        *out_ticks_numerator = atomic_load_explicit(&clock->ticks_numerator, memory_order_relaxed);
+        *out_ticks_denominator = atomic_load_explicit(&clock->ticks_denominator, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if(((theSequence & 1) == 0) && (atomic_load_explicit(&clock->sequence, memory_order_relaxed) == theSequence))
+        {
+            return theSequence;
+        }
+    }
+}
+
+bool device_clock_translate(const struct DeviceClock* from, const struct DeviceClock* to, int64_t sample_time, int64_t* out_sample_time)
+{
+    uint64_t theFromAnchor, theFromNumerator, theFromDenominator;
+    uint64_t theToAnchor, theToNumerator, theToDenominator;
+    device_clock_load(from, &theFromAnchor, &theFromNumerator, &theFromDenominator);
+    device_clock_load(to, &theToAnchor, &theToNumerator, &theToDenominator);
+    if((theFromNumerator != theToNumerator) || (theFromDenominator != theToDenominator))
+    {
+        return false;
+    }
+
+    //	at the same rate the two timelines only differ by the distance between their anchors
+    if(theFromAnchor >= theToAnchor)
+    {
+        *out_sample_time = sample_time + (int64_t)scale_exact(theFromAnchor - theToAnchor, theFromDenominator, theFromNumerator);
+    }
+    else
+    {
+        *out_sample_time = sample_time - (int64_t)scale_exact(theToAnchor - theFromAnchor, theFromDenominator, theFromNumerator);
+    }
+    return true;
+}
+
+void device_clock_zero_time_stamp(struct DeviceClock* clock, uint64_t current_host_time, uint32_t period, double* out_sample_time, uint64_t* out_host_time)
+{
+    uint64_t theAnchorHostTime;
+    uint64_t theTicksNumerator;
+    uint64_t theTicksDenominator;
+    uint32_t theSequence = device_clock_load(clock, &theAnchorHostTime, &theTicksNumerator, &theTicksDenominator);
+
+    //	a new publication starts a new timeline
+    if(clock->reader_sequence != theSequence)
+    {
+        clock->reader_sequence = theSequence;
+        clock->number_time_stamps = 0;
+    }
+
+    //	advance to the next period once the host clock has passed it
+    uint64_t theNextHostTime = theAnchorHostTime + scale_exact((clock->number_time_stamps + 1) * period, theTicksNumerator, theTicksDenominator);
+    if(theNextHostTime <= current_host_time)
+    {
+        ++clock->number_time_stamps;
+    }
+
+    uint64_t theSampleTime = clock->number_time_stamps * period;
+    *out_sample_time = (double)theSampleTime;
+    *out_host_time = theAnchorHostTime + scale_exact(theSampleTime, theTicksNumerator, theTicksDenominator);
+}
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Snapshot
+//==================================================================================================
+
+//	Every access here is sequentially consistent, which is what makes the grace period sound: a reader
+//	that loaded the old index counted itself before that load, and so before the writer swapped the
+//	index and before the writer's check of that count, which then waits for it. A reader that counts
+//	itself after the check loads the index after the swap and gets the new buffer.
+
+void snapshot_init(struct Snapshot* snapshot)
+{
+    atomic_store(&snapshot->current, 0);
+    atomic_store(&snapshot->epoch, 0);
+    atomic_store(&snapshot->readers[0], 0);
+    atomic_store(&snapshot->readers[1], 0);
+}
+
+uint32_t snapshot_current_index(const struct Snapshot* snapshot)
+{
+    return atomic_load_explicit(&snapshot->current, memory_order_relaxed);
+}
+
+uint32_t snapshot_write_index(const struct Snapshot* snapshot)
+{
+    return atomic_load_explicit(&snapshot->current, memory_order_relaxed) ^ 1;
+}
+
+void snapshot_publish(struct Snapshot* snapshot)
+{
+    atomic_fetch_xor(&snapshot->current, 1);
+
+    for(int theRound = 0; theRound < 2; theRound++)
+    {
+        uint32_t theEpoch = atomic_fetch_add(&snapshot->epoch, 1);
+        while(atomic_load(&snapshot->readers[theEpoch & 1]) != 0)
+        {
+            //	readers only ever hold on for the length of a copy
+            sched_yield();
+        }
+    }
+}
+
+uint32_t snapshot_read_begin(struct Snapshot* snapshot, uint32_t* out_index)
+{
+    uint32_t theTicket = atomic_load(&snapshot->epoch) & 1;
+    atomic_fetch_add(&snapshot->readers[theTicket], 1);
+    *out_index = atomic_load(&snapshot->current);
+    return theTicket;
+}
+
+void snapshot_read_end(struct Snapshot* snapshot, uint32_t ticket)
+{
+    atomic_fetch_sub(&snapshot->readers[ticket], 1);
+}
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Triple Buffer
+//==================================================================================================
+
+void triple_buffer_init(struct TripleBuffer* buffer)
+{
+    buffer->write_index = 0;
+    atomic_store(&buffer->shared, 1);
+    buffer->read_index = 2;
+}
+
+uint32_t triple_buffer_write_index(const struct TripleBuffer* buffer)
+{
+    return buffer->write_index;
+}
+
+void triple_buffer_publish(struct TripleBuffer* buffer)
+{
+    //	the release hands over what was written, the acquire takes back the buffer the reader let go of
+    uint32_t theShared = atomic_exchange_explicit(&buffer->shared, buffer->write_index | kTripleBuffer_Fresh, memory_order_acq_rel);
+    buffer->write_index = theShared & ~kTripleBuffer_Fresh;
+}
+
+uint32_t triple_buffer_read_index(struct TripleBuffer* buffer)
+{
+    if((atomic_load_explicit(&buffer->shared, memory_order_relaxed) & kTripleBuffer_Fresh) != 0)
+    {
+        uint32_t theShared = atomic_exchange_explicit(&buffer->shared, buffer->read_index, memory_order_acq_rel);
+        buffer->read_index = theShared & ~kTripleBuffer_Fresh;
+    }
+    return buffer->read_index;
+}
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Ring Buffer
+//==================================================================================================
+
+#if defined(__APPLE__)
+
+static void* mirror_map(size_t size)
+{
+    //	reserve twice the size, then remap the first half over the second
+    vm_address_t theBase = 0;
+    if(vm_allocate(mach_task_self(), &theBase, size * 2, VM_FLAGS_ANYWHERE) != KERN_SUCCESS)
+    {
+        return NULL;
+    }
+
+    vm_address_t theMirror = theBase + size;
+    vm_prot_t theCurrentProtection;
+    vm_prot_t theMaxProtection;
+    kern_return_t theError = vm_remap(mach_task_self(), &theMirror, size, 0, VM_FLAGS_FIXED | VM_FLAGS_OVERWRITE, mach_task_self(), theBase, 0, &theCurrentProtection, &theMaxProtection, VM_INHERIT_DEFAULT);
+    if((theError != KERN_SUCCESS) || (theMirror != theBase + size))
+    {
+        vm_deallocate(mach_task_self(), theBase, size * 2);
+        return NULL;
+    }
+
+    return (void*)theBase;
+}
+
+static void mirror_unmap(void* address, size_t size)
+{
+    vm_deallocate(mach_task_self(), (vm_address_t)address, size * 2);
+}
+
+#else
+
+static int mirror_open(size_t size)
+{
+#if defined(__linux__)
+    int theFile = memfd_create("VACring", MFD_CLOEXEC);
+#else
+    static _Atomic uint32_t sCounter = 0;
+    char theName[64];
+    snprintf(theName, sizeof(theName), "/VACring.%d.%u", (int)getpid(), (unsigned)atomic_fetch_add(&sCounter, 1));
+    int theFile = shm_open(theName, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if(theFile >= 0)
+    {
+        shm_unlink(theName);
+    }
+#endif
+    if((theFile >= 0) && (ftruncate(theFile, (off_t)size) != 0))
+    {
+        close(theFile);
+        theFile = -1;
+    }
+    return theFile;
+}
+
+static void* mirror_map(size_t size)
+{
+    int theFile = mirror_open(size);
+    if(theFile < 0)
+    {
+        return NULL;
+    }
+
+    //	reserve twice the size, then map the same file over both halves
+    char* theBase = mmap(NULL, size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(theBase != MAP_FAILED)
+    {
+        if((mmap(theBase, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, theFile, 0) == MAP_FAILED) ||
+           (mmap(theBase + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, theFile, 0) == MAP_FAILED))
+        {
+            munmap(theBase, size * 2);
+            theBase = MAP_FAILED;
+        }
+    }
+    close(theFile);
+
+    return (theBase != MAP_FAILED) ? theBase : NULL;
+}
+
+static void mirror_unmap(void* address, size_t size)
+{
+    munmap(address, size * 2);
+}
+
+#endif
+
+bool ring_buffer_allocate(struct RingBuffer* ring, uint32_t frame_count, uint32_t channels, bool lock)
+{
+    size_t thePageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t theFrameSize = channels * sizeof(float);
+
+    //	the mirror works in whole pages, the tags in whole blocks
+    while((((size_t)frame_count * theFrameSize) % thePageSize != 0) || (frame_count % kRingBuffer_BlockFrames != 0))
+    {
+        ++frame_count;
+    }
+
+    ring->mapped_size = (size_t)frame_count * theFrameSize;
+    ring->samples = mirror_map(ring->mapped_size);
+    ring->frame_count = frame_count;
+    ring->block_count = frame_count / kRingBuffer_BlockFrames;
+    ring->block_tags = calloc(ring->block_count, sizeof(*ring->block_tags));
+    ring->channels = channels;
+    ring->kernels = frame_kernels_for(channels);
+    atomic_init(&ring->generation, 1);
+    atomic_init(&ring->write_end, 0);
+    atomic_init(&ring->write_pending, 0);
+    atomic_init(&ring->sound_end, -(int64_t)ring->frame_count);
+
+    if((ring->samples == NULL) || (ring->block_tags == NULL))
+    {
+        ring_buffer_free(ring);
+        return false;
+    }
+
+    //	fault in both views now, each one has its own page table entries
+    memset(ring->samples, 0, ring->mapped_size * 2);
+    if(lock)
+    {
+        mlock(ring->samples, ring->mapped_size * 2);
+        mlock((void*)ring->block_tags, ring->block_count * sizeof(*ring->block_tags));
+    }
+
+    return true;
+}
+
+void ring_buffer_free(struct RingBuffer* ring)
+{
+    if(ring->samples != NULL)
+    {
+        munlock(ring->samples, ring->mapped_size * 2);
+        mirror_unmap(ring->samples, ring->mapped_size);
+    }
+    if(ring->block_tags != NULL)
+    {
+        munlock((void*)ring->block_tags, ring->block_count * sizeof(*ring->block_tags));
+        free((void*)ring->block_tags);
+    }
+    ring->samples = NULL;
+    ring->block_tags = NULL;
+}
+
+//	The generation goes in the top 16 bits, the silent flag below it and the absolute block number plus
+//	one in the rest, so a tag of zero never matches anything. 47 bits of block number last 370 years at
+//	768kHz; the 16 bits of generation wrap every 65536 resets, see ring_buffer_reset.
+#define                             kRingBuffer_SilentTag               (1ULL << 47)
+#define                             kRingBuffer_GenerationMask          0xFFFFULL
+
+static inline uint64_t ring_buffer_tag(uint64_t generation, int64_t block)
+{
+    return (generation << 48) | (((uint64_t)block + 1) & (kRingBuffer_SilentTag - 1));
+}
+
+void ring_buffer_reset(struct RingBuffer* ring)
+{
+    //	A tag only keeps the low bits of its generation, so a block last written 65536 resets ago would
+    //	match again. Every time those bits come round to zero the tags are cleared instead, which is
+    //	O(blocks) once in 65536 resets and leaves no tag that any of the next 65535 generations can match.
+    uint64_t theGeneration = atomic_fetch_add_explicit(&ring->generation, 1, memory_order_relaxed) + 1;
+    if((theGeneration & kRingBuffer_GenerationMask) == 0)
+    {
+        for(uint32_t i = 0; i < ring->block_count; ++i)
+        {
+            atomic_store_explicit(&ring->block_tags[i], 0, memory_order_relaxed);
+        }
+    }
+    //	a reader that sees the rewound cursors sees the new generation with them, and the writer's release
+    //	fence puts the bump ahead of every sample written after this, so a read the reset overlaps finds
+    //	the generation changed when it checks after its copy
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&ring->write_end, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->write_pending, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->sound_end, -(int64_t)ring->frame_count, memory_order_relaxed);
+}
+
+bool ring_buffer_is_silent(const struct RingBuffer* ring)
+{
+    int64_t theWriteEnd = atomic_load_explicit(&ring->write_end, memory_order_relaxed);
+    return atomic_load_explicit(&ring->sound_end, memory_order_relaxed) <= theWriteEnd - (int64_t)ring->frame_count;
+}
+
+//	Copies frame_count frames that sit offset frames into the transfer, so that a ramp split across
+//	several runs carries on where the previous run left it.
+static void ring_buffer_copy_gain(const struct RingBuffer* ring, float* out, const float* in, uint32_t offset, uint32_t frame_count, const struct RingGain* gain)
+{
+    uint32_t theChannels = ring->channels;
+    uint32_t theRampFrames = 0;
+    if(offset < gain->ramp_frames)
+    {
+        theRampFrames = gain->ramp_frames - offset;
+        if(theRampFrames > frame_count)
+        {
+            theRampFrames = frame_count;
+        }
+        if(gain->channel_start != NULL)
+        {
+            float theStarts[theChannels];
+            for(uint32_t theChannel = 0; theChannel < theChannels; theChannel++)
+            {
+                theStarts[theChannel] = gain->channel_start[theChannel] + (float)offset * gain->channel_step[theChannel];
+            }
+            ring->kernels.channel_gain_ramp(out, in, theRampFrames, theChannels, theStarts, gain->channel_step);
+        }
+        else
+        {
+            gKernels.gain_ramp(out, in, theRampFrames, theChannels, gain->start + (float)offset * gain->step, gain->step);
+        }
+    }
+
+    uint32_t theSteadyFrames = frame_count - theRampFrames;
+    if(theSteadyFrames == 0)
+    {
+        return;
+    }
+    out += (size_t)theRampFrames * theChannels;
+    in += (size_t)theRampFrames * theChannels;
+    if(gain->channel_target != NULL)
+    {
+        ring->kernels.channel_gain(out, in, theSteadyFrames, theChannels, gain->channel_target);
+    }
+    else if(gain->target == 0.0f)
+    {
+        gKernels.clear(out, theSteadyFrames * theChannels);
+    }
+    else
+    {
+        copy_gain_kernel_for(gain->target)(out, in, theSteadyFrames * theChannels, gain->target);
+    }
+}
+
+static void ring_buffer_copy_run(const struct RingBuffer* ring, int64_t start, int64_t end, bool is_valid, uint32_t offset, const struct RingGain* gain, float* out)
+{
+    uint32_t theFrameCount = (uint32_t)(end - start);
+    if(is_valid)
+    {
+        uint32_t theStart = (uint64_t)start % ring->frame_count;
+        ring_buffer_copy_gain(ring, out, ring->samples + (size_t)theStart * ring->channels, offset, theFrameCount, gain);
+    }
+    else
+    {
+        gKernels.clear(out, theFrameCount * ring->channels);
+    }
+}
+
+bool ring_buffer_read(const struct RingBuffer* ring, int64_t sample_time, uint32_t frame_count, const struct RingGain* gain, float* out)
+{
+    uint32_t theChannels = ring->channels;
+    int64_t theEnd = sample_time + frame_count;
+
+    //	muted, so there is nothing to fetch
+    if(ring_gain_is_muted(gain))
+    {
+        gKernels.clear(out, frame_count * theChannels);
+        return false;
+    }
+
+    //	the acquire pairs with the writer's release, so every tag and sample before write_end is visible
+    int64_t theWriteEnd = atomic_load_explicit(&ring->write_end, memory_order_acquire);
+    uint64_t theGeneration = atomic_load_explicit(&ring->generation, memory_order_relaxed);
+    int64_t theValidEnd = (theEnd < theWriteEnd) ? theEnd : theWriteEnd;
+    bool theReadAnything = false;
+
+    //	walk the blocks, copying runs of valid ones in one go and clearing the rest, silent ones included
+    int64_t theRunStart = sample_time;
+    bool theRunIsValid = false;
+    for(int64_t thePosition = sample_time; thePosition < theEnd; )
+    {
+        int64_t theBlock = (thePosition >= 0) ? (thePosition / kRingBuffer_BlockFrames) : -1;
+        int64_t theBlockEnd = (theBlock + 1) * kRingBuffer_BlockFrames;
+        int64_t theSegmentEnd = (theBlockEnd < theEnd) ? theBlockEnd : theEnd;
+        bool theSegmentIsValid = false;
+        bool theSegmentIsSilent = false;
+
+        if((thePosition >= 0) && (thePosition < theValidEnd))
+        {
+            //	the acquire pairs with the release of a block going from silent to sound, so its clear is
+            //	visible along with the new tag
+            uint64_t theTag = atomic_load_explicit(&ring->block_tags[theBlock % ring->block_count], memory_order_acquire);
+            uint64_t theExpectedTag = ring_buffer_tag(theGeneration, theBlock);
+            theSegmentIsValid = (theTag == theExpectedTag);
+            theSegmentIsSilent = (theTag == (theExpectedTag | kRingBuffer_SilentTag));
+            if((theSegmentIsValid || theSegmentIsSilent) && (theSegmentEnd > theValidEnd))
+            {
+                theSegmentEnd = theValidEnd;
+            }
+        }
+
+        if(theSegmentIsValid != theRunIsValid)
+        {
+            if(thePosition > theRunStart)
+            {
+                ring_buffer_copy_run(ring, theRunStart, thePosition, theRunIsValid, (uint32_t)(theRunStart - sample_time), gain, out + (theRunStart - sample_time) * theChannels);
+            }
+            theRunStart = thePosition;
+            theRunIsValid = theSegmentIsValid;
+        }
+        theReadAnything |= theSegmentIsValid || theSegmentIsSilent;
+        thePosition = theSegmentEnd;
+    }
+    ring_buffer_copy_run(ring, theRunStart, theEnd, theRunIsValid, (uint32_t)(theRunStart - sample_time), gain, out + (theRunStart - sample_time) * theChannels);
+
+    //	if the writer started on blocks a whole ring past ours while we copied, or the ring was reset and
+    //	rewound under us, what we have is torn
+    atomic_thread_fence(memory_order_acquire);
+    if(theReadAnything && ((atomic_load_explicit(&ring->write_pending, memory_order_relaxed) - sample_time > ring->frame_count) || (atomic_load_explicit(&ring->generation, memory_order_relaxed) != theGeneration)))
+    {
+        gKernels.clear(out, frame_count * theChannels);
+        return false;
+    }
+
+    return theReadAnything;
+}
+
+void ring_buffer_apply_gain(const struct RingBuffer* ring, const struct RingGain* gain, float* samples, uint32_t frame_count)
+{
+    ring_buffer_copy_gain(ring, samples, samples, 0, frame_count, gain);
+}
+
+//	Copies the frames from start to end of a write that began at sample_time, which may be none.
+static void ring_buffer_store_run(struct RingBuffer* ring, int64_t start, int64_t end, int64_t sample_time, const float* in, uint32_t offset, const struct RingGain* gain)
+{
+    if(end > start)
+    {
+        uint32_t theStart = (uint64_t)start % ring->frame_count;
+        uint32_t theRunOffset = (uint32_t)(start - sample_time);
+        ring_buffer_copy_gain(ring, ring->samples + (size_t)theStart * ring->channels, in + (size_t)theRunOffset * ring->channels, offset + theRunOffset, (uint32_t)(end - start), gain);
+    }
+}
+
+void ring_buffer_write(struct RingBuffer* ring, int64_t sample_time, uint32_t frame_count, const struct RingGain* gain, const float* in)
+{
+    uint32_t theChannels = ring->channels;
+    int64_t theEnd = sample_time + frame_count;
+    uint64_t theGeneration = atomic_load_explicit(&ring->generation, memory_order_relaxed);
+    uint32_t theOffset = 0;
+
+    //	frames before the start of time have nowhere to go
+    if(sample_time < 0)
+    {
+        in -= sample_time * theChannels;
+        theOffset = (uint32_t)(-sample_time);
+        sample_time = 0;
+        if(theEnd <= sample_time)
+        {
+            return;
+        }
+    }
+
+    //	announce every block we may touch, including the untouched tail of the last one
+    int64_t thePendingEnd = ((theEnd + kRingBuffer_BlockFrames - 1) / kRingBuffer_BlockFrames) * kRingBuffer_BlockFrames;
+    atomic_store_explicit(&ring->write_pending, thePendingEnd, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    //	Walk the blocks. A block written for the first time in this lap still holds an older lap: silence
+    //	leaves it at that and only tags it silent, sound clears it first. Everything else is copied, in
+    //	runs as long as the blocks allow.
+    bool theIsMuted = ring_gain_is_muted(gain);
+    int64_t theSoundEnd = -1;
+    int64_t theRunStart = sample_time;
+    for(int64_t thePosition = sample_time; thePosition < theEnd; )
+    {
+        int64_t theBlock = thePosition / kRingBuffer_BlockFrames;
+        int64_t theBlockEnd = (theBlock + 1) * kRingBuffer_BlockFrames;
+        int64_t theSegmentEnd = (theBlockEnd < theEnd) ? theBlockEnd : theEnd;
+
+        const float* theIn = in + (thePosition - sample_time) * theChannels;
+        bool theSegmentIsSilent = theIsMuted || gKernels.is_silent(theIn, (uint32_t)(theSegmentEnd - thePosition) * theChannels);
+        _Atomic uint64_t* theTag = &ring->block_tags[theBlock % ring->block_count];
+        uint64_t theExpectedTag = ring_buffer_tag(theGeneration, theBlock);
+        uint64_t theCurrentTag = atomic_load_explicit(theTag, memory_order_relaxed);
+
+        if((theCurrentTag != theExpectedTag) && theSegmentIsSilent)
+        {
+            if(theCurrentTag != (theExpectedTag | kRingBuffer_SilentTag))
+            {
+                atomic_store_explicit(theTag, theExpectedTag | kRingBuffer_SilentTag, memory_order_relaxed);
+            }
+            ring_buffer_store_run(ring, theRunStart, thePosition, sample_time, in, theOffset, gain);
+            theRunStart = theSegmentEnd;
+        }
+        else if(theCurrentTag != theExpectedTag)
+        {
+            size_t theBlockOffset = (size_t)(theBlock % ring->block_count) * kRingBuffer_BlockFrames * theChannels;
+            gKernels.clear(ring->samples + theBlockOffset, kRingBuffer_BlockFrames * theChannels);
+            atomic_store_explicit(theTag, theExpectedTag, memory_order_release);
+        }
+
+        if(!theSegmentIsSilent)
+        {
+            theSoundEnd = theSegmentEnd;
+        }
+        thePosition = theSegmentEnd;
+    }
+    ring_buffer_store_run(ring, theRunStart, theEnd, sample_time, in, theOffset, gain);
+
+    if(theSoundEnd >= 0)
+    {
+        atomic_store_explicit(&ring->sound_end, theSoundEnd, memory_order_relaxed);
+    }
+    atomic_store_explicit(&ring->write_end, theEnd, memory_order_release);
+}
@@ -0,0 +1,266 @@
+#ifndef VACcore_h
+#define VACcore_h
+
+//	The platform-neutral half of the driver. Nothing in here may include CoreAudio or Accelerate
+//	headers: the ring buffer, the zero time stamp clock, the state snapshots and the volume math only
+//	deal in plain C types so that they can be built and driven by something other than coreaudiod. The
+//	only OS specific code is the virtual memory mapping behind the mirrored ring.
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "VACkernels.h"
+
+#define                             kCacheLine_Size                     64
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Volume
+//==================================================================================================
+
+//	volume is a linear amplitude gain, decibel is 20 log10 of it clamped to the range below, and scalar
+//	maps that range linearly onto 0 to 1.
+//
+//	None of these call into libm: log2 and exp2 are range reduced to a short polynomial and the clamps
+//	are selects, so the batch versions are straight-line loops the compiler can vectorize. Across the
+//	control range decibels are within 1e-5 dB of 20 log10, and volumes within 5e-7 relative of
+//	10^(dB/20), far below anything audible or visible on a slider. tests/test_volume.c holds them to
+//	that and bench/bench_volume.c compares them with libm.
+#define                             kVolume_MinDB                       (-64.0f)
+#define                             kVolume_MaxDB                       (0.0f)
+
+float       volume_to_decibel(float volume);
+float       volume_from_decibel(float decibel);
+float       volume_to_scalar(float volume);
+float       volume_from_scalar(float scalar);
+
+//	out and in may be the same array, for converting a set of channel gains in place
+void        volume_to_decibel_batch(float* out, const float* in, uint32_t count);
+void        volume_from_decibel_batch(float* out, const float* in, uint32_t count);
+void        volume_to_scalar_batch(float* out, const float* in, uint32_t count);
+void        volume_from_scalar_batch(float* out, const float* in, uint32_t count);
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Clock
+//==================================================================================================
+
+//	Host time and sample time are related by an exact rational, host ticks per frame =
+//	ticks_numerator / ticks_denominator, built from the mach_timebase_info style nanoseconds per tick
+//	ratio and the integral sample rate and reduced by their common factor. Both conversions are O(1)
+//	64-bit integer arithmetic that splits the ratio into whole and fractional ticks, so nothing rounds
+//	and accumulates however long the device runs: the nth period always lands on the same host tick.
+//	The split keeps the fractional intermediates below ticks_numerator * ticks_denominator, which stays
+//	far inside 64 bits for any real timebase (the ratio is 2000000/147 at 44.1kHz on a 125/3 timebase).
+//
+//	The anchor and the ratio are published seqlock style, so the IO thread never blocks on them: the
+//	writers (set_rate and reset) bump sequence to odd, store, then bump it to even, and a reader that
+//	sees an odd or changed sequence simply retries. Writers must be serialized by the caller, which in
+//	the driver is the device's state mutex.
+//
+//	The time stamp count below the second line belongs to the thread that calls
+//	device_clock_zero_time_stamp, which coreaudiod only does from the device's IO thread. Each new
+//	publication starts a new timeline: the count restarts from zero at the new anchor, so a rate change
+//	re-anchors at the time it was made rather than scaling the periods already counted.
+struct DeviceClock {
+    alignas(kCacheLine_Size)
+    _Atomic uint32_t            sequence;
+    _Atomic uint64_t            anchor_host_time;
+    _Atomic uint64_t            ticks_numerator;
+    _Atomic uint64_t            ticks_denominator;
+
+    alignas(kCacheLine_Size)
+    uint32_t                    reader_sequence;
+    uint64_t                    number_time_stamps;
+};
+
+//	A host tick lasts timebase_numerator / timebase_denominator nanoseconds, as in mach_timebase_info.
+void        device_clock_set_rate(struct DeviceClock* clock, uint32_t timebase_numerator, uint32_t timebase_denominator, uint32_t sample_rate, uint64_t current_host_time);
+void        device_clock_reset(struct DeviceClock* clock, uint64_t current_host_time);
+void        device_clock_zero_time_stamp(struct DeviceClock* clock, uint64_t current_host_time, uint32_t period, double* out_sample_time, uint64_t* out_host_time);
+
+//	Exact conversions relative to the anchor, rounding down. Not meant for the IO thread while a writer
+//	may be publishing.
+uint64_t    device_clock_host_ticks_for_frames(const struct DeviceClock* clock, uint64_t frames);
+uint64_t    device_clock_frames_for_host_ticks(const struct DeviceClock* clock, uint64_t host_ticks);
+
+//	The sample time on to that falls on the same host tick as sample_time on from, with the offset
+//	between the two rounded towards zero. Returns false when the clocks run at different rates. Lock
+//	free, so fine on the IO thread.
+bool        device_clock_translate(const struct DeviceClock* from, const struct DeviceClock* to, int64_t sample_time, int64_t* out_sample_time);
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Snapshot
+//==================================================================================================
+
+//	Publishes a small block of state RCU style between two buffers the caller owns: readers always see
+//	a complete buffer that nobody is writing, and never wait for a writer.
+//
+//	A reader brackets its copy with snapshot_read_begin and snapshot_read_end, which is one atomic
+//	increment and one decrement of the reader count for the current epoch, so reads are wait-free. A
+//	writer fills the buffer snapshot_write_index names, then calls snapshot_publish, which makes that
+//	buffer current and waits out a grace period: it advances the epoch twice and each time waits for
+//	the readers still counted under the previous one to leave. When it returns no reader can hold the
+//	old buffer, and it becomes the next one to write. Readers that arrive during the wait count under
+//	the new epoch, so a steady stream of them can't hold the writer up.
+//
+//	Writers must be serialized by the caller, and may read the current buffer directly while they are.
+//	They must never publish from a thread that is itself between read_begin and read_end.
+struct Snapshot {
+    alignas(kCacheLine_Size)
+    _Atomic uint32_t            current;
+    _Atomic uint32_t            epoch;
+
+    alignas(kCacheLine_Size)
+    _Atomic uint32_t            readers[2];
+};
+
+void        snapshot_init(struct Snapshot* snapshot);
+uint32_t    snapshot_current_index(const struct Snapshot* snapshot);
+uint32_t    snapshot_write_index(const struct Snapshot* snapshot);
+void        snapshot_publish(struct Snapshot* snapshot);
+
+//	read_begin returns the ticket to hand back to read_end and stores the index of the buffer to read.
+uint32_t    snapshot_read_begin(struct Snapshot* snapshot, uint32_t* out_index);
+void        snapshot_read_end(struct Snapshot* snapshot, uint32_t ticket);
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Triple Buffer
+//==================================================================================================
+
+//	Hands a block of state from serialized writers to a single reader through three buffers the caller
+//	owns: one the writers fill, one the reader holds, and one in between. Publishing swaps the filled
+//	buffer with the one in between and flags it as fresh; the reader swaps it for its own only when
+//	the flag is set. Neither side ever waits or sees a buffer the other is using, and when nothing
+//	changed the reader pays a single relaxed load.
+//
+//	The shared word and each side's index sit on their own cache lines. Buffers handed out by
+//	write_index have to be filled completely, they hold whatever was published two changes ago.
+#define                             kTripleBuffer_Fresh                 4u
+
+struct TripleBuffer {
+    alignas(kCacheLine_Size)
+    _Atomic uint32_t            shared;
+
+    alignas(kCacheLine_Size)
+    uint32_t                    write_index;
+
+    alignas(kCacheLine_Size)
+    uint32_t                    read_index;
+};
+
+//	Call before the reader starts, with all three buffers holding the same contents.
+void        triple_buffer_init(struct TripleBuffer* buffer);
+uint32_t    triple_buffer_write_index(const struct TripleBuffer* buffer);
+void        triple_buffer_publish(struct TripleBuffer* buffer);
+
+//	Only ever from the one reader thread. Returns the index of the newest buffer published.
+uint32_t    triple_buffer_read_index(struct TripleBuffer* buffer);
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Ring Buffer
+//==================================================================================================
+
+//	Interleaved float frames addressed by absolute sample time modulo frame_count. The same physical
+//	pages are mapped twice back to back, so samples[frame_count * channels + i] aliases samples[i] and
+//	any span of up to frame_count frames starting inside the ring is contiguous in memory. frame_count
+//	is rounded up so that the ring covers a whole number of pages and blocks.
+//
+//	There is a single producer and any number of consumers: only the WriteMix side stores anything,
+//	the samples, the block tags and the write cursors, and readers only load them. A read is a pure
+//	function of the sample time it is asked for, so every reader keeps its own cursor and adding one
+//	costs the writer nothing.
+//
+//	Every block of kRingBuffer_BlockFrames frames carries a tag naming the absolute block it holds and
+//	the generation it was written in. A block whose tag doesn't match is stale and reads as silence
+//	without being touched, so neither an underrun nor a reset ever has to clear the ring. A tag can
+//	also say that the block holds nothing but silence so far: the writer then neither clears nor
+//	copies it, and readers produce zeros without reading it, so an idle cable moves no samples through
+//	memory. The first sound in such a block clears it before the tag changes. The writer
+//	publishes write_end with release ordering, and raises write_pending to the end of the last block it
+//	is about to modify before storing anything, so that a reader can tell after its copy whether the
+//	writer lapped it mid-read, seqlock style.
+#define                             kRingBuffer_BlockFrames             64
+
+struct RingBuffer {
+    float*                      samples;
+    _Atomic uint64_t*           block_tags;
+    size_t                      mapped_size;
+    uint32_t                    frame_count;
+    uint32_t                    block_count;
+    uint32_t                    channels;
+    //	looked up for channels once, when the ring is allocated
+    struct FrameKernels         kernels;
+
+    alignas(kCacheLine_Size)
+    _Atomic uint64_t            generation;
+    _Atomic int64_t             write_end;
+    _Atomic int64_t             write_pending;
+    //	the end of the last frame written that wasn't silence
+    _Atomic int64_t             sound_end;
+};
+
+//	The gain for one transfer in or out of the ring: the first ramp_frames frames go linearly from
+//	start by step per frame, the rest get target. A steady gain has no ramp frames and costs the same
+//	as the plain gain kernels; only the ramped frames go through the ramp kernel.
+//
+//	When the channels differ, channel_start, channel_step and channel_target hold one value per channel
+//	in place of the scalars and the transfer goes through the per-channel kernels. They are NULL
+//	otherwise, and have to stay valid for the duration of the transfer.
+struct RingGain {
+    float                       start;
+    float                       step;
+    uint32_t                    ramp_frames;
+    float                       target;
+    const float*                channel_start;
+    const float*                channel_step;
+    const float*                channel_target;
+};
+
+static inline struct RingGain ring_gain_steady(float gain)
+{
+    return (struct RingGain){ gain, 0.0f, 0, gain, NULL, NULL, NULL };
+}
+
+//	a steady zero, which lets a transfer skip the samples altogether
+static inline bool ring_gain_is_muted(const struct RingGain* gain)
+{
+    return (gain->ramp_frames == 0) && (gain->channel_target == NULL) && (gain->target == 0.0f);
+}
+
+//	Meant to be called once, well before IO starts: the pages are touched up front (and wired when
+//	lock is true) so the IO thread never takes a first-touch fault. Returns false if the mirrored
+//	mapping could not be set up; failing to wire the pages is not an error.
+bool        ring_buffer_allocate(struct RingBuffer* ring, uint32_t frame_count, uint32_t channels, bool lock);
+void        ring_buffer_free(struct RingBuffer* ring);
+
+//	Forgets everything that was written in O(1) by rewinding the cursors and starting a new generation,
+//	which makes every block tag stale. The tags hold 16 bits of generation, so every 65536th reset also
+//	clears them, in O(blocks). Readers may run alongside it, and one it overlaps gets silence; the writer
+//	may not.
+void        ring_buffer_reset(struct RingBuffer* ring);
+
+//	Copies the frames out of the ring with gain applied in the same pass. Frames the writer has not
+//	produced in this generation, or overwrote while they were being copied, come out as silence, as
+//	does everything when the gain is a steady zero. Returns false when no frame came from the ring.
+bool        ring_buffer_read(const struct RingBuffer* ring, int64_t sample_time, uint32_t frame_count, const struct RingGain* gain, float* out);
+
+//	Applies gain in place to frames laid out like the ring's, exactly as a read would have, for a reader
+//	that mixes something else into what it read at unity before the gain goes on.
+void        ring_buffer_apply_gain(const struct RingBuffer* ring, const struct RingGain* gain, float* samples, uint32_t frame_count);
+
+//	Stores the frames scaled by gain, so a muted writer still marks its blocks as written, with silence.
+//	Silent input, or a steady zero gain, only updates the tags of blocks that hold no sound yet.
+void        ring_buffer_write(struct RingBuffer* ring, int64_t sample_time, uint32_t frame_count, const struct RingGain* gain, const float* in);
+
+//	True when nothing but silence was written over the last frame_count frames, which is everything a
+//	reader could still get out of the ring. From any thread.
+bool        ring_buffer_is_silent(const struct RingBuffer* ring);
+
+#endif /* VACcore_h */
@@ -4,8 +4,12 @@
 #include <mach/mach_time.h>
 #include <pthread.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/syslog.h>
-#include <Accelerate/Accelerate.h>
+
+#include "VACcore.h"
+#include "VACkernels.h"
 
 //==================================================================================================
 #pragma mark -
@@ -59,6 +63,10 @@
 #pragma mark -
 #pragma mark VAC State
 
+#ifndef kNumber_Of_Channels
+#define                             kNumber_Of_Channels                 2
+#endif
+
 enum
 {
     kObjectID_PlugIn                    = kAudioObjectPlugInObject,
@@ -70,19 +78,44 @@ enum
     kObjectID_Stream_Output             = 7,
     kObjectID_Volume_Output_Master      = 8,
     kObjectID_Mute_Output_Master        = 9,
-    kObjectID_Device2                   = 10,
+};
+
+//	Every device owns a block of kObjectRole_Count consecutive object IDs starting with its own, so
+//	the device and the role of any of its objects fall out of the ID with a division.
+enum ObjectRole
+{
+    kObjectRole_Device                  = 0,
+    kObjectRole_Stream_Input            = 1,
+    kObjectRole_Volume_Input_Master     = 2,
+    kObjectRole_Mute_Input_Master       = 3,
+    kObjectRole_Stream_Output           = 4,
+    kObjectRole_Volume_Output_Master    = 5,
+    kObjectRole_Mute_Output_Master      = 6,
+    //	then one volume and one mute control per channel and scope, the one for channel i at the role
+    //	plus i
+    kObjectRole_Volume_Input_Channel    = 7,
+    kObjectRole_Mute_Input_Channel      = kObjectRole_Volume_Input_Channel + kNumber_Of_Channels,
+    kObjectRole_Volume_Output_Channel   = kObjectRole_Mute_Input_Channel + kNumber_Of_Channels,
+    kObjectRole_Mute_Output_Channel     = kObjectRole_Volume_Output_Channel + kNumber_Of_Channels,
+    kObjectRole_Count                   = kObjectRole_Mute_Output_Channel + kNumber_Of_Channels,
+    kObjectRole_None                    = kObjectRole_Count
 };
 
 enum ObjectType
 {
     kObjectType_Stream,
-    kObjectType_Control
+    kObjectType_Volume,
+    kObjectType_Mute,
+    kObjectType_Count
 };
 
+//	element is kAudioObjectPropertyElementMain for the streams and the master controls, and the
+//	channel number, counting from 1, for the channel controls
 struct ObjectInfo {
     AudioObjectID id;
     enum ObjectType type;
     AudioObjectPropertyScope scope;
+    AudioObjectPropertyElement element;
 };
 
 
@@ -144,14 +177,27 @@ struct ObjectInfo {
 
 #define                             kLatency_Frame_Size                 0
 
-#ifndef kNumber_Of_Channels
-#define                             kNumber_Of_Channels                 2
+#ifndef kRing_Buffer_Locked
+#define                             kRing_Buffer_Locked                 true
 #endif
 
 #ifndef kEnableVolumeControl
 #define                             kEnableVolumeControl                 true
 #endif
 
+//	A control change reaches the audio as a ramp over this many frames instead of a step. The
+//	exponential shape moves evenly in decibels, with silence at kVolume_MinDB, through the batch volume
+//	conversions; the linear one moves evenly in amplitude and needs no conversions at all. 0 turns
+//	ramps off.
+#ifndef kGain_Ramp_Frames
+#define                             kGain_Ramp_Frames                   512
+#endif
+
+#ifndef kGain_Ramp_Exponential
+#define                             kGain_Ramp_Exponential              false
+#endif
+
+
 static pthread_mutex_t              gPlugIn_StateMutex                  = PTHREAD_MUTEX_INITIALIZER;
 static UInt32                       gPlugIn_RefCount                    = 0;
 static AudioServerPlugInHostRef     gPlugIn_Host                        = NULL;
@@ -165,51 +211,314 @@ static CFStringRef                  gBox_Name                           = NULL;
 static Boolean                      gBox_Acquired                       = kBox_Aquired;
 
 
-static pthread_mutex_t              gDevice_IOMutex                     = PTHREAD_MUTEX_INITIALIZER;
-static Float64                      gDevice_SampleRate                  = 44100.0;
-static UInt64                       gDevice_IOIsRunning                 = 0;
-static const UInt32                 kDevice_RingBufferSize              = 16384;
-static Float64                      gDevice_HostTicksPerFrame           = 0.0;
-static UInt64                       gDevice_NumberTimeStamps            = 0;
-static Float64                      gDevice_AnchorSampleTime            = 0.0;
-static UInt64                       gDevice_AnchorHostTime              = 0;
-
-static bool                         gStream_Input_IsActive              = true;
-static bool                         gStream_Output_IsActive             = true;
-
-static const Float32                kVolume_MinDB                       = -64.0;
-static const Float32                kVolume_MaxDB                       = 0.0;
-static Float32                      gVolume_Master_Value                = 1.0;
-static bool                         gMute_Master_Value                  = false;
-
-static struct ObjectInfo            kDevice_ObjectList[]                = {
-#if kDevice_HasInput
-    { kObjectID_Stream_Input,           kObjectType_Stream,     kAudioObjectPropertyScopeInput  },
-    { kObjectID_Volume_Input_Master,    kObjectType_Control,    kAudioObjectPropertyScopeInput  },
-    { kObjectID_Mute_Input_Master,      kObjectType_Control,    kAudioObjectPropertyScopeInput  },
+//	A latency profile fixes how often the device publishes a zero time stamp, how many frames the
+//	ring holds and the safety offset it reports. The standard profile keeps the original long period
+//	and deep ring; the low latency one publishes every kLowLatency_Period frames and sizes the ring to
+//	a handful of periods, which keeps the IO working set small enough to stay in cache. The ring has
+//	to cover the distance between the input and output times of one IO cycle, so the device offers IO
+//	buffers of at most half of it (see latency_profile_max_io_frames) and turns away anything longer.
+//
+//	WriteMix turns a buffer away once the IO thread is later than a buffer plus both safety offsets,
+//	so the offsets are what a client trades in round trip for slack against a late IO thread.
+//	bench/bench_latency.c measures both per profile; pick the low latency offset from what it reports
+//	on the target machine.
+#ifndef kLowLatency_Period
+#define                             kLowLatency_Period                  512
+#endif
+
+#ifndef kLowLatency_Ring_Buffer_Frame_Size
+#define                             kLowLatency_Ring_Buffer_Frame_Size  (16 * kLowLatency_Period)
+#endif
+
+#ifndef kLowLatency_Safety_Offset
+#define                             kLowLatency_Safety_Offset           32
 #endif
-#if kDevice_HasOutput
-    { kObjectID_Stream_Output,          kObjectType_Stream,     kAudioObjectPropertyScopeOutput },
-    { kObjectID_Volume_Output_Master,   kObjectType_Control,    kAudioObjectPropertyScopeOutput },
-    { kObjectID_Mute_Output_Master,     kObjectType_Control,    kAudioObjectPropertyScopeOutput }
+
+enum LatencyProfile {
+    kLatencyProfile_Standard        = 0,
+    kLatencyProfile_Low             = 1,
+    kLatencyProfile_Count
+};
+
+struct LatencyProfileInfo {
+    UInt32                          zero_time_stamp_period;
+    UInt32                          ring_frame_count;
+    UInt32                          safety_offset;
+};
+
+static const struct LatencyProfileInfo kLatency_Profiles[kLatencyProfile_Count] = {
+    [kLatencyProfile_Standard]  = { 16384,                  65536 + kLatency_Frame_Size,        kLatency_Frame_Size         },
+    [kLatencyProfile_Low]       = { kLowLatency_Period,     kLowLatency_Ring_Buffer_Frame_Size, kLowLatency_Safety_Offset   },
+};
+
+//	The top of kAudioDevicePropertyBufferFrameSizeRange, and the most _DoIOOperation moves at once.
+static inline UInt32 latency_profile_max_io_frames(enum LatencyProfile profile)
+{
+    return kLatency_Profiles[profile].ring_frame_count / 2;
+}
+
+//	The HAL only passes a driver's own properties between processes when they are listed in
+//	kAudioObjectPropertyCustomPropertyInfoList, and then only as CFString or property list values. The
+//	device's are all property lists: a CFNumber in and out, with no qualifier.
+
+//	A CFNumber holding an enum LatencyProfile on the device object, global scope, settable. Changing it
+//	goes through a configuration change like the sample rate does, with
+//	kDevice_ConfigChange_LatencyProfile set in the action and the profile in the low bits. Sample rate
+//	actions never reach that bit.
+#define                             kVACDevicePropertyLatencyProfile    'vlpf'
+#define                             kDevice_ConfigChange_LatencyProfile (1ULL << 32)
+
+//	A CFNumber on the device object, global scope, read only: 1 while the cable carries nothing but
+//	silence, either because IO is stopped or because nothing audible was written over the last ring's
+//	worth of frames, and for a bus into any of the sources it mixes in either. The IO thread can't send
+//	notifications, so clients poll it.
+#define                             kVACDevicePropertyIsSilent          'vsil'
+
+//	A CFNumber on the device object, global scope, settable: how many frames behind the device's input
+//	time the calling process's clients read, up to half the ring. All the clients read the one ring,
+//	so a delayed client costs a second read of its own, in ProcessInput, and the writer nothing. Only
+//	a client with a delay takes part in ProcessInput, so a change that gives a client its first delay
+//	or takes its last away asks for a configuration change with kDevice_ConfigChange_ClientDelay set,
+//	which changes nothing on the device but has the HAL restart IO and ask WillDoIOOperation again.
+#define                             kVACDevicePropertyClientDelay       'vcdl'
+#define                             kDevice_ConfigChange_ClientDelay    (1ULL << 33)
+
+//	A CFNumber on the device object, global scope, settable: the linear gain from 0 to kBus_MaxGain
+//	that this device's output is summed with into the bus named by kDevice_DescriptionKey_Bus. It
+//	defaults to 1 and does nothing on a device that doesn't feed a bus.
+#define                             kVACDevicePropertyBusGain           'vbgn'
+#define                             kBus_MaxGain                        4.0f
+
+static const AudioServerPlugInCustomPropertyInfo kDevice_CustomProperties[] = {
+    { kVACDevicePropertyLatencyProfile, kAudioServerPlugInCustomPropertyDataTypeCFPropertyList, kAudioServerPlugInCustomPropertyDataTypeNone },
+    { kVACDevicePropertyIsSilent,       kAudioServerPlugInCustomPropertyDataTypeCFPropertyList, kAudioServerPlugInCustomPropertyDataTypeNone },
+    { kVACDevicePropertyClientDelay,    kAudioServerPlugInCustomPropertyDataTypeCFPropertyList, kAudioServerPlugInCustomPropertyDataTypeNone },
+    { kVACDevicePropertyBusGain,        kAudioServerPlugInCustomPropertyDataTypeCFPropertyList, kAudioServerPlugInCustomPropertyDataTypeNone },
+};
+
+//	One entry per role after the device's own, in role order. The channel controls are filled in by
+//	object_template_build.
+static struct ObjectInfo            gDevice_ObjectTemplate[kObjectRole_Count - 1] = {
+    { kObjectRole_Stream_Input,         kObjectType_Stream,     kAudioObjectPropertyScopeInput,     kAudioObjectPropertyElementMain },
+    { kObjectRole_Volume_Input_Master,  kObjectType_Volume,     kAudioObjectPropertyScopeInput,     kAudioObjectPropertyElementMain },
+    { kObjectRole_Mute_Input_Master,    kObjectType_Mute,       kAudioObjectPropertyScopeInput,     kAudioObjectPropertyElementMain },
+    { kObjectRole_Stream_Output,        kObjectType_Stream,     kAudioObjectPropertyScopeOutput,    kAudioObjectPropertyElementMain },
+    { kObjectRole_Volume_Output_Master, kObjectType_Volume,     kAudioObjectPropertyScopeOutput,    kAudioObjectPropertyElementMain },
+    { kObjectRole_Mute_Output_Master,   kObjectType_Mute,       kAudioObjectPropertyScopeOutput,    kAudioObjectPropertyElementMain }
+};
+
+#define                             kDevice_ObjectTemplateSize          (sizeof(gDevice_ObjectTemplate) / sizeof(struct ObjectInfo))
+
+//	The object lists a device reports, each kept per scope. Global holds the objects of every scope,
+//	the way the HAL expects.
+enum ObjectList
+{
+    kObjectList_Owned,
+    kObjectList_Streams,
+    kObjectList_Controls,
+    kObjectList_Count
+};
+
+enum ObjectListScope
+{
+    kObjectListScope_Global,
+    kObjectListScope_Input,
+    kObjectListScope_Output,
+    kObjectListScope_Count
+};
+
+struct ObjectIDList {
+    UInt32                          count;
+    AudioObjectID                   ids[kDevice_ObjectTemplateSize];
+};
+
+//	the input and output volume and mute controls are independent, each indexes its values by scope
+//	and then by element, the master first and then the channels
+enum ControlScope
+{
+    kControlScope_Input,
+    kControlScope_Output,
+    kControlScope_Count
+};
+
+#define                             kControl_ElementCount               (kNumber_Of_Channels + 1)
+
+#ifndef kMax_Number_Of_Devices
+#define                             kMax_Number_Of_Devices              128
 #endif
+
+//	the keys _CreateDevice understands in its description dictionary, all of them optional
+#define                             kDevice_DescriptionKey_UID          "uid"
+#define                             kDevice_DescriptionKey_Name         "name"
+#define                             kDevice_DescriptionKey_IsHidden     "hidden"
+#define                             kDevice_DescriptionKey_LowLatency   "low latency"
+//	the UID of an existing device with input, which then hears this one's output mixed into its own
+#define                             kDevice_DescriptionKey_Bus          "bus"
+
+struct DeviceDescription {
+    CFStringRef                     uid;
+    CFStringRef                     name;
+    bool                            is_hidden;
+    bool                            has_input;
+    bool                            has_output;
+    enum LatencyProfile             latency_profile;
+    struct Device*                  bus;
+};
+
+//	The part of a device's state that its properties report and the IO path reads. It is published as
+//	a Snapshot, so that clients polling properties and the IO thread never wait for, or on, the state
+//	mutex that IO start and stop and the property setters take.
+struct DeviceState {
+    Float64                         sample_rate;
+    //	only changes in a configuration change, when IO is stopped
+    enum LatencyProfile             latency_profile;
+    bool                            is_running;
+    bool                            stream_input_is_active;
+    bool                            stream_output_is_active;
+    bool                            mute_value[kControlScope_Count][kControl_ElementCount];
+    Float32                         volume_value[kControlScope_Count][kControl_ElementCount];
+    //	how loud this device's output is in the bus it feeds, see kVACDevicePropertyBusGain
+    Float32                         bus_gain;
+};
+
+//	What the IO thread needs from the controls and the latency profile, built from the DeviceState by
+//	device_controls_publish and read with device_controls by every call the host makes on the IO
+//	thread: GetZeroTimeStamp, WillDoIOOperation and DoIOOperation. A device keeps three behind a
+//	TripleBuffer, each on its own cache lines, so the property setters fill one while the IO thread
+//	reads another.
+struct DeviceControls {
+    alignas(kCacheLine_Size)
+    //	per channel, the master gain times the channel's, where a control's gain is its volume, or zero
+    //	when muted, or one when kEnableVolumeControl is off
+    Float32                         gain[kControlScope_Count][kNumber_Of_Channels];
+    //	every channel of the scope has the same gain, so the IO path can stay on the scalar kernels
+    bool                            is_uniform[kControlScope_Count];
+    //	the device has the scope's stream and it is active, otherwise its IO leaves the ring alone
+    bool                            is_active[kControlScope_Count];
+    UInt32                          safety_offset;
+    UInt32                          zero_time_stamp_period;
+    UInt32                          max_io_frames;
+};
+
+//	Where one scope's channel gains are on their way to the values in the DeviceControls. It belongs
+//	to the IO thread, which moves it along with device_gain_advance; _StartIO unprimes it so that a new
+//	run starts at the controls' values instead of ramping from wherever the last one stopped. While
+//	is_uniform is set only the first channel of current is kept up to date.
+struct GainRamp {
+    bool                            is_primed;
+    bool                            is_uniform;
+    UInt32                          frames_left;
+    Float32                         current[kNumber_Of_Channels];
+    Float32                         target[kNumber_Of_Channels];
+    //	the segment handed to the ring for the transfer in progress
+    Float32                         start[kNumber_Of_Channels];
+    Float32                         step[kNumber_Of_Channels];
 };
 
-static struct ObjectInfo            kDevice2_ObjectList[]                = {
-#if kDevice2_HasInput
-    { kObjectID_Stream_Input,           kObjectType_Stream,     kAudioObjectPropertyScopeInput  },
-    { kObjectID_Volume_Input_Master,    kObjectType_Control,    kAudioObjectPropertyScopeInput  },
-    { kObjectID_Mute_Input_Master,      kObjectType_Control,    kAudioObjectPropertyScopeInput  },
+//	_AddDeviceClient turns away any client past this many on one device.
+#ifndef kMax_Number_Of_Clients
+#define                             kMax_Number_Of_Clients              32
 #endif
-#if kDevice2_HasOutput
-    { kObjectID_Stream_Output,          kObjectType_Stream,     kAudioObjectPropertyScopeOutput },
-    { kObjectID_Volume_Output_Master,   kObjectType_Control,    kAudioObjectPropertyScopeOutput },
-    { kObjectID_Mute_Output_Master,     kObjectType_Control,    kAudioObjectPropertyScopeOutput }
+
+//	One HAL client of a device, filled in by _AddDeviceClient and emptied by _RemoveDeviceClient under
+//	the state mutex, with a client_id of zero marking a free slot. The IO thread looks its client up
+//	without locking: a slot is filled in before its client_id is stored with release ordering, and the
+//	host stops a client's IO before removing it.
+//
+//	A client's read cursor is the cycle's input time less delay_frames, so the IO thread keeps nothing
+//	per client and the readers never write to anything they share, however many there are.
+struct DeviceClient {
+    _Atomic UInt32                  client_id;
+    pid_t                           pid;
+    //	the same for every client of a process, see kVACDevicePropertyClientDelay
+    _Atomic UInt32                  delay_frames;
+};
+
+//	_CreateDevice turns away a device that would feed a bus past this many sources.
+#ifndef kMax_Number_Of_Bus_Sources
+#define                             kMax_Number_Of_Bus_Sources          32
 #endif
+
+//	how many frames of a source the bus reads at a time, which sizes its scratch buffer on the stack
+#define                             kBus_ChunkFrames                    256
+
+//	The devices whose output a bus device mixes into its input, each with its bus gain. A device joins
+//	a bus by naming it in its description. The bus's IO thread reads every source's own ring at the
+//	same host time and accumulates it with the sum kernel, so each ring keeps its single writer and no
+//	two threads ever store to the same samples, and nothing takes a lock. The list is published as a
+//	Snapshot, and its grace period is what lets a source's ring be freed or swapped once the source is
+//	out of the list.
+struct BusSources {
+    UInt32                          count;
+    struct Device*                  devices[kMax_Number_Of_Bus_Sources];
+    Float32                         gain[kMax_Number_Of_Bus_Sources];
+};
+
+//	Everything one cable needs, so that two apps on different devices never share a ring, a clock, a
+//	control value or a lock. Each device starts on its own cache line, and the ring inside it keeps
+//	its writer cursors on a line of their own.
+//
+//	Devices live in the fixed gDevices table and slot i always owns the object IDs starting at
+//	kObjectID_Device + i * kObjectRole_Count, so finding a device from any of its IDs is a division and
+//	a flag check however many cables exist. A free slot costs only the struct; the ring is allocated by
+//	device_create and released by device_destroy.
+struct Device {
+    alignas(kCacheLine_Size)
+    _Atomic bool                    is_alive;
+    AudioObjectID                   object_id;
+
+    //	fixed while the device is alive
+    CFStringRef                     uid;
+    CFStringRef                     name;
+    bool                            is_hidden;
+    bool                            has_input;
+    bool                            has_output;
+
+    //	the device this one's output is mixed into, or NULL, guarded by gPlugIn_StateMutex
+    struct Device*                  bus;
+
+    //	filled in from gDevice_ObjectTemplate, with the IDs rebased on object_id, so that the list
+    //	properties are a copy out of the right one
+    struct ObjectIDList             object_lists[kObjectList_Count][kObjectListScope_Count];
+
+    //	guards io_is_running and serializes the writers of the state and the clock
+    pthread_mutex_t                 state_mutex;
+    UInt64                          io_is_running;
+
+    //	read with device_state, changed with device_state_edit and device_state_publish
+    struct Snapshot                 state_snapshot;
+    struct DeviceState              states[2];
+
+    //	read with device_controls, on the IO thread only
+    struct TripleBuffer             controls_buffer;
+    struct DeviceControls           controls[3];
+
+    alignas(kCacheLine_Size)
+    struct GainRamp                 io_gains[kControlScope_Count];
+    //	what ReadInput applied this cycle, for the delayed clients' reads that follow it
+    struct RingGain                 io_input_gain;
+
+    //	see DeviceClient
+    struct DeviceClient             clients[kMax_Number_Of_Clients];
+    //	how many of them have a delay, so the IO thread only looks a client up when one might
+    _Atomic UInt32                  delayed_client_count;
+
+    //	read on the IO thread with snapshot_read_begin, changed with device_bus_publish
+    struct Snapshot                 bus_snapshot;
+    struct BusSources               bus_sources[2];
+    //	the count of the last list published, so a device that isn't a bus reads its input without
+    //	touching the snapshot
+    _Atomic UInt32                  bus_source_count;
+
+    //	published lock free, see DeviceClock
+    struct DeviceClock              clock;
+
+    struct RingBuffer               ring;
 };
 
-static const UInt32                 kDevice_ObjectListSize              = sizeof(kDevice_ObjectList) / sizeof(struct ObjectInfo);
-static const UInt32                 kDevice2_ObjectListSize              = sizeof(kDevice2_ObjectList) / sizeof(struct ObjectInfo);
+//	guarded by gPlugIn_StateMutex, apart from is_alive which the IO path reads without it
+static struct Device                gDevices[kMax_Number_Of_Devices];
+static UInt32                       gDevice_Count                       = 0;
 
 #ifndef kSampleRates
 #define                             kSampleRates       8000, 16000, 44100, 48000, 88200, 96000, 176400, 192000, 352800, 384000, 705600, 768000
@@ -224,8 +533,6 @@ static const UInt32                 kDevice_SampleRatesSize             = sizeof
 #define                             kBits_Per_Channel                   32
 #define                             kBytes_Per_Channel                  (kBits_Per_Channel/ 8)
 #define                             kBytes_Per_Frame                    (kNumber_Of_Channels * kBytes_Per_Channel)
-#define                             kRing_Buffer_Frame_Size             ((65536 + kLatency_Frame_Size))
-static Float32*                     gRingBuffer;
 
 void*                _Create(CFAllocatorRef inAllocator, CFUUIDRef inRequestedTypeUUID);
 static HRESULT        _QueryInterface(void* in_driver, REFIID inUUID, LPVOID* outInterface);
@@ -251,36 +558,8 @@ static OSStatus        _BeginIOOperation(AudioServerPlugInDriverRef in_driver, A
 static OSStatus        _DoIOOperation(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, AudioObjectID inStreamObjectID, UInt32 inClientID, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo* inIOCycleInfo, void* ioMainBuffer, void* ioSecondaryBuffer);
 static OSStatus        _EndIOOperation(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, UInt32 inClientID, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo* inIOCycleInfo);
 
-//    Implementation
-static Boolean        _HasPlugInProperty(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress);
-static OSStatus        _IsPlugInPropertySettable(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable);
-static OSStatus        getplugIn_property_size(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize);
-static OSStatus        _GetPlugInPropertyData(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, UInt32* outDataSize, void* outData);
-static OSStatus        set_propertyData( pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2]);
-
-static Boolean        hasbox_property(pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress);
-static OSStatus        box_property_settable(pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable);
-static OSStatus        getbox_property_datasize( pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize);
-static OSStatus        getbox_property_data( pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, UInt32* outDataSize, void* outData);
-static OSStatus        set_box_property( pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2]);
-
-static Boolean        has_device_property(pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress);
-static OSStatus        device_property_settable( pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable);
-static OSStatus        get_device_property_size(AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize);
-static OSStatus        get_device_property(AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, UInt32* outDataSize, void* outData);
-static OSStatus        set_device_property(pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2]);
-
-static Boolean        has_stream_property(pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress);
-static OSStatus        stream_property(pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable);
-static OSStatus        _GetStreamPropertyDataSize(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize);
-static OSStatus        _GetStreamPropertyData(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, UInt32* outDataSize, void* outData);
-static OSStatus        _SetStreamPropertyData(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2]);
-
-static Boolean        _HasControlProperty(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress);
-static OSStatus        _IsControlPropertySettable(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable);
-static OSStatus        _GetControlPropertyDataSize(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize);
-static OSStatus        _GetControlPropertyData(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, UInt32* outDataSize, void* outData);
-static OSStatus        _SetControlPropertyData(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2]);
+//	the property tables and their index live with the property operations further down
+static void            property_index_build(void);
 
 #pragma mark The Interface
 
@@ -329,2861 +608,2583 @@ static CFStringRef get_device_uid()       { RETURN_FORMATTED_STRING(kDevice_UID)
 static CFStringRef get_device_name()      { RETURN_FORMATTED_STRING(kDevice_Name) }
 static CFStringRef get_device2_uid()       { RETURN_FORMATTED_STRING(kDevice2_UID) }
 static CFStringRef get_device2_name()      { RETURN_FORMATTED_STRING(kDevice2_Name) }
-static CFStringRef get_device_model_uid() { RETURN_FORMATTED_STRING(kDevice_ModelUID) }
-
-// Volume conversions
-
-static Float32 volume_to_decibel(Float32 volume)
-{
-	if (volume <= powf(10.0f, kVolume_MinDB / 20.0f))
-		return kVolume_MinDB;
-	else
-		return 20.0f * log10f(volume);
-}
 
-static Float32 volume_from_decibel(Float32 decibel)
+//	the default UID and name for a device created without one, told apart by their slot
+static CFStringRef get_created_device_uid(UInt32 slot)
 {
-	if (decibel <= kVolume_MinDB)
-		return 0.0f;
-	else
-		return powf(10.0f, decibel / 20.0f);
+	CFStringRef theBase = get_device_uid();
+	CFStringRef theUID = CFStringCreateWithFormat(NULL, NULL, CFSTR("%@_%u"), theBase, (unsigned int)slot);
+	CFRelease(theBase);
+	return theUID;
 }
 
-static Float32 volume_to_scalar(Float32 volume)
+static CFStringRef get_created_device_name(UInt32 slot)
 {
-	Float32 decibel = volume_to_decibel(volume);
-	return (decibel - kVolume_MinDB) / (kVolume_MaxDB - kVolume_MinDB);
+	CFStringRef theBase = get_device_name();
+	CFStringRef theName = CFStringCreateWithFormat(NULL, NULL, CFSTR("%@ %u"), theBase, (unsigned int)slot);
+	CFRelease(theBase);
+	return theName;
 }
+static CFStringRef get_device_model_uid() { RETURN_FORMATTED_STRING(kDevice_ModelUID) }
 
-static Float32 volume_from_scalar(Float32 scalar)
+//	Property values that never change once the driver is up. They are built once in _Initialize and
+//	the property getters hand out a retain or a copy, so enumerating the devices doesn't format
+//	strings, search bundles or rebuild the channel layout on every query. Each cable's own UID and
+//	name are kept in its struct Device the same way.
+#define                             kDevice_ChannelLayoutSize           (offsetof(AudioChannelLayout, mChannelDescriptions) + (kNumber_Of_Channels * sizeof(AudioChannelDescription)))
+
+static CFStringRef                  gBox_UID                            = NULL;
+static CFStringRef                  gDevice_ModelUID                    = NULL;
+static CFURLRef                     gDevice_Icon                        = NULL;
+static union {
+    AudioChannelLayout              layout;
+    UInt8                           bytes[kDevice_ChannelLayoutSize];
+}                                   gDevice_ChannelLayout;
+
+static void property_cache_build(void)
 {
-	Float32 decibel = scalar * (kVolume_MaxDB - kVolume_MinDB) + kVolume_MinDB;
-	return volume_from_decibel(decibel);
-}
-
-static UInt32 device_object_list_size(AudioObjectPropertyScope scope, AudioObjectID objectID) {
-    
-    switch (objectID) {
-        case kObjectID_Device:
-            {
-                if (scope == kAudioObjectPropertyScopeGlobal)
-                {
-                    return kDevice_ObjectListSize;
-                }
-
-                UInt32 count = 0;
-                for (UInt32 i = 0; i < kDevice_ObjectListSize; i++)
-                {
-                    count += (kDevice_ObjectList[i].scope == scope);
-                }
-
-                return count;
-            }
-            break;
-            
-        case kObjectID_Device2:
-            {
-                if (scope == kAudioObjectPropertyScopeGlobal)
-                {
-                    return kDevice2_ObjectListSize;
-                }
-
-                UInt32 count = 0;
-                for (UInt32 i = 0; i < kDevice2_ObjectListSize; i++)
-                {
-                    count += (kDevice2_ObjectList[i].scope == scope);
-                }
-
-                return count;
-            }
-            break;
-            
-        default:
-            return 0;
-            break;
+    if(gBox_UID == NULL)
+    {
+        gBox_UID = get_box_uid();
     }
-}
-
-static UInt32 device_stream_list_size(AudioObjectPropertyScope scope, AudioObjectID objectID) {
-    
-    switch (objectID) {
-        case kObjectID_Device:
-            {
-                UInt32 count = 0;
-                for (UInt32 i = 0; i < kDevice_ObjectListSize; i++)
-                {
-                    count += (kDevice_ObjectList[i].type == kObjectType_Stream && (kDevice_ObjectList[i].scope == scope || scope == kAudioObjectPropertyScopeGlobal));
-                }
-
-                return count;
-            }
-            break;
-            
-        case kObjectID_Device2:
-            {
-                UInt32 count = 0;
-                for (UInt32 i = 0; i < kDevice2_ObjectListSize; i++)
-                {
-                    count += (kDevice2_ObjectList[i].type == kObjectType_Stream && (kDevice2_ObjectList[i].scope == scope || scope == kAudioObjectPropertyScopeGlobal));
-                }
-
-                return count;
-            }
-            break;
-            
-        default:
-            return 0;
-            break;
+    if(gDevice_ModelUID == NULL)
+    {
+        gDevice_ModelUID = get_device_model_uid();
     }
-    
-
-}
-
-static UInt32 device_control_list_size(AudioObjectPropertyScope scope, AudioObjectID objectID) {
-    
-    switch (objectID) {
-        case kObjectID_Device:
+    if(gDevice_Icon == NULL)
+    {
+        CFBundleRef theBundle = CFBundleGetBundleWithIdentifier(CFSTR("audio.existential.VAC.Speaker"));
+        if(theBundle != NULL)
         {
-            
-            UInt32 count = 0;
-            for (UInt32 i = 0; i < kDevice_ObjectListSize; i++)
-            {
-                count += (kDevice_ObjectList[i].type == kObjectType_Control && (kDevice_ObjectList[i].scope == scope || scope == kAudioObjectPropertyScopeGlobal));
-            }
-
-            return count;
+            gDevice_Icon = CFBundleCopyResourceURL(theBundle, CFSTR("VAC.ai.Speaker.icns"), NULL, NULL);
         }
-            break;
-        case kObjectID_Device2:
-        {
-            
-            UInt32 count = 0;
-            for (UInt32 i = 0; i < kDevice2_ObjectListSize; i++)
-            {
-                count += (kDevice2_ObjectList[i].type == kObjectType_Control && (kDevice2_ObjectList[i].scope == scope || scope == kAudioObjectPropertyScopeGlobal));
-            }
+    }
 
-            return count;
-        }
-            break;
-            
-        default:
-            return 0;
-            break;
+    AudioChannelLayout* theLayout = &gDevice_ChannelLayout.layout;
+    theLayout->mChannelLayoutTag = kAudioChannelLayoutTag_UseChannelDescriptions;
+    theLayout->mChannelBitmap = 0;
+    theLayout->mNumberChannelDescriptions = kNumber_Of_Channels;
+    for(UInt32 i = 0; i < kNumber_Of_Channels; ++i)
+    {
+        theLayout->mChannelDescriptions[i].mChannelLabel = kAudioChannelLabel_Left + i;
+        theLayout->mChannelDescriptions[i].mChannelFlags = 0;
+        theLayout->mChannelDescriptions[i].mCoordinates[0] = 0;
+        theLayout->mChannelDescriptions[i].mCoordinates[1] = 0;
+        theLayout->mChannelDescriptions[i].mCoordinates[2] = 0;
     }
+}
 
+static void device_set_clock_rate(struct Device* device, Float64 sample_rate)
+{
+	//	every supported rate is integral, so the clock can keep the host time mapping exact
+	struct mach_timebase_info theTimeBaseInfo;
+	mach_timebase_info(&theTimeBaseInfo);
+	device_clock_set_rate(&device->clock, theTimeBaseInfo.numer, theTimeBaseInfo.denom, (uint32_t)sample_rate, mach_absolute_time());
 }
 
-static UInt32 minimum(UInt32 a, UInt32 b) {
-    return a < b ? a : b;
+//	Wait-free, from any thread.
+static struct DeviceState device_state(struct Device* device)
+{
+	uint32_t theIndex;
+	uint32_t theTicket = snapshot_read_begin(&device->state_snapshot, &theIndex);
+	struct DeviceState theState = device->states[theIndex];
+	snapshot_read_end(&device->state_snapshot, theTicket);
+	return theState;
 }
 
-static bool is_valid_sample_rate(Float64 sample_rate)
+//	The caller holds the state mutex, which keeps the current state from changing under it.
+static const struct DeviceState* device_state_current(const struct Device* device)
 {
-    for(UInt32 i = 0; i < kDevice_SampleRatesSize; i++)
-    {
-        if (sample_rate == kDevice_SampleRates[i])
-        {
-            return true;
-        }
-    }
+	return &device->states[snapshot_current_index(&device->state_snapshot)];
+}
 
-    return false;
+//	The caller holds the state mutex. Returns a copy of the current state to change and then hand to
+//	device_state_publish.
+static struct DeviceState* device_state_edit(struct Device* device)
+{
+	struct DeviceState* theState = &device->states[snapshot_write_index(&device->state_snapshot)];
+	*theState = *device_state_current(device);
+	return theState;
 }
 
-#pragma mark Factory
+//	The caller holds the state mutex. Returns once no reader can still see the previous state.
+static void device_state_publish(struct Device* device)
+{
+	snapshot_publish(&device->state_snapshot);
+}
 
-void*	_Create(CFAllocatorRef inAllocator, CFUUIDRef inRequestedTypeUUID)
+static Float32 device_control_gain(const struct DeviceState* state, UInt32 scope, UInt32 element)
 {
-	#pragma unused(inAllocator)
-    void* result = NULL;
-    if(CFEqual(inRequestedTypeUUID, kAudioServerPlugInTypeUUID))
-    {
-		result = g_driver_ref;
-    }
-    return result;
+	Float32 theVolume = kEnableVolumeControl ? state->volume_value[scope][element] : 1.0f;
+	return state->mute_value[scope][element] ? 0.0f : theVolume;
 }
 
-#pragma mark Inheritence
+static void device_controls_fill(struct DeviceControls* controls, const struct Device* device, const struct DeviceState* state)
+{
+	controls->is_active[kControlScope_Input] = device->has_input && state->stream_input_is_active;
+	controls->is_active[kControlScope_Output] = device->has_output && state->stream_output_is_active;
+	for(UInt32 theScope = 0; theScope < kControlScope_Count; ++theScope)
+	{
+		Float32 theMaster = device_control_gain(state, theScope, kAudioObjectPropertyElementMain);
+		controls->is_uniform[theScope] = true;
+		for(UInt32 theChannel = 0; theChannel < kNumber_Of_Channels; ++theChannel)
+		{
+			controls->gain[theScope][theChannel] = theMaster * device_control_gain(state, theScope, theChannel + 1);
+			controls->is_uniform[theScope] &= (controls->gain[theScope][theChannel] == controls->gain[theScope][0]);
+		}
+	}
+	controls->safety_offset = kLatency_Profiles[state->latency_profile].safety_offset;
+	controls->zero_time_stamp_period = kLatency_Profiles[state->latency_profile].zero_time_stamp_period;
+	controls->max_io_frames = latency_profile_max_io_frames(state->latency_profile);
+}
 
-static HRESULT	_QueryInterface(void* in_driver, REFIID inUUID, LPVOID* outInterface)
+//	The caller holds the state mutex and has published the state the controls come from. The IO thread
+//	picks them up at its next operation.
+static void device_controls_publish(struct Device* device)
 {
-	//	declare the local variables
-	HRESULT result = 0;
-	CFUUIDRef theRequestedUUID = NULL;
-	
-	theRequestedUUID = CFUUIDCreateFromUUIDBytes(NULL, inUUID);
+	device_controls_fill(&device->controls[triple_buffer_write_index(&device->controls_buffer)], device, device_state_current(device));
+	triple_buffer_publish(&device->controls_buffer);
+}
 
-	if(CFEqual(theRequestedUUID, IUnknownUUID) || CFEqual(theRequestedUUID, kAudioServerPlugInDriverInterfaceUUID))
+//	Only from the device's IO thread. Costs one relaxed load unless a control changed, where
+//	device_state costs two atomic read-modify-writes on a line every reader shares.
+static const struct DeviceControls* device_controls(struct Device* device)
+{
+	return &device->controls[triple_buffer_read_index(&device->controls_buffer)];
+}
+
+//	On the IO thread. Reads the device's own ring and, when it is a bus, mixes in every source's ring at
+//	the same host time, scaled by the source's bus gain, before the input gain goes on the whole mix.
+//	A source at another sample rate, or with nothing but silence in its ring, is left out, and so is
+//	everything while the input is muted. A device without sources costs one relaxed load more than its
+//	own ring. The count can lag the list by a cycle either way, which only ever leaves a new source out
+//	or takes the snapshot for an empty list.
+static void device_read_input(struct Device* device, SInt64 sample_time, UInt32 frame_count, float* out)
+{
+	if(atomic_load_explicit(&device->bus_source_count, memory_order_relaxed) == 0)
 	{
-		pthread_mutex_lock(&gPlugIn_StateMutex);
-		++gPlugIn_RefCount;
-		pthread_mutex_unlock(&gPlugIn_StateMutex);
-		*outInterface = g_driver_ref;
+		ring_buffer_read(&device->ring, sample_time, frame_count, &device->io_input_gain, out);
+		return;
+	}
+	UInt32 theIndex;
+	UInt32 theTicket = snapshot_read_begin(&device->bus_snapshot, &theIndex);
+	const struct BusSources* theSources = &device->bus_sources[theIndex];
+	if((theSources->count == 0) || ring_gain_is_muted(&device->io_input_gain))
+	{
+		ring_buffer_read(&device->ring, sample_time, frame_count, &device->io_input_gain, out);
 	}
 	else
 	{
-		result = E_NOINTERFACE;
+		alignas(kCacheLine_Size) float theScratch[kBus_ChunkFrames * kNumber_Of_Channels];
+		struct RingGain theUnity = ring_gain_steady(1.0f);
+		ring_buffer_read(&device->ring, sample_time, frame_count, &theUnity, out);
+		for(UInt32 theSource = 0; theSource < theSources->count; ++theSource)
+		{
+			const struct Device* theDevice = theSources->devices[theSource];
+			int64_t theSampleTime;
+			if((theSources->gain[theSource] == 0.0f) || ring_buffer_is_silent(&theDevice->ring) || !device_clock_translate(&device->clock, &theDevice->clock, sample_time, &theSampleTime))
+			{
+				continue;
+			}
+			for(UInt32 theOffset = 0; theOffset < frame_count; theOffset += kBus_ChunkFrames)
+			{
+				UInt32 theFrameCount = (frame_count - theOffset < kBus_ChunkFrames) ? (frame_count - theOffset) : kBus_ChunkFrames;
+				if(ring_buffer_read(&theDevice->ring, theSampleTime + theOffset, theFrameCount, &theUnity, theScratch))
+				{
+					gKernels.sum(out + (size_t)theOffset * kNumber_Of_Channels, theScratch, theFrameCount * kNumber_Of_Channels, theSources->gain[theSource]);
+				}
+			}
+		}
+		ring_buffer_apply_gain(&device->ring, &device->io_input_gain, out, frame_count);
 	}
-	
-	//	make sure to release the UUID we created
-	CFRelease(theRequestedUUID);
-    
-	return result;
+	snapshot_read_end(&device->bus_snapshot, theTicket);
 }
 
-static ULONG	_AddRef(void* in_driver)
+//	The caller holds the state mutex, and calls this after any change to the client table.
+static void device_clients_count_delayed(struct Device* device)
 {
-	//	declare the local variables
-	ULONG result = 0;
-	
-	//	increment the refcount
-	pthread_mutex_lock(&gPlugIn_StateMutex);
-	if(gPlugIn_RefCount < UINT32_MAX)
+	UInt32 theCount = 0;
+	for(UInt32 theIndex = 0; theIndex < kMax_Number_Of_Clients; ++theIndex)
 	{
-		++gPlugIn_RefCount;
+		const struct DeviceClient* theClient = &device->clients[theIndex];
+		if((atomic_load_explicit(&theClient->client_id, memory_order_relaxed) != 0) && (atomic_load_explicit(&theClient->delay_frames, memory_order_relaxed) > 0))
+		{
+			++theCount;
+		}
 	}
-	result = gPlugIn_RefCount;
-	pthread_mutex_unlock(&gPlugIn_StateMutex);
-
-	return result;
+	atomic_store_explicit(&device->delayed_client_count, theCount, memory_order_relaxed);
 }
 
-static ULONG	_Release(void* in_driver)
+//	The caller holds the state mutex. A new client of a process that already has one reads with the
+//	same delay. Fails when the table is full, since a client without a slot couldn't be delayed.
+static OSStatus device_client_add(struct Device* device, UInt32 client_id, pid_t pid)
 {
-	//	declare the local variables
-	ULONG result = 0;
-	
-	//	decrement the refcount
-	pthread_mutex_lock(&gPlugIn_StateMutex);
-	if(gPlugIn_RefCount > 0)
+	struct DeviceClient* theFreeClient = NULL;
+	UInt32 theDelay = 0;
+	for(UInt32 theIndex = 0; theIndex < kMax_Number_Of_Clients; ++theIndex)
 	{
-		--gPlugIn_RefCount;
+		struct DeviceClient* theClient = &device->clients[theIndex];
+		if(atomic_load_explicit(&theClient->client_id, memory_order_relaxed) == 0)
+		{
+			theFreeClient = (theFreeClient == NULL) ? theClient : theFreeClient;
+		}
+		else if(theClient->pid == pid)
+		{
+			theDelay = atomic_load_explicit(&theClient->delay_frames, memory_order_relaxed);
+		}
 	}
-	result = gPlugIn_RefCount;
-	pthread_mutex_unlock(&gPlugIn_StateMutex);
-
-	return result;
+	if(theFreeClient == NULL)
+	{
+		return kAudioHardwareIllegalOperationError;
+	}
+	theFreeClient->pid = pid;
+	atomic_store_explicit(&theFreeClient->delay_frames, theDelay, memory_order_relaxed);
+	atomic_store_explicit(&theFreeClient->client_id, client_id, memory_order_release);
+	device_clients_count_delayed(device);
+	return 0;
 }
 
-#pragma mark Basic Operations
-
-static OSStatus	_Initialize(AudioServerPlugInDriverRef in_driver, AudioServerPlugInHostRef inHost)
+//	The caller holds the state mutex.
+static void device_client_remove(struct Device* device, UInt32 client_id)
 {
-
-	//	declare the local variables
-	OSStatus result = 0;
-	
-	//	store the AudioServerPlugInHostRef
-	gPlugIn_Host = inHost;
-	
-	//	initialize the box acquired property from the settings
-	CFPropertyListRef theSettingsData = NULL;
-	gPlugIn_Host->CopyFromStorage(gPlugIn_Host, CFSTR("box acquired"), &theSettingsData);
-	if(theSettingsData != NULL)
+	for(UInt32 theIndex = 0; theIndex < kMax_Number_Of_Clients; ++theIndex)
 	{
-		if(CFGetTypeID(theSettingsData) == CFBooleanGetTypeID())
-		{
-			gBox_Acquired = CFBooleanGetValue((CFBooleanRef)theSettingsData);
-		}
-		else if(CFGetTypeID(theSettingsData) == CFNumberGetTypeID())
+		if(atomic_load_explicit(&device->clients[theIndex].client_id, memory_order_relaxed) == client_id)
 		{
-			SInt32 theValue = 0;
-			CFNumberGetValue((CFNumberRef)theSettingsData, kCFNumberSInt32Type, &theValue);
-			gBox_Acquired = theValue ? 1 : 0;
+			atomic_store_explicit(&device->clients[theIndex].client_id, 0, memory_order_relaxed);
 		}
-		CFRelease(theSettingsData);
 	}
-	
-	//	initialize the box name from the settings
-	gPlugIn_Host->CopyFromStorage(gPlugIn_Host, CFSTR("box acquired"), &theSettingsData);
-	if(theSettingsData != NULL)
+	device_clients_count_delayed(device);
+}
+
+//	On the IO thread. The delay is capped at half the ring, which leaves the other half for the writer
+//	to run ahead of the input time, in case the latency profile shrank the ring after it was set. With
+//	no client delayed, which is the usual case, it doesn't look at the table at all.
+static UInt32 device_client_delay(struct Device* device, UInt32 client_id)
+{
+	if(atomic_load_explicit(&device->delayed_client_count, memory_order_relaxed) == 0)
 	{
-		if(CFGetTypeID(theSettingsData) == CFStringGetTypeID())
+		return 0;
+	}
+	for(UInt32 theIndex = 0; theIndex < kMax_Number_Of_Clients; ++theIndex)
+	{
+		if(atomic_load_explicit(&device->clients[theIndex].client_id, memory_order_acquire) == client_id)
 		{
-			gBox_Name = (CFStringRef)theSettingsData;
-			CFRetain(gBox_Name);
+			UInt32 theDelay = atomic_load_explicit(&device->clients[theIndex].delay_frames, memory_order_relaxed);
+			return (theDelay < device->ring.frame_count / 2) ? theDelay : device->ring.frame_count / 2;
 		}
-		CFRelease(theSettingsData);
 	}
-	
-	//	set the box name directly as a last resort
-	if(gBox_Name == NULL)
+	return 0;
+}
+
+//	The points fraction of the way from from to to, for the first channel_count channels at once.
+static void gain_ramp_points(Float32* out, const Float32* from, const Float32* to, Float32 fraction, UInt32 channel_count)
+{
+	if(kGain_Ramp_Exponential)
 	{
-		gBox_Name = CFSTR("AVC Box");
+		Float32 theFrom[kNumber_Of_Channels];
+		Float32 theTo[kNumber_Of_Channels];
+		volume_to_decibel_batch(theFrom, from, channel_count);
+		volume_to_decibel_batch(theTo, to, channel_count);
+		for(UInt32 theChannel = 0; theChannel < channel_count; ++theChannel)
+		{
+			out[theChannel] = theFrom[theChannel] + (theTo[theChannel] - theFrom[theChannel]) * fraction;
+		}
+		volume_from_decibel_batch(out, out, channel_count);
+		return;
+	}
+	for(UInt32 theChannel = 0; theChannel < channel_count; ++theChannel)
+	{
+		out[theChannel] = from[theChannel] + (to[theChannel] - from[theChannel]) * fraction;
 	}
-	
-	//	calculate the host ticks per frame
-	struct mach_timebase_info theTimeBaseInfo;
-	mach_timebase_info(&theTimeBaseInfo);
-	Float64 theHostClockFrequency = (Float64)theTimeBaseInfo.denom / (Float64)theTimeBaseInfo.numer;
-	theHostClockFrequency *= 1000000000.0;
-	gDevice_HostTicksPerFrame = theHostClockFrequency / gDevice_SampleRate;
-    return result;
 }
 
-static OSStatus	_CreateDevice(AudioServerPlugInDriverRef in_driver, CFDictionaryRef inDescription, const AudioServerPlugInClientInfo* inClientInfo, AudioObjectID* outDeviceObjectID)
+//	Only from the device's IO thread. Moves the scope's ramp frame_count frames toward the controls and
+//	returns the gain for those frames. The ramp is laid out one linear segment per transfer, so an
+//	exponential ramp costs a pair of batch conversions per IO operation rather than per sample. Once the ramp
+//	arrives the transfer takes the steady gain path, and while every channel agrees it stays on the
+//	scalar kernels.
+static struct RingGain device_gain_advance(struct GainRamp* ramp, const struct DeviceControls* controls, enum ControlScope scope, UInt32 frame_count)
 {
+	const Float32* theTarget = controls->gain[scope];
+	if(!ramp->is_primed || (kGain_Ramp_Frames == 0))
+	{
+		ramp->is_primed = true;
+		ramp->is_uniform = controls->is_uniform[scope];
+		ramp->frames_left = 0;
+		memcpy(ramp->current, theTarget, sizeof(ramp->current));
+		memcpy(ramp->target, theTarget, sizeof(ramp->target));
+	}
+	else if(memcmp(ramp->target, theTarget, sizeof(ramp->target)) != 0)
+	{
+		if(ramp->is_uniform && !controls->is_uniform[scope])
+		{
+			for(UInt32 theChannel = 1; theChannel < kNumber_Of_Channels; ++theChannel)
+			{
+				ramp->current[theChannel] = ramp->current[0];
+			}
+			ramp->is_uniform = false;
+		}
+		memcpy(ramp->target, theTarget, sizeof(ramp->target));
+		ramp->frames_left = kGain_Ramp_Frames;
+	}
 
-	#pragma unused(inDescription, inClientInfo, outDeviceObjectID)
-	
-	//	declare the local variables
-	OSStatus result = kAudioHardwareUnsupportedOperationError;
-	
-	return result;
+	struct RingGain theGain = ring_gain_steady(ramp->target[0]);
+	if(ramp->frames_left == 0)
+	{
+		if(!ramp->is_uniform)
+		{
+			theGain.channel_target = ramp->target;
+		}
+		return theGain;
+	}
+
+	UInt32 theRampFrames = (frame_count < ramp->frames_left) ? frame_count : ramp->frames_left;
+	Float32 theFraction = (Float32)theRampFrames / (Float32)ramp->frames_left;
+	UInt32 theChannelCount = ramp->is_uniform ? 1 : kNumber_Of_Channels;
+	Float32 theEnd[kNumber_Of_Channels];
+	if(theRampFrames < ramp->frames_left)
+	{
+		gain_ramp_points(theEnd, ramp->current, ramp->target, theFraction, theChannelCount);
+	}
+	else
+	{
+		memcpy(theEnd, ramp->target, sizeof(theEnd));
+	}
+	for(UInt32 theChannel = 0; theChannel < theChannelCount; ++theChannel)
+	{
+		ramp->start[theChannel] = ramp->current[theChannel];
+		ramp->step[theChannel] = (theEnd[theChannel] - ramp->current[theChannel]) / (Float32)theRampFrames;
+		ramp->current[theChannel] = theEnd[theChannel];
+	}
+	ramp->frames_left -= theRampFrames;
+
+	theGain.ramp_frames = theRampFrames;
+	if(ramp->is_uniform)
+	{
+		theGain.start = ramp->start[0];
+		theGain.step = ramp->step[0];
+	}
+	else
+	{
+		theGain.channel_start = ramp->start;
+		theGain.channel_step = ramp->step;
+		theGain.channel_target = ramp->target;
+	}
+
+	//	arrived, so from here on the channels agree exactly when the controls say they do
+	if(ramp->frames_left == 0)
+	{
+		ramp->is_uniform = controls->is_uniform[scope];
+	}
+	return theGain;
 }
 
-static OSStatus	_DestroyDevice(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID)
+//	any role but kObjectRole_Device
+static const struct ObjectInfo* object_info(enum ObjectRole role)
 {
+    return &gDevice_ObjectTemplate[role - 1];
+}
 
-	#pragma unused(inDeviceObjectID)
-	
-	//	declare the local variables
-	OSStatus result = kAudioHardwareUnsupportedOperationError;
-	
-	return result;
+//	Called by _Initialize before any device exists. Idempotent.
+static void object_template_build(void)
+{
+    static const struct {
+        enum ObjectRole             first_role;
+        enum ObjectType             type;
+        AudioObjectPropertyScope    scope;
+    } kChannel_Controls[] = {
+        { kObjectRole_Volume_Input_Channel,     kObjectType_Volume,     kAudioObjectPropertyScopeInput  },
+        { kObjectRole_Mute_Input_Channel,       kObjectType_Mute,       kAudioObjectPropertyScopeInput  },
+        { kObjectRole_Volume_Output_Channel,    kObjectType_Volume,     kAudioObjectPropertyScopeOutput },
+        { kObjectRole_Mute_Output_Channel,      kObjectType_Mute,       kAudioObjectPropertyScopeOutput },
+    };
+
+    for(UInt32 i = 0; i < sizeof(kChannel_Controls) / sizeof(kChannel_Controls[0]); i++)
+    {
+        for(UInt32 theChannel = 0; theChannel < kNumber_Of_Channels; ++theChannel)
+        {
+            enum ObjectRole theRole = kChannel_Controls[i].first_role + theChannel;
+            gDevice_ObjectTemplate[theRole - 1] = (struct ObjectInfo){ theRole, kChannel_Controls[i].type, kChannel_Controls[i].scope, theChannel + 1 };
+        }
+    }
 }
 
-static OSStatus	_AddDeviceClient(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, const AudioServerPlugInClientInfo* inClientInfo)
+static struct Device* device_for_object(AudioObjectID inObjectID)
 {
+    if((inObjectID < kObjectID_Device) || (inObjectID >= kObjectID_Device + kMax_Number_Of_Devices * kObjectRole_Count))
+    {
+        return NULL;
+    }
 
-	#pragma unused(inClientInfo)
-	
-	//	declare the local variables
-	OSStatus result = 0;
-	
-	return result;
+    struct Device* theDevice = &gDevices[(inObjectID - kObjectID_Device) / kObjectRole_Count];
+    return atomic_load_explicit(&theDevice->is_alive, memory_order_acquire) ? theDevice : NULL;
 }
 
-static OSStatus	_RemoveDeviceClient(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, const AudioServerPlugInClientInfo* inClientInfo)
+//	Takes the device's state mutex for a handler that touches what device_destroy releases under it:
+//	the strings and the ring. The device was alive when the call was resolved, but it can have been
+//	destroyed since, so that is checked again under the mutex. Returns false, without the mutex held,
+//	when the device is gone.
+static bool device_lock_alive(struct Device* device)
 {
+    pthread_mutex_lock(&device->state_mutex);
+    if(atomic_load_explicit(&device->is_alive, memory_order_relaxed))
+    {
+        return true;
+    }
+    pthread_mutex_unlock(&device->state_mutex);
+    return false;
+}
 
-	#pragma unused(inClientInfo)
-	
-	//	declare the local variables
-	OSStatus result = 0;
-	
-	return result;
+//	The caller holds gPlugIn_StateMutex.
+static UInt32 device_bus_source_count(const struct Device* bus)
+{
+    UInt32 theCount = 0;
+    for(UInt32 i = 0; i < kMax_Number_Of_Devices; i++)
+    {
+        theCount += (atomic_load_explicit(&gDevices[i].is_alive, memory_order_relaxed) && (gDevices[i].bus == bus)) ? 1 : 0;
+    }
+    return theCount;
 }
 
-static OSStatus	_PerformDeviceConfigurationChange(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, UInt64 inChangeAction, void* inChangeInfo)
+//	The caller holds gPlugIn_StateMutex.
+static struct Device* device_for_uid(CFStringRef uid)
 {
+    for(UInt32 i = 0; i < kMax_Number_Of_Devices; i++)
+    {
+        if(atomic_load_explicit(&gDevices[i].is_alive, memory_order_relaxed) && (CFStringCompare(uid, gDevices[i].uid, 0) == kCFCompareEqualTo))
+        {
+            return &gDevices[i];
+        }
+    }
+    return NULL;
+}
 
-	#pragma unused(inChangeInfo)
+static enum ObjectRole object_role(AudioObjectID inObjectID)
+{
+    struct Device* theDevice = device_for_object(inObjectID);
+    if(theDevice == NULL)
+    {
+        return kObjectRole_None;
+    }
 
-	//	declare the local variables
-	OSStatus result = 0;
-	    
-	
-	//	lock the state mutex
-	pthread_mutex_lock(&gPlugIn_StateMutex);
-	
-	//	change the sample rate
-	gDevice_SampleRate = inChangeAction;
-	
-	//	recalculate the state that depends on the sample rate
-	struct mach_timebase_info theTimeBaseInfo;
-	mach_timebase_info(&theTimeBaseInfo);
-    Float64 theHostClockFrequency = (Float64)theTimeBaseInfo.denom / (Float64)theTimeBaseInfo.numer;
-	theHostClockFrequency *= 1000000000.0;
-	gDevice_HostTicksPerFrame = theHostClockFrequency / gDevice_SampleRate;
+    enum ObjectRole theRole = (enum ObjectRole)(inObjectID - theDevice->object_id);
+    if(theRole == kObjectRole_Device)
+    {
+        return theRole;
+    }
+    bool theIsInput = object_info(theRole)->scope == kAudioObjectPropertyScopeInput;
+    return (theIsInput ? theDevice->has_input : theDevice->has_output) ? theRole : kObjectRole_None;
+}
 
-	//	unlock the state mutex
-	pthread_mutex_unlock(&gPlugIn_StateMutex);
-    
-	return result;
+static void object_id_list_append(struct ObjectIDList* list, AudioObjectID id)
+{
+    list->ids[list->count++] = id;
 }
 
-static OSStatus	_AbortDeviceConfigurationChange(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, UInt64 inChangeAction, void* inChangeInfo)
+static void device_build_object_lists(struct Device* device)
 {
+    memset(device->object_lists, 0, sizeof(device->object_lists));
+    for (UInt32 i = 0; i < kDevice_ObjectTemplateSize; i++)
+    {
+        bool theIsInput = gDevice_ObjectTemplate[i].scope == kAudioObjectPropertyScopeInput;
+        if (theIsInput ? device->has_input : device->has_output)
+        {
+            AudioObjectID theID = device->object_id + gDevice_ObjectTemplate[i].id;
+            enum ObjectListScope theScope = theIsInput ? kObjectListScope_Input : kObjectListScope_Output;
+            enum ObjectList theList = (gDevice_ObjectTemplate[i].type == kObjectType_Stream) ? kObjectList_Streams : kObjectList_Controls;
+
+            object_id_list_append(&device->object_lists[kObjectList_Owned][kObjectListScope_Global], theID);
+            object_id_list_append(&device->object_lists[kObjectList_Owned][theScope], theID);
+            object_id_list_append(&device->object_lists[theList][kObjectListScope_Global], theID);
+            object_id_list_append(&device->object_lists[theList][theScope], theID);
+        }
+    }
+}
 
-	#pragma unused(inChangeAction, inChangeInfo)
+//	the device objects have nothing in any scope other than global, input and output
+static const struct ObjectIDList* device_object_ids(const struct Device* device, enum ObjectList list, AudioObjectPropertyScope scope)
+{
+    static const struct ObjectIDList kEmpty_ObjectIDList = { 0 };
+    switch(scope)
+    {
+        case kAudioObjectPropertyScopeGlobal:
+            return &device->object_lists[list][kObjectListScope_Global];
 
-	//	declare the local variables
-	OSStatus result = 0;
+        case kAudioObjectPropertyScopeInput:
+            return &device->object_lists[list][kObjectListScope_Input];
 
-	return result;
+        case kAudioObjectPropertyScopeOutput:
+            return &device->object_lists[list][kObjectListScope_Output];
+
+        default:
+            return &kEmpty_ObjectIDList;
+    }
 }
 
-#pragma mark Property Operations
+//	Rebuilds the list of the devices that feed bus, leaving out skip, and publishes it. When it returns
+//	the bus's IO thread no longer reads any device that isn't in the list. The caller holds
+//	gPlugIn_StateMutex.
+static void device_bus_publish(struct Device* bus, const struct Device* skip)
+{
+    pthread_mutex_lock(&bus->state_mutex);
+    struct BusSources* theSources = &bus->bus_sources[snapshot_write_index(&bus->bus_snapshot)];
+    theSources->count = 0;
+    for(UInt32 i = 0; (i < kMax_Number_Of_Devices) && (theSources->count < kMax_Number_Of_Bus_Sources); i++)
+    {
+        struct Device* theDevice = &gDevices[i];
+        if(atomic_load_explicit(&theDevice->is_alive, memory_order_relaxed) && (theDevice->bus == bus) && (theDevice != skip))
+        {
+            theSources->devices[theSources->count] = theDevice;
+            theSources->gain[theSources->count] = device_state(theDevice).bus_gain;
+            ++theSources->count;
+        }
+    }
+    snapshot_publish(&bus->bus_snapshot);
+    atomic_store_explicit(&bus->bus_source_count, theSources->count, memory_order_relaxed);
+    pthread_mutex_unlock(&bus->state_mutex);
+}
 
-static Boolean	_HasProperty(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress)
+//	The caller holds gPlugIn_StateMutex. Takes its own references to the description's strings.
+static OSStatus device_create(UInt32 slot, const struct DeviceDescription* description)
 {
+    struct Device* theDevice = &gDevices[slot];
+
+    pthread_mutex_lock(&theDevice->state_mutex);
+    theDevice->object_id = kObjectID_Device + slot * kObjectRole_Count;
+    theDevice->uid = CFRetain(description->uid);
+    theDevice->name = CFRetain(description->name);
+    theDevice->is_hidden = description->is_hidden;
+    theDevice->has_input = description->has_input;
+    theDevice->has_output = description->has_output;
+    theDevice->bus = description->bus;
+    device_build_object_lists(theDevice);
+
+    theDevice->io_is_running = 0;
+    for(UInt32 theIndex = 0; theIndex < kMax_Number_Of_Clients; ++theIndex)
+    {
+        atomic_store_explicit(&theDevice->clients[theIndex].client_id, 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&theDevice->delayed_client_count, 0, memory_order_relaxed);
+
+    //	nobody can read the state of a device that isn't alive yet, so it can be set up in place
+    snapshot_init(&theDevice->state_snapshot);
+    struct DeviceState* theState = &theDevice->states[snapshot_current_index(&theDevice->state_snapshot)];
+    theState->sample_rate = 44100.0;
+    theState->latency_profile = description->latency_profile;
+    theState->is_running = false;
+    theState->stream_input_is_active = true;
+    theState->stream_output_is_active = true;
+    for(UInt32 theScope = 0; theScope < kControlScope_Count; ++theScope)
+    {
+        for(UInt32 theElement = 0; theElement < kControl_ElementCount; ++theElement)
+        {
+            theState->mute_value[theScope][theElement] = false;
+            theState->volume_value[theScope][theElement] = 1.0;
+        }
+    }
+    theState->bus_gain = 1.0f;
+    for(UInt32 theIndex = 0; theIndex < 3; ++theIndex)
+    {
+        device_controls_fill(&theDevice->controls[theIndex], theDevice, theState);
+    }
+    triple_buffer_init(&theDevice->controls_buffer);
+    snapshot_init(&theDevice->bus_snapshot);
+    theDevice->bus_sources[snapshot_current_index(&theDevice->bus_snapshot)].count = 0;
+    atomic_store_explicit(&theDevice->bus_source_count, 0, memory_order_relaxed);
 
-	Boolean result = false;
-    switch(inObjectID)
-	{
-		case kObjectID_PlugIn:
-			result = _HasPlugInProperty(in_driver, inObjectID, inClientProcessID, inAddress);
-			break;
-		
-		case kObjectID_Box:
-			result = hasbox_property(inClientProcessID, inAddress);
-			break;
-		
-		case kObjectID_Device:
-        case kObjectID_Device2:
-			result = has_device_property(inClientProcessID, inAddress);
-			break;
-		
-		case kObjectID_Stream_Input:
-		case kObjectID_Stream_Output:
-			result = has_stream_property(inClientProcessID, inAddress);
-			break;
-		
-		case kObjectID_Volume_Output_Master:
-		case kObjectID_Mute_Output_Master:
-        case kObjectID_Volume_Input_Master:
-        case kObjectID_Mute_Input_Master:
-			result = _HasControlProperty(in_driver, inObjectID, inClientProcessID, inAddress);
-			break;
-	};
+    //	calculate the host ticks per frame
+    device_set_clock_rate(theDevice, theState->sample_rate);
 
-	return result;
+    //	the ring lives for as long as the device, StartIO only rewinds it
+    bool theRingIsReady = ring_buffer_allocate(&theDevice->ring, kLatency_Profiles[theState->latency_profile].ring_frame_count, kNumber_Of_Channels, kRing_Buffer_Locked);
+    if(!theRingIsReady)
+    {
+        CFRelease(theDevice->uid);
+        CFRelease(theDevice->name);
+        theDevice->uid = NULL;
+        theDevice->name = NULL;
+    }
+    pthread_mutex_unlock(&theDevice->state_mutex);
+
+    if(!theRingIsReady)
+    {
+        DebugMsg("device_create: failed to allocate the ring buffer");
+        return kAudioHardwareUnspecifiedError;
+    }
+
+    atomic_store_explicit(&theDevice->is_alive, true, memory_order_release);
+    ++gDevice_Count;
+    if(theDevice->bus != NULL)
+    {
+        device_bus_publish(theDevice->bus, NULL);
+    }
+    return 0;
 }
 
-static OSStatus	_IsPropertySettable(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable)
+//	The caller holds gPlugIn_StateMutex.
+static OSStatus device_destroy(struct Device* device)
 {
+    pthread_mutex_lock(&device->state_mutex);
+    if(device->io_is_running > 0)
+    {
+        pthread_mutex_unlock(&device->state_mutex);
+        return kAudioHardwareIllegalOperationError;
+    }
 
-	OSStatus result = 0;
-	
-	switch(inObjectID)
-	{
-		case kObjectID_PlugIn:
-			result = _IsPlugInPropertySettable(in_driver, inObjectID, inClientProcessID, inAddress, outIsSettable);
-			break;
-		
-		case kObjectID_Box:
-			result = box_property_settable(inClientProcessID, inAddress, outIsSettable);
-			break;
-		
-		case kObjectID_Device:
-        case kObjectID_Device2:
-			result = device_property_settable(inClientProcessID, inAddress, outIsSettable);
-			break;
-		
-		case kObjectID_Stream_Input:
-		case kObjectID_Stream_Output:
-			result = stream_property(inClientProcessID, inAddress, outIsSettable);
-			break;
-		
-		case kObjectID_Volume_Output_Master:
-		case kObjectID_Mute_Output_Master:
-        case kObjectID_Volume_Input_Master:
-        case kObjectID_Mute_Input_Master:
-			result = _IsControlPropertySettable(in_driver, inObjectID, inClientProcessID, inAddress, outIsSettable);
-			break;
-				
-		default:
-			result = kAudioHardwareBadObjectError;
-			break;
-	};
+    atomic_store_explicit(&device->is_alive, false, memory_order_release);
 
-	return result;
+    //	the bus's IO thread has to be done with the ring before it goes, and a bus takes its sources
+    //	with it
+    if(device->bus != NULL)
+    {
+        device_bus_publish(device->bus, NULL);
+        device->bus = NULL;
+    }
+    for(UInt32 i = 0; i < kMax_Number_Of_Devices; i++)
+    {
+        if(gDevices[i].bus == device)
+        {
+            gDevices[i].bus = NULL;
+        }
+    }
+
+    ring_buffer_free(&device->ring);
+    CFRelease(device->uid);
+    CFRelease(device->name);
+    device->uid = NULL;
+    device->name = NULL;
+    pthread_mutex_unlock(&device->state_mutex);
+
+    --gDevice_Count;
+    return 0;
 }
 
-static OSStatus	_GetPropertyDataSize(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
+//	The caller holds gPlugIn_StateMutex. Writes up to max_count device IDs in slot order and returns
+//	how many it wrote.
+static UInt32 device_list(AudioObjectID* out_ids, UInt32 max_count)
 {
+    UInt32 theCount = 0;
+    for(UInt32 i = 0; (i < kMax_Number_Of_Devices) && (theCount < max_count); i++)
+    {
+        if(atomic_load_explicit(&gDevices[i].is_alive, memory_order_relaxed))
+        {
+            out_ids[theCount++] = gDevices[i].object_id;
+        }
+    }
+    return theCount;
+}
 
-	OSStatus result = 0;
-	
-	switch(inObjectID)
-	{
-		case kObjectID_PlugIn:
-			result = getplugIn_property_size(in_driver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, outDataSize);
-			break;
-		
-		case kObjectID_Box:
-			result = getbox_property_datasize(inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, outDataSize);
-			break;
-		
-		case kObjectID_Device:
-        case kObjectID_Device2:
-			result = get_device_property_size(  inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, outDataSize);
-			break;
-		
-		case kObjectID_Stream_Input:
-		case kObjectID_Stream_Output:
-			result = _GetStreamPropertyDataSize(in_driver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, outDataSize);
-			break;
-		
-		case kObjectID_Volume_Output_Master:
-		case kObjectID_Mute_Output_Master:
-        case kObjectID_Volume_Input_Master:
-        case kObjectID_Mute_Input_Master:
-			result = _GetControlPropertyDataSize(in_driver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, outDataSize);
-			break;
-				
-		default:
-			result = kAudioHardwareBadObjectError;
-			break;
-	};
-
-	return result;
+static void notify_device_list_changed_async(void* inContext)
+{
+    #pragma unused(inContext)
+    AudioObjectPropertyAddress thePlugInAddress = { kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+    AudioObjectPropertyAddress theBoxAddress = { kAudioBoxPropertyDeviceList, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+    gPlugIn_Host->PropertiesChanged(gPlugIn_Host, kObjectID_PlugIn, 1, &thePlugInAddress);
+    gPlugIn_Host->PropertiesChanged(gPlugIn_Host, kObjectID_Box, 1, &theBoxAddress);
 }
 
-static OSStatus	_GetPropertyData(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+static void notify_device_list_changed(void)
 {
-	//	declare the local variables
-	OSStatus result = 0;
-	
+    dispatch_async_f(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), NULL, notify_device_list_changed_async);
+}
 
-	switch(inObjectID)
-	{
-		case kObjectID_PlugIn:
-			result = _GetPlugInPropertyData(in_driver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, outDataSize, outData);
-			break;
-		
-		case kObjectID_Box:
-			result = getbox_property_data( inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, outDataSize, outData);
-			break;
-		
-		case kObjectID_Device:
-        case kObjectID_Device2:
-			result = get_device_property( inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, outDataSize, outData);
-			break;
-		
-		case kObjectID_Stream_Input:
-		case kObjectID_Stream_Output:
-			result = _GetStreamPropertyData(in_driver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, outDataSize, outData);
-			break;
-		
-		case kObjectID_Volume_Output_Master:
-		case kObjectID_Mute_Output_Master:
-        case kObjectID_Volume_Input_Master:
-        case kObjectID_Mute_Input_Master:
-			result = _GetControlPropertyData(in_driver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, outDataSize, outData);
-			break;
-				
-		default:
-			result = kAudioHardwareBadObjectError;
-			break;
-	};
+//	A configuration change is asked for from a property setter but has to reach the host from
+//	outside it, so the request is carried over to the global queue on the heap.
+struct ConfigurationChangeRequest {
+    AudioObjectID device_object_id;
+    UInt64 action;
+};
 
-	return result;
+static void request_configuration_change_async(void* inContext)
+{
+    struct ConfigurationChangeRequest* theRequest = (struct ConfigurationChangeRequest*)inContext;
+    gPlugIn_Host->RequestDeviceConfigurationChange(gPlugIn_Host, theRequest->device_object_id, theRequest->action, NULL);
+    free(theRequest);
 }
 
-static OSStatus	_SetPropertyData(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, const void* inData)
+static OSStatus request_configuration_change(AudioObjectID device_object_id, UInt64 action)
 {
-	//	declare the local variables
-	OSStatus result = 0;
-	UInt32 theNumberPropertiesChanged = 0;
-	AudioObjectPropertyAddress theChangedAddresses[2];
-	
-	switch(inObjectID)
-	{
-		case kObjectID_PlugIn:
-			result = set_propertyData(inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, inData, &theNumberPropertiesChanged, theChangedAddresses);
-			break;
-		
-		case kObjectID_Box:
-			result = set_box_property( inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, inData, &theNumberPropertiesChanged, theChangedAddresses);
-			break;
-		
-		case kObjectID_Device:
-        case kObjectID_Device2:
-			result = set_device_property(inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, inData, &theNumberPropertiesChanged, theChangedAddresses);
-			break;
-		
-		case kObjectID_Stream_Input:
-		case kObjectID_Stream_Output:
-			result = _SetStreamPropertyData(in_driver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, inData, &theNumberPropertiesChanged, theChangedAddresses);
-			break;
-		
-		case kObjectID_Volume_Output_Master:
-		case kObjectID_Mute_Output_Master:
-        case kObjectID_Volume_Input_Master:
-        case kObjectID_Mute_Input_Master:
-			result = _SetControlPropertyData(in_driver, inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, inData, &theNumberPropertiesChanged, theChangedAddresses);
-			break;
-				
-		default:
-			result = kAudioHardwareBadObjectError;
-			break;
-	};
-
-	//	send any notifications
-	if(theNumberPropertiesChanged > 0)
-	{
-		gPlugIn_Host->PropertiesChanged(gPlugIn_Host, inObjectID, theNumberPropertiesChanged, theChangedAddresses);
-	}
+    struct ConfigurationChangeRequest* theRequest = (struct ConfigurationChangeRequest*)malloc(sizeof(struct ConfigurationChangeRequest));
+    if(theRequest == NULL)
+    {
+        return kAudioHardwareUnspecifiedError;
+    }
+    theRequest->device_object_id = device_object_id;
+    theRequest->action = action;
+    dispatch_async_f(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), theRequest, request_configuration_change_async);
+    return 0;
+}
 
-	return result;
+static UInt32 minimum(UInt32 a, UInt32 b) {
+    return a < b ? a : b;
 }
 
-#pragma mark PlugIn Property Operations
+static bool is_valid_sample_rate(Float64 sample_rate)
+{
+    for(UInt32 i = 0; i < kDevice_SampleRatesSize; i++)
+    {
+        if (sample_rate == kDevice_SampleRates[i])
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+#pragma mark Factory
+
+void*	_Create(CFAllocatorRef inAllocator, CFUUIDRef inRequestedTypeUUID)
+{
+	#pragma unused(inAllocator)
+    void* result = NULL;
+    if(CFEqual(inRequestedTypeUUID, kAudioServerPlugInTypeUUID))
+    {
+		result = g_driver_ref;
+    }
+    return result;
+}
+
+#pragma mark Inheritence
 
-static Boolean	_HasPlugInProperty(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress)
+static HRESULT	_QueryInterface(void* in_driver, REFIID inUUID, LPVOID* outInterface)
 {
-	//	This method returns whether or not the plug-in object has the given property.
+	//	declare the local variables
+	HRESULT result = 0;
+	CFUUIDRef theRequestedUUID = NULL;
 	
-	#pragma unused(inClientProcessID)
+	theRequestedUUID = CFUUIDCreateFromUUIDBytes(NULL, inUUID);
+
+	if(CFEqual(theRequestedUUID, IUnknownUUID) || CFEqual(theRequestedUUID, kAudioServerPlugInDriverInterfaceUUID))
+	{
+		pthread_mutex_lock(&gPlugIn_StateMutex);
+		++gPlugIn_RefCount;
+		pthread_mutex_unlock(&gPlugIn_StateMutex);
+		*outInterface = g_driver_ref;
+	}
+	else
+	{
+		result = E_NOINTERFACE;
+	}
 	
+	//	make sure to release the UUID we created
+	CFRelease(theRequestedUUID);
+    
+	return result;
+}
+
+static ULONG	_AddRef(void* in_driver)
+{
 	//	declare the local variables
-	Boolean result = false;
+	ULONG result = 0;
 	
-	switch(inAddress->mSelector)
+	//	increment the refcount
+	pthread_mutex_lock(&gPlugIn_StateMutex);
+	if(gPlugIn_RefCount < UINT32_MAX)
 	{
-		case kAudioObjectPropertyBaseClass:
-		case kAudioObjectPropertyClass:
-		case kAudioObjectPropertyOwner:
-		case kAudioObjectPropertyManufacturer:
-		case kAudioObjectPropertyOwnedObjects:
-		case kAudioPlugInPropertyBoxList:
-		case kAudioPlugInPropertyTranslateUIDToBox:
-		case kAudioPlugInPropertyDeviceList:
-		case kAudioPlugInPropertyTranslateUIDToDevice:
-		case kAudioPlugInPropertyResourceBundle:
-			result = true;
-			break;
-	};
+		++gPlugIn_RefCount;
+	}
+	result = gPlugIn_RefCount;
+	pthread_mutex_unlock(&gPlugIn_StateMutex);
 
 	return result;
 }
 
-static OSStatus	_IsPlugInPropertySettable(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable)
+static ULONG	_Release(void* in_driver)
 {
+	//	declare the local variables
+	ULONG result = 0;
 	
-	#pragma unused(inClientProcessID)
-	
+	//	decrement the refcount
+	pthread_mutex_lock(&gPlugIn_StateMutex);
+	if(gPlugIn_RefCount > 0)
+	{
+		--gPlugIn_RefCount;
+	}
+	result = gPlugIn_RefCount;
+	pthread_mutex_unlock(&gPlugIn_StateMutex);
+
+	return result;
+}
+
+#pragma mark Basic Operations
+
+static OSStatus	_Initialize(AudioServerPlugInDriverRef in_driver, AudioServerPlugInHostRef inHost)
+{
+
 	//	declare the local variables
 	OSStatus result = 0;
 	
+	//	store the AudioServerPlugInHostRef
+	gPlugIn_Host = inHost;
 	
-	switch(inAddress->mSelector)
+	//	initialize the box acquired property from the settings
+	CFPropertyListRef theSettingsData = NULL;
+	gPlugIn_Host->CopyFromStorage(gPlugIn_Host, CFSTR("box acquired"), &theSettingsData);
+	if(theSettingsData != NULL)
 	{
-		case kAudioObjectPropertyBaseClass:
-		case kAudioObjectPropertyClass:
-		case kAudioObjectPropertyOwner:
-		case kAudioObjectPropertyManufacturer:
-		case kAudioObjectPropertyOwnedObjects:
-		case kAudioPlugInPropertyBoxList:
-		case kAudioPlugInPropertyTranslateUIDToBox:
-		case kAudioPlugInPropertyDeviceList:
-		case kAudioPlugInPropertyTranslateUIDToDevice:
-		case kAudioPlugInPropertyResourceBundle:
-			*outIsSettable = false;
-			break;
-		
-		default:
-			result = kAudioHardwareUnknownPropertyError;
-			break;
-	};
+		if(CFGetTypeID(theSettingsData) == CFBooleanGetTypeID())
+		{
+			gBox_Acquired = CFBooleanGetValue((CFBooleanRef)theSettingsData);
+		}
+		else if(CFGetTypeID(theSettingsData) == CFNumberGetTypeID())
+		{
+			SInt32 theValue = 0;
+			CFNumberGetValue((CFNumberRef)theSettingsData, kCFNumberSInt32Type, &theValue);
+			gBox_Acquired = theValue ? 1 : 0;
+		}
+		CFRelease(theSettingsData);
+	}
+	
+	//	initialize the box name from the settings
+	gPlugIn_Host->CopyFromStorage(gPlugIn_Host, CFSTR("box acquired"), &theSettingsData);
+	if(theSettingsData != NULL)
+	{
+		if(CFGetTypeID(theSettingsData) == CFStringGetTypeID())
+		{
+			gBox_Name = (CFStringRef)theSettingsData;
+			CFRetain(gBox_Name);
+		}
+		CFRelease(theSettingsData);
+	}
+	
+	//	set the box name directly as a last resort
+	if(gBox_Name == NULL)
+	{
+		gBox_Name = CFSTR("AVC Box");
+	}
+	
+	//	pick the sample kernels for this CPU before any IO can run
+	kernels_select();
 
-	return result;
+	//	index the property tables and build the values that never change before the host starts
+	//	asking about properties
+	object_template_build();
+	property_index_build();
+	property_cache_build();
+
+	for(UInt32 i = 0; i < kMax_Number_Of_Devices; i++)
+	{
+		pthread_mutex_init(&gDevices[i].state_mutex, NULL);
+	}
+	
+	//	the two built-in cables take the first two slots, which keeps their object IDs where they were
+	struct DeviceDescription theBuiltInDevices[] = {
+		{ get_device_uid(), get_device_name(), kDevice_IsHidden, kDevice_HasInput, kDevice_HasOutput, kLatencyProfile_Standard, NULL },
+		{ get_device2_uid(), get_device2_name(), kDevice2_IsHidden, kDevice2_HasInput, kDevice2_HasOutput, kLatencyProfile_Standard, NULL },
+	};
+	pthread_mutex_lock(&gPlugIn_StateMutex);
+	for(UInt32 i = 0; i < sizeof(theBuiltInDevices) / sizeof(theBuiltInDevices[0]); i++)
+	{
+		OSStatus theError = device_create(i, &theBuiltInDevices[i]);
+		if(theError != 0)
+		{
+			result = theError;
+		}
+		CFRelease(theBuiltInDevices[i].uid);
+		CFRelease(theBuiltInDevices[i].name);
+	}
+	pthread_mutex_unlock(&gPlugIn_StateMutex);
+    return result;
 }
 
-static OSStatus	getplugIn_property_size(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
+static OSStatus	_CreateDevice(AudioServerPlugInDriverRef in_driver, CFDictionaryRef inDescription, const AudioServerPlugInClientInfo* inClientInfo, AudioObjectID* outDeviceObjectID)
 {
-	//	This method returns the byte size of the property's data.
-	
-	#pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData)
+
+	#pragma unused(inClientInfo)
 	
 	//	declare the local variables
 	OSStatus result = 0;
+	UInt32 theSlot = kMax_Number_Of_Devices;
+	struct DeviceDescription theDescription = { NULL, NULL, false, true, true, kLatencyProfile_Standard, NULL };
 	
-
-	switch(inAddress->mSelector)
+	pthread_mutex_lock(&gPlugIn_StateMutex);
+	
+	//	take the lowest free slot, so IDs and default names are reused after a device goes away
+	for(UInt32 i = 0; i < kMax_Number_Of_Devices; i++)
 	{
-		case kAudioObjectPropertyBaseClass:
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyClass:
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyOwner:
-			*outDataSize = sizeof(AudioObjectID);
-			break;
-			
-		case kAudioObjectPropertyManufacturer:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyOwnedObjects:
-			if(gBox_Acquired)
-			{
-				*outDataSize = 2 * sizeof(AudioClassID);
-			}
-			else
-			{
-				*outDataSize = sizeof(AudioClassID);
-			}
-			break;
-			
-		case kAudioPlugInPropertyBoxList:
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioPlugInPropertyTranslateUIDToBox:
-			*outDataSize = sizeof(AudioObjectID);
-			break;
-			
-		case kAudioPlugInPropertyDeviceList:
-			if(gBox_Acquired)
-			{
-				*outDataSize = sizeof(AudioClassID)*2;
-			}
-			else
-			{
-				*outDataSize = 0;
-			}
-			break;
-			
-		case kAudioPlugInPropertyTranslateUIDToDevice:
-			*outDataSize = sizeof(AudioObjectID);
-			break;
-			
-		case kAudioPlugInPropertyResourceBundle:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		default:
-			result = kAudioHardwareUnknownPropertyError;
+		if(!atomic_load_explicit(&gDevices[i].is_alive, memory_order_relaxed))
+		{
+			theSlot = i;
 			break;
-	};
-
+		}
+	}
+	FailWithAction(theSlot == kMax_Number_Of_Devices, result = kAudioHardwareIllegalOperationError, Done, "_CreateDevice: no free device slot");
+	
+	//	pick up whatever the description specifies and fill in the rest
+	if(inDescription != NULL)
+	{
+		CFTypeRef theValue = CFDictionaryGetValue(inDescription, CFSTR(kDevice_DescriptionKey_UID));
+		if((theValue != NULL) && (CFGetTypeID(theValue) == CFStringGetTypeID()))
+		{
+			theDescription.uid = CFRetain(theValue);
+		}
+		theValue = CFDictionaryGetValue(inDescription, CFSTR(kDevice_DescriptionKey_Name));
+		if((theValue != NULL) && (CFGetTypeID(theValue) == CFStringGetTypeID()))
+		{
+			theDescription.name = CFRetain(theValue);
+		}
+		theValue = CFDictionaryGetValue(inDescription, CFSTR(kDevice_DescriptionKey_IsHidden));
+		if((theValue != NULL) && (CFGetTypeID(theValue) == CFBooleanGetTypeID()))
+		{
+			theDescription.is_hidden = CFBooleanGetValue((CFBooleanRef)theValue);
+		}
+		theValue = CFDictionaryGetValue(inDescription, CFSTR(kDevice_DescriptionKey_LowLatency));
+		if((theValue != NULL) && (CFGetTypeID(theValue) == CFBooleanGetTypeID()) && CFBooleanGetValue((CFBooleanRef)theValue))
+		{
+			theDescription.latency_profile = kLatencyProfile_Low;
+		}
+		theValue = CFDictionaryGetValue(inDescription, CFSTR(kDevice_DescriptionKey_Bus));
+		if((theValue != NULL) && (CFGetTypeID(theValue) == CFStringGetTypeID()))
+		{
+			theDescription.bus = device_for_uid((CFStringRef)theValue);
+			FailWithAction((theDescription.bus == NULL) || !theDescription.bus->has_input, result = kAudioHardwareIllegalOperationError, Done, "_CreateDevice: the bus is not a device with input");
+			FailWithAction(device_bus_source_count(theDescription.bus) >= kMax_Number_Of_Bus_Sources, result = kAudioHardwareIllegalOperationError, Done, "_CreateDevice: the bus already mixes as many sources as it can");
+		}
+	}
+	if(theDescription.uid == NULL)
+	{
+		theDescription.uid = get_created_device_uid(theSlot);
+	}
+	if(theDescription.name == NULL)
+	{
+		theDescription.name = get_created_device_name(theSlot);
+	}
+	
+	//	UIDs have to stay unique
+	FailWithAction(device_for_uid(theDescription.uid) != NULL, result = kAudioHardwareIllegalOperationError, Done, "_CreateDevice: a device with that UID already exists");
+	
+	result = device_create(theSlot, &theDescription);
+	FailIf(result != 0, Done, "_CreateDevice: failed to create the device");
+	*outDeviceObjectID = gDevices[theSlot].object_id;
+	notify_device_list_changed();
+	
+Done:
+	pthread_mutex_unlock(&gPlugIn_StateMutex);
+	if(theDescription.uid != NULL)
+	{
+		CFRelease(theDescription.uid);
+	}
+	if(theDescription.name != NULL)
+	{
+		CFRelease(theDescription.name);
+	}
 	return result;
 }
 
-static OSStatus    _GetStreamPropertyDataSize(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
+static OSStatus	_DestroyDevice(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID)
 {
-    //    This method returns the byte size of the property's data.
-    
-    #pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData)
-    
-    //    declare the local variables
-    OSStatus result = 0;
-    
-    
-    switch(inAddress->mSelector)
-    {
-        case kAudioObjectPropertyBaseClass:
-            *outDataSize = sizeof(AudioClassID);
-            break;
-
-        case kAudioObjectPropertyClass:
-            *outDataSize = sizeof(AudioClassID);
-            break;
-
-        case kAudioObjectPropertyOwner:
-            *outDataSize = sizeof(AudioObjectID);
-            break;
-
-        case kAudioObjectPropertyOwnedObjects:
-            *outDataSize = 0 * sizeof(AudioObjectID);
-            break;
-
-        case kAudioStreamPropertyIsActive:
-            *outDataSize = sizeof(UInt32);
-            break;
-
-        case kAudioStreamPropertyDirection:
-            *outDataSize = sizeof(UInt32);
-            break;
-
-        case kAudioStreamPropertyTerminalType:
-            *outDataSize = sizeof(UInt32);
-            break;
 
-        case kAudioStreamPropertyStartingChannel:
-            *outDataSize = sizeof(UInt32);
-            break;
-        
-        case kAudioStreamPropertyLatency:
-            *outDataSize = sizeof(UInt32);
-            break;
+	//	declare the local variables
+	OSStatus result = 0;
+	
+	pthread_mutex_lock(&gPlugIn_StateMutex);
+	
+	struct Device* theDevice = device_for_object(inDeviceObjectID);
+	FailWithAction((theDevice == NULL) || (theDevice->object_id != inDeviceObjectID), result = kAudioHardwareBadDeviceError, Done, "_DestroyDevice: bad device ID");
+	
+	result = device_destroy(theDevice);
+	FailIf(result != 0, Done, "_DestroyDevice: the device is still running");
+	notify_device_list_changed();
+	
+Done:
+	pthread_mutex_unlock(&gPlugIn_StateMutex);
+	return result;
+}
 
-        case kAudioStreamPropertyVirtualFormat:
-        case kAudioStreamPropertyPhysicalFormat:
-            *outDataSize = sizeof(AudioStreamBasicDescription);
-            break;
+static OSStatus	_AddDeviceClient(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, const AudioServerPlugInClientInfo* inClientInfo)
+{
 
-        case kAudioStreamPropertyAvailableVirtualFormats:
-        case kAudioStreamPropertyAvailablePhysicalFormats:
-            *outDataSize = kDevice_SampleRatesSize * sizeof(AudioStreamRangedDescription);
-            break;
+	//	declare the local variables
+	OSStatus result = 0;
+	struct Device* theDevice = device_for_object(inDeviceObjectID);
+	FailWithAction(theDevice == NULL, result = kAudioHardwareBadObjectError, Done, "_AddDeviceClient: bad device ID");
+	
+	pthread_mutex_lock(&theDevice->state_mutex);
+	result = device_client_add(theDevice, inClientInfo->mClientID, inClientInfo->mProcessID);
+	pthread_mutex_unlock(&theDevice->state_mutex);
+	FailIf(result != 0, Done, "_AddDeviceClient: no free client slot");
+	
+Done:
+	return result;
+}
 
-        default:
-            result = kAudioHardwareUnknownPropertyError;
-            break;
-    };
+static OSStatus	_RemoveDeviceClient(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, const AudioServerPlugInClientInfo* inClientInfo)
+{
 
-    return result;
+	//	declare the local variables
+	OSStatus result = 0;
+	struct Device* theDevice = device_for_object(inDeviceObjectID);
+	FailWithAction(theDevice == NULL, result = kAudioHardwareBadObjectError, Done, "_RemoveDeviceClient: bad device ID");
+	
+	pthread_mutex_lock(&theDevice->state_mutex);
+	device_client_remove(theDevice, inClientInfo->mClientID);
+	pthread_mutex_unlock(&theDevice->state_mutex);
+	
+Done:
+	return result;
 }
 
-static OSStatus    _GetStreamPropertyData(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+static OSStatus	_PerformDeviceConfigurationChange(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, UInt64 inChangeAction, void* inChangeInfo)
 {
-    #pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData)
-    
-    //    declare the local variables
-    OSStatus result = 0;
-    UInt32 theNumberItemsToFetch;
-    
-    switch(inAddress->mSelector)
-    {
-        case kAudioObjectPropertyBaseClass:
-            *((AudioClassID*)outData) = kAudioObjectClassID;
-            *outDataSize = sizeof(AudioClassID);
-            break;
-            
-        case kAudioObjectPropertyClass:
-            *((AudioClassID*)outData) = kAudioStreamClassID;
-            *outDataSize = sizeof(AudioClassID);
-            break;
-            
-        case kAudioObjectPropertyOwner:
-            *((AudioObjectID*)outData) = kObjectID_Device;
-            *outDataSize = sizeof(AudioObjectID);
-            break;
-            
-        case kAudioObjectPropertyOwnedObjects:
-            //    Streams do not own any objects
-            *outDataSize = 0 * sizeof(AudioObjectID);
-            break;
 
-        case kAudioStreamPropertyIsActive:
-            pthread_mutex_lock(&gPlugIn_StateMutex);
-            *((UInt32*)outData) = (inObjectID == kObjectID_Stream_Input) ? gStream_Input_IsActive : gStream_Output_IsActive;
-            pthread_mutex_unlock(&gPlugIn_StateMutex);
-            *outDataSize = sizeof(UInt32);
-            break;
+	#pragma unused(inChangeInfo)
 
-        case kAudioStreamPropertyDirection:
-            *((UInt32*)outData) = (inObjectID == kObjectID_Stream_Input) ? 1 : 0;
-            *outDataSize = sizeof(UInt32);
-            break;
+	//	declare the local variables
+	OSStatus result = 0;
+	struct Device* theDevice = device_for_object(inDeviceObjectID);
+	FailWithAction(theDevice == NULL, result = kAudioHardwareBadObjectError, Done, "_PerformDeviceConfigurationChange: bad device ID");
+	
+	//	a device feeding a bus leaves it while its ring is swapped, so that the bus's IO thread is done
+	//	with the old one before it is freed
+	bool theRingChanges = (inChangeAction & kDevice_ConfigChange_LatencyProfile) != 0;
+	if(theRingChanges)
+	{
+		pthread_mutex_lock(&gPlugIn_StateMutex);
+		if(theDevice->bus != NULL)
+		{
+			device_bus_publish(theDevice->bus, theDevice);
+		}
+	}
+	
+	//	lock the state mutex
+	pthread_mutex_lock(&theDevice->state_mutex);
+	
+	if((inChangeAction & kDevice_ConfigChange_LatencyProfile) != 0)
+	{
+		//	IO is stopped, so the ring can be swapped for one sized for the new profile. Build the new
+		//	one first so that a failed allocation leaves the device as it was.
+		enum LatencyProfile theNewProfile = (enum LatencyProfile)(inChangeAction & ~kDevice_ConfigChange_LatencyProfile);
+		struct RingBuffer theNewRing;
+		if((theNewProfile < kLatencyProfile_Count) && ring_buffer_allocate(&theNewRing, kLatency_Profiles[theNewProfile].ring_frame_count, kNumber_Of_Channels, kRing_Buffer_Locked))
+		{
+			ring_buffer_free(&theDevice->ring);
+			theDevice->ring = theNewRing;
+			device_state_edit(theDevice)->latency_profile = theNewProfile;
+			device_state_publish(theDevice);
+			device_controls_publish(theDevice);
+		}
+		else
+		{
+			result = kAudioHardwareUnspecifiedError;
+		}
+	}
+	else if((inChangeAction & kDevice_ConfigChange_ClientDelay) != 0)
+	{
+		//	nothing to change, the HAL asks WillDoIOOperation again as IO restarts
+	}
+	else
+	{
+		//	change the sample rate
+		device_state_edit(theDevice)->sample_rate = inChangeAction;
+		device_state_publish(theDevice);
+		
+		//	recalculate the state that depends on the sample rate
+		device_set_clock_rate(theDevice, (Float64)inChangeAction);
+	}
 
-        case kAudioStreamPropertyTerminalType:
-            *((UInt32*)outData) = (inObjectID == kObjectID_Stream_Input) ? kAudioStreamTerminalTypeMicrophone : kAudioStreamTerminalTypeSpeaker;
-            *outDataSize = sizeof(UInt32);
-            break;
+	//	unlock the state mutex
+	pthread_mutex_unlock(&theDevice->state_mutex);
+	
+	if(theRingChanges)
+	{
+		if(theDevice->bus != NULL)
+		{
+			device_bus_publish(theDevice->bus, NULL);
+		}
+		pthread_mutex_unlock(&gPlugIn_StateMutex);
+	}
+    
+Done:
+	return result;
+}
 
-        case kAudioStreamPropertyStartingChannel:
-            *((UInt32*)outData) = 1;
-            *outDataSize = sizeof(UInt32);
-            break;
+static OSStatus	_AbortDeviceConfigurationChange(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, UInt64 inChangeAction, void* inChangeInfo)
+{
 
-        case kAudioStreamPropertyLatency:
-            *((UInt32*)outData) = kLatency_Frame_Size;
-            *outDataSize = sizeof(UInt32);
-            break;
+	#pragma unused(inChangeAction, inChangeInfo)
 
-        case kAudioStreamPropertyVirtualFormat:
-        case kAudioStreamPropertyPhysicalFormat:
-            pthread_mutex_lock(&gPlugIn_StateMutex);
-            ((AudioStreamBasicDescription*)outData)->mSampleRate = gDevice_SampleRate;
-            ((AudioStreamBasicDescription*)outData)->mFormatID = kAudioFormatLinearPCM;
-            ((AudioStreamBasicDescription*)outData)->mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagsNativeEndian | kAudioFormatFlagIsPacked;
-            ((AudioStreamBasicDescription*)outData)->mBytesPerPacket = kBytes_Per_Channel * kNumber_Of_Channels;
-            ((AudioStreamBasicDescription*)outData)->mFramesPerPacket = 1;
-            ((AudioStreamBasicDescription*)outData)->mBytesPerFrame = kBytes_Per_Channel * kNumber_Of_Channels;
-            ((AudioStreamBasicDescription*)outData)->mChannelsPerFrame = kNumber_Of_Channels;
-            ((AudioStreamBasicDescription*)outData)->mBitsPerChannel = kBits_Per_Channel;
-            pthread_mutex_unlock(&gPlugIn_StateMutex);
-            *outDataSize = sizeof(AudioStreamBasicDescription);
-            break;
+	//	declare the local variables
+	OSStatus result = 0;
 
-        case kAudioStreamPropertyAvailableVirtualFormats:
-        case kAudioStreamPropertyAvailablePhysicalFormats:
-            theNumberItemsToFetch = inDataSize / sizeof(AudioStreamRangedDescription);
-            
-            //    clamp it to the number of items we have
-            if(theNumberItemsToFetch > kDevice_SampleRatesSize)
-            {
-                theNumberItemsToFetch = kDevice_SampleRatesSize;
-            }
+	return result;
+}
 
-            //    fill out the return array
-            for(UInt32 i = 0; i < theNumberItemsToFetch; i++)
-            {
-                ((AudioStreamRangedDescription*)outData)[i].mFormat.mSampleRate = kDevice_SampleRates[i];
-                ((AudioStreamRangedDescription*)outData)[i].mFormat.mFormatID = kAudioFormatLinearPCM;
-                ((AudioStreamRangedDescription*)outData)[i].mFormat.mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagsNativeEndian | kAudioFormatFlagIsPacked;
-                ((AudioStreamRangedDescription*)outData)[i].mFormat.mBytesPerPacket = kBytes_Per_Frame;
-                ((AudioStreamRangedDescription*)outData)[i].mFormat.mFramesPerPacket = 1;
-                ((AudioStreamRangedDescription*)outData)[i].mFormat.mBytesPerFrame = kBytes_Per_Frame;
-                ((AudioStreamRangedDescription*)outData)[i].mFormat.mChannelsPerFrame = kNumber_Of_Channels;
-                ((AudioStreamRangedDescription*)outData)[i].mFormat.mBitsPerChannel = kBits_Per_Channel;
-                ((AudioStreamRangedDescription*)outData)[i].mSampleRateRange.mMinimum = kDevice_SampleRates[i];
-                ((AudioStreamRangedDescription*)outData)[i].mSampleRateRange.mMaximum = kDevice_SampleRates[i];
-            }
+#pragma mark Property Registry
+
+//	Every property of every object class is described once, in the tables below: the selector, its
+//	size (fixed, or worked out per call for lists), the getter and, for settable ones, the setter. The
+//	five property entry points resolve the object and the descriptor the same way and then only call
+//	through the descriptor, so adding a property is one table row plus its handlers.
+//
+//	Lookup is a hash of the selector into a small open addressed index per class, built from the
+//	tables once in _Initialize, so it costs the same however many properties a class has. Audio MIDI
+//	Setup and DAWs query every property of every device while enumerating, which makes this path
+//	much hotter than it looks.
+
+enum PropertyClass {
+    kPropertyClass_PlugIn,
+    kPropertyClass_Box,
+    kPropertyClass_Device,
+    kPropertyClass_Stream,
+    kPropertyClass_Volume,
+    kPropertyClass_Mute,
+    kPropertyClass_Count
+};
 
-            //    report how much we wrote
-            *outDataSize = theNumberItemsToFetch * sizeof(AudioStreamRangedDescription);
-            break;
+struct PropertyDescriptor;
+
+//	What a handler works on, resolved once per call. device is NULL for the plug-in and the box.
+struct PropertyContext {
+    AudioObjectID                       object_id;
+    enum ObjectRole                     role;
+    struct Device*                      device;
+    const AudioObjectPropertyAddress*   address;
+    UInt32                              qualifier_size;
+    const void*                         qualifier;
+    //	the process asking, for the properties that answer per process
+    pid_t                               client_pid;
+    const struct PropertyDescriptor*    descriptor;
+};
 
-        default:
-            result = kAudioHardwareUnknownPropertyError;
-            break;
-    };
+typedef UInt32      (*PropertySizeHandler)(const struct PropertyContext* context);
+
+//	For fixed size properties the caller has already checked inDataSize and filled in *outDataSize,
+//	so the getter only writes the value. Variable size getters fit what they can in inDataSize and
+//	report how much that was.
+typedef OSStatus    (*PropertyGetHandler)(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData);
+
+//	inData is always exactly the property's size.
+typedef OSStatus    (*PropertySetHandler)(const struct PropertyContext* context, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2]);
+
+struct PropertyDescriptor {
+    AudioObjectPropertySelector         selector;
+    //	the device properties that only exist in the input and output scopes
+    bool                                io_scope_only;
+    //	the size of a fixed size property, ignored when size_of is set
+    UInt32                              size;
+    PropertySizeHandler                 size_of;
+    PropertyGetHandler                  get;
+    //	NULL for read only properties
+    PropertySetHandler                  set;
+    //	the value property_get_constant returns, or which of the device's object lists to report
+    UInt32                              value;
+};
 
-    return result;
+//	a UInt32 sized property whose value never changes
+#define PROPERTY_CONSTANT(inSelector, inValue)                  { inSelector, false, sizeof(UInt32), NULL, property_get_constant, NULL, inValue }
+#define PROPERTY_IO_CONSTANT(inSelector, inValue)               { inSelector, true, sizeof(UInt32), NULL, property_get_constant, NULL, inValue }
+#define PROPERTY_FIXED(inSelector, inType, inGet, inSet)        { inSelector, false, sizeof(inType), NULL, inGet, inSet, 0 }
+#define PROPERTY_IO_FIXED(inSelector, inSize, inGet)            { inSelector, true, inSize, NULL, inGet, NULL, 0 }
+#define PROPERTY_LIST(inSelector, inSizeOf, inGet)              { inSelector, false, 0, inSizeOf, inGet, NULL, 0 }
+#define PROPERTY_NONE(inSelector)                               { inSelector, false, 0, NULL, property_get_none, NULL, 0 }
+#define PROPERTY_OBJECT_LIST(inSelector, inList)                { inSelector, false, 0, device_object_list_size, device_get_object_list, NULL, inList }
+
+static void set_changed_address(AudioObjectPropertyAddress* outAddress, AudioObjectPropertySelector selector)
+{
+    outAddress->mSelector = selector;
+    outAddress->mScope = kAudioObjectPropertyScopeGlobal;
+    outAddress->mElement = kAudioObjectPropertyElementMain;
 }
 
-static OSStatus    _SetStreamPropertyData(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
+#pragma mark Shared Property Handlers
+
+static OSStatus property_get_constant(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
 {
-    #pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData)
-    
-    //    declare the local variables
-    OSStatus result = 0;
-    Float64 theOldSampleRate;
-    UInt64 theNewSampleRate;
-    
-    *outNumberPropertiesChanged = 0;
-    
-    switch(inAddress->mSelector)
-    {
-        case kAudioStreamPropertyIsActive:
-            pthread_mutex_lock(&gPlugIn_StateMutex);
-            if(inObjectID == kObjectID_Stream_Input)
-            {
-                if(gStream_Input_IsActive != (*((const UInt32*)inData) != 0))
-                {
-                    gStream_Input_IsActive = *((const UInt32*)inData) != 0;
-                    *outNumberPropertiesChanged = 1;
-                    outChangedAddresses[0].mSelector = kAudioStreamPropertyIsActive;
-                    outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
-                    outChangedAddresses[0].mElement = kAudioObjectPropertyElementMain;
-                }
-            }
-            else
-            {
-                if(gStream_Output_IsActive != (*((const UInt32*)inData) != 0))
-                {
-                    gStream_Output_IsActive = *((const UInt32*)inData) != 0;
-                    *outNumberPropertiesChanged = 1;
-                    outChangedAddresses[0].mSelector = kAudioStreamPropertyIsActive;
-                    outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
-                    outChangedAddresses[0].mElement = kAudioObjectPropertyElementMain;
-                }
-            }
-            pthread_mutex_unlock(&gPlugIn_StateMutex);
-            break;
-            
-        case kAudioStreamPropertyVirtualFormat:
-        case kAudioStreamPropertyPhysicalFormat:
-            pthread_mutex_lock(&gPlugIn_StateMutex);
-            theOldSampleRate = gDevice_SampleRate;
-            pthread_mutex_unlock(&gPlugIn_StateMutex);
-            if(((const AudioStreamBasicDescription*)inData)->mSampleRate != theOldSampleRate)
-            {
-                theOldSampleRate = ((const AudioStreamBasicDescription*)inData)->mSampleRate;
-                theNewSampleRate = (UInt64)theOldSampleRate;
-                dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{ gPlugIn_Host->RequestDeviceConfigurationChange(gPlugIn_Host, kObjectID_Device, theNewSampleRate, NULL); });
-            }
-            break;
-        
-        default:
-            result = kAudioHardwareUnknownPropertyError;
-            break;
-    };
+    #pragma unused(inDataSize, outDataSize)
+    *((UInt32*)outData) = context->descriptor->value;
+    return 0;
+}
 
-    return result;
+//	for objects that don't own anything
+static OSStatus property_get_none(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(context, inDataSize, outDataSize, outData)
+    return 0;
 }
 
-#pragma mark Control Property Operations
+static OSStatus property_get_apple_manufacturer(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(context, inDataSize, outDataSize)
+    *((CFStringRef*)outData) = CFSTR("Apple Inc.");
+    return 0;
+}
 
-static Boolean    _HasControlProperty(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress)
+//	streams and controls belong to their device
+static OSStatus property_get_device_owner(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
 {
-    
-    #pragma unused(inClientProcessID)
-    
-    //    declare the local variables
-    Boolean result = false;
-    
-    switch(inObjectID)
-    {
-        case kObjectID_Volume_Input_Master:
-        case kObjectID_Volume_Output_Master:
-            switch(inAddress->mSelector)
-            {
-                case kAudioObjectPropertyBaseClass:
-                case kAudioObjectPropertyClass:
-                case kAudioObjectPropertyOwner:
-                case kAudioObjectPropertyOwnedObjects:
-                case kAudioControlPropertyScope:
-                case kAudioControlPropertyElement:
-                case kAudioLevelControlPropertyScalarValue:
-                case kAudioLevelControlPropertyDecibelValue:
-                case kAudioLevelControlPropertyDecibelRange:
-                case kAudioLevelControlPropertyConvertScalarToDecibels:
-                case kAudioLevelControlPropertyConvertDecibelsToScalar:
-                    result = true;
-                    break;
-            };
-            break;
-        
-        case kObjectID_Mute_Input_Master:
-        case kObjectID_Mute_Output_Master:
-            switch(inAddress->mSelector)
-            {
-                case kAudioObjectPropertyBaseClass:
-                case kAudioObjectPropertyClass:
-                case kAudioObjectPropertyOwner:
-                case kAudioObjectPropertyOwnedObjects:
-                case kAudioControlPropertyScope:
-                case kAudioControlPropertyElement:
-                case kAudioBooleanControlPropertyValue:
-                    result = true;
-                    break;
-            };
-            break;
-    };
+    #pragma unused(inDataSize, outDataSize)
+    *((AudioObjectID*)outData) = context->device->object_id;
+    return 0;
+}
 
-    return result;
+#pragma mark PlugIn Property Handlers
+
+static UInt32 plugin_owned_objects_size(const struct PropertyContext* context)
+{
+    #pragma unused(context)
+    pthread_mutex_lock(&gPlugIn_StateMutex);
+    UInt32 theSize = (1 + (gBox_Acquired ? gDevice_Count : 0)) * sizeof(AudioObjectID);
+    pthread_mutex_unlock(&gPlugIn_StateMutex);
+    return theSize;
 }
 
-static OSStatus    _IsControlPropertySettable(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable)
+static OSStatus plugin_get_owned_objects(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
 {
-    #pragma unused(inClientProcessID)
-    
-    OSStatus result = 0;
-    
-    switch(inObjectID)
+    #pragma unused(context)
+    UInt32 theNumberItemsToFetch = inDataSize / sizeof(AudioObjectID);
+
+    //	the box comes first, then the devices if it has been acquired
+    pthread_mutex_lock(&gPlugIn_StateMutex);
+    if(theNumberItemsToFetch > 0)
     {
-        case kObjectID_Volume_Input_Master:
-        case kObjectID_Volume_Output_Master:
-            switch(inAddress->mSelector)
-            {
-                case kAudioObjectPropertyBaseClass:
-                case kAudioObjectPropertyClass:
-                case kAudioObjectPropertyOwner:
-                case kAudioObjectPropertyOwnedObjects:
-                case kAudioControlPropertyScope:
-                case kAudioControlPropertyElement:
-                case kAudioLevelControlPropertyDecibelRange:
-                case kAudioLevelControlPropertyConvertScalarToDecibels:
-                case kAudioLevelControlPropertyConvertDecibelsToScalar:
-                    *outIsSettable = false;
-                    break;
-                
-                case kAudioLevelControlPropertyScalarValue:
-                case kAudioLevelControlPropertyDecibelValue:
-                    *outIsSettable = true;
-                    break;
-                
-                default:
-                    result = kAudioHardwareUnknownPropertyError;
-                    break;
-            };
-            break;
-        
-        case kObjectID_Mute_Input_Master:
-        case kObjectID_Mute_Output_Master:
-            switch(inAddress->mSelector)
-            {
-                case kAudioObjectPropertyBaseClass:
-                case kAudioObjectPropertyClass:
-                case kAudioObjectPropertyOwner:
-                case kAudioObjectPropertyOwnedObjects:
-                case kAudioControlPropertyScope:
-                case kAudioControlPropertyElement:
-                    *outIsSettable = false;
-                    break;
-                
-                case kAudioBooleanControlPropertyValue:
-                    *outIsSettable = true;
-                    break;
-                
-                default:
-                    result = kAudioHardwareUnknownPropertyError;
-                    break;
-            };
-            break;
-                
-        default:
-            result = kAudioHardwareBadObjectError;
-            break;
-    };
+        ((AudioObjectID*)outData)[0] = kObjectID_Box;
+        theNumberItemsToFetch = 1 + (gBox_Acquired ? device_list((AudioObjectID*)outData + 1, theNumberItemsToFetch - 1) : 0);
+    }
+    pthread_mutex_unlock(&gPlugIn_StateMutex);
 
-    return result;
+    *outDataSize = theNumberItemsToFetch * sizeof(AudioObjectID);
+    return 0;
 }
 
-static OSStatus    _GetControlPropertyDataSize(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
+static UInt32 plugin_box_list_size(const struct PropertyContext* context)
 {
-    #pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData)
-    
-    //    declare the local variables
-    OSStatus result = 0;
-    
-    switch(inObjectID)
-    {
-        case kObjectID_Volume_Input_Master:
-        case kObjectID_Volume_Output_Master:
-            switch(inAddress->mSelector)
-            {
-                case kAudioObjectPropertyBaseClass:
-                    *outDataSize = sizeof(AudioClassID);
-                    break;
-
-                case kAudioObjectPropertyClass:
-                    *outDataSize = sizeof(AudioClassID);
-                    break;
-
-                case kAudioObjectPropertyOwner:
-                    *outDataSize = sizeof(AudioObjectID);
-                    break;
-
-                case kAudioObjectPropertyOwnedObjects:
-                    *outDataSize = 0 * sizeof(AudioObjectID);
-                    break;
-
-                case kAudioControlPropertyScope:
-                    *outDataSize = sizeof(AudioObjectPropertyScope);
-                    break;
-
-                case kAudioControlPropertyElement:
-                    *outDataSize = sizeof(AudioObjectPropertyElement);
-                    break;
-
-                case kAudioLevelControlPropertyScalarValue:
-                    *outDataSize = sizeof(Float32);
-                    break;
-
-                case kAudioLevelControlPropertyDecibelValue:
-                    *outDataSize = sizeof(Float32);
-                    break;
-
-                case kAudioLevelControlPropertyDecibelRange:
-                    *outDataSize = sizeof(AudioValueRange);
-                    break;
-
-                case kAudioLevelControlPropertyConvertScalarToDecibels:
-                    *outDataSize = sizeof(Float32);
-                    break;
-
-                case kAudioLevelControlPropertyConvertDecibelsToScalar:
-                    *outDataSize = sizeof(Float32);
-                    break;
-
-                default:
-                    result = kAudioHardwareUnknownPropertyError;
-                    break;
-            };
-            break;
-        
-        case kObjectID_Mute_Input_Master:
-        case kObjectID_Mute_Output_Master:
-            switch(inAddress->mSelector)
-            {
-                case kAudioObjectPropertyBaseClass:
-                    *outDataSize = sizeof(AudioClassID);
-                    break;
-
-                case kAudioObjectPropertyClass:
-                    *outDataSize = sizeof(AudioClassID);
-                    break;
-
-                case kAudioObjectPropertyOwner:
-                    *outDataSize = sizeof(AudioObjectID);
-                    break;
-
-                case kAudioObjectPropertyOwnedObjects:
-                    *outDataSize = 0 * sizeof(AudioObjectID);
-                    break;
-
-                case kAudioControlPropertyScope:
-                    *outDataSize = sizeof(AudioObjectPropertyScope);
-                    break;
-
-                case kAudioControlPropertyElement:
-                    *outDataSize = sizeof(AudioObjectPropertyElement);
-                    break;
-
-                case kAudioBooleanControlPropertyValue:
-                    *outDataSize = sizeof(UInt32);
-                    break;
-
-                default:
-                    result = kAudioHardwareUnknownPropertyError;
-                    break;
-            };
-            break;
-                
-        default:
-            result = kAudioHardwareBadObjectError;
-            break;
-    };
-
-    return result;
+    #pragma unused(context)
+    return sizeof(AudioObjectID);
 }
 
-static OSStatus    _GetControlPropertyData(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+static OSStatus plugin_get_box_list(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
 {
-    #pragma unused(inClientProcessID, inQualifierData, inQualifierDataSize)
-    
-    //    declare the local variables
-    OSStatus result = 0;
-    
-    switch(inObjectID)
+    #pragma unused(context)
+    //	there is just the one box
+    UInt32 theNumberItemsToFetch = minimum(inDataSize / sizeof(AudioObjectID), 1);
+    if(theNumberItemsToFetch > 0)
     {
-        case kObjectID_Volume_Input_Master:
-        case kObjectID_Volume_Output_Master:
-            switch(inAddress->mSelector)
-            {
-                case kAudioObjectPropertyBaseClass:
-                    *((AudioClassID*)outData) = kAudioLevelControlClassID;
-                    *outDataSize = sizeof(AudioClassID);
-                    break;
-                    
-                case kAudioObjectPropertyClass:
-                    *((AudioClassID*)outData) = kAudioVolumeControlClassID;
-                    *outDataSize = sizeof(AudioClassID);
-                    break;
-                    
-                case kAudioObjectPropertyOwner:
-                    *((AudioObjectID*)outData) = kObjectID_Device;
-                    *outDataSize = sizeof(AudioObjectID);
-                    break;
-                    
-                case kAudioObjectPropertyOwnedObjects:
-                    //    Controls do not own any objects
-                    *outDataSize = 0 * sizeof(AudioObjectID);
-                    break;
-
-                case kAudioControlPropertyScope:
-                    *((AudioObjectPropertyScope*)outData) = (inObjectID == kObjectID_Volume_Input_Master) ? kAudioObjectPropertyScopeInput : kAudioObjectPropertyScopeOutput;
-                    *outDataSize = sizeof(AudioObjectPropertyScope);
-                    break;
-
-                case kAudioControlPropertyElement:
-                    *((AudioObjectPropertyElement*)outData) = kAudioObjectPropertyElementMain;
-                    *outDataSize = sizeof(AudioObjectPropertyElement);
-                    break;
-
-                case kAudioLevelControlPropertyScalarValue:
-                    pthread_mutex_lock(&gPlugIn_StateMutex);
-                    *((Float32*)outData) = volume_to_scalar(gVolume_Master_Value);
-                    pthread_mutex_unlock(&gPlugIn_StateMutex);
-                    *outDataSize = sizeof(Float32);
-                    break;
-
-                case kAudioLevelControlPropertyDecibelValue:
-                    pthread_mutex_lock(&gPlugIn_StateMutex);
-                    *((Float32*)outData) = gVolume_Master_Value;
-                    pthread_mutex_unlock(&gPlugIn_StateMutex);
-                    *((Float32*)outData) = volume_to_decibel(*((Float32*)outData));
-                    
-                    //    report how much we wrote
-                    *outDataSize = sizeof(Float32);
-                    break;
-
-                case kAudioLevelControlPropertyDecibelRange:
-                    ((AudioValueRange*)outData)->mMinimum = kVolume_MinDB;
-                    ((AudioValueRange*)outData)->mMaximum = kVolume_MaxDB;
-                    *outDataSize = sizeof(AudioValueRange);
-                    break;
-
-                case kAudioLevelControlPropertyConvertScalarToDecibels:
-                    
-                    if(*((Float32*)outData) < 0.0)
-                    {
-                        *((Float32*)outData) = 0;
-                    }
-                    if(*((Float32*)outData) > 1.0)
-                    {
-                        *((Float32*)outData) = 1.0;
-                    }
-                    
-                    *((Float32*)outData) *= *((Float32*)outData);
-                    *((Float32*)outData) = kVolume_MinDB + (*((Float32*)outData) * (kVolume_MaxDB - kVolume_MinDB));
-                    
-                    //    report how much we wrote
-                    *outDataSize = sizeof(Float32);
-                    break;
-
-                case kAudioLevelControlPropertyConvertDecibelsToScalar:
-                    
-                    if(*((Float32*)outData) < kVolume_MinDB)
-                    {
-                        *((Float32*)outData) = kVolume_MinDB;
-                    }
-                    if(*((Float32*)outData) > kVolume_MaxDB)
-                    {
-                        *((Float32*)outData) = kVolume_MaxDB;
-                    }
-                    
-                    *((Float32*)outData) = *((Float32*)outData) - kVolume_MinDB;
-                    *((Float32*)outData) /= kVolume_MaxDB - kVolume_MinDB;
-                    *((Float32*)outData) = sqrtf(*((Float32*)outData));
-                    
-                    //    report how much we wrote
-                    *outDataSize = sizeof(Float32);
-                    break;
-
-                default:
-                    result = kAudioHardwareUnknownPropertyError;
-                    break;
-            };
-            break;
-        
-        case kObjectID_Mute_Input_Master:
-        case kObjectID_Mute_Output_Master:
-            switch(inAddress->mSelector)
-            {
-                case kAudioObjectPropertyBaseClass:
-                    *((AudioClassID*)outData) = kAudioBooleanControlClassID;
-                    *outDataSize = sizeof(AudioClassID);
-                    break;
-                    
-                case kAudioObjectPropertyClass:
-                    *((AudioClassID*)outData) = kAudioMuteControlClassID;
-                    *outDataSize = sizeof(AudioClassID);
-                    break;
-                    
-                case kAudioObjectPropertyOwner:
-                    *((AudioObjectID*)outData) = kObjectID_Device;
-                    *outDataSize = sizeof(AudioObjectID);
-                    break;
-                    
-                case kAudioObjectPropertyOwnedObjects:
-                    *outDataSize = 0 * sizeof(AudioObjectID);
-                    break;
-
-                case kAudioControlPropertyScope:
-                    *((AudioObjectPropertyScope*)outData) = (inObjectID == kObjectID_Mute_Input_Master) ? kAudioObjectPropertyScopeInput : kAudioObjectPropertyScopeOutput;
-                    *outDataSize = sizeof(AudioObjectPropertyScope);
-                    break;
-
-                case kAudioControlPropertyElement:
-                    *((AudioObjectPropertyElement*)outData) = kAudioObjectPropertyElementMain;
-                    *outDataSize = sizeof(AudioObjectPropertyElement);
-                    break;
-
-                case kAudioBooleanControlPropertyValue:
-                    pthread_mutex_lock(&gPlugIn_StateMutex);
-                    *((UInt32*)outData) = gMute_Master_Value ? 1 : 0;
-                    pthread_mutex_unlock(&gPlugIn_StateMutex);
-                    *outDataSize = sizeof(UInt32);
-                    break;
-
-                default:
-                    result = kAudioHardwareUnknownPropertyError;
-                    break;
-            };
-            break;
-                
-        default:
-            result = kAudioHardwareBadObjectError;
-            break;
-    };
-
-    return result;
+        ((AudioObjectID*)outData)[0] = kObjectID_Box;
+    }
+    *outDataSize = theNumberItemsToFetch * sizeof(AudioObjectID);
+    return 0;
 }
 
-static OSStatus    _SetControlPropertyData(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
+static OSStatus plugin_get_translate_uid_to_box(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
 {
-    #pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData)
-    
-    //    declare the local variables
-    OSStatus result = 0;
-    Float32 theNewVolume;
-    
-    *outNumberPropertiesChanged = 0;
-    
-    switch(inObjectID)
+    #pragma unused(inDataSize, outDataSize)
+    if(context->qualifier_size != sizeof(CFStringRef))
     {
-        case kObjectID_Volume_Input_Master:
-        case kObjectID_Volume_Output_Master:
-            switch(inAddress->mSelector)
-            {
-                case kAudioLevelControlPropertyScalarValue:
-                    theNewVolume = volume_from_scalar(*((const Float32*)inData));
-                    if(theNewVolume < 0.0)
-                    {
-                        theNewVolume = 0.0;
-                    }
-                    else if(theNewVolume > 1.0)
-                    {
-                        theNewVolume = 1.0;
-                    }
-                    pthread_mutex_lock(&gPlugIn_StateMutex);
-                    if(gVolume_Master_Value != theNewVolume)
-                    {
-                        gVolume_Master_Value = theNewVolume;
-                        *outNumberPropertiesChanged = 2;
-                        outChangedAddresses[0].mSelector = kAudioLevelControlPropertyScalarValue;
-                        outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
-                        outChangedAddresses[0].mElement = kAudioObjectPropertyElementMain;
-                        outChangedAddresses[1].mSelector = kAudioLevelControlPropertyDecibelValue;
-                        outChangedAddresses[1].mScope = kAudioObjectPropertyScopeGlobal;
-                        outChangedAddresses[1].mElement = kAudioObjectPropertyElementMain;
-                    }
-                    pthread_mutex_unlock(&gPlugIn_StateMutex);
-                    break;
-                
-                case kAudioLevelControlPropertyDecibelValue:
-                    theNewVolume = *((const Float32*)inData);
-                    if(theNewVolume < kVolume_MinDB)
-                    {
-                        theNewVolume = kVolume_MinDB;
-                    }
-                    else if(theNewVolume > kVolume_MaxDB)
-                    {
-                        theNewVolume = kVolume_MaxDB;
-                    }
-                    theNewVolume = volume_from_decibel(theNewVolume);
-                    pthread_mutex_lock(&gPlugIn_StateMutex);
-                    if(gVolume_Master_Value != theNewVolume)
-                    {
-                        gVolume_Master_Value = theNewVolume;
-                        *outNumberPropertiesChanged = 2;
-                        outChangedAddresses[0].mSelector = kAudioLevelControlPropertyScalarValue;
-                        outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
-                        outChangedAddresses[0].mElement = kAudioObjectPropertyElementMain;
-                        outChangedAddresses[1].mSelector = kAudioLevelControlPropertyDecibelValue;
-                        outChangedAddresses[1].mScope = kAudioObjectPropertyScopeGlobal;
-                        outChangedAddresses[1].mElement = kAudioObjectPropertyElementMain;
-                    }
-                    pthread_mutex_unlock(&gPlugIn_StateMutex);
-                    break;
-                
-                default:
-                    result = kAudioHardwareUnknownPropertyError;
-                    break;
-            };
-            break;
-        
-        case kObjectID_Mute_Input_Master:
-        case kObjectID_Mute_Output_Master:
-            switch(inAddress->mSelector)
-            {
-                case kAudioBooleanControlPropertyValue:
-                    pthread_mutex_lock(&gPlugIn_StateMutex);
-                    if(gMute_Master_Value != (*((const UInt32*)inData) != 0))
-                    {
-                        gMute_Master_Value = *((const UInt32*)inData) != 0;
-                        *outNumberPropertiesChanged = 1;
-                        outChangedAddresses[0].mSelector = kAudioBooleanControlPropertyValue;
-                        outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
-                        outChangedAddresses[0].mElement = kAudioObjectPropertyElementMain;
-                    }
-                    pthread_mutex_unlock(&gPlugIn_StateMutex);
-                    break;
-                
-                default:
-                    result = kAudioHardwareUnknownPropertyError;
-                    break;
-            };
-            break;
-                
-        default:
-            result = kAudioHardwareBadObjectError;
-            break;
-    };
+        return kAudioHardwareBadPropertySizeError;
+    }
 
-    return result;
+    *((AudioObjectID*)outData) = (CFStringCompare(*((const CFStringRef*)context->qualifier), gBox_UID, 0) == kCFCompareEqualTo) ? kObjectID_Box : kAudioObjectUnknown;
+    return 0;
 }
 
-#pragma mark IO Operations
-
-static OSStatus    _StartIO(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, UInt32 inClientID)
+static UInt32 plugin_device_list_size(const struct PropertyContext* context)
 {
-    #pragma unused(inClientID, inDeviceObjectID)
-    
-    OSStatus result = 0;
-    
+    #pragma unused(context)
     pthread_mutex_lock(&gPlugIn_StateMutex);
-    
-    if(gDevice_IOIsRunning == UINT64_MAX)
-    {
-        result = kAudioHardwareIllegalOperationError;
-    }
-    else if(gDevice_IOIsRunning == 0)
-    {
-        gDevice_IOIsRunning = 1;
-        gDevice_NumberTimeStamps = 0;
-        gDevice_AnchorSampleTime = 0;
-        gDevice_AnchorHostTime = mach_absolute_time();
-        
-        gRingBuffer = calloc(kRing_Buffer_Frame_Size * kNumber_Of_Channels, sizeof(Float32));
-    }
-    else
-    {
-        ++gDevice_IOIsRunning;
-    }
-    
+    UInt32 theSize = (gBox_Acquired ? gDevice_Count : 0) * sizeof(AudioObjectID);
     pthread_mutex_unlock(&gPlugIn_StateMutex);
-    
-    return result;
+    return theSize;
 }
 
-static OSStatus    _StopIO(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, UInt32 inClientID)
+//	the plug-in and the box list the same devices, and only while the box is acquired
+static OSStatus plugin_get_device_list(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
 {
-    
-    #pragma unused(inClientID, inDeviceObjectID)
-    
-    OSStatus result = 0;
-    
+    #pragma unused(context)
     pthread_mutex_lock(&gPlugIn_StateMutex);
-    
-    if(gDevice_IOIsRunning == 0)
-    {
-        result = kAudioHardwareIllegalOperationError;
-    }
-    else if(gDevice_IOIsRunning == 1)
-    {
-        gDevice_IOIsRunning = 0;
-        free(gRingBuffer);
-    }
-    else
+    UInt32 theNumberItemsToFetch = gBox_Acquired ? device_list((AudioObjectID*)outData, inDataSize / sizeof(AudioObjectID)) : 0;
+    pthread_mutex_unlock(&gPlugIn_StateMutex);
+
+    *outDataSize = theNumberItemsToFetch * sizeof(AudioObjectID);
+    return 0;
+}
+
+static OSStatus plugin_get_translate_uid_to_device(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    if(context->qualifier_size != sizeof(CFStringRef))
     {
-        --gDevice_IOIsRunning;
+        return kAudioHardwareBadPropertySizeError;
     }
-    
+
+    pthread_mutex_lock(&gPlugIn_StateMutex);
+    struct Device* theDevice = device_for_uid(*((const CFStringRef*)context->qualifier));
+    *((AudioObjectID*)outData) = (theDevice != NULL) ? theDevice->object_id : kAudioObjectUnknown;
     pthread_mutex_unlock(&gPlugIn_StateMutex);
-    
-    return result;
+    return 0;
 }
 
-static OSStatus    _GetZeroTimeStamp(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, UInt32 inClientID, Float64* outSampleTime, UInt64* outHostTime, UInt64* outSeed)
+static OSStatus plugin_get_resource_bundle(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
 {
-    #pragma unused(inClientID, inDeviceObjectID)
-    
-    OSStatus result = 0;
-    UInt64 theCurrentHostTime;
-    Float64 theHostTicksPerRingBuffer;
-    Float64 theHostTickOffset;
-    UInt64 theNextHostTime;
-    
-    pthread_mutex_lock(&gDevice_IOMutex);
-    
-    theCurrentHostTime = mach_absolute_time();
-    
-    theHostTicksPerRingBuffer = gDevice_HostTicksPerFrame * ((Float64)kDevice_RingBufferSize);
-    
-    theHostTickOffset = ((Float64)(gDevice_NumberTimeStamps + 1)) * theHostTicksPerRingBuffer;
-    
-    theNextHostTime = gDevice_AnchorHostTime + ((UInt64)theHostTickOffset);
-    
-    if(theNextHostTime <= theCurrentHostTime)
+    #pragma unused(context, inDataSize, outDataSize)
+    *((CFStringRef*)outData) = CFSTR("");
+    return 0;
+}
+
+static const struct PropertyDescriptor kPlugIn_Properties[] = {
+    PROPERTY_CONSTANT(kAudioObjectPropertyBaseClass, kAudioObjectClassID),
+    PROPERTY_CONSTANT(kAudioObjectPropertyClass, kAudioPlugInClassID),
+    PROPERTY_CONSTANT(kAudioObjectPropertyOwner, kAudioObjectUnknown),
+    PROPERTY_FIXED(kAudioObjectPropertyManufacturer, CFStringRef, property_get_apple_manufacturer, NULL),
+    PROPERTY_LIST(kAudioObjectPropertyOwnedObjects, plugin_owned_objects_size, plugin_get_owned_objects),
+    PROPERTY_LIST(kAudioPlugInPropertyBoxList, plugin_box_list_size, plugin_get_box_list),
+    PROPERTY_FIXED(kAudioPlugInPropertyTranslateUIDToBox, AudioObjectID, plugin_get_translate_uid_to_box, NULL),
+    PROPERTY_LIST(kAudioPlugInPropertyDeviceList, plugin_device_list_size, plugin_get_device_list),
+    PROPERTY_FIXED(kAudioPlugInPropertyTranslateUIDToDevice, AudioObjectID, plugin_get_translate_uid_to_device, NULL),
+    PROPERTY_FIXED(kAudioPlugInPropertyResourceBundle, CFStringRef, plugin_get_resource_bundle, NULL),
+};
+
+#pragma mark Box Property Handlers
+
+static OSStatus box_get_name(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(context, inDataSize, outDataSize)
+    pthread_mutex_lock(&gPlugIn_StateMutex);
+    *((CFStringRef*)outData) = gBox_Name;
+    if(gBox_Name != NULL)
     {
-        ++gDevice_NumberTimeStamps;
+        CFRetain(gBox_Name);
     }
-    
-    *outSampleTime = gDevice_NumberTimeStamps * kDevice_RingBufferSize;
-    *outHostTime = gDevice_AnchorHostTime + (((Float64)gDevice_NumberTimeStamps) * theHostTicksPerRingBuffer);
-    *outSeed = 1;
-    
-    pthread_mutex_unlock(&gDevice_IOMutex);
-    
-    return result;
+    pthread_mutex_unlock(&gPlugIn_StateMutex);
+    return 0;
 }
 
-static OSStatus    _WillDoIOOperation(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, UInt32 inClientID, UInt32 inOperationID, Boolean* outWillDo, Boolean* outWillDoInPlace)
+static OSStatus box_set_name(const struct PropertyContext* context, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
 {
-    #pragma unused(inClientID, inDeviceObjectID)
-    
-    OSStatus result = 0;
-    bool willDo = false;
-    bool willDoInPlace = true;
-    switch(inOperationID)
-    {
-        case kAudioServerPlugInIOOperationReadInput:
-            willDo = true;
-            willDoInPlace = true;
-            break;
-            
-        case kAudioServerPlugInIOOperationWriteMix:
-            willDo = true;
-            willDoInPlace = true;
-            break;
-            
-    };
-    
-    if(outWillDo != NULL)
+    #pragma unused(context)
+    //	boxes should allow their name to be editable
+    CFStringRef theNewName = *((const CFStringRef*)inData);
+    pthread_mutex_lock(&gPlugIn_StateMutex);
+    if(theNewName != NULL)
     {
-        *outWillDo = willDo;
+        CFRetain(theNewName);
     }
-    if(outWillDoInPlace != NULL)
+    if(gBox_Name != NULL)
     {
-        *outWillDoInPlace = willDoInPlace;
+        CFRelease(gBox_Name);
     }
+    gBox_Name = theNewName;
+    pthread_mutex_unlock(&gPlugIn_StateMutex);
 
-    return result;
+    *outNumberPropertiesChanged = 1;
+    set_changed_address(&outChangedAddresses[0], kAudioObjectPropertyName);
+    return 0;
 }
 
-static OSStatus    _BeginIOOperation(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, UInt32 inClientID, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo* inIOCycleInfo)
+static OSStatus box_get_model_name(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
 {
-    
-    #pragma unused(inClientID, inOperationID, inIOBufferFrameSize, inIOCycleInfo, inDeviceObjectID)
-    
-    OSStatus result = 0;
+    #pragma unused(context, inDataSize, outDataSize)
+    *((CFStringRef*)outData) = CFSTR("Null Model");
+    return 0;
+}
 
-    return result;
+static void box_identify_finished_async(void* inContext)
+{
+    #pragma unused(inContext)
+    AudioObjectPropertyAddress theAddress = { kAudioObjectPropertyIdentify, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+    gPlugIn_Host->PropertiesChanged(gPlugIn_Host, kObjectID_Box, 1, &theAddress);
 }
 
+static OSStatus box_set_identify(const struct PropertyContext* context, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
+{
+    #pragma unused(context, inData, outNumberPropertiesChanged, outChangedAddresses)
+    //	there is nothing to blink, so just tell the host a couple of seconds later that it's over
+    dispatch_after_f(dispatch_time(0, 2ULL * 1000ULL * 1000ULL * 1000ULL), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), NULL, box_identify_finished_async);
+    return 0;
+}
 
-static OSStatus    _EndIOOperation(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, UInt32 inClientID, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo* inIOCycleInfo)
+static OSStatus box_get_serial_number(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
 {
-    #pragma unused(inClientID, inOperationID, inIOBufferFrameSize, inIOCycleInfo, inDeviceObjectID)
-    
-    OSStatus result = 0;
+    #pragma unused(context, inDataSize, outDataSize)
+    *((CFStringRef*)outData) = CFSTR("00000001");
+    return 0;
+}
 
-    return result;
+static OSStatus box_get_firmware_version(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(context, inDataSize, outDataSize)
+    *((CFStringRef*)outData) = CFSTR("1.0");
+    return 0;
 }
 
+static OSStatus box_get_uid(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(context, inDataSize, outDataSize)
+    *((CFStringRef*)outData) = CFRetain(gBox_UID);
+    return 0;
+}
 
-static OSStatus    _DoIOOperation(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, AudioObjectID inStreamObjectID, UInt32 inClientID, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo* inIOCycleInfo, void* ioMainBuffer, void* ioSecondaryBuffer)
+static OSStatus box_get_acquired(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
 {
-    #pragma unused(inClientID, inIOCycleInfo, ioSecondaryBuffer, inDeviceObjectID)
-    
-    OSStatus the_answer = 0;
-    static Float64 lastOutputSampleTime = 0;
-    static Boolean isBufferClear = true;
-    
-    UInt64 m_sample_time = inOperationID == kAudioServerPlugInIOOperationReadInput ? inIOCycleInfo->mInputTime.mSampleTime : inIOCycleInfo->mOutputTime.mSampleTime;
-    UInt32 ringBufferFrameLocationStart = m_sample_time % kRing_Buffer_Frame_Size;
-    UInt32 firstPartFrameSize = kRing_Buffer_Frame_Size - ringBufferFrameLocationStart;
-    UInt32 secondPartFrameSize = 0;
-    
-    if (firstPartFrameSize >= inIOBufferFrameSize)
-        firstPartFrameSize = inIOBufferFrameSize;
-    else
-        secondPartFrameSize = inIOBufferFrameSize - firstPartFrameSize;
-    
-    
-    
-    if(inOperationID == kAudioServerPlugInIOOperationReadInput)
-    {
-        if (gMute_Master_Value || lastOutputSampleTime - inIOBufferFrameSize < inIOCycleInfo->mInputTime.mSampleTime)
-        {
-            vDSP_vclr(ioMainBuffer, 1, inIOBufferFrameSize * kNumber_Of_Channels);
-            
-            if (!isBufferClear)
-            {
-                vDSP_vclr(gRingBuffer, 1, kRing_Buffer_Frame_Size * kNumber_Of_Channels);
-                isBufferClear = true;
-            }
-        }
-        else
-        {
-            memcpy(ioMainBuffer, gRingBuffer + ringBufferFrameLocationStart * kNumber_Of_Channels, firstPartFrameSize * kNumber_Of_Channels * sizeof(Float32));
-            memcpy((Float32*)ioMainBuffer + firstPartFrameSize * kNumber_Of_Channels, gRingBuffer, secondPartFrameSize * kNumber_Of_Channels * sizeof(Float32));
-            
-        if(kEnableVolumeControl)
-        {
-         vDSP_vsmul(ioMainBuffer, 1, &gVolume_Master_Value, ioMainBuffer, 1, inIOBufferFrameSize * kNumber_Of_Channels);
-        }
+    #pragma unused(context, inDataSize, outDataSize)
+    pthread_mutex_lock(&gPlugIn_StateMutex);
+    *((UInt32*)outData) = gBox_Acquired ? 1 : 0;
+    pthread_mutex_unlock(&gPlugIn_StateMutex);
+    return 0;
+}
 
-        }
+static void box_acquired_changed_async(void* inContext)
+{
+    #pragma unused(inContext)
+    AudioObjectPropertyAddress theAddress = { kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+    gPlugIn_Host->PropertiesChanged(gPlugIn_Host, kObjectID_PlugIn, 1, &theAddress);
+}
+
+static OSStatus box_set_acquired(const struct PropertyContext* context, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
+{
+    #pragma unused(context)
+    //	when the box is acquired, it means the contents, namely the devices, are available to the system
+    pthread_mutex_lock(&gPlugIn_StateMutex);
+    if(gBox_Acquired != (*((const UInt32*)inData) != 0))
+    {
+        gBox_Acquired = *((const UInt32*)inData) != 0;
+        gPlugIn_Host->WriteToStorage(gPlugIn_Host, CFSTR("box acquired"), gBox_Acquired ? kCFBooleanTrue : kCFBooleanFalse);
+
+        //	this property and the device list have changed, on the plug-in as well as on the box
+        *outNumberPropertiesChanged = 2;
+        set_changed_address(&outChangedAddresses[0], kAudioBoxPropertyAcquired);
+        set_changed_address(&outChangedAddresses[1], kAudioBoxPropertyDeviceList);
+        dispatch_async_f(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), NULL, box_acquired_changed_async);
     }
-    
-    if(inOperationID == kAudioServerPlugInIOOperationWriteMix)
+    pthread_mutex_unlock(&gPlugIn_StateMutex);
+    return 0;
+}
+
+static const struct PropertyDescriptor kBox_Properties[] = {
+    PROPERTY_CONSTANT(kAudioObjectPropertyBaseClass, kAudioObjectClassID),
+    PROPERTY_CONSTANT(kAudioObjectPropertyClass, kAudioBoxClassID),
+    PROPERTY_CONSTANT(kAudioObjectPropertyOwner, kObjectID_PlugIn),
+    PROPERTY_FIXED(kAudioObjectPropertyName, CFStringRef, box_get_name, box_set_name),
+    PROPERTY_FIXED(kAudioObjectPropertyModelName, CFStringRef, box_get_model_name, NULL),
+    PROPERTY_FIXED(kAudioObjectPropertyManufacturer, CFStringRef, property_get_apple_manufacturer, NULL),
+    PROPERTY_NONE(kAudioObjectPropertyOwnedObjects),
+    { kAudioObjectPropertyIdentify, false, sizeof(UInt32), NULL, property_get_constant, box_set_identify, 0 },
+    PROPERTY_FIXED(kAudioObjectPropertySerialNumber, CFStringRef, box_get_serial_number, NULL),
+    PROPERTY_FIXED(kAudioObjectPropertyFirmwareVersion, CFStringRef, box_get_firmware_version, NULL),
+    PROPERTY_FIXED(kAudioBoxPropertyBoxUID, CFStringRef, box_get_uid, NULL),
+    PROPERTY_CONSTANT(kAudioBoxPropertyTransportType, kAudioDeviceTransportTypeVirtual),
+    PROPERTY_CONSTANT(kAudioBoxPropertyHasAudio, 1),
+    PROPERTY_CONSTANT(kAudioBoxPropertyHasVideo, 0),
+    PROPERTY_CONSTANT(kAudioBoxPropertyHasMIDI, 0),
+    PROPERTY_CONSTANT(kAudioBoxPropertyIsProtected, 0),
+    PROPERTY_FIXED(kAudioBoxPropertyAcquired, UInt32, box_get_acquired, box_set_acquired),
+    PROPERTY_CONSTANT(kAudioBoxPropertyAcquisitionFailed, 0),
+    PROPERTY_LIST(kAudioBoxPropertyDeviceList, plugin_device_list_size, plugin_get_device_list),
+};
+
+#pragma mark Device Property Handlers
+
+static OSStatus device_get_name(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    if(!device_lock_alive(context->device))
     {
-        
-        if (inIOCycleInfo->mCurrentTime.mSampleTime > inIOCycleInfo->mOutputTime.mSampleTime + inIOBufferFrameSize + kLatency_Frame_Size)
-            return kAudioHardwareUnspecifiedError;
-        
-        
-        memcpy(gRingBuffer + ringBufferFrameLocationStart * kNumber_Of_Channels, ioMainBuffer, firstPartFrameSize * kNumber_Of_Channels * sizeof(Float32));
-        memcpy(gRingBuffer, (Float32*)ioMainBuffer + firstPartFrameSize * kNumber_Of_Channels, secondPartFrameSize * kNumber_Of_Channels * sizeof(Float32));
-        
-        lastOutputSampleTime = inIOCycleInfo->mOutputTime.mSampleTime + inIOBufferFrameSize;
-        isBufferClear = false;
+        return kAudioHardwareBadObjectError;
     }
+    *((CFStringRef*)outData) = CFRetain(context->device->name);
+    pthread_mutex_unlock(&context->device->state_mutex);
+    return 0;
+}
 
-    return the_answer;
+static OSStatus device_get_manufacturer(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(context, inDataSize, outDataSize)
+    *((CFStringRef*)outData) = CFSTR(kManufacturer_Name);
+    return 0;
 }
 
-static OSStatus	_GetPlugInPropertyData(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+//	the owned object, stream and control lists, the descriptor's value saying which one
+static UInt32 device_object_list_size(const struct PropertyContext* context)
 {
-	//	declare the local variables
-	OSStatus result = 0;
-	UInt32 theNumberItemsToFetch;
-	
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-			*((AudioClassID*)outData) = kAudioObjectClassID;
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyClass:
-			*((AudioClassID*)outData) = kAudioPlugInClassID;
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyOwner:
-			*((AudioObjectID*)outData) = kAudioObjectUnknown;
-			*outDataSize = sizeof(AudioObjectID);
-			break;
-			
-		case kAudioObjectPropertyManufacturer:
-			*((CFStringRef*)outData) = CFSTR("Apple Inc.");
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyOwnedObjects:
+    return device_object_ids(context->device, (enum ObjectList)context->descriptor->value, context->address->mScope)->count * sizeof(AudioObjectID);
+}
 
-			theNumberItemsToFetch = inDataSize / sizeof(AudioObjectID);
-			
-			//	Clamp that to the number of boxes this driver implements (which is just 1)
-			if(theNumberItemsToFetch > (gBox_Acquired ? 2 : 1))
-			{
-				theNumberItemsToFetch = (gBox_Acquired ? 2 : 1);
-			}
-			
-			//	Write the devices' object IDs into the return value
-			if(theNumberItemsToFetch > 1)
-			{
-				((AudioObjectID*)outData)[0] = kObjectID_Box;
-				((AudioObjectID*)outData)[0] = kObjectID_Device;
-			}
-			else if(theNumberItemsToFetch > 0)
-			{
-				((AudioObjectID*)outData)[0] = kObjectID_Box;
-			}
-			
-			//	Return how many bytes we wrote to
-			*outDataSize = theNumberItemsToFetch * sizeof(AudioClassID);
-			break;
-			
-		case kAudioPlugInPropertyBoxList:
+static OSStatus device_get_object_list(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    const struct ObjectIDList* theList = device_object_ids(context->device, (enum ObjectList)context->descriptor->value, context->address->mScope);
+    UInt32 theNumberItemsToFetch = minimum(inDataSize / sizeof(AudioObjectID), theList->count);
+    memcpy(outData, theList->ids, theNumberItemsToFetch * sizeof(AudioObjectID));
+    *outDataSize = theNumberItemsToFetch * sizeof(AudioObjectID);
+    return 0;
+}
 
-			theNumberItemsToFetch = inDataSize / sizeof(AudioObjectID);
-			
-			//	Clamp that to the number of boxes this driver implements (which is just 1)
-			if(theNumberItemsToFetch > 1)
-			{
-				theNumberItemsToFetch = 1;
-			}
-			
-			//	Write the devices' object IDs into the return value
-			if(theNumberItemsToFetch > 0)
-			{
-				((AudioObjectID*)outData)[0] = kObjectID_Box;
-			}
-			
-			//	Return how many bytes we wrote to
-			*outDataSize = theNumberItemsToFetch * sizeof(AudioClassID);
-			break;
-			
-		case kAudioPlugInPropertyTranslateUIDToBox:
-			FailWithAction(inDataSize < sizeof(AudioObjectID), result = kAudioHardwareBadPropertySizeError, Done, "_GetPlugInPropertyData: not enough space for the return value of kAudioPlugInPropertyTranslateUIDToBox");
+static OSStatus device_get_uid(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    if(!device_lock_alive(context->device))
+    {
+        return kAudioHardwareBadObjectError;
+    }
+    *((CFStringRef*)outData) = CFRetain(context->device->uid);
+    pthread_mutex_unlock(&context->device->state_mutex);
+    return 0;
+}
 
-			CFStringRef boxUID = get_box_uid();
+static OSStatus device_get_model_uid(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(context, inDataSize, outDataSize)
+    *((CFStringRef*)outData) = CFRetain(gDevice_ModelUID);
+    return 0;
+}
 
-			if(CFStringCompare(*((CFStringRef*)inQualifierData), boxUID, 0) == kCFCompareEqualTo)
-			{
-				CFStringRef formattedString = CFStringCreateWithFormat(NULL, NULL, CFSTR(kBox_UID), kNumber_Of_Channels);
-				if(CFStringCompare(*((CFStringRef*)inQualifierData), formattedString, 0) == kCFCompareEqualTo)
-				{
-					*((AudioObjectID*)outData) = kObjectID_Box;
-				}
-				else
-				{
-					*((AudioObjectID*)outData) = kAudioObjectUnknown;
-				}
-				*outDataSize = sizeof(AudioObjectID);
-				CFRelease(formattedString);
+static UInt32 device_related_devices_size(const struct PropertyContext* context)
+{
+    #pragma unused(context)
+    return sizeof(AudioObjectID);
+}
 
-				*((AudioObjectID*)outData) = kObjectID_Box;
-			}
-			else
-			{
-				*((AudioObjectID*)outData) = kAudioObjectUnknown;
-			}
-			*outDataSize = sizeof(AudioObjectID);
-			CFRelease(boxUID);
-			break;
-			
-		case kAudioPlugInPropertyDeviceList:
-			theNumberItemsToFetch = inDataSize / sizeof(AudioObjectID);
-			
-			//	Clamp that to the number of devices this driver implements (which is just 1 if the
-			//	box has been acquired)
-			if(theNumberItemsToFetch > (gBox_Acquired ? 2 : 0))
-			{
-				theNumberItemsToFetch = (gBox_Acquired ? 2 : 0);
-			}
-			
-			//	Write the devices' object IDs into the return value
-			if(theNumberItemsToFetch > 1)
-			{
-				((AudioObjectID*)outData)[0] = kObjectID_Device;
-                ((AudioObjectID*)outData)[1] = kObjectID_Device2;
-			}
-            else if(theNumberItemsToFetch > 0)
-            {
-                ((AudioObjectID*)outData)[0] = kObjectID_Device;
-            }
-			
-			//	Return how many bytes we wrote to
-			*outDataSize = theNumberItemsToFetch * sizeof(AudioClassID);
-			break;
-			
-		case kAudioPlugInPropertyTranslateUIDToDevice:
+static OSStatus device_get_related_devices(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    //	every cable is only related to itself
+    UInt32 theNumberItemsToFetch = minimum(inDataSize / sizeof(AudioObjectID), 1);
+    if(theNumberItemsToFetch > 0)
+    {
+        ((AudioObjectID*)outData)[0] = context->device->object_id;
+    }
+    *outDataSize = theNumberItemsToFetch * sizeof(AudioObjectID);
+    return 0;
+}
 
-			FailWithAction(inDataSize < sizeof(AudioObjectID), result = kAudioHardwareBadPropertySizeError, Done, "_GetPlugInPropertyData: not enough space for the return value of kAudioPlugInPropertyTranslateUIDToDevice");
-            
-			CFStringRef deviceUID = get_device_uid();
-            CFStringRef device2UID = get_device2_uid();
+static OSStatus device_get_is_running(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    *((UInt32*)outData) = device_state(context->device).is_running ? 1 : 0;
+    return 0;
+}
 
-			if(CFStringCompare(*((CFStringRef*)inQualifierData), deviceUID, 0) == kCFCompareEqualTo)
-			{
-				*((AudioObjectID*)outData) = kObjectID_Device;
-			}
-            else if(CFStringCompare(*((CFStringRef*)inQualifierData), device2UID, 0) == kCFCompareEqualTo)
-            {
-                *((AudioObjectID*)outData) = kObjectID_Device2;
-            }
-			else
-			{
-				*((AudioObjectID*)outData) = kAudioObjectUnknown;
-			}
-			*outDataSize = sizeof(AudioObjectID);
-			CFRelease(deviceUID);
-            CFRelease(device2UID);
-			break;
-			
-		case kAudioPlugInPropertyResourceBundle:
-			*((CFStringRef*)outData) = CFSTR("");
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		default:
-			result = kAudioHardwareUnknownPropertyError;
-			break;
-	};
-Done:
-	return result;
+static OSStatus device_get_safety_offset(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    *((UInt32*)outData) = kLatency_Profiles[device_state(context->device).latency_profile].safety_offset;
+    return 0;
 }
 
-static OSStatus	set_propertyData(pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
+static OSStatus device_get_buffer_frame_size_range(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
 {
-	#pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData, inDataSize, inData)
-	
-	//	declare the local variables
-	OSStatus result = 0;
-	
-	//	initialize the returned number of changed properties
-	*outNumberPropertiesChanged = 0;
-	
-	switch(inAddress->mSelector)
-	{
-		default:
-			result = kAudioHardwareUnknownPropertyError;
-			break;
-	};
+    #pragma unused(inDataSize, outDataSize)
+    AudioValueRange* theRange = (AudioValueRange*)outData;
+    theRange->mMinimum = 1;
+    theRange->mMaximum = latency_profile_max_io_frames(device_state(context->device).latency_profile);
+    return 0;
+}
 
-	return result;
+static OSStatus device_get_nominal_sample_rate(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    *((Float64*)outData) = device_state(context->device).sample_rate;
+    return 0;
 }
 
-#pragma mark Box Property Operations
+//	The sample rate only changes in a configuration change, so this just asks the host for one. The
+//	streams' formats go through here too.
+static OSStatus device_request_sample_rate(struct Device* device, Float64 sample_rate)
+{
+    if(!is_valid_sample_rate(sample_rate))
+    {
+        return kAudioHardwareIllegalOperationError;
+    }
+
+    if(sample_rate != device_state(device).sample_rate)
+    {
+        return request_configuration_change(device->object_id, (UInt64)sample_rate);
+    }
+    return 0;
+}
 
-static Boolean	hasbox_property(pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress)
+static OSStatus device_set_nominal_sample_rate(const struct PropertyContext* context, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
 {
-	//	This method returns whether or not the box object has the given property.
-	
-	#pragma unused(inClientProcessID)
-	
-	//	declare the local variables
-	Boolean result = false;
-	
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-		case kAudioObjectPropertyClass:
-		case kAudioObjectPropertyOwner:
-		case kAudioObjectPropertyName:
-		case kAudioObjectPropertyModelName:
-		case kAudioObjectPropertyManufacturer:
-		case kAudioObjectPropertyOwnedObjects:
-		case kAudioObjectPropertyIdentify:
-		case kAudioObjectPropertySerialNumber:
-		case kAudioObjectPropertyFirmwareVersion:
-		case kAudioBoxPropertyBoxUID:
-		case kAudioBoxPropertyTransportType:
-		case kAudioBoxPropertyHasAudio:
-		case kAudioBoxPropertyHasVideo:
-		case kAudioBoxPropertyHasMIDI:
-		case kAudioBoxPropertyIsProtected:
-		case kAudioBoxPropertyAcquired:
-		case kAudioBoxPropertyAcquisitionFailed:
-		case kAudioBoxPropertyDeviceList:
-            result = true;
-			break;
-	};
+    #pragma unused(outNumberPropertiesChanged, outChangedAddresses)
+    return device_request_sample_rate(context->device, *((const Float64*)inData));
+}
 
-	return result;
+static UInt32 available_sample_rates_size(const struct PropertyContext* context)
+{
+    #pragma unused(context)
+    return kDevice_SampleRatesSize * sizeof(AudioValueRange);
 }
 
-static OSStatus	box_property_settable(pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable)
+static OSStatus device_get_available_sample_rates(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
 {
+    #pragma unused(context)
+    UInt32 theNumberItemsToFetch = minimum(inDataSize / sizeof(AudioValueRange), kDevice_SampleRatesSize);
+    for(UInt32 i = 0; i < theNumberItemsToFetch; i++)
+    {
+        ((AudioValueRange*)outData)[i].mMinimum = kDevice_SampleRates[i];
+        ((AudioValueRange*)outData)[i].mMaximum = kDevice_SampleRates[i];
+    }
+    *outDataSize = theNumberItemsToFetch * sizeof(AudioValueRange);
+    return 0;
+}
 
-	#pragma unused(inClientProcessID)
-	
-	//	declare the local variables
-	OSStatus result = 0;
-	
+static OSStatus device_get_is_hidden(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    *((UInt32*)outData) = context->device->is_hidden;
+    return 0;
+}
 
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-		case kAudioObjectPropertyClass:
-		case kAudioObjectPropertyOwner:
-		case kAudioObjectPropertyModelName:
-		case kAudioObjectPropertyManufacturer:
-		case kAudioObjectPropertyOwnedObjects:
-		case kAudioObjectPropertySerialNumber:
-		case kAudioObjectPropertyFirmwareVersion:
-		case kAudioBoxPropertyBoxUID:
-		case kAudioBoxPropertyTransportType:
-		case kAudioBoxPropertyHasAudio:
-		case kAudioBoxPropertyHasVideo:
-		case kAudioBoxPropertyHasMIDI:
-		case kAudioBoxPropertyIsProtected:
-		case kAudioBoxPropertyAcquisitionFailed:
-		case kAudioBoxPropertyDeviceList:
-			*outIsSettable = false;
-			break;
-		
-		case kAudioObjectPropertyName:
-		case kAudioObjectPropertyIdentify:
-		case kAudioBoxPropertyAcquired:
-			*outIsSettable = true;
-			break;
-		
-		default:
-			result = kAudioHardwareUnknownPropertyError;
-			break;
-	};
+static OSStatus device_get_preferred_channels_for_stereo(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(context, inDataSize, outDataSize)
+    ((UInt32*)outData)[0] = 1;
+    ((UInt32*)outData)[1] = 2;
+    return 0;
+}
 
-	return result;
+static OSStatus device_get_preferred_channel_layout(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(context, inDataSize, outDataSize)
+    memcpy(outData, gDevice_ChannelLayout.bytes, kDevice_ChannelLayoutSize);
+    return 0;
 }
 
-static OSStatus	getbox_property_datasize(pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
+static OSStatus device_get_zero_time_stamp_period(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
 {
-	#pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData)
-	
-	//	declare the local variables
-	OSStatus result = 0;
-	
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyClass:
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyOwner:
-			*outDataSize = sizeof(AudioObjectID);
-			break;
-			
-		case kAudioObjectPropertyName:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyModelName:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyManufacturer:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyOwnedObjects:
-			*outDataSize = 0;
-			break;
-			
-		case kAudioObjectPropertyIdentify:
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioObjectPropertySerialNumber:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyFirmwareVersion:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioBoxPropertyBoxUID:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioBoxPropertyTransportType:
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyHasAudio:
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyHasVideo:
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyHasMIDI:
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyIsProtected:
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyAcquired:
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyAcquisitionFailed:
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyDeviceList:
-			{
-				pthread_mutex_lock(&gPlugIn_StateMutex);
-				*outDataSize = gBox_Acquired ? sizeof(AudioObjectID) * 2 : 0;
-				pthread_mutex_unlock(&gPlugIn_StateMutex);
-			}
-			break;
-			
-		default:
-			result = kAudioHardwareUnknownPropertyError;
-			break;
-	};
+    #pragma unused(inDataSize, outDataSize)
+    *((UInt32*)outData) = kLatency_Profiles[device_state(context->device).latency_profile].zero_time_stamp_period;
+    return 0;
+}
 
-	return result;
+static UInt32 device_custom_properties_size(const struct PropertyContext* context)
+{
+    #pragma unused(context)
+    return sizeof(kDevice_CustomProperties);
 }
 
-static OSStatus	getbox_property_data(pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+static OSStatus device_get_custom_properties(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
 {
-	#pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData)
-	
-	//	declare the local variables
-	OSStatus result = 0;
-	
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-			*((AudioClassID*)outData) = kAudioObjectClassID;
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyClass:
-			*((AudioClassID*)outData) = kAudioBoxClassID;
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyOwner:
-			*((AudioObjectID*)outData) = kObjectID_PlugIn;
-			*outDataSize = sizeof(AudioObjectID);
-			break;
-			
-		case kAudioObjectPropertyName:
-			pthread_mutex_lock(&gPlugIn_StateMutex);
-			*((CFStringRef*)outData) = gBox_Name;
-			pthread_mutex_unlock(&gPlugIn_StateMutex);
-			if(*((CFStringRef*)outData) != NULL)
-			{
-				CFRetain(*((CFStringRef*)outData));
-			}
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyModelName:
-			*((CFStringRef*)outData) = CFSTR("Null Model");
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyManufacturer:
-			*((CFStringRef*)outData) = CFSTR("Apple Inc.");
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyOwnedObjects:
-			//	This returns the objects directly owned by the object. Boxes don't own anything.
-			*outDataSize = 0;
-			break;
-			
-		case kAudioObjectPropertyIdentify:
-			*((UInt32*)outData) = 0;
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioObjectPropertySerialNumber:			*((CFStringRef*)outData) = CFSTR("00000001");
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyFirmwareVersion:
-			*((CFStringRef*)outData) = CFSTR("1.0");
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioBoxPropertyBoxUID:
+    #pragma unused(context)
+    UInt32 theNumberItemsToFetch = minimum(inDataSize / sizeof(AudioServerPlugInCustomPropertyInfo), sizeof(kDevice_CustomProperties) / sizeof(AudioServerPlugInCustomPropertyInfo));
+    memcpy(outData, kDevice_CustomProperties, theNumberItemsToFetch * sizeof(AudioServerPlugInCustomPropertyInfo));
+    *outDataSize = theNumberItemsToFetch * sizeof(AudioServerPlugInCustomPropertyInfo);
+    return 0;
+}
 
-			*((CFStringRef*)outData) = get_box_uid();
-			break;
-			
-		case kAudioBoxPropertyTransportType:
-			*((UInt32*)outData) = kAudioDeviceTransportTypeVirtual;
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyHasAudio:
-			*((UInt32*)outData) = 1;
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyHasVideo:
-			*((UInt32*)outData) = 0;
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyHasMIDI:
-			*((UInt32*)outData) = 0;
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyIsProtected:
-			*((UInt32*)outData) = 0;
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyAcquired:
-			pthread_mutex_lock(&gPlugIn_StateMutex);
-			*((UInt32*)outData) = gBox_Acquired ? 1 : 0;
-			pthread_mutex_unlock(&gPlugIn_StateMutex);
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyAcquisitionFailed:
-			*((UInt32*)outData) = 0;
-			*outDataSize = sizeof(UInt32);
-			break;
-			
-		case kAudioBoxPropertyDeviceList:
-			//	This is used to indicate which devices came from this box
-			pthread_mutex_lock(&gPlugIn_StateMutex);
-			if(gBox_Acquired)
-			{
-                if(inDataSize < sizeof(AudioObjectID))
-                {
-                    result = kAudioHardwareBadPropertySizeError;
-                    *outDataSize = 0;
-                }
-                else
-                {
-                    if (inDataSize >= sizeof(AudioObjectID) * 2)
-                    {
-                        ((AudioObjectID*)outData)[0] = kObjectID_Device;
-                        ((AudioObjectID*)outData)[1] = kObjectID_Device2;
-                        *outDataSize = sizeof(AudioObjectID) * 2;
-                    }
-                    else
-                    {
-                        ((AudioObjectID*)outData)[0] = kObjectID_Device;
-                        *outDataSize = sizeof(AudioObjectID) * 1;
-                    }
-                }
-			}
-			else
-			{
-				*outDataSize = 0;
-			}
-            
-			pthread_mutex_unlock(&gPlugIn_StateMutex);
-			break;
-			
-		default:
-			result = kAudioHardwareUnknownPropertyError;
-			break;
-	};
+//	The custom properties' values travel as CFNumbers. Returns false for anything that isn't one or
+//	doesn't fit in an SInt32.
+static bool custom_property_number(CFPropertyListRef value, SInt32* out_number)
+{
+    return (value != NULL) && (CFGetTypeID(value) == CFNumberGetTypeID()) && CFNumberGetValue((CFNumberRef)value, kCFNumberSInt32Type, out_number);
+}
 
-	return result;
+static OSStatus device_get_latency_profile(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    SInt32 theProfile = device_state(context->device).latency_profile;
+    *((CFPropertyListRef*)outData) = CFNumberCreate(NULL, kCFNumberSInt32Type, &theProfile);
+    return 0;
 }
 
-static OSStatus	set_box_property(pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
+static OSStatus device_set_latency_profile(const struct PropertyContext* context, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
 {
-	#pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData, inDataSize, inData)
-	
-	//	declare the local variables
-	OSStatus result = 0;
-	
-	//	initialize the returned number of changed properties
-	*outNumberPropertiesChanged = 0;
-	
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyName:
-			//	Boxes should allow their name to be editable
-			{
-				CFStringRef* theNewName = (CFStringRef*)inData;
-				pthread_mutex_lock(&gPlugIn_StateMutex);
-				if((theNewName != NULL) && (*theNewName != NULL))
-				{
-					CFRetain(*theNewName);
-				}
-				if(gBox_Name != NULL)
-				{
-					CFRelease(gBox_Name);
-				}
-				gBox_Name = *theNewName;
-				pthread_mutex_unlock(&gPlugIn_StateMutex);
-				*outNumberPropertiesChanged = 1;
-				outChangedAddresses[0].mSelector = kAudioObjectPropertyName;
-				outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
-				outChangedAddresses[0].mElement = kAudioObjectPropertyElementMain;
-			}
-			break;
-			
-		case kAudioObjectPropertyIdentify:
-			{
-				dispatch_after(dispatch_time(0, 2ULL * 1000ULL * 1000ULL * 1000ULL), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),	^()
-																																		{
-																																			AudioObjectPropertyAddress theAddress = { kAudioObjectPropertyIdentify, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
-																																			gPlugIn_Host->PropertiesChanged(gPlugIn_Host, kObjectID_Box, 1, &theAddress);
-																																		});
-			}
-			break;
-			
-		case kAudioBoxPropertyAcquired:
-			//	When the box is acquired, it means the contents, namely the device, are available to the system
-			{
-				pthread_mutex_lock(&gPlugIn_StateMutex);
-				if(gBox_Acquired != (*((UInt32*)inData) != 0))
-				{
-					//	the new value is different from the old value, so save it
-					gBox_Acquired = *((UInt32*)inData) != 0;
-					gPlugIn_Host->WriteToStorage(gPlugIn_Host, CFSTR("box acquired"), gBox_Acquired ? kCFBooleanTrue : kCFBooleanFalse);
-					
-					//	and it means that this property and the device list property have changed
-					*outNumberPropertiesChanged = 2;
-					outChangedAddresses[0].mSelector = kAudioBoxPropertyAcquired;
-					outChangedAddresses[0].mScope = kAudioObjectPropertyScopeGlobal;
-					outChangedAddresses[0].mElement = kAudioObjectPropertyElementMain;
-					outChangedAddresses[1].mSelector = kAudioBoxPropertyDeviceList;
-					outChangedAddresses[1].mScope = kAudioObjectPropertyScopeGlobal;
-					outChangedAddresses[1].mElement = kAudioObjectPropertyElementMain;
-					
-					//	but it also means that the device list has changed for the plug-in too
-					dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),	^()
-																									{
-																										AudioObjectPropertyAddress theAddress = { kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
-																										gPlugIn_Host->PropertiesChanged(gPlugIn_Host, kObjectID_PlugIn, 1, &theAddress);
-																									});
-				}
-				pthread_mutex_unlock(&gPlugIn_StateMutex);
-			}
-			break;
-			
-		default:
-			result = kAudioHardwareUnknownPropertyError;
-			break;
-	};
+    #pragma unused(outNumberPropertiesChanged, outChangedAddresses)
+    SInt32 theNewProfile = 0;
+    if(!custom_property_number(*((const CFPropertyListRef*)inData), &theNewProfile) || (theNewProfile < 0) || (theNewProfile >= kLatencyProfile_Count))
+    {
+        return kAudioHardwareIllegalOperationError;
+    }
 
-	return result;
+    if(theNewProfile != device_state(context->device).latency_profile)
+    {
+        //	the period and the ring size can only change while IO is stopped
+        return request_configuration_change(context->device->object_id, kDevice_ConfigChange_LatencyProfile | theNewProfile);
+    }
+    return 0;
+}
+
+static OSStatus device_get_is_silent(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    //	the ring is only swapped and freed under the state mutex
+    if(!device_lock_alive(context->device))
+    {
+        return kAudioHardwareBadObjectError;
+    }
+    bool theIsRunning = device_state_current(context->device)->is_running;
+    bool theIsSilent = !theIsRunning || ring_buffer_is_silent(&context->device->ring);
+    pthread_mutex_unlock(&context->device->state_mutex);
+
+    //	a running bus also carries whatever its sources mix in, the way device_read_input sees them. The
+    //	list is copied out of the snapshot before any source's lock is taken, since whoever publishes a
+    //	new one waits for the snapshot's readers.
+    if(theIsRunning && theIsSilent)
+    {
+        UInt32 theIndex;
+        UInt32 theTicket = snapshot_read_begin(&context->device->bus_snapshot, &theIndex);
+        struct BusSources theSources = context->device->bus_sources[theIndex];
+        snapshot_read_end(&context->device->bus_snapshot, theTicket);
+        for(UInt32 theSource = 0; theIsSilent && (theSource < theSources.count); ++theSource)
+        {
+            struct Device* theDevice = theSources.devices[theSource];
+            if((theSources.gain[theSource] != 0.0f) && device_lock_alive(theDevice))
+            {
+                theIsSilent = !device_state_current(theDevice)->is_running || ring_buffer_is_silent(&theDevice->ring);
+                pthread_mutex_unlock(&theDevice->state_mutex);
+            }
+        }
+    }
+
+    SInt32 theValue = theIsSilent ? 1 : 0;
+    *((CFPropertyListRef*)outData) = CFNumberCreate(NULL, kCFNumberSInt32Type, &theValue);
+    return 0;
 }
 
-#pragma mark Device Property Operations
+static OSStatus device_get_client_delay(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    UInt32 theDelay = 0;
+    pthread_mutex_lock(&context->device->state_mutex);
+    for(UInt32 theIndex = 0; theIndex < kMax_Number_Of_Clients; ++theIndex)
+    {
+        const struct DeviceClient* theClient = &context->device->clients[theIndex];
+        if((atomic_load_explicit(&theClient->client_id, memory_order_relaxed) != 0) && (theClient->pid == context->client_pid))
+        {
+            theDelay = atomic_load_explicit(&theClient->delay_frames, memory_order_relaxed);
+        }
+    }
+    pthread_mutex_unlock(&context->device->state_mutex);
+    SInt32 theValue = (SInt32)theDelay;
+    *((CFPropertyListRef*)outData) = CFNumberCreate(NULL, kCFNumberSInt32Type, &theValue);
+    return 0;
+}
 
-static Boolean	has_device_property( pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress)
+static OSStatus device_set_client_delay(const struct PropertyContext* context, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
 {
-	//	This method returns whether or not the given object has the given property.
-	
-	#pragma unused(inClientProcessID)
-	
-	//	declare the local variables
-	Boolean result = false;
-	
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-		case kAudioObjectPropertyClass:
-		case kAudioObjectPropertyOwner:
-		case kAudioObjectPropertyName:
-		case kAudioObjectPropertyManufacturer:
-		case kAudioObjectPropertyOwnedObjects:
-		case kAudioDevicePropertyDeviceUID:
-		case kAudioDevicePropertyModelUID:
-		case kAudioDevicePropertyTransportType:
-		case kAudioDevicePropertyRelatedDevices:
-		case kAudioDevicePropertyClockDomain:
-		case kAudioDevicePropertyDeviceIsAlive:
-		case kAudioDevicePropertyDeviceIsRunning:
-		case kAudioObjectPropertyControlList:
-		case kAudioDevicePropertyNominalSampleRate:
-		case kAudioDevicePropertyAvailableNominalSampleRates:
-		case kAudioDevicePropertyIsHidden:
-		case kAudioDevicePropertyZeroTimeStampPeriod:
-		case kAudioDevicePropertyIcon:
-		case kAudioDevicePropertyStreams:
-            result = true;
-			break;
-			
-		case kAudioDevicePropertyDeviceCanBeDefaultDevice:
-		case kAudioDevicePropertyDeviceCanBeDefaultSystemDevice:
-		case kAudioDevicePropertyLatency:
-		case kAudioDevicePropertySafetyOffset:
-		case kAudioDevicePropertyPreferredChannelsForStereo:
-		case kAudioDevicePropertyPreferredChannelLayout:
-            result = (inAddress->mScope == kAudioObjectPropertyScopeInput) || (inAddress->mScope == kAudioObjectPropertyScopeOutput);
-			break;
-	};
+    #pragma unused(outNumberPropertiesChanged, outChangedAddresses)
+    SInt32 theDelay = 0;
+    if(!custom_property_number(*((const CFPropertyListRef*)inData), &theDelay) || (theDelay < 0))
+    {
+        return kAudioHardwareIllegalOperationError;
+    }
+    UInt32 theClientCount = 0;
+    bool theProcessInputChanges = false;
+    pthread_mutex_lock(&context->device->state_mutex);
+    if((UInt32)theDelay <= kLatency_Profiles[device_state_current(context->device)->latency_profile].ring_frame_count / 2)
+    {
+        for(UInt32 theIndex = 0; theIndex < kMax_Number_Of_Clients; ++theIndex)
+        {
+            struct DeviceClient* theClient = &context->device->clients[theIndex];
+            if((atomic_load_explicit(&theClient->client_id, memory_order_relaxed) != 0) && (theClient->pid == context->client_pid))
+            {
+                UInt32 theOldDelay = atomic_exchange_explicit(&theClient->delay_frames, (UInt32)theDelay, memory_order_relaxed);
+                theProcessInputChanges |= ((theOldDelay > 0) != (theDelay > 0));
+                ++theClientCount;
+            }
+        }
+        device_clients_count_delayed(context->device);
+    }
+    pthread_mutex_unlock(&context->device->state_mutex);
 
-	return result;
+    //	too long a delay, or a process that isn't a client of the device
+    if(theClientCount == 0)
+    {
+        return kAudioHardwareIllegalOperationError;
+    }
+    return theProcessInputChanges ? request_configuration_change(context->device->object_id, kDevice_ConfigChange_ClientDelay) : 0;
 }
 
-static OSStatus	device_property_settable( pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable)
+static OSStatus device_get_bus_gain(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
 {
-	//	This method returns whether or not the given property on the object can have its value
-	//	changed.
-	
-	#pragma unused(inClientProcessID)
-	
-	//	declare the local variables
-	OSStatus result = 0;
+    #pragma unused(inDataSize, outDataSize)
+    Float32 theGain = device_state(context->device).bus_gain;
+    *((CFPropertyListRef*)outData) = CFNumberCreate(NULL, kCFNumberFloat32Type, &theGain);
+    return 0;
+}
 
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-		case kAudioObjectPropertyClass:
-		case kAudioObjectPropertyOwner:
-		case kAudioObjectPropertyName:
-		case kAudioObjectPropertyManufacturer:
-		case kAudioObjectPropertyOwnedObjects:
-		case kAudioDevicePropertyDeviceUID:
-		case kAudioDevicePropertyModelUID:
-		case kAudioDevicePropertyTransportType:
-		case kAudioDevicePropertyRelatedDevices:
-		case kAudioDevicePropertyClockDomain:
-		case kAudioDevicePropertyDeviceIsAlive:
-		case kAudioDevicePropertyDeviceIsRunning:
-		case kAudioDevicePropertyDeviceCanBeDefaultDevice:
-		case kAudioDevicePropertyDeviceCanBeDefaultSystemDevice:
-		case kAudioDevicePropertyLatency:
-		case kAudioDevicePropertyStreams:
-		case kAudioObjectPropertyControlList:
-		case kAudioDevicePropertySafetyOffset:
-		case kAudioDevicePropertyAvailableNominalSampleRates:
-		case kAudioDevicePropertyIsHidden:
-		case kAudioDevicePropertyPreferredChannelsForStereo:
-		case kAudioDevicePropertyPreferredChannelLayout:
-		case kAudioDevicePropertyZeroTimeStampPeriod:
-		case kAudioDevicePropertyIcon:
-			*outIsSettable = false;
-			break;
-		
-		case kAudioDevicePropertyNominalSampleRate:
-			*outIsSettable = true;
-			break;
-		
-		default:
-			result = kAudioHardwareUnknownPropertyError;
-			break;
-	};
+static OSStatus device_set_bus_gain(const struct PropertyContext* context, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
+{
+    CFPropertyListRef theValue = *((const CFPropertyListRef*)inData);
+    Float64 theNumber = 0.0;
+    if((theValue == NULL) || (CFGetTypeID(theValue) != CFNumberGetTypeID()) || !CFNumberGetValue((CFNumberRef)theValue, kCFNumberFloat64Type, &theNumber) || !((theNumber >= 0.0) && (theNumber <= kBus_MaxGain)))
+    {
+        return kAudioHardwareIllegalOperationError;
+    }
+    Float32 theGain = (Float32)theNumber;
 
-	return result;
+    //	the bus keeps its own copy of the gain, which it gets from the device table
+    pthread_mutex_lock(&gPlugIn_StateMutex);
+    pthread_mutex_lock(&context->device->state_mutex);
+    bool theGainChanged = device_state_current(context->device)->bus_gain != theGain;
+    if(theGainChanged)
+    {
+        device_state_edit(context->device)->bus_gain = theGain;
+        device_state_publish(context->device);
+        *outNumberPropertiesChanged = 1;
+        set_changed_address(&outChangedAddresses[0], kVACDevicePropertyBusGain);
+    }
+    pthread_mutex_unlock(&context->device->state_mutex);
+    if(theGainChanged && (context->device->bus != NULL))
+    {
+        device_bus_publish(context->device->bus, NULL);
+    }
+    pthread_mutex_unlock(&gPlugIn_StateMutex);
+    return 0;
 }
 
-static OSStatus	get_device_property_size( AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
+static OSStatus device_get_icon(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
 {
-	//	This method returns the byte size of the property's data.
-	
-	#pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData)
-	
-	//	declare the local variables
-	OSStatus result = 0;
-	
-	
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyClass:
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyOwner:
-			*outDataSize = sizeof(AudioObjectID);
-			break;
-			
-		case kAudioObjectPropertyName:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyManufacturer:
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyOwnedObjects:
-            *outDataSize = device_object_list_size(inAddress->mScope, inObjectID) * sizeof(AudioObjectID);
-			break;
+    #pragma unused(context, inDataSize, outDataSize)
+    *((CFURLRef*)outData) = (gDevice_Icon != NULL) ? CFRetain(gDevice_Icon) : NULL;
+    return 0;
+}
 
-		case kAudioDevicePropertyDeviceUID:
-			*outDataSize = sizeof(CFStringRef);
-			break;
+static const struct PropertyDescriptor kDevice_Properties[] = {
+    PROPERTY_CONSTANT(kAudioObjectPropertyBaseClass, kAudioObjectClassID),
+    PROPERTY_CONSTANT(kAudioObjectPropertyClass, kAudioDeviceClassID),
+    PROPERTY_CONSTANT(kAudioObjectPropertyOwner, kObjectID_PlugIn),
+    PROPERTY_FIXED(kAudioObjectPropertyName, CFStringRef, device_get_name, NULL),
+    PROPERTY_FIXED(kAudioObjectPropertyManufacturer, CFStringRef, device_get_manufacturer, NULL),
+    PROPERTY_OBJECT_LIST(kAudioObjectPropertyOwnedObjects, kObjectList_Owned),
+    PROPERTY_FIXED(kAudioDevicePropertyDeviceUID, CFStringRef, device_get_uid, NULL),
+    PROPERTY_FIXED(kAudioDevicePropertyModelUID, CFStringRef, device_get_model_uid, NULL),
+    PROPERTY_CONSTANT(kAudioDevicePropertyTransportType, kAudioDeviceTransportTypeVirtual),
+    PROPERTY_LIST(kAudioDevicePropertyRelatedDevices, device_related_devices_size, device_get_related_devices),
+    PROPERTY_CONSTANT(kAudioDevicePropertyClockDomain, 0),
+    PROPERTY_CONSTANT(kAudioDevicePropertyDeviceIsAlive, 1),
+    PROPERTY_FIXED(kAudioDevicePropertyDeviceIsRunning, UInt32, device_get_is_running, NULL),
+    PROPERTY_IO_CONSTANT(kAudioDevicePropertyDeviceCanBeDefaultDevice, 1),
+    PROPERTY_IO_CONSTANT(kAudioDevicePropertyDeviceCanBeDefaultSystemDevice, 1),
+    PROPERTY_IO_CONSTANT(kAudioDevicePropertyLatency, 0),
+    PROPERTY_OBJECT_LIST(kAudioDevicePropertyStreams, kObjectList_Streams),
+    PROPERTY_OBJECT_LIST(kAudioObjectPropertyControlList, kObjectList_Controls),
+    PROPERTY_IO_FIXED(kAudioDevicePropertySafetyOffset, sizeof(UInt32), device_get_safety_offset),
+    PROPERTY_FIXED(kAudioDevicePropertyBufferFrameSizeRange, AudioValueRange, device_get_buffer_frame_size_range, NULL),
+    PROPERTY_FIXED(kAudioDevicePropertyNominalSampleRate, Float64, device_get_nominal_sample_rate, device_set_nominal_sample_rate),
+    PROPERTY_LIST(kAudioDevicePropertyAvailableNominalSampleRates, available_sample_rates_size, device_get_available_sample_rates),
+    PROPERTY_FIXED(kAudioDevicePropertyIsHidden, UInt32, device_get_is_hidden, NULL),
+    PROPERTY_IO_FIXED(kAudioDevicePropertyPreferredChannelsForStereo, 2 * sizeof(UInt32), device_get_preferred_channels_for_stereo),
+    PROPERTY_IO_FIXED(kAudioDevicePropertyPreferredChannelLayout, kDevice_ChannelLayoutSize, device_get_preferred_channel_layout),
+    PROPERTY_FIXED(kAudioDevicePropertyZeroTimeStampPeriod, UInt32, device_get_zero_time_stamp_period, NULL),
+    PROPERTY_FIXED(kAudioDevicePropertyIcon, CFURLRef, device_get_icon, NULL),
+    PROPERTY_LIST(kAudioObjectPropertyCustomPropertyInfoList, device_custom_properties_size, device_get_custom_properties),
+    PROPERTY_FIXED(kVACDevicePropertyLatencyProfile, CFPropertyListRef, device_get_latency_profile, device_set_latency_profile),
+    PROPERTY_FIXED(kVACDevicePropertyIsSilent, CFPropertyListRef, device_get_is_silent, NULL),
+    PROPERTY_FIXED(kVACDevicePropertyClientDelay, CFPropertyListRef, device_get_client_delay, device_set_client_delay),
+    PROPERTY_FIXED(kVACDevicePropertyBusGain, CFPropertyListRef, device_get_bus_gain, device_set_bus_gain),
+};
 
-		case kAudioDevicePropertyModelUID:
-			*outDataSize = sizeof(CFStringRef);
-			break;
+#pragma mark Stream Property Handlers
 
-		case kAudioDevicePropertyTransportType:
-			*outDataSize = sizeof(UInt32);
-			break;
+static OSStatus stream_get_is_active(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    struct DeviceState theState = device_state(context->device);
+    *((UInt32*)outData) = (context->role == kObjectRole_Stream_Input) ? theState.stream_input_is_active : theState.stream_output_is_active;
+    return 0;
+}
 
-		case kAudioDevicePropertyRelatedDevices:
-			*outDataSize = sizeof(AudioObjectID);
-			break;
+static OSStatus stream_set_is_active(const struct PropertyContext* context, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
+{
+    bool theIsActive = *((const UInt32*)inData) != 0;
+    pthread_mutex_lock(&context->device->state_mutex);
+    const struct DeviceState* theState = device_state_current(context->device);
+    if(((context->role == kObjectRole_Stream_Input) ? theState->stream_input_is_active : theState->stream_output_is_active) != theIsActive)
+    {
+        struct DeviceState* theNewState = device_state_edit(context->device);
+        *((context->role == kObjectRole_Stream_Input) ? &theNewState->stream_input_is_active : &theNewState->stream_output_is_active) = theIsActive;
+        device_state_publish(context->device);
+        device_controls_publish(context->device);
+        *outNumberPropertiesChanged = 1;
+        set_changed_address(&outChangedAddresses[0], kAudioStreamPropertyIsActive);
+    }
+    pthread_mutex_unlock(&context->device->state_mutex);
+    return 0;
+}
 
-		case kAudioDevicePropertyClockDomain:
-			*outDataSize = sizeof(UInt32);
-			break;
+static OSStatus stream_get_direction(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    *((UInt32*)outData) = (context->role == kObjectRole_Stream_Input) ? 1 : 0;
+    return 0;
+}
 
-		case kAudioDevicePropertyDeviceIsAlive:
-			*outDataSize = sizeof(AudioClassID);
-			break;
+static OSStatus stream_get_terminal_type(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    *((UInt32*)outData) = (context->role == kObjectRole_Stream_Input) ? kAudioStreamTerminalTypeMicrophone : kAudioStreamTerminalTypeSpeaker;
+    return 0;
+}
 
-		case kAudioDevicePropertyDeviceIsRunning:
-			*outDataSize = sizeof(UInt32);
-			break;
+static void stream_fill_format(AudioStreamBasicDescription* outFormat, Float64 sample_rate)
+{
+    outFormat->mSampleRate = sample_rate;
+    outFormat->mFormatID = kAudioFormatLinearPCM;
+    outFormat->mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagsNativeEndian | kAudioFormatFlagIsPacked;
+    outFormat->mBytesPerPacket = kBytes_Per_Frame;
+    outFormat->mFramesPerPacket = 1;
+    outFormat->mBytesPerFrame = kBytes_Per_Frame;
+    outFormat->mChannelsPerFrame = kNumber_Of_Channels;
+    outFormat->mBitsPerChannel = kBits_Per_Channel;
+}
 
-		case kAudioDevicePropertyDeviceCanBeDefaultDevice:
-			*outDataSize = sizeof(UInt32);
-			break;
+static OSStatus stream_get_format(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    stream_fill_format((AudioStreamBasicDescription*)outData, device_state(context->device).sample_rate);
+    return 0;
+}
 
-		case kAudioDevicePropertyDeviceCanBeDefaultSystemDevice:
-			*outDataSize = sizeof(UInt32);
-			break;
+static OSStatus stream_set_format(const struct PropertyContext* context, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
+{
+    #pragma unused(outNumberPropertiesChanged, outChangedAddresses)
+    return device_request_sample_rate(context->device, ((const AudioStreamBasicDescription*)inData)->mSampleRate);
+}
 
-		case kAudioDevicePropertyLatency:
-			*outDataSize = sizeof(UInt32);
-			break;
+static UInt32 stream_available_formats_size(const struct PropertyContext* context)
+{
+    #pragma unused(context)
+    return kDevice_SampleRatesSize * sizeof(AudioStreamRangedDescription);
+}
 
-		case kAudioDevicePropertyStreams:
-            *outDataSize = device_stream_list_size(inAddress->mScope, inObjectID) * sizeof(AudioObjectID);
-			break;
+static OSStatus stream_get_available_formats(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(context)
+    UInt32 theNumberItemsToFetch = minimum(inDataSize / sizeof(AudioStreamRangedDescription), kDevice_SampleRatesSize);
+    for(UInt32 i = 0; i < theNumberItemsToFetch; i++)
+    {
+        stream_fill_format(&((AudioStreamRangedDescription*)outData)[i].mFormat, kDevice_SampleRates[i]);
+        ((AudioStreamRangedDescription*)outData)[i].mSampleRateRange.mMinimum = kDevice_SampleRates[i];
+        ((AudioStreamRangedDescription*)outData)[i].mSampleRateRange.mMaximum = kDevice_SampleRates[i];
+    }
+    *outDataSize = theNumberItemsToFetch * sizeof(AudioStreamRangedDescription);
+    return 0;
+}
 
-		case kAudioObjectPropertyControlList:
-            *outDataSize = device_control_list_size(inAddress->mScope, inObjectID) * sizeof(AudioObjectID);
-			break;
+static const struct PropertyDescriptor kStream_Properties[] = {
+    PROPERTY_CONSTANT(kAudioObjectPropertyBaseClass, kAudioObjectClassID),
+    PROPERTY_CONSTANT(kAudioObjectPropertyClass, kAudioStreamClassID),
+    PROPERTY_FIXED(kAudioObjectPropertyOwner, AudioObjectID, property_get_device_owner, NULL),
+    PROPERTY_NONE(kAudioObjectPropertyOwnedObjects),
+    PROPERTY_FIXED(kAudioStreamPropertyIsActive, UInt32, stream_get_is_active, stream_set_is_active),
+    PROPERTY_FIXED(kAudioStreamPropertyDirection, UInt32, stream_get_direction, NULL),
+    PROPERTY_FIXED(kAudioStreamPropertyTerminalType, UInt32, stream_get_terminal_type, NULL),
+    PROPERTY_CONSTANT(kAudioStreamPropertyStartingChannel, 1),
+    PROPERTY_CONSTANT(kAudioStreamPropertyLatency, kLatency_Frame_Size),
+    PROPERTY_FIXED(kAudioStreamPropertyVirtualFormat, AudioStreamBasicDescription, stream_get_format, stream_set_format),
+    PROPERTY_FIXED(kAudioStreamPropertyPhysicalFormat, AudioStreamBasicDescription, stream_get_format, stream_set_format),
+    PROPERTY_LIST(kAudioStreamPropertyAvailableVirtualFormats, stream_available_formats_size, stream_get_available_formats),
+    PROPERTY_LIST(kAudioStreamPropertyAvailablePhysicalFormats, stream_available_formats_size, stream_get_available_formats),
+};
 
-		case kAudioDevicePropertySafetyOffset:
-			*outDataSize = sizeof(UInt32);
-			break;
+#pragma mark Control Property Handlers
 
-		case kAudioDevicePropertyNominalSampleRate:
-			*outDataSize = sizeof(Float64);
-			break;
+static enum ControlScope control_scope(const struct PropertyContext* context)
+{
+    return (object_info(context->role)->scope == kAudioObjectPropertyScopeInput) ? kControlScope_Input : kControlScope_Output;
+}
 
-		case kAudioDevicePropertyAvailableNominalSampleRates:
-			*outDataSize = kDevice_SampleRatesSize * sizeof(AudioValueRange);
-			break;
-		
-		case kAudioDevicePropertyIsHidden:
-			*outDataSize = sizeof(UInt32);
-			break;
+static AudioObjectPropertyElement control_element(const struct PropertyContext* context)
+{
+    return object_info(context->role)->element;
+}
 
-		case kAudioDevicePropertyPreferredChannelsForStereo:
-			*outDataSize = 2 * sizeof(UInt32);
-			break;
+static OSStatus control_get_scope(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    *((AudioObjectPropertyScope*)outData) = object_info(context->role)->scope;
+    return 0;
+}
 
-		case kAudioDevicePropertyPreferredChannelLayout:
-			*outDataSize = offsetof(AudioChannelLayout, mChannelDescriptions) + (kNumber_Of_Channels * sizeof(AudioChannelDescription));
-			break;
+static OSStatus control_get_element(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    *((AudioObjectPropertyElement*)outData) = control_element(context);
+    return 0;
+}
 
-		case kAudioDevicePropertyZeroTimeStampPeriod:
-			*outDataSize = sizeof(UInt32);
-			break;
+static OSStatus volume_get_scalar(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    *((Float32*)outData) = volume_to_scalar(device_state(context->device).volume_value[control_scope(context)][control_element(context)]);
+    return 0;
+}
 
-		case kAudioDevicePropertyIcon:
-			*outDataSize = sizeof(CFURLRef);
-			break;
+static OSStatus volume_get_decibels(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    *((Float32*)outData) = volume_to_decibel(device_state(context->device).volume_value[control_scope(context)][control_element(context)]);
+    return 0;
+}
 
-		default:
-			result = kAudioHardwareUnknownPropertyError;
-			break;
-	};
+//	both value properties change together, whichever one was set
+static void volume_store(const struct PropertyContext* context, Float32 volume, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
+{
+    if(volume < 0.0f)
+    {
+        volume = 0.0f;
+    }
+    else if(volume > 1.0f)
+    {
+        volume = 1.0f;
+    }
 
-	return result;
+    enum ControlScope theScope = control_scope(context);
+    AudioObjectPropertyElement theElement = control_element(context);
+    pthread_mutex_lock(&context->device->state_mutex);
+    if(device_state_current(context->device)->volume_value[theScope][theElement] != volume)
+    {
+        device_state_edit(context->device)->volume_value[theScope][theElement] = volume;
+        device_state_publish(context->device);
+        device_controls_publish(context->device);
+        *outNumberPropertiesChanged = 2;
+        set_changed_address(&outChangedAddresses[0], kAudioLevelControlPropertyScalarValue);
+        set_changed_address(&outChangedAddresses[1], kAudioLevelControlPropertyDecibelValue);
+    }
+    pthread_mutex_unlock(&context->device->state_mutex);
 }
 
-static OSStatus	get_device_property( AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+static OSStatus volume_set_scalar(const struct PropertyContext* context, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
 {
-	#pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData)
-	
-	//	declare the local variables
-	OSStatus result = 0;
-	UInt32 theNumberItemsToFetch;
-	UInt32 theItemIndex;
-	
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-			*((AudioClassID*)outData) = kAudioObjectClassID;
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyClass:
-			*((AudioClassID*)outData) = kAudioDeviceClassID;
-			*outDataSize = sizeof(AudioClassID);
-			break;
-			
-		case kAudioObjectPropertyOwner:
-			*((AudioObjectID*)outData) = kObjectID_PlugIn;
-			*outDataSize = sizeof(AudioObjectID);
-			break;
-			
-		case kAudioObjectPropertyName:
-            
-            switch (inObjectID) {
-                case kObjectID_Device:
-                    *((CFStringRef*)outData) = get_device_name();
-                    *outDataSize = sizeof(CFStringRef);
-                    break;
-                    
-                case kObjectID_Device2:
-                    *((CFStringRef*)outData) = get_device2_name();
-                    *outDataSize = sizeof(CFStringRef);
-                    break;
-            }
-			break;
-			
-		case kAudioObjectPropertyManufacturer:
-			*((CFStringRef*)outData) = CFSTR(kManufacturer_Name);
-			*outDataSize = sizeof(CFStringRef);
-			break;
-			
-		case kAudioObjectPropertyOwnedObjects:
-            theNumberItemsToFetch = minimum(inDataSize / sizeof(AudioObjectID), device_object_list_size(inAddress->mScope, inObjectID));
+    volume_store(context, volume_from_scalar(*((const Float32*)inData)), outNumberPropertiesChanged, outChangedAddresses);
+    return 0;
+}
 
-            //    fill out the list with the right objects
-            for (UInt32 i = 0, k = 0; k < theNumberItemsToFetch; i++)
-            {
-                if (kDevice_ObjectList[i].scope == inAddress->mScope || inAddress->mScope == kAudioObjectPropertyScopeGlobal)
-                {
-                    ((AudioObjectID*)outData)[k++] = kDevice_ObjectList[i].id;
-                }
-            }
-			//	report how much we wrote
-			*outDataSize = theNumberItemsToFetch * sizeof(AudioObjectID);
-			break;
+static OSStatus volume_set_decibels(const struct PropertyContext* context, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
+{
+    Float32 theDecibels = *((const Float32*)inData);
+    if(theDecibels < kVolume_MinDB)
+    {
+        theDecibels = kVolume_MinDB;
+    }
+    else if(theDecibels > kVolume_MaxDB)
+    {
+        theDecibels = kVolume_MaxDB;
+    }
+    volume_store(context, volume_from_decibel(theDecibels), outNumberPropertiesChanged, outChangedAddresses);
+    return 0;
+}
 
-		case kAudioDevicePropertyDeviceUID:
-
-            switch (inObjectID) {
-                case kObjectID_Device:
-                    *((CFStringRef*)outData) = get_device_uid();
-                    *outDataSize = sizeof(CFStringRef);
-                    break;
-                    
-                case kObjectID_Device2:
-                    *((CFStringRef*)outData) = get_device2_uid();
-                    *outDataSize = sizeof(CFStringRef);
-                    break;
-            }
-            
+static OSStatus volume_get_decibel_range(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(context, inDataSize, outDataSize)
+    ((AudioValueRange*)outData)->mMinimum = kVolume_MinDB;
+    ((AudioValueRange*)outData)->mMaximum = kVolume_MaxDB;
+    return 0;
+}
 
-			break;
+//	the conversions take their argument in outData and convert it in place
+static OSStatus volume_convert_scalar_to_decibels(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(context, inDataSize, outDataSize)
+    Float32 theValue = *((Float32*)outData);
+    if(theValue < 0.0f)
+    {
+        theValue = 0.0f;
+    }
+    if(theValue > 1.0f)
+    {
+        theValue = 1.0f;
+    }
+    theValue *= theValue;
+    *((Float32*)outData) = kVolume_MinDB + (theValue * (kVolume_MaxDB - kVolume_MinDB));
+    return 0;
+}
 
-		case kAudioDevicePropertyModelUID:
+static OSStatus volume_convert_decibels_to_scalar(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(context, inDataSize, outDataSize)
+    Float32 theValue = *((Float32*)outData);
+    if(theValue < kVolume_MinDB)
+    {
+        theValue = kVolume_MinDB;
+    }
+    if(theValue > kVolume_MaxDB)
+    {
+        theValue = kVolume_MaxDB;
+    }
+    theValue = (theValue - kVolume_MinDB) / (kVolume_MaxDB - kVolume_MinDB);
+    *((Float32*)outData) = sqrtf(theValue);
+    return 0;
+}
 
-            *((CFStringRef*)outData) = get_device_model_uid();
-			*outDataSize = sizeof(CFStringRef);
-			break;
+static OSStatus mute_get_value(const struct PropertyContext* context, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(inDataSize, outDataSize)
+    *((UInt32*)outData) = device_state(context->device).mute_value[control_scope(context)][control_element(context)] ? 1 : 0;
+    return 0;
+}
 
-		case kAudioDevicePropertyTransportType:
-			*((UInt32*)outData) = kAudioDeviceTransportTypeVirtual;
-			*outDataSize = sizeof(UInt32);
-			break;
+static OSStatus mute_set_value(const struct PropertyContext* context, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
+{
+    bool theMute = *((const UInt32*)inData) != 0;
+    enum ControlScope theScope = control_scope(context);
+    AudioObjectPropertyElement theElement = control_element(context);
+    pthread_mutex_lock(&context->device->state_mutex);
+    if(device_state_current(context->device)->mute_value[theScope][theElement] != theMute)
+    {
+        device_state_edit(context->device)->mute_value[theScope][theElement] = theMute;
+        device_state_publish(context->device);
+        device_controls_publish(context->device);
+        *outNumberPropertiesChanged = 1;
+        set_changed_address(&outChangedAddresses[0], kAudioBooleanControlPropertyValue);
+    }
+    pthread_mutex_unlock(&context->device->state_mutex);
+    return 0;
+}
 
-		case kAudioDevicePropertyRelatedDevices:
-			theNumberItemsToFetch = inDataSize / sizeof(AudioObjectID);
-			
-			//	we only have the one device...
-			if(theNumberItemsToFetch > 1)
-			{
-				theNumberItemsToFetch = 1;
-			}
-			
-			//	Write the devices' object IDs into the return value
-			if(theNumberItemsToFetch > 0)
-			{
-                switch (inObjectID) {
-                    case kObjectID_Device:
-                        ((AudioObjectID*)outData)[0] = kObjectID_Device;
-                        break;
-                        
-                    case kObjectID_Device2:
-                        ((AudioObjectID*)outData)[0] = kObjectID_Device2;
-                        break;
-                }
-				
-			}
-			
-			//	report how much we wrote
-			*outDataSize = theNumberItemsToFetch * sizeof(AudioObjectID);
-			break;
+static const struct PropertyDescriptor kVolume_Properties[] = {
+    PROPERTY_CONSTANT(kAudioObjectPropertyBaseClass, kAudioLevelControlClassID),
+    PROPERTY_CONSTANT(kAudioObjectPropertyClass, kAudioVolumeControlClassID),
+    PROPERTY_FIXED(kAudioObjectPropertyOwner, AudioObjectID, property_get_device_owner, NULL),
+    PROPERTY_NONE(kAudioObjectPropertyOwnedObjects),
+    PROPERTY_FIXED(kAudioControlPropertyScope, AudioObjectPropertyScope, control_get_scope, NULL),
+    PROPERTY_FIXED(kAudioControlPropertyElement, AudioObjectPropertyElement, control_get_element, NULL),
+    PROPERTY_FIXED(kAudioLevelControlPropertyScalarValue, Float32, volume_get_scalar, volume_set_scalar),
+    PROPERTY_FIXED(kAudioLevelControlPropertyDecibelValue, Float32, volume_get_decibels, volume_set_decibels),
+    PROPERTY_FIXED(kAudioLevelControlPropertyDecibelRange, AudioValueRange, volume_get_decibel_range, NULL),
+    PROPERTY_FIXED(kAudioLevelControlPropertyConvertScalarToDecibels, Float32, volume_convert_scalar_to_decibels, NULL),
+    PROPERTY_FIXED(kAudioLevelControlPropertyConvertDecibelsToScalar, Float32, volume_convert_decibels_to_scalar, NULL),
+};
 
-		case kAudioDevicePropertyClockDomain:
-			*((UInt32*)outData) = 0;
-			*outDataSize = sizeof(UInt32);
-			break;
+static const struct PropertyDescriptor kMute_Properties[] = {
+    PROPERTY_CONSTANT(kAudioObjectPropertyBaseClass, kAudioBooleanControlClassID),
+    PROPERTY_CONSTANT(kAudioObjectPropertyClass, kAudioMuteControlClassID),
+    PROPERTY_FIXED(kAudioObjectPropertyOwner, AudioObjectID, property_get_device_owner, NULL),
+    PROPERTY_NONE(kAudioObjectPropertyOwnedObjects),
+    PROPERTY_FIXED(kAudioControlPropertyScope, AudioObjectPropertyScope, control_get_scope, NULL),
+    PROPERTY_FIXED(kAudioControlPropertyElement, AudioObjectPropertyElement, control_get_element, NULL),
+    PROPERTY_FIXED(kAudioBooleanControlPropertyValue, UInt32, mute_get_value, mute_set_value),
+};
 
-		case kAudioDevicePropertyDeviceIsAlive:
-			*((UInt32*)outData) = 1;
-			*outDataSize = sizeof(UInt32);
-			break;
+#pragma mark Property Lookup
 
-		case kAudioDevicePropertyDeviceIsRunning:
-			pthread_mutex_lock(&gPlugIn_StateMutex);
-			*((UInt32*)outData) = ((gDevice_IOIsRunning > 0) > 0) ? 1 : 0;
-			pthread_mutex_unlock(&gPlugIn_StateMutex);
-			*outDataSize = sizeof(UInt32);
-			break;
+#define PROPERTY_TABLE(inTable)     { inTable, sizeof(inTable) / sizeof(inTable[0]) }
 
-		case kAudioDevicePropertyDeviceCanBeDefaultDevice:
-			*((UInt32*)outData) = 1;
-			*outDataSize = sizeof(UInt32);
-			break;
+static const struct {
+    const struct PropertyDescriptor*    descriptors;
+    UInt32                              count;
+} kProperty_Tables[kPropertyClass_Count] = {
+    [kPropertyClass_PlugIn] = PROPERTY_TABLE(kPlugIn_Properties),
+    [kPropertyClass_Box]    = PROPERTY_TABLE(kBox_Properties),
+    [kPropertyClass_Device] = PROPERTY_TABLE(kDevice_Properties),
+    [kPropertyClass_Stream] = PROPERTY_TABLE(kStream_Properties),
+    [kPropertyClass_Volume] = PROPERTY_TABLE(kVolume_Properties),
+    [kPropertyClass_Mute]   = PROPERTY_TABLE(kMute_Properties),
+};
 
-		case kAudioDevicePropertyDeviceCanBeDefaultSystemDevice:
-			*((UInt32*)outData) = 1;
-			*outDataSize = sizeof(UInt32);
-			break;
+//	a power of two at least twice the size of the biggest table, so probes stay short
+#define                             kPropertyIndex_Bits                 6
+#define                             kPropertyIndex_Size                 (1 << kPropertyIndex_Bits)
 
-		case kAudioDevicePropertyLatency:
-			*((UInt32*)outData) = 0;
-			*outDataSize = sizeof(UInt32);
-			break;
+//	written in _Initialize, which leaves it as it is when called again, and only read afterwards
+static const struct PropertyDescriptor* gProperty_Index[kPropertyClass_Count][kPropertyIndex_Size];
 
-		case kAudioDevicePropertyStreams:
-            theNumberItemsToFetch = minimum(inDataSize / sizeof(AudioObjectID), device_stream_list_size(inAddress->mScope, inObjectID));
+static UInt32 property_index_slot(AudioObjectPropertySelector selector)
+{
+    //	Fibonacci hashing spreads the four character codes, which share most of their bits
+    return (UInt32)(selector * 2654435769u) >> (32 - kPropertyIndex_Bits);
+}
 
-            //    fill out the list with as many objects as requested
-            for (UInt32 i = 0, k = 0; k < theNumberItemsToFetch; i++)
+static void property_index_build(void)
+{
+    for(UInt32 theClass = 0; theClass < kPropertyClass_Count; theClass++)
+    {
+        for(UInt32 i = 0; i < kProperty_Tables[theClass].count; i++)
+        {
+            const struct PropertyDescriptor* theDescriptor = &kProperty_Tables[theClass].descriptors[i];
+            UInt32 theSlot = property_index_slot(theDescriptor->selector);
+            while((gProperty_Index[theClass][theSlot] != NULL) && (gProperty_Index[theClass][theSlot] != theDescriptor))
             {
-                if ((kDevice_ObjectList[i].type == kObjectType_Stream) &&
-                    (kDevice_ObjectList[i].scope == inAddress->mScope || inAddress->mScope == kAudioObjectPropertyScopeGlobal))
-                {
-                    ((AudioObjectID*)outData)[k++] = kDevice_ObjectList[i].id;
-                }
+                theSlot = (theSlot + 1) & (kPropertyIndex_Size - 1);
             }
+            gProperty_Index[theClass][theSlot] = theDescriptor;
+        }
+    }
+}
 
-			//	report how much we wrote
-			*outDataSize = theNumberItemsToFetch * sizeof(AudioObjectID);
-			break;
-
-		case kAudioObjectPropertyControlList:
-            theNumberItemsToFetch = minimum(inDataSize / sizeof(AudioObjectID), device_control_list_size(inAddress->mScope, inObjectID));
-
-            //    fill out the list with as many objects as requested
-            for (UInt32 i = 0, k = 0; k < theNumberItemsToFetch; i++)
+static const struct PropertyDescriptor* property_lookup(enum PropertyClass property_class, const AudioObjectPropertyAddress* address)
+{
+    UInt32 theSlot = property_index_slot(address->mSelector);
+    const struct PropertyDescriptor* theDescriptor;
+    while((theDescriptor = gProperty_Index[property_class][theSlot]) != NULL)
+    {
+        if(theDescriptor->selector == address->mSelector)
+        {
+            if(theDescriptor->io_scope_only && (address->mScope != kAudioObjectPropertyScopeInput) && (address->mScope != kAudioObjectPropertyScopeOutput))
             {
-                if (kDevice_ObjectList[i].type == kObjectType_Control)
-                {
-                    ((AudioObjectID*)outData)[k++] = kDevice_ObjectList[i].id;
-                }
+                return NULL;
             }
-			//	report how much we wrote
-			*outDataSize = theNumberItemsToFetch * sizeof(AudioObjectID);
-			break;
+            return theDescriptor;
+        }
+        theSlot = (theSlot + 1) & (kPropertyIndex_Size - 1);
+    }
+    return NULL;
+}
 
-		case kAudioDevicePropertySafetyOffset:
-			*((UInt32*)outData) = kLatency_Frame_Size;
-			*outDataSize = sizeof(UInt32);
-			break;
+static const enum PropertyClass kObjectType_PropertyClass[kObjectType_Count] = {
+    [kObjectType_Stream]                = kPropertyClass_Stream,
+    [kObjectType_Volume]                = kPropertyClass_Volume,
+    [kObjectType_Mute]                  = kPropertyClass_Mute,
+};
 
-		case kAudioDevicePropertyNominalSampleRate:
-			pthread_mutex_lock(&gPlugIn_StateMutex);
-			*((Float64*)outData) = gDevice_SampleRate;
-			pthread_mutex_unlock(&gPlugIn_StateMutex);
-			*outDataSize = sizeof(Float64);
-			break;
+//	Works out which object and which property a call is about. Returns kAudioHardwareBadObjectError
+//	for an object that doesn't exist and kAudioHardwareUnknownPropertyError for a property the object
+//	doesn't have.
+//
+//	This runs on every property call, so it finds the device without gPlugIn_StateMutex. That is safe
+//	because gDevices is a static table: the pointer stays valid whatever happens to the device. What is
+//	read here, object_id and the directions, is written by device_create before the release store of
+//	is_alive that device_for_object acquires, and never changes while the device is alive. The device
+//	can still be destroyed before the handler runs, so the handlers that touch what device_destroy
+//	frees, the strings and the ring, check again with device_lock_alive.
+static OSStatus property_resolve(AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, struct PropertyContext* outContext)
+{
+    enum PropertyClass theClass;
 
-		case kAudioDevicePropertyAvailableNominalSampleRates:
-			theNumberItemsToFetch = inDataSize / sizeof(AudioValueRange);
-			
-			//	clamp it to the number of items we have
-			if(theNumberItemsToFetch > kDevice_SampleRatesSize)
-			{
-				theNumberItemsToFetch = kDevice_SampleRatesSize;
-			}
-			
-            //	fill out the return array
-            for(UInt32 i = 0; i < theNumberItemsToFetch; i++)
-            {
-                ((AudioValueRange*)outData)[i].mMinimum = kDevice_SampleRates[i];
-                ((AudioValueRange*)outData)[i].mMaximum = kDevice_SampleRates[i];
-            }
+    outContext->object_id = inObjectID;
+    outContext->role = kObjectRole_None;
+    outContext->device = NULL;
+    outContext->address = inAddress;
+    outContext->qualifier_size = inQualifierDataSize;
+    outContext->qualifier = inQualifierData;
+    outContext->client_pid = inClientProcessID;
 
-			//	report how much we wrote
-			*outDataSize = theNumberItemsToFetch * sizeof(AudioValueRange);
-			break;
-		
-		case kAudioDevicePropertyIsHidden:
-            
-            switch (inObjectID) {
-                case kObjectID_Device:
-                    *((UInt32*)outData) = kDevice_IsHidden;
-                    break;
-                
-                case kObjectID_Device2:
-                    *((UInt32*)outData) = kDevice2_IsHidden;
-                    break;
-            }
-			*outDataSize = sizeof(UInt32);
-			break;
+    if(inObjectID == kObjectID_PlugIn)
+    {
+        theClass = kPropertyClass_PlugIn;
+    }
+    else if(inObjectID == kObjectID_Box)
+    {
+        theClass = kPropertyClass_Box;
+    }
+    else
+    {
+        outContext->role = object_role(inObjectID);
+        if(outContext->role == kObjectRole_None)
+        {
+            return kAudioHardwareBadObjectError;
+        }
+        outContext->device = device_for_object(inObjectID);
+        theClass = (outContext->role == kObjectRole_Device) ? kPropertyClass_Device : kObjectType_PropertyClass[object_info(outContext->role)->type];
+    }
 
-		case kAudioDevicePropertyPreferredChannelsForStereo:
-			((UInt32*)outData)[0] = 1;
-			((UInt32*)outData)[1] = 2;
-			*outDataSize = 2 * sizeof(UInt32);
-			break;
+    outContext->descriptor = property_lookup(theClass, inAddress);
+    return (outContext->descriptor != NULL) ? 0 : kAudioHardwareUnknownPropertyError;
+}
 
-		case kAudioDevicePropertyPreferredChannelLayout:
-			{
-				//	calcualte how big the
-				UInt32 theACLSize = offsetof(AudioChannelLayout, mChannelDescriptions) + (kNumber_Of_Channels * sizeof(AudioChannelDescription));
-				((AudioChannelLayout*)outData)->mChannelLayoutTag = kAudioChannelLayoutTag_UseChannelDescriptions;
-				((AudioChannelLayout*)outData)->mChannelBitmap = 0;
-				((AudioChannelLayout*)outData)->mNumberChannelDescriptions = kNumber_Of_Channels;
-				for(theItemIndex = 0; theItemIndex < kNumber_Of_Channels; ++theItemIndex)
-				{
-					((AudioChannelLayout*)outData)->mChannelDescriptions[theItemIndex].mChannelLabel = kAudioChannelLabel_Left + theItemIndex;
-					((AudioChannelLayout*)outData)->mChannelDescriptions[theItemIndex].mChannelFlags = 0;
-					((AudioChannelLayout*)outData)->mChannelDescriptions[theItemIndex].mCoordinates[0] = 0;
-					((AudioChannelLayout*)outData)->mChannelDescriptions[theItemIndex].mCoordinates[1] = 0;
-					((AudioChannelLayout*)outData)->mChannelDescriptions[theItemIndex].mCoordinates[2] = 0;
-				}
-				*outDataSize = theACLSize;
-			}
-			break;
+#pragma mark Property Operations
 
-		case kAudioDevicePropertyZeroTimeStampPeriod:
-			*((UInt32*)outData) = kDevice_RingBufferSize;
-			*outDataSize = sizeof(UInt32);
-			break;
+static Boolean	_HasProperty(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress)
+{
+    #pragma unused(in_driver)
 
-		case kAudioDevicePropertyIcon:
-			{
-				CFBundleRef theBundle = CFBundleGetBundleWithIdentifier(CFSTR("audio.existential.VAC.Speaker"));
-				CFURLRef theURL = CFBundleCopyResourceURL(theBundle, CFSTR("VAC.ai.Speaker.icns"), NULL, NULL);
-				*((CFURLRef*)outData) = theURL;
-				*outDataSize = sizeof(CFURLRef);
-			}
-			break;
-			
-		default:
-			result = kAudioHardwareUnknownPropertyError;
-			break;
-	};
+    struct PropertyContext theContext;
+    return property_resolve(inObjectID, inClientProcessID, inAddress, 0, NULL, &theContext) == 0;
+}
 
-	return result;
+static OSStatus	_IsPropertySettable(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable)
+{
+    #pragma unused(in_driver)
+
+    struct PropertyContext theContext;
+    OSStatus result = property_resolve(inObjectID, inClientProcessID, inAddress, 0, NULL, &theContext);
+    if(result == 0)
+    {
+        *outIsSettable = theContext.descriptor->set != NULL;
+    }
+    return result;
 }
 
-static OSStatus	set_device_property(pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, const void* inData, UInt32* outNumberPropertiesChanged, AudioObjectPropertyAddress outChangedAddresses[2])
+static OSStatus	_GetPropertyDataSize(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize)
 {
-	#pragma unused(inClientProcessID, inQualifierDataSize, inQualifierData)
-	
-	//	declare the local variables
-	OSStatus result = 0;
-	Float64 theOldSampleRate;
-	UInt64 theNewSampleRate;
-	
+    #pragma unused(in_driver)
 
-	*outNumberPropertiesChanged = 0;
-	
-	switch(inAddress->mSelector)
-	{
-		case kAudioDevicePropertyNominalSampleRate:
+    struct PropertyContext theContext;
+    OSStatus result = property_resolve(inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, &theContext);
+    if(result == 0)
+    {
+        *outDataSize = (theContext.descriptor->size_of != NULL) ? theContext.descriptor->size_of(&theContext) : theContext.descriptor->size;
+    }
+    return result;
+}
 
+static OSStatus	_GetPropertyData(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, UInt32* outDataSize, void* outData)
+{
+    #pragma unused(in_driver)
 
-			//	make sure that the new value is different than the old value
-			pthread_mutex_lock(&gPlugIn_StateMutex);
-			theOldSampleRate = gDevice_SampleRate;
-			pthread_mutex_unlock(&gPlugIn_StateMutex);
-			if(*((const Float64*)inData) != theOldSampleRate)
-			{
-				//	we dispatch this so that the change can happen asynchronously
-				theOldSampleRate = *((const Float64*)inData);
-				theNewSampleRate = (UInt64)theOldSampleRate;
-				dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{ gPlugIn_Host->RequestDeviceConfigurationChange(gPlugIn_Host, kObjectID_Device, theNewSampleRate, NULL); });
-			}
-			break;
-		
-		default:
-            result = kAudioHardwareUnknownPropertyError;
-			break;
-	};
+    struct PropertyContext theContext;
+    OSStatus result = property_resolve(inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, &theContext);
+    FailIf(result != 0, Done, "_GetPropertyData: unknown object or property");
 
-	return result;
+    if(theContext.descriptor->size_of == NULL)
+    {
+        FailWithAction(inDataSize < theContext.descriptor->size, result = kAudioHardwareBadPropertySizeError, Done, "_GetPropertyData: not enough space for the return value");
+        *outDataSize = theContext.descriptor->size;
+    }
+    result = theContext.descriptor->get(&theContext, inDataSize, outDataSize, outData);
+
+Done:
+    return result;
+}
+
+static OSStatus	_SetPropertyData(AudioServerPlugInDriverRef in_driver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, const void* inData)
+{
+    #pragma unused(in_driver)
+
+    UInt32 theNumberPropertiesChanged = 0;
+    AudioObjectPropertyAddress theChangedAddresses[2];
+    struct PropertyContext theContext;
+    OSStatus result = property_resolve(inObjectID, inClientProcessID, inAddress, inQualifierDataSize, inQualifierData, &theContext);
+    FailIf(result != 0, Done, "_SetPropertyData: unknown object or property");
+    FailWithAction(theContext.descriptor->set == NULL, result = kAudioHardwareUnknownPropertyError, Done, "_SetPropertyData: the property is read only");
+    FailWithAction(inDataSize != theContext.descriptor->size, result = kAudioHardwareBadPropertySizeError, Done, "_SetPropertyData: wrong size for the data");
+
+    result = theContext.descriptor->set(&theContext, inData, &theNumberPropertiesChanged, theChangedAddresses);
+
+    //	send any notifications
+    if(theNumberPropertiesChanged > 0)
+    {
+        gPlugIn_Host->PropertiesChanged(gPlugIn_Host, inObjectID, theNumberPropertiesChanged, theChangedAddresses);
+    }
+
+Done:
+    return result;
 }
 
-#pragma mark Stream Property Operations
+#pragma mark IO Operations
 
-static Boolean	has_stream_property(pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress)
+static OSStatus    _StartIO(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, UInt32 inClientID)
 {
-	
-	#pragma unused(inClientProcessID)
-	
-	//	declare the local variables
-	Boolean result = false;
+    #pragma unused(inClientID)
+    
+    OSStatus result = 0;
+    struct Device* theDevice = device_for_object(inDeviceObjectID);
+    
+    if(theDevice == NULL)
+    {
+        return kAudioHardwareBadObjectError;
+    }
+    
+    pthread_mutex_lock(&theDevice->state_mutex);
+    
+    if(theDevice->io_is_running == UINT64_MAX)
+    {
+        result = kAudioHardwareIllegalOperationError;
+    }
+    else if(theDevice->io_is_running == 0)
+    {
+        if(theDevice->ring.samples != NULL)
+        {
+            theDevice->io_is_running = 1;
+            device_clock_reset(&theDevice->clock, mach_absolute_time());
+            ring_buffer_reset(&theDevice->ring);
+            for(UInt32 theScope = 0; theScope < kControlScope_Count; ++theScope)
+            {
+                theDevice->io_gains[theScope].is_primed = false;
+            }
+            device_state_edit(theDevice)->is_running = true;
+            device_state_publish(theDevice);
+        }
+        else
+        {
+            result = kAudioHardwareUnspecifiedError;
+        }
+    }
+    else
+    {
+        ++theDevice->io_is_running;
+    }
+    
+    pthread_mutex_unlock(&theDevice->state_mutex);
+    
+    return result;
+}
 
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-		case kAudioObjectPropertyClass:
-		case kAudioObjectPropertyOwner:
-		case kAudioObjectPropertyOwnedObjects:
-		case kAudioStreamPropertyIsActive:
-		case kAudioStreamPropertyDirection:
-		case kAudioStreamPropertyTerminalType:
-		case kAudioStreamPropertyStartingChannel:
-		case kAudioStreamPropertyLatency:
-		case kAudioStreamPropertyVirtualFormat:
-		case kAudioStreamPropertyPhysicalFormat:
-		case kAudioStreamPropertyAvailableVirtualFormats:
-		case kAudioStreamPropertyAvailablePhysicalFormats:
-			result = true;
-			break;
-	};
+static OSStatus    _StopIO(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, UInt32 inClientID)
+{
+    
+    #pragma unused(inClientID)
+    
+    OSStatus result = 0;
+    struct Device* theDevice = device_for_object(inDeviceObjectID);
+    
+    if(theDevice == NULL)
+    {
+        return kAudioHardwareBadObjectError;
+    }
+    
+    pthread_mutex_lock(&theDevice->state_mutex);
+    
+    if(theDevice->io_is_running == 0)
+    {
+        result = kAudioHardwareIllegalOperationError;
+    }
+    else if(theDevice->io_is_running == 1)
+    {
+        theDevice->io_is_running = 0;
+        device_state_edit(theDevice)->is_running = false;
+        device_state_publish(theDevice);
+    }
+    else
+    {
+        --theDevice->io_is_running;
+    }
+    
+    pthread_mutex_unlock(&theDevice->state_mutex);
+    
+    return result;
+}
 
-	return result;
+static OSStatus    _GetZeroTimeStamp(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, UInt32 inClientID, Float64* outSampleTime, UInt64* outHostTime, UInt64* outSeed)
+{
+    #pragma unused(inClientID)
+    
+    OSStatus result = 0;
+    struct Device* theDevice = device_for_object(inDeviceObjectID);
+    
+    if(theDevice == NULL)
+    {
+        return kAudioHardwareBadObjectError;
+    }
+    
+    //	lock free, so the IO thread never waits on a configuration change
+    device_clock_zero_time_stamp(&theDevice->clock, mach_absolute_time(), device_controls(theDevice)->zero_time_stamp_period, outSampleTime, outHostTime);
+    *outSeed = 1;
+    
+    return result;
 }
 
-static OSStatus	stream_property(pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable)
+static OSStatus    _WillDoIOOperation(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, UInt32 inClientID, UInt32 inOperationID, Boolean* outWillDo, Boolean* outWillDoInPlace)
 {
-	#pragma unused(inClientProcessID)
-	
-	//	declare the local variables
-	OSStatus reuslt = 0;
-	
+    #pragma unused(inClientID)
+    
+    OSStatus result = 0;
+    bool willDo = false;
+    bool willDoInPlace = true;
+    struct Device* theDevice = device_for_object(inDeviceObjectID);
+    
+    if(theDevice == NULL)
+    {
+        return kAudioHardwareBadObjectError;
+    }
+    
+    //	a direction without a stream, or with its stream deactivated, doesn't take part in the cycle
+    const struct DeviceControls* theControls = device_controls(theDevice);
+    switch(inOperationID)
+    {
+        case kAudioServerPlugInIOOperationReadInput:
+            willDo = theControls->is_active[kControlScope_Input];
+            willDoInPlace = true;
+            break;
+            
+        case kAudioServerPlugInIOOperationProcessInput:
+            //	per client, and only a delayed client has anything to do in it, see
+            //	kVACDevicePropertyClientDelay
+            willDo = theControls->is_active[kControlScope_Input] && (device_client_delay(theDevice, inClientID) > 0);
+            willDoInPlace = true;
+            break;
+            
+        case kAudioServerPlugInIOOperationWriteMix:
+            willDo = theControls->is_active[kControlScope_Output];
+            willDoInPlace = true;
+            break;
+            
+    };
+    
+    if(outWillDo != NULL)
+    {
+        *outWillDo = willDo;
+    }
+    if(outWillDoInPlace != NULL)
+    {
+        *outWillDoInPlace = willDoInPlace;
+    }
 
-	switch(inAddress->mSelector)
-	{
-		case kAudioObjectPropertyBaseClass:
-		case kAudioObjectPropertyClass:
-		case kAudioObjectPropertyOwner:
-		case kAudioObjectPropertyOwnedObjects:
-		case kAudioStreamPropertyDirection:
-		case kAudioStreamPropertyTerminalType:
-		case kAudioStreamPropertyStartingChannel:
-		case kAudioStreamPropertyLatency:
-		case kAudioStreamPropertyAvailableVirtualFormats:
-		case kAudioStreamPropertyAvailablePhysicalFormats:
-			*outIsSettable = false;
-			break;
-		
-		case kAudioStreamPropertyIsActive:
-		case kAudioStreamPropertyVirtualFormat:
-		case kAudioStreamPropertyPhysicalFormat:
-			*outIsSettable = true;
-			break;
-		
-		default:
-            reuslt = kAudioHardwareUnknownPropertyError;
-			break;
-	};
+    return result;
+}
+
+static OSStatus    _BeginIOOperation(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, UInt32 inClientID, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo* inIOCycleInfo)
+{
+    
+    #pragma unused(inClientID, inOperationID, inIOBufferFrameSize, inIOCycleInfo, inDeviceObjectID)
+    
+    OSStatus result = 0;
 
-	return reuslt;
+    return result;
 }
 
+
+static OSStatus    _EndIOOperation(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, UInt32 inClientID, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo* inIOCycleInfo)
+{
+    #pragma unused(inClientID, inOperationID, inIOBufferFrameSize, inIOCycleInfo, inDeviceObjectID)
+    
+    OSStatus result = 0;
+
+    return result;
+}
+
+
+static OSStatus    _DoIOOperation(AudioServerPlugInDriverRef in_driver, AudioObjectID inDeviceObjectID, AudioObjectID inStreamObjectID, UInt32 inClientID, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo* inIOCycleInfo, void* ioMainBuffer, void* ioSecondaryBuffer)
+{
+    #pragma unused(ioSecondaryBuffer)
+    
+    OSStatus the_answer = 0;
+    struct Device* theDevice = device_for_object(inDeviceObjectID);
+    
+    if(theDevice == NULL)
+    {
+        return kAudioHardwareBadObjectError;
+    }
+    
+    //	the output gain is applied on the way into the ring and the input gain on the way out
+    const struct DeviceControls* theControls = device_controls(theDevice);
+    
+    //	a longer buffer than the device's buffer frame size range allows would wrap round the ring onto
+    //	itself, so a host that ignored the range gets an error and, for input, silence
+    if(inIOBufferFrameSize > theControls->max_io_frames)
+    {
+        if(inOperationID == kAudioServerPlugInIOOperationReadInput)
+        {
+            gKernels.clear(ioMainBuffer, inIOBufferFrameSize * kNumber_Of_Channels);
+        }
+        return kAudioHardwareIllegalOperationError;
+    }
+    
+    //	_WillDoIOOperation keeps inactive directions out of the cycle, this only catches a stream
+    //	deactivated while the host still had the old answer, without touching the ring
+    if(inOperationID == kAudioServerPlugInIOOperationReadInput && !theControls->is_active[kControlScope_Input])
+    {
+        gKernels.clear(ioMainBuffer, inIOBufferFrameSize * kNumber_Of_Channels);
+        return the_answer;
+    }
+    if(inOperationID == kAudioServerPlugInIOOperationProcessInput && !theControls->is_active[kControlScope_Input])
+    {
+        return the_answer;
+    }
+    if(inOperationID == kAudioServerPlugInIOOperationWriteMix && !theControls->is_active[kControlScope_Output])
+    {
+        return the_answer;
+    }
+    
+    if(inOperationID == kAudioServerPlugInIOOperationReadInput)
+    {
+        theDevice->io_input_gain = device_gain_advance(&theDevice->io_gains[kControlScope_Input], theControls, kControlScope_Input, inIOBufferFrameSize);
+        
+        device_read_input(theDevice, (SInt64)inIOCycleInfo->mInputTime.mSampleTime, inIOBufferFrameSize, ioMainBuffer);
+    }
+    
+    if(inOperationID == kAudioServerPlugInIOOperationProcessInput)
+    {
+        //	ReadInput has already filled the buffer for a client without a delay; a delayed one reads
+        //	again from further back, with the same gain
+        UInt32 theDelay = device_client_delay(theDevice, inClientID);
+        if(theDelay > 0)
+        {
+            device_read_input(theDevice, (SInt64)inIOCycleInfo->mInputTime.mSampleTime - theDelay, inIOBufferFrameSize, ioMainBuffer);
+        }
+    }
+    
+    if(inOperationID == kAudioServerPlugInIOOperationWriteMix)
+    {
+        
+        if (inIOCycleInfo->mCurrentTime.mSampleTime > inIOCycleInfo->mOutputTime.mSampleTime + inIOBufferFrameSize + theControls->safety_offset)
+            return kAudioHardwareUnspecifiedError;
+        
+        struct RingGain theGain = device_gain_advance(&theDevice->io_gains[kControlScope_Output], theControls, kControlScope_Output, inIOBufferFrameSize);
+        
+        ring_buffer_write(&theDevice->ring, (SInt64)inIOCycleInfo->mOutputTime.mSampleTime, inIOBufferFrameSize, &theGain, ioMainBuffer);
+    }
+
+    return the_answer;
+}
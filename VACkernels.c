@@ -0,0 +1,623 @@
+#include "VACkernels.h"
+
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define                             kKernels_HasX86                     1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define                             kKernels_HasNEON                    1
+#endif
+
+//	keep a * b + c as two roundings everywhere so every set matches the reference. GCC ignores the
+//	standard pragma and contracts by default, so it gets its own, and the CMake build passes
+//	-ffp-contract=off as well.
+#pragma STDC FP_CONTRACT OFF
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Scalar Reference
+//==================================================================================================
+
+//	every bit of a float but the sign
+#define                             kKernels_MagnitudeMask              0x7FFFFFFFu
+
+static void scalar_clear(float* out, uint32_t sample_count)
+{
+    for(uint32_t i = 0; i < sample_count; i++)
+    {
+        out[i] = 0.0f;
+    }
+}
+
+static void scalar_copy(float* out, const float* in, uint32_t sample_count, float gain)
+{
+    (void)gain;
+    for(uint32_t i = 0; i < sample_count; i++)
+    {
+        out[i] = in[i];
+    }
+}
+
+static void scalar_gain(float* out, const float* in, uint32_t sample_count, float gain)
+{
+    for(uint32_t i = 0; i < sample_count; i++)
+    {
+        out[i] = in[i] * gain;
+    }
+}
+
+static void scalar_gain_ramp(float* out, const float* in, uint32_t frame_count, uint32_t channels, float start, float step)
+{
+    for(uint32_t theFrame = 0; theFrame < frame_count; theFrame++)
+    {
+        float theGain = start + (float)theFrame * step;
+        for(uint32_t theChannel = 0; theChannel < channels; theChannel++)
+        {
+            out[theFrame * channels + theChannel] = in[theFrame * channels + theChannel] * theGain;
+        }
+    }
+}
+
+static void scalar_channel_gain(float* out, const float* in, uint32_t frame_count, uint32_t channels, const float* gains)
+{
+    for(uint32_t theFrame = 0; theFrame < frame_count; theFrame++)
+    {
+        for(uint32_t theChannel = 0; theChannel < channels; theChannel++)
+        {
+            out[theFrame * channels + theChannel] = in[theFrame * channels + theChannel] * gains[theChannel];
+        }
+    }
+}
+
+static void scalar_channel_gain_ramp(float* out, const float* in, uint32_t frame_count, uint32_t channels, const float* start, const float* step)
+{
+    for(uint32_t theFrame = 0; theFrame < frame_count; theFrame++)
+    {
+        for(uint32_t theChannel = 0; theChannel < channels; theChannel++)
+        {
+            out[theFrame * channels + theChannel] = in[theFrame * channels + theChannel] * (start[theChannel] + (float)theFrame * step[theChannel]);
+        }
+    }
+}
+
+static void scalar_sum(float* out, const float* in, uint32_t sample_count, float gain)
+{
+    for(uint32_t i = 0; i < sample_count; i++)
+    {
+        out[i] = out[i] + in[i] * gain;
+    }
+}
+
+static bool scalar_is_silent(const float* in, uint32_t sample_count)
+{
+    uint32_t theBits = 0;
+    for(uint32_t i = 0; i < sample_count; i++)
+    {
+        uint32_t theSample;
+        memcpy(&theSample, in + i, sizeof(theSample));
+        theBits |= theSample;
+    }
+    return (theBits & kKernels_MagnitudeMask) == 0;
+}
+
+static void scalar_interleave(float* out, const float* const* in, uint32_t frame_count, uint32_t channels)
+{
+    for(uint32_t theFrame = 0; theFrame < frame_count; theFrame++)
+    {
+        for(uint32_t theChannel = 0; theChannel < channels; theChannel++)
+        {
+            out[theFrame * channels + theChannel] = in[theChannel][theFrame];
+        }
+    }
+}
+
+static void scalar_deinterleave(float* const* out, const float* in, uint32_t frame_count, uint32_t channels)
+{
+    for(uint32_t theFrame = 0; theFrame < frame_count; theFrame++)
+    {
+        for(uint32_t theChannel = 0; theChannel < channels; theChannel++)
+        {
+            out[theChannel][theFrame] = in[theFrame * channels + theChannel];
+        }
+    }
+}
+
+static const struct Kernels         kKernels_Scalar                     = { "scalar", scalar_clear, scalar_copy, scalar_gain, scalar_gain_ramp, scalar_channel_gain, scalar_channel_gain_ramp, scalar_sum, scalar_is_silent, scalar_interleave, scalar_deinterleave, NULL };
+
+struct Kernels                      gKernels                            = { "scalar", scalar_clear, scalar_copy, scalar_gain, scalar_gain_ramp, scalar_channel_gain, scalar_channel_gain_ramp, scalar_sum, scalar_is_silent, scalar_interleave, scalar_deinterleave, NULL };
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Vector Templates
+//==================================================================================================
+
+//	The element-wise kernels only differ between instruction sets in the vector type, its width and
+//	the handful of intrinsics below, so they are stamped out from one template. Tails shorter than a
+//	vector fall back to the scalar expression.
+//
+//	The ramp needs the frame index of every lane. When a vector holds a whole number of frames the
+//	lanes carry a pattern of frame indices that advances by one vector's worth of frames each step;
+//	when a frame is a whole number of vectors each frame gets its own broadcast gain. Any other channel
+//	count goes through the scalar loop.
+//
+//	The silence scan ORs the bits of a few vectors at a time and stops at the first chunk with any
+//	set outside the sign, so sound costs almost nothing to rule out and only silence is read to the
+//	end.
+//
+//	The per-channel kernels repeat the channel gains over a chunk that is a whole number of frames and
+//	vectors (see frame_kernel_chunk), so every channel count up to kChannelPattern_MaxSamples per chunk
+//	takes the vector path with one extra load per vector; the ramp keeps the frame index of every lane
+//	of the chunk alongside.
+#define DEFINE_ELEMENTWISE_KERNELS(isa, ATTRIBUTES, Vector, kWidth, Load, Store, Set1, Zero, Mul, Add, Or) \
+ATTRIBUTES static void isa##_clear(float* out, uint32_t sample_count)                                   \
+{                                                                                                       \
+    Vector theZero = Zero();                                                                            \
+    uint32_t i = 0;                                                                                     \
+    for(; i + kWidth <= sample_count; i += kWidth) Store(out + i, theZero);                             \
+    for(; i < sample_count; i++) out[i] = 0.0f;                                                         \
+}                                                                                                       \
+ATTRIBUTES static void isa##_copy(float* out, const float* in, uint32_t sample_count, float gain)       \
+{                                                                                                       \
+    (void)gain;                                                                                         \
+    uint32_t i = 0;                                                                                     \
+    for(; i + kWidth <= sample_count; i += kWidth) Store(out + i, Load(in + i));                        \
+    for(; i < sample_count; i++) out[i] = in[i];                                                        \
+}                                                                                                       \
+ATTRIBUTES static void isa##_gain(float* out, const float* in, uint32_t sample_count, float gain)       \
+{                                                                                                       \
+    Vector theGain = Set1(gain);                                                                        \
+    uint32_t i = 0;                                                                                     \
+    for(; i + kWidth <= sample_count; i += kWidth) Store(out + i, Mul(Load(in + i), theGain));          \
+    for(; i < sample_count; i++) out[i] = in[i] * gain;                                                 \
+}                                                                                                       \
+ATTRIBUTES static void isa##_sum(float* out, const float* in, uint32_t sample_count, float gain)        \
+{                                                                                                       \
+    Vector theGain = Set1(gain);                                                                        \
+    uint32_t i = 0;                                                                                     \
+    for(; i + kWidth <= sample_count; i += kWidth)                                                      \
+        Store(out + i, Add(Load(out + i), Mul(Load(in + i), theGain)));                                 \
+    for(; i < sample_count; i++) out[i] = out[i] + in[i] * gain;                                        \
+}                                                                                                       \
+ATTRIBUTES static void isa##_gain_ramp(float* out, const float* in, uint32_t frame_count, uint32_t channels, float start, float step) \
+{                                                                                                       \
+    uint32_t theSampleCount = frame_count * channels;                                                   \
+    uint32_t i = 0;                                                                                     \
+    if((kWidth % channels) == 0)                                                                        \
+    {                                                                                                   \
+        float theLanes[kWidth];                                                                         \
+        for(uint32_t theLane = 0; theLane < kWidth; theLane++) theLanes[theLane] = (float)(theLane / channels); \
+        Vector theFrame = Load(theLanes);                                                               \
+        Vector theAdvance = Set1((float)(kWidth / channels));                                           \
+        Vector theStart = Set1(start);                                                                  \
+        Vector theStep = Set1(step);                                                                    \
+        for(; i + kWidth <= theSampleCount; i += kWidth)                                                \
+        {                                                                                               \
+            Store(out + i, Mul(Load(in + i), Add(theStart, Mul(theFrame, theStep))));                   \
+            theFrame = Add(theFrame, theAdvance);                                                       \
+        }                                                                                               \
+    }                                                                                                   \
+    else if((channels % kWidth) == 0)                                                                   \
+    {                                                                                                   \
+        for(uint32_t theFrame = 0; theFrame < frame_count; theFrame++)                                  \
+        {                                                                                               \
+            Vector theGain = Set1(start + (float)theFrame * step);                                      \
+            for(uint32_t theEnd = i + channels; i < theEnd; i += kWidth)                                \
+                Store(out + i, Mul(Load(in + i), theGain));                                             \
+        }                                                                                               \
+    }                                                                                                   \
+    for(; i < theSampleCount; i++) out[i] = in[i] * (start + (float)(i / channels) * step);             \
+}                                                                                                       \
+ATTRIBUTES static void isa##_channel_gain(float* out, const float* in, uint32_t frame_count, uint32_t channels, const float* gains)\
+{                                                                                                       \
+    const uint32_t theChunk = frame_kernel_chunk(kWidth, channels);                                     \
+    uint32_t theSampleCount = frame_count * channels;                                                   \
+    uint32_t i = 0;                                                                                     \
+    if(theChunk <= kChannelPattern_MaxSamples)                                                          \
+    {                                                                                                   \
+        float theGains[kChannelPattern_MaxSamples];                                                     \
+        for(uint32_t theLane = 0; theLane < theChunk; theLane++) theGains[theLane] = gains[theLane % channels];\
+        for(; i + theChunk <= theSampleCount; i += theChunk)                                            \
+            for(uint32_t theLane = 0; theLane < theChunk; theLane += kWidth)                            \
+                Store(out + i + theLane, Mul(Load(in + i + theLane), Load(theGains + theLane)));        \
+    }                                                                                                   \
+    for(; i < theSampleCount; i++) out[i] = in[i] * gains[i % channels];                                \
+}                                                                                                       \
+ATTRIBUTES static void isa##_channel_gain_ramp(float* out, const float* in, uint32_t frame_count, uint32_t channels, const float* start, const float* step)\
+{                                                                                                       \
+    const uint32_t theChunk = frame_kernel_chunk(kWidth, channels);                                     \
+    uint32_t theSampleCount = frame_count * channels;                                                   \
+    uint32_t i = 0;                                                                                     \
+    if(theChunk <= kChannelPattern_MaxSamples)                                                          \
+    {                                                                                                   \
+        float theStarts[kChannelPattern_MaxSamples];                                                    \
+        float theSteps[kChannelPattern_MaxSamples];                                                     \
+        float theFrames[kChannelPattern_MaxSamples];                                                    \
+        for(uint32_t theLane = 0; theLane < theChunk; theLane++)                                        \
+        {                                                                                               \
+            theStarts[theLane] = start[theLane % channels];                                             \
+            theSteps[theLane] = step[theLane % channels];                                               \
+            theFrames[theLane] = (float)(theLane / channels);                                           \
+        }                                                                                               \
+        Vector theAdvance = Set1((float)(theChunk / channels));                                         \
+        for(; i + theChunk <= theSampleCount; i += theChunk)                                            \
+            for(uint32_t theLane = 0; theLane < theChunk; theLane += kWidth)                            \
+            {                                                                                           \
+                Vector theFrame = Load(theFrames + theLane);                                            \
+                Vector theGain = Add(Load(theStarts + theLane), Mul(theFrame, Load(theSteps + theLane)));\
+                Store(out + i + theLane, Mul(Load(in + i + theLane), theGain));                         \
+                Store(theFrames + theLane, Add(theFrame, theAdvance));                                  \
+            }                                                                                           \
+    }                                                                                                   \
+    for(; i < theSampleCount; i++) out[i] = in[i] * (start[i % channels] + (float)(i / channels) * step[i % channels]);\
+}                                                                                                       \
+ATTRIBUTES static bool isa##_is_silent(const float* in, uint32_t sample_count)                          \
+{                                                                                                       \
+    uint32_t i = 0;                                                                                     \
+    for(; i + 4 * kWidth <= sample_count; i += 4 * kWidth)                                              \
+    {                                                                                                   \
+        Vector theBits = Zero();                                                                        \
+        for(uint32_t theLane = 0; theLane < 4 * kWidth; theLane += kWidth)                              \
+            theBits = Or(theBits, Load(in + i + theLane));                                              \
+        float theLanes[kWidth];                                                                         \
+        Store(theLanes, theBits);                                                                       \
+        if(!scalar_is_silent(theLanes, kWidth)) return false;                                           \
+    }                                                                                                   \
+    return scalar_is_silent(in + i, sample_count - i);                                                  \
+}
+
+//	the longest chunk the per-channel kernels lay out on the stack, anything longer goes scalar
+#define                             kChannelPattern_MaxSamples          128
+
+//	A chunk that is a whole number of frames and of vectors: the least common multiple of the vector
+//	width and the channel count, stretched to at least four vectors so that short buffers still get
+//	some unrolling.
+static inline uint32_t frame_kernel_chunk(uint32_t width, uint32_t channels)
+{
+    uint32_t theChunk = width;
+    while(((theChunk % channels) != 0) || (theChunk < 4 * width))
+    {
+        theChunk += width;
+    }
+    return theChunk;
+}
+
+//	The per-channel kernels again with the channel count baked in, for the layouts a device is usually
+//	configured with. The chunk is then a constant, so the gain pattern is laid out with constant
+//	divisions rather than run time ones (or not at all, when a frame is a whole number of vectors and
+//	the gains are their own pattern), and the ramp finds the frame index of a lane as the pattern's
+//	plus one broadcast per chunk instead of storing every lane's back to the stack after each use. At
+//	the 32 to 128 frames of a host buffer that setup is most of what the generic versions cost. The
+//	values are the generic versions' (the frame indices are whole numbers either way), so they are as
+//	bit-identical to the reference.
+#define DEFINE_FRAME_KERNELS(isa, ATTRIBUTES, Vector, kWidth, Load, Store, Set1, Mul, Add, kChannels)   \
+ATTRIBUTES static void isa##_channel_gain_##kChannels(float* out, const float* in, uint32_t frame_count, uint32_t channels, const float* gains) \
+{                                                                                                       \
+    (void)channels;                                                                                     \
+    const uint32_t theChunk = frame_kernel_chunk(kWidth, kChannels);                                    \
+    float theGains[kChannelPattern_MaxSamples];                                                         \
+    const float* thePattern = gains;                                                                    \
+    if(theChunk != kChannels)                                                                           \
+    {                                                                                                   \
+        for(uint32_t theLane = 0; theLane < theChunk; theLane++) theGains[theLane] = gains[theLane % kChannels]; \
+        thePattern = theGains;                                                                          \
+    }                                                                                                   \
+    uint32_t theSampleCount = frame_count * kChannels;                                                  \
+    uint32_t i = 0;                                                                                     \
+    for(; i + theChunk <= theSampleCount; i += theChunk)                                                \
+        for(uint32_t theLane = 0; theLane < theChunk; theLane += kWidth)                                \
+            Store(out + i + theLane, Mul(Load(in + i + theLane), Load(thePattern + theLane)));          \
+    for(; i < theSampleCount; i++) out[i] = in[i] * gains[i % kChannels];                               \
+}                                                                                                       \
+ATTRIBUTES static void isa##_channel_gain_ramp_##kChannels(float* out, const float* in, uint32_t frame_count, uint32_t channels, const float* start, const float* step) \
+{                                                                                                       \
+    (void)channels;                                                                                     \
+    const uint32_t theChunk = frame_kernel_chunk(kWidth, kChannels);                                    \
+    float theStarts[kChannelPattern_MaxSamples];                                                        \
+    float theSteps[kChannelPattern_MaxSamples];                                                         \
+    float theFrames[kChannelPattern_MaxSamples];                                                        \
+    const float* theStartPattern = start;                                                               \
+    const float* theStepPattern = step;                                                                 \
+    if(theChunk != kChannels)                                                                           \
+    {                                                                                                   \
+        for(uint32_t theLane = 0; theLane < theChunk; theLane++)                                        \
+        {                                                                                               \
+            theStarts[theLane] = start[theLane % kChannels];                                            \
+            theSteps[theLane] = step[theLane % kChannels];                                              \
+        }                                                                                               \
+        theStartPattern = theStarts;                                                                    \
+        theStepPattern = theSteps;                                                                      \
+    }                                                                                                   \
+    for(uint32_t theLane = 0; theLane < theChunk; theLane++) theFrames[theLane] = (float)(theLane / kChannels); \
+    uint32_t theSampleCount = frame_count * kChannels;                                                  \
+    uint32_t i = 0;                                                                                     \
+    float theChunkFrame = 0.0f;                                                                         \
+    for(; i + theChunk <= theSampleCount; i += theChunk, theChunkFrame += (float)(theChunk / kChannels)) \
+    {                                                                                                   \
+        Vector theOffset = Set1(theChunkFrame);                                                         \
+        for(uint32_t theLane = 0; theLane < theChunk; theLane += kWidth)                                \
+        {                                                                                               \
+            Vector theFrame = Add(Load(theFrames + theLane), theOffset);                                \
+            Vector theGain = Add(Load(theStartPattern + theLane), Mul(theFrame, Load(theStepPattern + theLane))); \
+            Store(out + i + theLane, Mul(Load(in + i + theLane), theGain));                             \
+        }                                                                                               \
+    }                                                                                                   \
+    for(; i < theSampleCount; i++) out[i] = in[i] * (start[i % kChannels] + (float)(i / kChannels) * step[i % kChannels]); \
+}
+
+//	one specialized pair per common layout: mono, stereo, 5.1, 7.1 and the wide multichannel ones
+#define DEFINE_FRAME_KERNEL_SET(isa, ATTRIBUTES, Vector, kWidth, Load, Store, Set1, Mul, Add)           \
+DEFINE_FRAME_KERNELS(isa, ATTRIBUTES, Vector, kWidth, Load, Store, Set1, Mul, Add, 1)                   \
+DEFINE_FRAME_KERNELS(isa, ATTRIBUTES, Vector, kWidth, Load, Store, Set1, Mul, Add, 2)                   \
+DEFINE_FRAME_KERNELS(isa, ATTRIBUTES, Vector, kWidth, Load, Store, Set1, Mul, Add, 6)                   \
+DEFINE_FRAME_KERNELS(isa, ATTRIBUTES, Vector, kWidth, Load, Store, Set1, Mul, Add, 8)                   \
+DEFINE_FRAME_KERNELS(isa, ATTRIBUTES, Vector, kWidth, Load, Store, Set1, Mul, Add, 16)                  \
+DEFINE_FRAME_KERNELS(isa, ATTRIBUTES, Vector, kWidth, Load, Store, Set1, Mul, Add, 32)                  \
+DEFINE_FRAME_KERNELS(isa, ATTRIBUTES, Vector, kWidth, Load, Store, Set1, Mul, Add, 64)                  \
+static const struct FrameKernels    k##isa##_FrameKernels[kFrameKernels_Count] =                        \
+{                                                                                                       \
+    { 1, isa##_channel_gain_1, isa##_channel_gain_ramp_1 },                                             \
+    { 2, isa##_channel_gain_2, isa##_channel_gain_ramp_2 },                                             \
+    { 6, isa##_channel_gain_6, isa##_channel_gain_ramp_6 },                                             \
+    { 8, isa##_channel_gain_8, isa##_channel_gain_ramp_8 },                                             \
+    { 16, isa##_channel_gain_16, isa##_channel_gain_ramp_16 },                                          \
+    { 32, isa##_channel_gain_32, isa##_channel_gain_ramp_32 },                                          \
+    { 64, isa##_channel_gain_64, isa##_channel_gain_ramp_64 },                                          \
+};
+
+//==================================================================================================
+#pragma mark -
+#pragma mark x86
+//==================================================================================================
+
+#if kKernels_HasX86
+
+#define SSE2_ATTRIBUTES
+#define AVX2_ATTRIBUTES                 __attribute__((target("avx2")))
+#define AVX512_ATTRIBUTES               __attribute__((target("avx512f")))
+
+//	_mm512_or_ps needs AVX512DQ, the integer OR only AVX512F
+AVX512_ATTRIBUTES static inline __m512 avx512_or(__m512 a, __m512 b) { return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(a), _mm512_castps_si512(b))); }
+
+DEFINE_ELEMENTWISE_KERNELS(sse2, SSE2_ATTRIBUTES, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_set1_ps, _mm_setzero_ps, _mm_mul_ps, _mm_add_ps, _mm_or_ps)
+DEFINE_ELEMENTWISE_KERNELS(avx2, AVX2_ATTRIBUTES, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps, _mm256_setzero_ps, _mm256_mul_ps, _mm256_add_ps, _mm256_or_ps)
+DEFINE_ELEMENTWISE_KERNELS(avx512, AVX512_ATTRIBUTES, __m512, 16, _mm512_loadu_ps, _mm512_storeu_ps, _mm512_set1_ps, _mm512_setzero_ps, _mm512_mul_ps, _mm512_add_ps, avx512_or)
+
+DEFINE_FRAME_KERNEL_SET(sse2, SSE2_ATTRIBUTES, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_set1_ps, _mm_mul_ps, _mm_add_ps)
+DEFINE_FRAME_KERNEL_SET(avx2, AVX2_ATTRIBUTES, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps, _mm256_mul_ps, _mm256_add_ps)
+DEFINE_FRAME_KERNEL_SET(avx512, AVX512_ATTRIBUTES, __m512, 16, _mm512_loadu_ps, _mm512_storeu_ps, _mm512_set1_ps, _mm512_mul_ps, _mm512_add_ps)
+
+//	only stereo gets a shuffle based (de)interleave, the rest is rare enough to stay scalar
+
+static void sse2_interleave(float* out, const float* const* in, uint32_t frame_count, uint32_t channels)
+{
+    uint32_t theFrame = 0;
+    if(channels == 2)
+    {
+        for(; theFrame + 4 <= frame_count; theFrame += 4)
+        {
+            __m128 theLeft = _mm_loadu_ps(in[0] + theFrame);
+            __m128 theRight = _mm_loadu_ps(in[1] + theFrame);
+            _mm_storeu_ps(out + theFrame * 2, _mm_unpacklo_ps(theLeft, theRight));
+            _mm_storeu_ps(out + theFrame * 2 + 4, _mm_unpackhi_ps(theLeft, theRight));
+        }
+    }
+    const float* theTails[channels];
+    for(uint32_t theChannel = 0; theChannel < channels; theChannel++) theTails[theChannel] = in[theChannel] + theFrame;
+    scalar_interleave(out + theFrame * channels, theTails, frame_count - theFrame, channels);
+}
+
+static void sse2_deinterleave(float* const* out, const float* in, uint32_t frame_count, uint32_t channels)
+{
+    uint32_t theFrame = 0;
+    if(channels == 2)
+    {
+        for(; theFrame + 4 <= frame_count; theFrame += 4)
+        {
+            __m128 theFirst = _mm_loadu_ps(in + theFrame * 2);
+            __m128 theSecond = _mm_loadu_ps(in + theFrame * 2 + 4);
+            _mm_storeu_ps(out[0] + theFrame, _mm_shuffle_ps(theFirst, theSecond, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(out[1] + theFrame, _mm_shuffle_ps(theFirst, theSecond, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+    }
+    float* theTails[channels];
+    for(uint32_t theChannel = 0; theChannel < channels; theChannel++) theTails[theChannel] = out[theChannel] + theFrame;
+    scalar_deinterleave(theTails, in + theFrame * channels, frame_count - theFrame, channels);
+}
+
+AVX2_ATTRIBUTES static void avx2_interleave(float* out, const float* const* in, uint32_t frame_count, uint32_t channels)
+{
+    uint32_t theFrame = 0;
+    if(channels == 2)
+    {
+        for(; theFrame + 8 <= frame_count; theFrame += 8)
+        {
+            __m256 theLeft = _mm256_loadu_ps(in[0] + theFrame);
+            __m256 theRight = _mm256_loadu_ps(in[1] + theFrame);
+            __m256 theLow = _mm256_unpacklo_ps(theLeft, theRight);
+            __m256 theHigh = _mm256_unpackhi_ps(theLeft, theRight);
+            _mm256_storeu_ps(out + theFrame * 2, _mm256_permute2f128_ps(theLow, theHigh, 0x20));
+            _mm256_storeu_ps(out + theFrame * 2 + 8, _mm256_permute2f128_ps(theLow, theHigh, 0x31));
+        }
+    }
+    const float* theTails[channels];
+    for(uint32_t theChannel = 0; theChannel < channels; theChannel++) theTails[theChannel] = in[theChannel] + theFrame;
+    scalar_interleave(out + theFrame * channels, theTails, frame_count - theFrame, channels);
+}
+
+AVX2_ATTRIBUTES static void avx2_deinterleave(float* const* out, const float* in, uint32_t frame_count, uint32_t channels)
+{
+    uint32_t theFrame = 0;
+    if(channels == 2)
+    {
+        for(; theFrame + 8 <= frame_count; theFrame += 8)
+        {
+            __m256 theFirst = _mm256_loadu_ps(in + theFrame * 2);
+            __m256 theSecond = _mm256_loadu_ps(in + theFrame * 2 + 8);
+            __m256 theLow = _mm256_permute2f128_ps(theFirst, theSecond, 0x20);
+            __m256 theHigh = _mm256_permute2f128_ps(theFirst, theSecond, 0x31);
+            _mm256_storeu_ps(out[0] + theFrame, _mm256_shuffle_ps(theLow, theHigh, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm256_storeu_ps(out[1] + theFrame, _mm256_shuffle_ps(theLow, theHigh, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+    }
+    float* theTails[channels];
+    for(uint32_t theChannel = 0; theChannel < channels; theChannel++) theTails[theChannel] = out[theChannel] + theFrame;
+    scalar_deinterleave(theTails, in + theFrame * channels, frame_count - theFrame, channels);
+}
+
+AVX512_ATTRIBUTES static void avx512_interleave(float* out, const float* const* in, uint32_t frame_count, uint32_t channels)
+{
+    uint32_t theFrame = 0;
+    if(channels == 2)
+    {
+        __m512i theLowIndices = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+        __m512i theHighIndices = _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+        for(; theFrame + 16 <= frame_count; theFrame += 16)
+        {
+            __m512 theLeft = _mm512_loadu_ps(in[0] + theFrame);
+            __m512 theRight = _mm512_loadu_ps(in[1] + theFrame);
+            _mm512_storeu_ps(out + theFrame * 2, _mm512_permutex2var_ps(theLeft, theLowIndices, theRight));
+            _mm512_storeu_ps(out + theFrame * 2 + 16, _mm512_permutex2var_ps(theLeft, theHighIndices, theRight));
+        }
+    }
+    const float* theTails[channels];
+    for(uint32_t theChannel = 0; theChannel < channels; theChannel++) theTails[theChannel] = in[theChannel] + theFrame;
+    scalar_interleave(out + theFrame * channels, theTails, frame_count - theFrame, channels);
+}
+
+AVX512_ATTRIBUTES static void avx512_deinterleave(float* const* out, const float* in, uint32_t frame_count, uint32_t channels)
+{
+    uint32_t theFrame = 0;
+    if(channels == 2)
+    {
+        __m512i theEvenIndices = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+        __m512i theOddIndices = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+        for(; theFrame + 16 <= frame_count; theFrame += 16)
+        {
+            __m512 theFirst = _mm512_loadu_ps(in + theFrame * 2);
+            __m512 theSecond = _mm512_loadu_ps(in + theFrame * 2 + 16);
+            _mm512_storeu_ps(out[0] + theFrame, _mm512_permutex2var_ps(theFirst, theEvenIndices, theSecond));
+            _mm512_storeu_ps(out[1] + theFrame, _mm512_permutex2var_ps(theFirst, theOddIndices, theSecond));
+        }
+    }
+    float* theTails[channels];
+    for(uint32_t theChannel = 0; theChannel < channels; theChannel++) theTails[theChannel] = out[theChannel] + theFrame;
+    scalar_deinterleave(theTails, in + theFrame * channels, frame_count - theFrame, channels);
+}
+
+static const struct Kernels         kKernels_SSE2                       = { "sse2", sse2_clear, sse2_copy, sse2_gain, sse2_gain_ramp, sse2_channel_gain, sse2_channel_gain_ramp, sse2_sum, sse2_is_silent, sse2_interleave, sse2_deinterleave, ksse2_FrameKernels };
+static const struct Kernels         kKernels_AVX2                       = { "avx2", avx2_clear, avx2_copy, avx2_gain, avx2_gain_ramp, avx2_channel_gain, avx2_channel_gain_ramp, avx2_sum, avx2_is_silent, avx2_interleave, avx2_deinterleave, kavx2_FrameKernels };
+static const struct Kernels         kKernels_AVX512                     = { "avx512", avx512_clear, avx512_copy, avx512_gain, avx512_gain_ramp, avx512_channel_gain, avx512_channel_gain_ramp, avx512_sum, avx512_is_silent, avx512_interleave, avx512_deinterleave, kavx512_FrameKernels };
+
+#endif
+
+//==================================================================================================
+#pragma mark -
+#pragma mark NEON
+//==================================================================================================
+
+#if kKernels_HasNEON
+
+#define NEON_ATTRIBUTES
+
+static inline float32x4_t neon_zero(void) { return vdupq_n_f32(0.0f); }
+static inline float32x4_t neon_or(float32x4_t a, float32x4_t b) { return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+
+DEFINE_ELEMENTWISE_KERNELS(neon, NEON_ATTRIBUTES, float32x4_t, 4, vld1q_f32, vst1q_f32, vdupq_n_f32, neon_zero, vmulq_f32, vaddq_f32, neon_or)
+DEFINE_FRAME_KERNEL_SET(neon, NEON_ATTRIBUTES, float32x4_t, 4, vld1q_f32, vst1q_f32, vdupq_n_f32, vmulq_f32, vaddq_f32)
+
+static void neon_interleave(float* out, const float* const* in, uint32_t frame_count, uint32_t channels)
+{
+    uint32_t theFrame = 0;
+    if(channels == 2)
+    {
+        for(; theFrame + 4 <= frame_count; theFrame += 4)
+        {
+            float32x4x2_t thePair = { { vld1q_f32(in[0] + theFrame), vld1q_f32(in[1] + theFrame) } };
+            vst2q_f32(out + theFrame * 2, thePair);
+        }
+    }
+    const float* theTails[channels];
+    for(uint32_t theChannel = 0; theChannel < channels; theChannel++) theTails[theChannel] = in[theChannel] + theFrame;
+    scalar_interleave(out + theFrame * channels, theTails, frame_count - theFrame, channels);
+}
+
+static void neon_deinterleave(float* const* out, const float* in, uint32_t frame_count, uint32_t channels)
+{
+    uint32_t theFrame = 0;
+    if(channels == 2)
+    {
+        for(; theFrame + 4 <= frame_count; theFrame += 4)
+        {
+            float32x4x2_t thePair = vld2q_f32(in + theFrame * 2);
+            vst1q_f32(out[0] + theFrame, thePair.val[0]);
+            vst1q_f32(out[1] + theFrame, thePair.val[1]);
+        }
+    }
+    float* theTails[channels];
+    for(uint32_t theChannel = 0; theChannel < channels; theChannel++) theTails[theChannel] = out[theChannel] + theFrame;
+    scalar_deinterleave(theTails, in + theFrame * channels, frame_count - theFrame, channels);
+}
+
+static const struct Kernels         kKernels_NEON                       = { "neon", neon_clear, neon_copy, neon_gain, neon_gain_ramp, neon_channel_gain, neon_channel_gain_ramp, neon_sum, neon_is_silent, neon_interleave, neon_deinterleave, kneon_FrameKernels };
+
+#endif
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Dispatch
+//==================================================================================================
+
+uint32_t kernels_available(const struct Kernels** out_sets, uint32_t max_sets)
+{
+    const struct Kernels* theSets[4];
+    uint32_t theCount = 0;
+
+    theSets[theCount++] = &kKernels_Scalar;
+#if kKernels_HasX86
+    theSets[theCount++] = &kKernels_SSE2;
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+    {
+        theSets[theCount++] = &kKernels_AVX2;
+    }
+    if(__builtin_cpu_supports("avx512f"))
+    {
+        theSets[theCount++] = &kKernels_AVX512;
+    }
+#endif
+#if kKernels_HasNEON
+    theSets[theCount++] = &kKernels_NEON;
+#endif
+
+    if(theCount > max_sets)
+    {
+        theCount = max_sets;
+    }
+    memcpy(out_sets, theSets, theCount * sizeof(*out_sets));
+    return theCount;
+}
+
+struct FrameKernels frame_kernels_for(uint32_t channels)
+{
+    for(uint32_t i = 0; (gKernels.frames != NULL) && (i < kFrameKernels_Count); i++)
+    {
+        if(gKernels.frames[i].channels == channels)
+        {
+            return gKernels.frames[i];
+        }
+    }
+    return (struct FrameKernels){ 0, gKernels.channel_gain, gKernels.channel_gain_ramp };
+}
+
+void kernels_select(void)
+{
+    //	the sets are listed narrowest first
+    const struct Kernels* theSets[4];
+    uint32_t theCount = kernels_available(theSets, 4);
+    gKernels = *theSets[theCount - 1];
+}
@@ -0,0 +1,88 @@
+#ifndef VACkernels_h
+#define VACkernels_h
+
+//	The sample crunching used on the IO path. Every kernel has a scalar reference version and, where
+//	the compiler can target them, SSE2, AVX2, AVX-512 and NEON versions. kernels_select() picks the
+//	widest set the CPU supports at run time and installs it in gKernels; until then gKernels holds the
+//	scalar set, so it is always safe to call through.
+//
+//	The vector versions do the same multiplies and adds in the same order as the scalar ones (no fused
+//	multiply-add, and VACkernels.c turns FP contraction off for clang and GCC), so their results are
+//	bit-identical to the reference. tests/test_kernels.c checks that for every set the CPU can run.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef void (*ClearKernel)(float* out, uint32_t sample_count);
+
+//	copy ignores gain, so it can stand in for gain at unity
+typedef void (*CopyGainKernel)(float* out, const float* in, uint32_t sample_count, float gain);
+
+//	out[frame][channel] = in[frame][channel] * (start + frame * step)
+typedef void (*GainRampKernel)(float* out, const float* in, uint32_t frame_count, uint32_t channels, float start, float step);
+
+//	out[frame][channel] = in[frame][channel] * gains[channel]
+typedef void (*ChannelGainKernel)(float* out, const float* in, uint32_t frame_count, uint32_t channels, const float* gains);
+
+//	out[frame][channel] = in[frame][channel] * (start[channel] + frame * step[channel])
+typedef void (*ChannelGainRampKernel)(float* out, const float* in, uint32_t frame_count, uint32_t channels, const float* start, const float* step);
+
+//	out[i] += in[i] * gain
+typedef void (*SumKernel)(float* out, const float* in, uint32_t sample_count, float gain);
+
+//	true when every sample is a zero of either sign, tested on the bits so that denormals count as
+//	sound whatever the FPU's denormal mode; a block this passes is stored as silence, so it must not
+//	lose anything
+typedef bool (*SilenceKernel)(const float* in, uint32_t sample_count);
+
+typedef void (*InterleaveKernel)(float* out, const float* const* in, uint32_t frame_count, uint32_t channels);
+typedef void (*DeinterleaveKernel)(float* const* out, const float* in, uint32_t frame_count, uint32_t channels);
+
+//	The per-channel gain kernels over one channel count. The common counts get versions with the count
+//	baked in, which ignore the channels argument; any other count gets the generic ones from gKernels.
+struct FrameKernels {
+    //	0 for the generic fallback
+    uint32_t                    channels;
+    ChannelGainKernel           channel_gain;
+    ChannelGainRampKernel       channel_gain_ramp;
+};
+
+#define                             kFrameKernels_Count                 7
+
+struct Kernels {
+    const char*                 name;
+    ClearKernel                 clear;
+    CopyGainKernel              copy;
+    CopyGainKernel              gain;
+    GainRampKernel              gain_ramp;
+    ChannelGainKernel           channel_gain;
+    ChannelGainRampKernel       channel_gain_ramp;
+    SumKernel                   sum;
+    SilenceKernel               is_silent;
+    InterleaveKernel            interleave;
+    DeinterleaveKernel          deinterleave;
+    //	kFrameKernels_Count entries, or NULL when every layout uses the generic kernels
+    const struct FrameKernels*  frames;
+};
+
+extern struct Kernels               gKernels;
+
+//	Call once before any IO, it is not safe against concurrent use of gKernels.
+void                    kernels_select(void);
+
+//	Every set this build and this CPU can run, the scalar reference first. Meant for validation and
+//	benchmarking, the IO path only uses gKernels.
+uint32_t                kernels_available(const struct Kernels** out_sets, uint32_t max_sets);
+
+//	Picks the cheapest kernel for the gain once, so the per-sample loop doesn't branch on it. A gain
+//	of zero never reaches a kernel: callers just clear.
+static inline CopyGainKernel copy_gain_kernel_for(float gain)
+{
+    return (gain == 1.0f) ? gKernels.copy : gKernels.gain;
+}
+
+//	Meant to be looked up once when a device is configured, not per IO cycle, and after kernels_select()
+//	so that the specialized versions come from the selected set.
+struct FrameKernels     frame_kernels_for(uint32_t channels);
+
+#endif /* VACkernels_h */
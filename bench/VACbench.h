@@ -0,0 +1,49 @@
+#ifndef VACbench_h
+#define VACbench_h
+
+//	Timing for the benchmarks in bench/. bench_run calls body with an iteration count, several times
+//	over, and reports the best time per iteration, which is the one least disturbed by everything else
+//	the machine was doing. None of these are run by ctest: the numbers only mean something on an idle
+//	machine, built with optimization.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#define                             kBench_Trials                       7
+
+static inline uint64_t bench_now(void)
+{
+    struct timespec theTime;
+    clock_gettime(CLOCK_MONOTONIC, &theTime);
+    return (uint64_t)theTime.tv_sec * 1000000000ULL + (uint64_t)theTime.tv_nsec;
+}
+
+//	nanoseconds per iteration
+static inline double bench_run(void (*body)(void* context, uint32_t iterations), void* context, uint32_t iterations)
+{
+    double theBest = 0.0;
+    body(context, iterations < 16 ? iterations : 16);
+    for(uint32_t theTrial = 0; theTrial < kBench_Trials; ++theTrial)
+    {
+        uint64_t theStart = bench_now();
+        body(context, iterations);
+        double theTime = (double)(bench_now() - theStart) / (double)iterations;
+        if((theTrial == 0) || (theTime < theBest))
+        {
+            theBest = theTime;
+        }
+    }
+    return theBest;
+}
+
+//	bytes moved per iteration over nanoseconds per iteration
+static inline double bench_gigabytes_per_second(double bytes, double nanoseconds)
+{
+    return (nanoseconds > 0.0) ? bytes / nanoseconds : 0.0;
+}
+
+//	somewhere for results to go so the compiler can't drop the work that made them
+static volatile float               gBench_Sink;
+
+#endif
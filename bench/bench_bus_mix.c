@@ -0,0 +1,124 @@
+//	What a bus's ReadInput costs as it mixes more sources in. For 2, 8 and as many sources as the
+//	driver lets a bus have, a bus is created with that many cables feeding it, all running IO in
+//	lockstep with every source writing sound, and the time per IO cycle of the bus is reported with
+//	what that is per source and the bandwidth of source frames it mixes. The last bus is fed until
+//	_CreateDevice turns a source away, which is how the bench finds the driver's limit, and it has to
+//	be turned away as an illegal operation.
+
+#include "VACbench.h"
+#include "VAChost.h"
+
+#include <stdlib.h>
+
+#define                             kBench_FrameSize                    512
+//	enough cycles to get more than a ring behind whatever was written before
+#define                             kBench_SettleCycles                 256
+#define                             kBench_Cycles                       2000
+
+struct BenchBusMix {
+    AudioObjectID                   bus;
+    //	source_count of each, then the bus's IO last
+    AudioObjectID*                  sources;
+    struct VACHostIO*               io;
+    uint32_t                        source_count;
+    //	why the bus took no more sources, when it was fed until it refused one
+    OSStatus                        refusal;
+};
+
+static void bench_render(struct VACHostIO* io)
+{
+    const struct BenchBusMix* theBench = (const struct BenchBusMix*)io->refcon;
+    bool theIsBus = (io == &theBench->io[theBench->source_count]);
+    UInt32 theSamples = io->frame_size * io->channel_count;
+    for(UInt32 i = 0; i < theSamples; ++i)
+    {
+        io->output[i] = theIsBus ? 0.0f : (float)((io->cycle * theSamples + i) % 997) / 997.0f - 0.5f;
+    }
+}
+
+//	ns per cycle of the bus, over cycles lockstep rounds
+static double bench_cycles(struct BenchBusMix* bench, uint32_t cycles)
+{
+    uint64_t theBusTime = 0;
+    for(uint32_t theCycle = 0; theCycle < cycles; ++theCycle)
+    {
+        for(uint32_t theDevice = 0; theDevice <= bench->source_count; ++theDevice)
+        {
+            uint64_t theStart = bench_now();
+            vac_host_io_cycle(&bench->io[theDevice], 0);
+            theBusTime += (theDevice == bench->source_count) ? bench_now() - theStart : 0;
+        }
+    }
+    return (double)theBusTime / (double)cycles;
+}
+
+//	A source_count of 0 feeds the bus until _CreateDevice refuses a source.
+static OSStatus bench_create(struct BenchBusMix* bench, uint32_t source_count)
+{
+    char theBusUID[32];
+    snprintf(theBusUID, sizeof(theBusUID), "bench.bus.%u", source_count);
+    bench->source_count = 0;
+    bench->refusal = 0;
+    OSStatus theError = vac_host_create_device(theBusUID, NULL, false, &bench->bus);
+    while((theError == 0) && ((source_count == 0) || (bench->source_count < source_count)))
+    {
+        char theUID[48];
+        snprintf(theUID, sizeof(theUID), "%s.source.%u", theBusUID, bench->source_count);
+        AudioObjectID theSource = kAudioObjectUnknown;
+        theError = vac_host_create_device(theUID, theBusUID, false, &theSource);
+        if(theError == 0)
+        {
+            bench->sources = (AudioObjectID*)realloc(bench->sources, (bench->source_count + 1) * sizeof(AudioObjectID));
+            bench->sources[bench->source_count++] = theSource;
+        }
+        else if(source_count == 0)
+        {
+            bench->refusal = theError;
+            theError = (bench->source_count > 0) ? 0 : theError;
+            break;
+        }
+    }
+    bench->io = (struct VACHostIO*)realloc(bench->io, (bench->source_count + 1) * sizeof(struct VACHostIO));
+    vac_host_drain();
+    return theError;
+}
+
+int main(void)
+{
+    static struct BenchBusMix theBench;
+    vac_host_load();
+
+    static const uint32_t kSourceCounts[] = { 2, 8, 0 };
+    printf("%8s %14s %14s %12s\n", "sources", "bus ns", "ns/source", "mix GB/s");
+    for(uint32_t theCount = 0; theCount < sizeof(kSourceCounts) / sizeof(kSourceCounts[0]); ++theCount)
+    {
+        OSStatus theError = bench_create(&theBench, kSourceCounts[theCount]);
+        if(theError != 0)
+        {
+            printf("creating source %u of a bus failed with %d\n", theBench.source_count + 1, (int)theError);
+            return 1;
+        }
+        for(uint32_t theDevice = 0; theDevice <= theBench.source_count; ++theDevice)
+        {
+            vac_host_io_start(&theBench.io[theDevice], (theDevice == theBench.source_count) ? theBench.bus : theBench.sources[theDevice], 1, kBench_FrameSize);
+            theBench.io[theDevice].render = bench_render;
+            theBench.io[theDevice].refcon = &theBench;
+        }
+
+        bench_cycles(&theBench, kBench_SettleCycles);
+        double theBusTime = bench_cycles(&theBench, kBench_Cycles);
+        //	the source frames the bus reads out of their rings and sums each cycle
+        double theBytes = (double)kBench_FrameSize * theBench.io[0].channel_count * sizeof(float) * theBench.source_count;
+        printf("%8u %14.0f %14.0f %12.2f\n", theBench.source_count, theBusTime, theBusTime / theBench.source_count, bench_gigabytes_per_second(theBytes, theBusTime));
+
+        for(uint32_t theDevice = 0; theDevice <= theBench.source_count; ++theDevice)
+        {
+            vac_host_io_stop(&theBench.io[theDevice]);
+        }
+    }
+
+    printf("source %u for the bus: %s (%d)\n", theBench.source_count + 1, (theBench.refusal == kAudioHardwareIllegalOperationError) ? "refused" : "not refused as an illegal operation", (int)theBench.refusal);
+    free(theBench.sources);
+    free(theBench.io);
+    return (theBench.refusal == kAudioHardwareIllegalOperationError) ? 0 : 1;
+}
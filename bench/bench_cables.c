@@ -0,0 +1,108 @@
+//	What the other cables cost a cable. With 1 to 64 cables created through CreateDevice, and IO
+//	running on all of them, measures a property call on the newest cable, the plug-in's device list,
+//	one IO cycle per cable and creating and destroying one more cable. Every cable is found from its
+//	object ID by a division, so only the device list should grow with the count.
+
+#include "VACbench.h"
+#include "VAChost.h"
+
+#include <stdlib.h>
+
+#define                             kBench_MaxCables                    64
+#define                             kBench_FrameSize                    512
+
+struct BenchCables {
+    AudioServerPlugInDriverRef      driver;
+    uint32_t                        count;
+    AudioObjectID                   devices[kBench_MaxCables];
+    struct VACHostIO                io[kBench_MaxCables];
+};
+
+static void bench_get_name(void* context, uint32_t iterations)
+{
+    struct BenchCables* theBench = (struct BenchCables*)context;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        CFStringRef theName = NULL;
+        vac_host_get(theBench->devices[theBench->count - 1], kAudioObjectPropertyName, kAudioObjectPropertyScopeGlobal, sizeof(theName), &theName);
+        CFRelease(theName);
+    }
+}
+
+static void bench_get_device_list(void* context, uint32_t iterations)
+{
+    AudioObjectID theDevices[kBench_MaxCables + 8];
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        vac_host_get(kAudioObjectPlugInObject, kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, sizeof(theDevices), theDevices);
+    }
+    gBench_Sink = (float)theDevices[0];
+}
+
+//	one cycle of every cable, in lockstep so that simulated time only moves forward
+static void bench_io_cycle(void* context, uint32_t iterations)
+{
+    struct BenchCables* theBench = (struct BenchCables*)context;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        for(uint32_t theCable = 0; theCable < theBench->count; ++theCable)
+        {
+            vac_host_io_cycle(&theBench->io[theCable], 0);
+        }
+    }
+    gBench_Sink = theBench->io[0].input[0];
+}
+
+static void bench_create_destroy(void* context, uint32_t iterations)
+{
+    struct BenchCables* theBench = (struct BenchCables*)context;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        AudioObjectID theDevice = kAudioObjectUnknown;
+        vac_host_create_device("bench.cable.extra", NULL, false, &theDevice);
+        (*theBench->driver)->DestroyDevice(theBench->driver, theDevice);
+        vac_host_drain();
+    }
+}
+
+int main(void)
+{
+    static struct BenchCables theBench;
+    theBench.driver = vac_host_load();
+
+    printf("%8s %14s %14s %18s %18s\n", "cables", "name ns", "list ns", "cycle ns/cable", "create+destroy us");
+    for(uint32_t theCount = 1; theCount <= kBench_MaxCables; theCount *= 2)
+    {
+        for(; theBench.count < theCount; ++theBench.count)
+        {
+            char theUID[32];
+            snprintf(theUID, sizeof(theUID), "bench.cable.%u", theBench.count);
+            OSStatus theError = vac_host_create_device(theUID, NULL, false, &theBench.devices[theBench.count]);
+            if(theError != 0)
+            {
+                printf("creating cable %u failed with %d\n", theBench.count, (int)theError);
+                return 1;
+            }
+        }
+        vac_host_drain();
+
+        //	all the cables start at the same simulated time
+        for(uint32_t theCable = 0; theCable < theBench.count; ++theCable)
+        {
+            vac_host_io_start(&theBench.io[theCable], theBench.devices[theCable], 1, kBench_FrameSize);
+        }
+
+        double theName = bench_run(bench_get_name, &theBench, 100000);
+        double theList = bench_run(bench_get_device_list, &theBench, 100000);
+        double theCycle = bench_run(bench_io_cycle, &theBench, 2000 / theBench.count + 1) / theBench.count;
+
+        for(uint32_t theCable = 0; theCable < theBench.count; ++theCable)
+        {
+            vac_host_io_stop(&theBench.io[theCable]);
+        }
+        double theCreate = bench_run(bench_create_destroy, &theBench, 20) / 1000.0;
+
+        printf("%8u %14.1f %14.1f %18.1f %18.1f\n", theBench.count, theName, theList, theCycle, theCreate);
+    }
+    return 0;
+}
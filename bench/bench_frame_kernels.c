@@ -0,0 +1,97 @@
+//	The per-channel gain kernels with the channel count baked in against the generic ones of the same
+//	set, at the 32 to 128 frame host buffers where the per-call setup shows. For every set this CPU
+//	can run that has specialized versions, and every channel count they cover, reports the time per
+//	call of each and how many times faster the specialized one is.
+
+#include "VACbench.h"
+#include "VACkernels.h"
+
+#include <stdlib.h>
+
+#define                             kBench_MaxFrames                    128
+#define                             kBench_Calls                        20000
+
+struct BenchFrameKernels {
+    ChannelGainKernel               channel_gain;
+    ChannelGainRampKernel           channel_gain_ramp;
+    uint32_t                        frames;
+    uint32_t                        channels;
+    const float*                    in;
+    float*                          out;
+    float                           gains[64];
+    float                           steps[64];
+};
+
+static void bench_channel_gain(void* context, uint32_t iterations)
+{
+    struct BenchFrameKernels* theBench = (struct BenchFrameKernels*)context;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        theBench->channel_gain(theBench->out, theBench->in, theBench->frames, theBench->channels, theBench->gains);
+    }
+    gBench_Sink = theBench->out[0];
+}
+
+static void bench_channel_gain_ramp(void* context, uint32_t iterations)
+{
+    struct BenchFrameKernels* theBench = (struct BenchFrameKernels*)context;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        theBench->channel_gain_ramp(theBench->out, theBench->in, theBench->frames, theBench->channels, theBench->gains, theBench->steps);
+    }
+    gBench_Sink = theBench->out[0];
+}
+
+int main(void)
+{
+    static const uint32_t kFrames[] = { 32, 64, 128 };
+    float* theIn = (float*)malloc(kBench_MaxFrames * 64 * sizeof(float));
+    float* theOut = (float*)malloc(kBench_MaxFrames * 64 * sizeof(float));
+    for(uint32_t i = 0; i < kBench_MaxFrames * 64; ++i)
+    {
+        theIn[i] = (float)(i % 977) / 977.0f;
+    }
+
+    struct BenchFrameKernels theGeneric;
+    struct BenchFrameKernels theSpecialized;
+    for(uint32_t c = 0; c < 64; ++c)
+    {
+        theGeneric.gains[c] = theSpecialized.gains[c] = 0.25f + (float)c / 128.0f;
+        theGeneric.steps[c] = theSpecialized.steps[c] = 1e-4f * (float)(c + 1);
+    }
+    theGeneric.in = theSpecialized.in = theIn;
+    theGeneric.out = theSpecialized.out = theOut;
+
+    const struct Kernels* theSets[8];
+    uint32_t theSetCount = kernels_available(theSets, 8);
+    printf("%8s %9s %7s %16s %16s %8s %16s %16s %8s\n", "set", "channels", "frames", "gain generic ns", "specialized ns", "speedup", "ramp generic ns", "specialized ns", "speedup");
+    for(uint32_t s = 0; s < theSetCount; ++s)
+    {
+        const struct Kernels* theSet = theSets[s];
+        for(uint32_t f = 0; (theSet->frames != NULL) && (f < kFrameKernels_Count); ++f)
+        {
+            const struct FrameKernels* theKernels = &theSet->frames[f];
+            for(uint32_t l = 0; l < sizeof(kFrames) / sizeof(kFrames[0]); ++l)
+            {
+                theGeneric.channel_gain = theSet->channel_gain;
+                theGeneric.channel_gain_ramp = theSet->channel_gain_ramp;
+                theSpecialized.channel_gain = theKernels->channel_gain;
+                theSpecialized.channel_gain_ramp = theKernels->channel_gain_ramp;
+                theGeneric.frames = theSpecialized.frames = kFrames[l];
+                theGeneric.channels = theSpecialized.channels = theKernels->channels;
+
+                double theGainGeneric = bench_run(bench_channel_gain, &theGeneric, kBench_Calls);
+                double theGainSpecialized = bench_run(bench_channel_gain, &theSpecialized, kBench_Calls);
+                double theRampGeneric = bench_run(bench_channel_gain_ramp, &theGeneric, kBench_Calls);
+                double theRampSpecialized = bench_run(bench_channel_gain_ramp, &theSpecialized, kBench_Calls);
+                printf("%8s %9u %7u %16.1f %16.1f %7.2fx %16.1f %16.1f %7.2fx\n", theSet->name, theKernels->channels, kFrames[l],
+                    theGainGeneric, theGainSpecialized, theGainGeneric / theGainSpecialized,
+                    theRampGeneric, theRampSpecialized, theRampGeneric / theRampSpecialized);
+            }
+        }
+    }
+
+    free(theIn);
+    free(theOut);
+    return 0;
+}
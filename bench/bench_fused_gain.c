@@ -0,0 +1,92 @@
+//	ReadInput with a volume applied: the fused kernel reads the ring once and writes the scaled frames,
+//	where the original copied them out and then scaled them in a second pass over the host buffer. Both
+//	are timed at 2, 16 and 64 channels for a few buffer sizes, next to the unity (plain copy) and mute
+//	(clear only) variants the transfer picks instead when it can. Bandwidth counts the bytes each way
+//	the fused version moves, so the two pass version shows what it loses by moving more.
+
+#include "VACbench.h"
+#include "VACcore.h"
+
+#include <stdlib.h>
+
+struct BenchGain {
+    const float*                    in;
+    float*                          out;
+    uint32_t                        samples;
+};
+
+static void bench_fused(void* context, uint32_t iterations)
+{
+    struct BenchGain* theBench = (struct BenchGain*)context;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        gKernels.gain(theBench->out, theBench->in, theBench->samples, 0.5f);
+    }
+    gBench_Sink = theBench->out[0];
+}
+
+static void bench_two_pass(void* context, uint32_t iterations)
+{
+    struct BenchGain* theBench = (struct BenchGain*)context;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        gKernels.copy(theBench->out, theBench->in, theBench->samples, 1.0f);
+        gKernels.gain(theBench->out, theBench->out, theBench->samples, 0.5f);
+    }
+    gBench_Sink = theBench->out[0];
+}
+
+static void bench_unity(void* context, uint32_t iterations)
+{
+    struct BenchGain* theBench = (struct BenchGain*)context;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        gKernels.copy(theBench->out, theBench->in, theBench->samples, 1.0f);
+    }
+    gBench_Sink = theBench->out[0];
+}
+
+static void bench_mute(void* context, uint32_t iterations)
+{
+    struct BenchGain* theBench = (struct BenchGain*)context;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        gKernels.clear(theBench->out, theBench->samples);
+    }
+    gBench_Sink = theBench->out[0];
+}
+
+int main(void)
+{
+    static const uint32_t kChannels[] = { 2, 16, 64 };
+    static const uint32_t kFrames[] = { 128, 512, 4096 };
+    kernels_select();
+
+    float* theIn = (float*)malloc(4096 * 64 * sizeof(float));
+    float* theOut = (float*)malloc(4096 * 64 * sizeof(float));
+    for(uint32_t i = 0; i < 4096 * 64; ++i)
+    {
+        theIn[i] = (float)(i % 1000) / 1000.0f;
+    }
+
+    printf("kernels %s, GB/s of ring data read and host buffer written\n", gKernels.name);
+    printf("%9s %7s %12s %12s %12s %12s\n", "channels", "frames", "fused", "two pass", "unity", "mute");
+    for(uint32_t c = 0; c < sizeof(kChannels) / sizeof(kChannels[0]); ++c)
+    {
+        for(uint32_t f = 0; f < sizeof(kFrames) / sizeof(kFrames[0]); ++f)
+        {
+            struct BenchGain theBench = { theIn, theOut, kChannels[c] * kFrames[f] };
+            uint32_t theIterations = (1u << 26) / theBench.samples;
+            double theBytes = (double)theBench.samples * sizeof(float) * 2.0;
+            printf("%9u %7u %12.2f %12.2f %12.2f %12.2f\n", kChannels[c], kFrames[f],
+                bench_gigabytes_per_second(theBytes, bench_run(bench_fused, &theBench, theIterations)),
+                bench_gigabytes_per_second(theBytes, bench_run(bench_two_pass, &theBench, theIterations)),
+                bench_gigabytes_per_second(theBytes, bench_run(bench_unity, &theBench, theIterations)),
+                bench_gigabytes_per_second(theBytes / 2.0, bench_run(bench_mute, &theBench, theIterations)));
+        }
+    }
+
+    free(theIn);
+    free(theOut);
+    return 0;
+}
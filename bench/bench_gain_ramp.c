@@ -0,0 +1,110 @@
+//	What a control change costs the IO cycle while it ramps in: one read out of the ring and one write
+//	into it, with a steady gain and with a ramp over the whole buffer, first with every channel alike
+//	(the scalar kernels) and then with a gain per channel (the per-channel kernels). Timed at 2, 16 and
+//	64 channels for a few buffer sizes; the ratio is what a cycle inside a ramp costs over a steady one.
+//	The ring is filled with sound first so the reads copy frames rather than hand out silence.
+
+#include "VACbench.h"
+#include "VACcore.h"
+
+#include <stdlib.h>
+
+#define                             kBench_MaxChannels                  64
+#define                             kBench_MaxFrames                    4096
+#define                             kBench_RingFrames                   16384
+
+struct BenchRamp {
+    struct RingBuffer*              ring;
+    float*                          samples;
+    uint32_t                        frames;
+    struct RingGain                 gain;
+};
+
+static void bench_read(void* context, uint32_t iterations)
+{
+    struct BenchRamp* theBench = (struct BenchRamp*)context;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        ring_buffer_read(theBench->ring, 0, theBench->frames, &theBench->gain, theBench->samples);
+    }
+    gBench_Sink = theBench->samples[0];
+}
+
+static void bench_write(void* context, uint32_t iterations)
+{
+    struct BenchRamp* theBench = (struct BenchRamp*)context;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        ring_buffer_write(theBench->ring, 0, theBench->frames, &theBench->gain, theBench->samples);
+    }
+}
+
+//	ns for a read and a write with the gain
+static double bench_cycle(struct BenchRamp* bench, struct RingGain gain, uint32_t iterations)
+{
+    bench->gain = gain;
+    return bench_run(bench_read, bench, iterations) + bench_run(bench_write, bench, iterations);
+}
+
+int main(void)
+{
+    static const uint32_t kChannels[] = { 2, 16, 64 };
+    static const uint32_t kFrames[] = { 128, 512, 4096 };
+    kernels_select();
+
+    float* theSound = (float*)malloc(kBench_MaxFrames * kBench_MaxChannels * sizeof(float));
+    float* theSamples = (float*)malloc(kBench_MaxFrames * kBench_MaxChannels * sizeof(float));
+    for(uint32_t i = 0; i < kBench_MaxFrames * kBench_MaxChannels; ++i)
+    {
+        theSound[i] = (float)(i % 1000) / 1000.0f + 0.001f;
+    }
+
+    float theChannelStart[kBench_MaxChannels];
+    float theChannelStep[kBench_MaxChannels];
+    float theChannelTarget[kBench_MaxChannels];
+
+    printf("kernels %s, ns for one read and one write\n", gKernels.name);
+    printf("%9s %7s %12s %12s %8s %12s %12s %8s\n", "channels", "frames", "steady", "ramp", "ratio", "ch steady", "ch ramp", "ratio");
+    for(uint32_t c = 0; c < sizeof(kChannels) / sizeof(kChannels[0]); ++c)
+    {
+        struct RingBuffer theRing;
+        if(!ring_buffer_allocate(&theRing, kBench_RingFrames, kChannels[c], false))
+        {
+            fprintf(stderr, "could not allocate the ring\n");
+            return 1;
+        }
+        struct RingGain theUnity = ring_gain_steady(1.0f);
+        ring_buffer_reset(&theRing);
+        ring_buffer_write(&theRing, 0, kBench_MaxFrames, &theUnity, theSound);
+
+        for(uint32_t f = 0; f < sizeof(kFrames) / sizeof(kFrames[0]); ++f)
+        {
+            uint32_t theFrames = kFrames[f];
+            for(uint32_t theChannel = 0; theChannel < kChannels[c]; ++theChannel)
+            {
+                theChannelStart[theChannel] = 1.0f - 0.01f * (float)theChannel;
+                theChannelTarget[theChannel] = 0.5f - 0.005f * (float)theChannel;
+                theChannelStep[theChannel] = (theChannelTarget[theChannel] - theChannelStart[theChannel]) / (float)theFrames;
+            }
+            struct RingGain theSteady = ring_gain_steady(0.5f);
+            struct RingGain theRamp = { 1.0f, -0.5f / (float)theFrames, theFrames, 0.5f, NULL, NULL, NULL };
+            struct RingGain theChannelSteady = { 0.5f, 0.0f, 0, 0.5f, NULL, NULL, theChannelTarget };
+            struct RingGain theChannelRamp = { 1.0f, 0.0f, theFrames, 0.5f, theChannelStart, theChannelStep, theChannelTarget };
+
+            struct BenchRamp theBench = { &theRing, theSamples, theFrames, theSteady };
+            uint32_t theIterations = (1u << 24) / (theFrames * kChannels[c]) + 1;
+            double theSteadyTime = bench_cycle(&theBench, theSteady, theIterations);
+            double theRampTime = bench_cycle(&theBench, theRamp, theIterations);
+            double theChannelSteadyTime = bench_cycle(&theBench, theChannelSteady, theIterations);
+            double theChannelRampTime = bench_cycle(&theBench, theChannelRamp, theIterations);
+            printf("%9u %7u %12.0f %12.0f %8.2f %12.0f %12.0f %8.2f\n", kChannels[c], theFrames,
+                theSteadyTime, theRampTime, theRampTime / theSteadyTime,
+                theChannelSteadyTime, theChannelRampTime, theChannelRampTime / theChannelSteadyTime);
+        }
+        ring_buffer_free(&theRing);
+    }
+
+    free(theSound);
+    free(theSamples);
+    return 0;
+}
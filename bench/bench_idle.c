@@ -0,0 +1,142 @@
+//	What an idle cable costs next to one carrying sound. A bus with kBench_Sources sources runs IO in
+//	lockstep with them: every device writing silence, then only the sources writing sound, then every
+//	device. For each the time per IO cycle of a source and of the bus (whose ReadInput mixes the
+//	sources in) is reported, with the host buffer bandwidth that works out to, the cable is silent
+//	property of both and what a query of it on the bus costs. With only the sources sounding the bus
+//	has to report sound too. Silence only marks block tags on the way in and skips the ring on the way
+//	out, so an idle cycle should cost a fraction of an active one.
+
+#include "VACbench.h"
+#include "VAChost.h"
+
+#include <stdlib.h>
+
+#define                             kBench_Sources                      4
+#define                             kBench_FrameSize                    512
+//	enough cycles to get more than a ring behind whatever was written before
+#define                             kBench_SettleCycles                 256
+#define                             kBench_Cycles                       4000
+
+//	from VACdummy.c
+#define                             kVACDevicePropertyIsSilent          'vsil'
+
+struct BenchIdle {
+    AudioObjectID                   bus;
+    AudioObjectID                   sources[kBench_Sources];
+    struct VACHostIO                io[kBench_Sources + 1];
+    bool                            is_source_active;
+    bool                            is_bus_active;
+};
+
+static void bench_render(struct VACHostIO* io)
+{
+    const struct BenchIdle* theBench = (const struct BenchIdle*)io->refcon;
+    bool theIsActive = (io == &theBench->io[kBench_Sources]) ? theBench->is_bus_active : theBench->is_source_active;
+    UInt32 theSamples = io->frame_size * io->channel_count;
+    for(UInt32 i = 0; i < theSamples; ++i)
+    {
+        io->output[i] = theIsActive ? (float)((io->cycle * theSamples + i) % 997) / 997.0f - 0.5f : 0.0f;
+    }
+}
+
+static SInt32 bench_is_silent(AudioObjectID device_id)
+{
+    CFPropertyListRef theValue = NULL;
+    SInt32 theIsSilent = -1;
+    if(vac_host_get(device_id, kVACDevicePropertyIsSilent, kAudioObjectPropertyScopeGlobal, sizeof(theValue), &theValue) == 0)
+    {
+        CFNumberGetValue((CFNumberRef)theValue, kCFNumberSInt32Type, &theIsSilent);
+        CFRelease(theValue);
+    }
+    return theIsSilent;
+}
+
+static void bench_query(void* context, uint32_t iterations)
+{
+    struct BenchIdle* theBench = (struct BenchIdle*)context;
+    SInt32 theSum = 0;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        theSum += bench_is_silent(theBench->bus);
+    }
+    gBench_Sink = (float)theSum;
+}
+
+//	ns per cycle of a source and of the bus, over cycles lockstep rounds
+static void bench_cycles(struct BenchIdle* bench, uint32_t cycles, double* out_source, double* out_bus)
+{
+    uint64_t theSourceTime = 0;
+    uint64_t theBusTime = 0;
+    for(uint32_t theCycle = 0; theCycle < cycles; ++theCycle)
+    {
+        for(uint32_t theDevice = 0; theDevice <= kBench_Sources; ++theDevice)
+        {
+            uint64_t theStart = bench_now();
+            vac_host_io_cycle(&bench->io[theDevice], 0);
+            uint64_t theTime = bench_now() - theStart;
+            *((theDevice == kBench_Sources) ? &theBusTime : &theSourceTime) += theTime;
+        }
+    }
+    *out_source = (double)theSourceTime / ((double)cycles * kBench_Sources);
+    *out_bus = (double)theBusTime / (double)cycles;
+}
+
+int main(void)
+{
+    static struct BenchIdle theBench;
+    vac_host_load();
+
+    OSStatus theError = vac_host_create_device("bench.bus", NULL, false, &theBench.bus);
+    for(uint32_t i = 0; (theError == 0) && (i < kBench_Sources); ++i)
+    {
+        char theUID[32];
+        snprintf(theUID, sizeof(theUID), "bench.source.%u", i);
+        theError = vac_host_create_device(theUID, "bench.bus", false, &theBench.sources[i]);
+    }
+    if(theError != 0)
+    {
+        printf("creating the devices failed with %d\n", (int)theError);
+        return 1;
+    }
+    vac_host_drain();
+
+    for(uint32_t theDevice = 0; theDevice <= kBench_Sources; ++theDevice)
+    {
+        vac_host_io_start(&theBench.io[theDevice], (theDevice == kBench_Sources) ? theBench.bus : theBench.sources[theDevice], 1, kBench_FrameSize);
+        theBench.io[theDevice].render = bench_render;
+        theBench.io[theDevice].refcon = &theBench;
+    }
+
+    //	what a cycle moves between the host and the driver, out and back in
+    double theBytes = (double)kBench_FrameSize * theBench.io[0].channel_count * sizeof(float) * 2.0;
+    printf("%u sources into a bus, %u frames of %u channels per cycle\n", kBench_Sources, kBench_FrameSize, theBench.io[0].channel_count);
+    printf("%8s %14s %12s %14s %12s %12s %12s %12s\n", "sounding", "source ns", "source GB/s", "bus ns", "bus GB/s", "source vsil", "bus vsil", "query ns");
+    static const struct {
+        const char*                 name;
+        bool                        is_source_active;
+        bool                        is_bus_active;
+    } kStates[] = {
+        { "idle",       false,  false },
+        { "sources",    true,   false },
+        { "active",     true,   true },
+    };
+    for(uint32_t theState = 0; theState < sizeof(kStates) / sizeof(kStates[0]); ++theState)
+    {
+        theBench.is_source_active = kStates[theState].is_source_active;
+        theBench.is_bus_active = kStates[theState].is_bus_active;
+        double theSourceTime = 0.0;
+        double theBusTime = 0.0;
+        bench_cycles(&theBench, kBench_SettleCycles, &theSourceTime, &theBusTime);
+        bench_cycles(&theBench, kBench_Cycles, &theSourceTime, &theBusTime);
+        printf("%8s %14.0f %12.2f %14.0f %12.2f %12d %12d %12.0f\n", kStates[theState].name,
+            theSourceTime, bench_gigabytes_per_second(theBytes, theSourceTime),
+            theBusTime, bench_gigabytes_per_second(theBytes, theBusTime),
+            (int)bench_is_silent(theBench.sources[0]), (int)bench_is_silent(theBench.bus), bench_run(bench_query, &theBench, 10000));
+    }
+
+    for(uint32_t theDevice = 0; theDevice <= kBench_Sources; ++theDevice)
+    {
+        vac_host_io_stop(&theBench.io[theDevice]);
+    }
+    return 0;
+}
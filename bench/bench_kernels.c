@@ -0,0 +1,125 @@
+//	Bandwidth of every kernel in every set this CPU can run, in GB/s of samples read plus written, for
+//	a stereo host buffer of 512 frames that sits in L1 and a 64 channel one that doesn't.
+
+#include "VACbench.h"
+#include "VACkernels.h"
+
+#include <stdlib.h>
+
+enum BenchKernel {
+    kBenchKernel_Clear,
+    kBenchKernel_Copy,
+    kBenchKernel_Gain,
+    kBenchKernel_GainRamp,
+    kBenchKernel_ChannelGain,
+    kBenchKernel_ChannelGainRamp,
+    kBenchKernel_Sum,
+    kBenchKernel_IsSilent,
+    kBenchKernel_Interleave,
+    kBenchKernel_Deinterleave,
+    kBenchKernel_Count
+};
+
+static const char* const            kBenchKernel_Names[kBenchKernel_Count] = { "clear", "copy", "gain", "gain_ramp", "channel_gain", "channel_gain_ramp", "sum", "is_silent", "interleave", "deinterleave" };
+
+//	samples moved per sample of buffer, reads plus writes
+static const double                 kBenchKernel_Traffic[kBenchKernel_Count] = { 1, 2, 2, 2, 2, 2, 3, 1, 2, 2 };
+
+struct BenchKernels {
+    const struct Kernels*           set;
+    enum BenchKernel                kernel;
+    uint32_t                        frames;
+    uint32_t                        channels;
+    float*                          in;
+    float*                          out;
+    float*                          silence;
+    const float*                    planes_in[64];
+    float*                          planes_out[64];
+    float                           gains[64];
+    float                           steps[64];
+};
+
+static void bench_kernel(void* context, uint32_t iterations)
+{
+    struct BenchKernels* theBench = (struct BenchKernels*)context;
+    const struct Kernels* theSet = theBench->set;
+    uint32_t theFrames = theBench->frames;
+    uint32_t theChannels = theBench->channels;
+    uint32_t theSamples = theFrames * theChannels;
+    bool theSilent = false;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        switch(theBench->kernel)
+        {
+            case kBenchKernel_Clear:            theSet->clear(theBench->out, theSamples); break;
+            case kBenchKernel_Copy:             theSet->copy(theBench->out, theBench->in, theSamples, 1.0f); break;
+            case kBenchKernel_Gain:             theSet->gain(theBench->out, theBench->in, theSamples, 0.5f); break;
+            case kBenchKernel_GainRamp:         theSet->gain_ramp(theBench->out, theBench->in, theFrames, theChannels, 0.5f, 1e-4f); break;
+            case kBenchKernel_ChannelGain:      theSet->channel_gain(theBench->out, theBench->in, theFrames, theChannels, theBench->gains); break;
+            case kBenchKernel_ChannelGainRamp:  theSet->channel_gain_ramp(theBench->out, theBench->in, theFrames, theChannels, theBench->gains, theBench->steps); break;
+            case kBenchKernel_Sum:              theSet->sum(theBench->out, theBench->in, theSamples, 0.5f); break;
+            case kBenchKernel_IsSilent:         theSilent ^= theSet->is_silent(theBench->silence, theSamples); break;
+            case kBenchKernel_Interleave:       theSet->interleave(theBench->out, theBench->planes_in, theFrames, theChannels); break;
+            case kBenchKernel_Deinterleave:     theSet->deinterleave(theBench->planes_out, theBench->in, theFrames, theChannels); break;
+            default:                            break;
+        }
+    }
+    gBench_Sink = theBench->out[0] + (theSilent ? 1.0f : 0.0f);
+}
+
+int main(void)
+{
+    static const uint32_t kLayouts[][2] = { { 512, 2 }, { 512, 64 } };
+    struct BenchKernels theBench;
+    theBench.in = (float*)malloc(512 * 64 * sizeof(float));
+    theBench.out = (float*)malloc(512 * 64 * sizeof(float));
+    //	is_silent stops at the first sound, so it scans silence to be measured over the whole buffer
+    theBench.silence = (float*)calloc(512 * 64, sizeof(float));
+    for(uint32_t i = 0; i < 512 * 64; ++i)
+    {
+        theBench.in[i] = (float)(i % 977) / 977.0f;
+    }
+    for(uint32_t c = 0; c < 64; ++c)
+    {
+        theBench.gains[c] = 0.5f + (float)c / 128.0f;
+        theBench.steps[c] = 1e-5f;
+    }
+
+    const struct Kernels* theSets[8];
+    uint32_t theSetCount = kernels_available(theSets, 8);
+    for(uint32_t l = 0; l < sizeof(kLayouts) / sizeof(kLayouts[0]); ++l)
+    {
+        theBench.frames = kLayouts[l][0];
+        theBench.channels = kLayouts[l][1];
+        for(uint32_t c = 0; c < theBench.channels; ++c)
+        {
+            theBench.planes_in[c] = theBench.in + (size_t)c * theBench.frames;
+            theBench.planes_out[c] = theBench.out + (size_t)c * theBench.frames;
+        }
+
+        printf("\n%u frames of %u channels, GB/s\n%18s", theBench.frames, theBench.channels, "");
+        for(uint32_t s = 0; s < theSetCount; ++s)
+        {
+            printf(" %9s", theSets[s]->name);
+        }
+        printf("\n");
+        for(uint32_t k = 0; k < kBenchKernel_Count; ++k)
+        {
+            printf("%18s", kBenchKernel_Names[k]);
+            theBench.kernel = (enum BenchKernel)k;
+            for(uint32_t s = 0; s < theSetCount; ++s)
+            {
+                theBench.set = theSets[s];
+                uint32_t theSamples = theBench.frames * theBench.channels;
+                double theTime = bench_run(bench_kernel, &theBench, (1u << 25) / theSamples);
+                printf(" %9.2f", bench_gigabytes_per_second(kBenchKernel_Traffic[k] * theSamples * sizeof(float), theTime));
+            }
+            printf("\n");
+        }
+    }
+
+    free(theBench.in);
+    free(theBench.out);
+    free(theBench.silence);
+    return 0;
+}
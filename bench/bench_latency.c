@@ -0,0 +1,167 @@
+//	What each latency profile costs and how close it runs to a glitch. For both profiles and a few IO
+//	buffer sizes, runs a real IO thread on real time for a second the way the HAL does, sleeping until
+//	each cycle is due and then running it, with a loopback signal written by WriteMix and checked when
+//	ReadInput brings it back. It reports the round trip from WriteMix to ReadInput that the profile's
+//	safety offsets add up to, how late the thread woke up, and the glitches: cycles where WriteMix
+//	turned the buffer away for being too late, and frames that came back wrong. Runs once on an idle
+//	machine and once with a thread spinning next to the IO thread.
+
+#include "VACbench.h"
+#include "VAChost.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define                             kBench_Seconds                      1
+#define                             kBench_MaxLateness                  65536
+
+struct BenchLatency {
+    SInt64                          first_output_time;
+    uint32_t                        lateness[kBench_MaxLateness];
+    uint32_t                        cycles;
+    uint32_t                        refused;
+    uint64_t                        wrong_frames;
+    _Atomic bool                    is_done;
+};
+
+static float bench_signal(SInt64 sample_time, UInt32 channel)
+{
+    return (float)((sample_time * 7 + channel) % 4096 + 1) / 4096.0f;
+}
+
+static void bench_render(struct VACHostIO* io)
+{
+    struct BenchLatency* theBench = (struct BenchLatency*)io->refcon;
+    SInt64 theOutputTime = (SInt64)io->cycle_info.mOutputTime.mSampleTime;
+    if(theBench->first_output_time < 0)
+    {
+        theBench->first_output_time = theOutputTime;
+    }
+    for(UInt32 i = 0; i < io->frame_size; ++i)
+    {
+        for(UInt32 c = 0; c < io->channel_count; ++c)
+        {
+            io->output[i * io->channel_count + c] = bench_signal(theOutputTime + i, c);
+        }
+    }
+}
+
+static void* bench_spinner(void* context)
+{
+    struct BenchLatency* theBench = (struct BenchLatency*)context;
+    while(!atomic_load_explicit(&theBench->is_done, memory_order_relaxed))
+    {
+    }
+    return NULL;
+}
+
+static void bench_sleep_until(uint64_t host_time)
+{
+    struct timespec theTime = { (time_t)(host_time / 1000000000ULL), (long)(host_time % 1000000000ULL) };
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &theTime, NULL) != 0)
+    {
+    }
+}
+
+static uint32_t bench_percentile(const uint32_t* histogram, uint32_t count, double fraction)
+{
+    uint64_t theTarget = (uint64_t)(fraction * count);
+    theTarget = (theTarget < count) ? theTarget : count - 1;
+    uint64_t theSeen = 0;
+    for(uint32_t i = 0; i < kBench_MaxLateness; ++i)
+    {
+        theSeen += histogram[i];
+        if(theSeen > theTarget)
+        {
+            return i;
+        }
+    }
+    return kBench_MaxLateness - 1;
+}
+
+static void bench_measure(AudioObjectID device_id, const char* profile_name, UInt32 frame_size, bool is_loaded)
+{
+    static struct BenchLatency theBench;
+    memset(&theBench, 0, sizeof(theBench));
+    theBench.first_output_time = -1;
+
+    pthread_t theSpinner;
+    if(is_loaded)
+    {
+        pthread_create(&theSpinner, NULL, bench_spinner, &theBench);
+    }
+
+    struct VACHostIO theIO;
+    vac_host_io_start(&theIO, device_id, 1, frame_size);
+    theIO.render = bench_render;
+    theIO.refcon = &theBench;
+
+    uint32_t theCycles = (uint32_t)(kBench_Seconds * theIO.sample_rate / frame_size);
+    for(uint32_t theCycle = 1; theCycle <= theCycles; ++theCycle)
+    {
+        bench_sleep_until(theIO.start_host_time + (uint64_t)((Float64)theCycle * frame_size * 1000000000.0 / theIO.sample_rate));
+        OSStatus theError = vac_host_io_cycle(&theIO, 0);
+        theBench.refused += (theError != 0) ? 1 : 0;
+
+        Float64 theLateness = theIO.cycle_info.mCurrentTime.mSampleTime - (theIO.schedule_sample_time + (Float64)(theIO.cycle * frame_size));
+        uint32_t theBucket = (theLateness <= 0) ? 0 : (uint32_t)theLateness;
+        ++theBench.lateness[(theBucket < kBench_MaxLateness) ? theBucket : kBench_MaxLateness - 1];
+        ++theBench.cycles;
+
+        SInt64 theInputTime = (SInt64)theIO.cycle_info.mInputTime.mSampleTime;
+        for(UInt32 i = 0; (theBench.first_output_time >= 0) && (i < frame_size); ++i)
+        {
+            if(theInputTime + i >= theBench.first_output_time)
+            {
+                theBench.wrong_frames += (theIO.input[i * theIO.channel_count] != bench_signal(theInputTime + i, 0)) ? 1 : 0;
+            }
+        }
+    }
+    UInt32 theRoundTrip = frame_size + theIO.input_offset + theIO.output_offset;
+    vac_host_io_stop(&theIO);
+
+    if(is_loaded)
+    {
+        atomic_store(&theBench.is_done, true);
+        pthread_join(theSpinner, NULL);
+    }
+
+    printf("%9s %6u %7s %6u %6u %7.2f %9u %9u %9u %9u %9llu\n", profile_name, frame_size, is_loaded ? "loaded" : "idle", theIO.input_offset, theIO.output_offset, theRoundTrip * 1000.0 / theIO.sample_rate,
+           bench_percentile(theBench.lateness, theBench.cycles, 0.5), bench_percentile(theBench.lateness, theBench.cycles, 0.999), bench_percentile(theBench.lateness, theBench.cycles, 1.0), theBench.refused, (unsigned long long)theBench.wrong_frames);
+}
+
+static void bench_set_profile(AudioObjectID device_id, SInt32 profile)
+{
+    CFNumberRef theProfile = CFNumberCreate(NULL, kCFNumberSInt32Type, &profile);
+    vac_host_set(device_id, 'vlpf', kAudioObjectPropertyScopeGlobal, sizeof(CFPropertyListRef), &theProfile);
+    CFRelease(theProfile);
+    vac_host_drain();
+}
+
+int main(void)
+{
+    static const struct { const char* name; SInt32 profile; UInt32 frame_sizes[3]; } kProfiles[] = {
+        { "standard", 0, { 64, 512, 1024 } },
+        { "low", 1, { 32, 64, 512 } },
+    };
+
+    vac_host_load();
+    vac_host_use_real_time(true);
+    AudioObjectID theDevices[8];
+    vac_host_get(kAudioObjectPlugInObject, kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, sizeof(theDevices), theDevices);
+
+    printf("lateness in frames, round trip from WriteMix to ReadInput\n");
+    printf("%9s %6s %7s %6s %6s %7s %9s %9s %9s %9s %9s\n", "profile", "frames", "load", "in", "out", "trip ms", "late 50%", "late 99.9", "late max", "refused", "wrong");
+    for(uint32_t p = 0; p < sizeof(kProfiles) / sizeof(kProfiles[0]); ++p)
+    {
+        bench_set_profile(theDevices[0], kProfiles[p].profile);
+        for(uint32_t f = 0; f < 3; ++f)
+        {
+            bench_measure(theDevices[0], kProfiles[p].name, kProfiles[p].frame_sizes[f], false);
+            bench_measure(theDevices[0], kProfiles[p].name, kProfiles[p].frame_sizes[f], true);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+//	Property calls per second through the registry, for the selectors the HAL asks the plug-in, a
+//	device, its streams and its controls about most often, and for selectors an object doesn't have,
+//	which have to be ruled out just as fast. Each query is a HasProperty, a GetPropertyDataSize and a
+//	GetPropertyData, the way the HAL reads a property it hasn't cached.
+
+#include "VACbench.h"
+#include "VAChost.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#define                             kBench_MaxSelectors                 16
+
+struct BenchSelector {
+    AudioObjectPropertySelector     selector;
+    AudioObjectPropertyScope        scope;
+    //	the value is a CF object the caller has to release
+    bool                            is_cf;
+};
+
+struct BenchObject {
+    const char*                     name;
+    AudioObjectID                   object_id;
+    uint32_t                        count;
+    //	how many of the selectors the object has, which has to be all of them but for the unknown ones
+    uint32_t                        answered;
+    struct BenchSelector            selectors[kBench_MaxSelectors];
+};
+
+static AudioServerPlugInDriverRef   gBench_Driver;
+
+static void bench_query(void* context, uint32_t iterations)
+{
+    struct BenchObject* theObject = (struct BenchObject*)context;
+    uint32_t theAnswered = 0;
+    UInt8 theData[1024];
+    pid_t thePID = getpid();
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        const struct BenchSelector* theSelector = &theObject->selectors[i % theObject->count];
+        AudioObjectPropertyAddress theAddress = { theSelector->selector, theSelector->scope, kAudioObjectPropertyElementMain };
+        if(!(*gBench_Driver)->HasProperty(gBench_Driver, theObject->object_id, thePID, &theAddress))
+        {
+            continue;
+        }
+        UInt32 theSize = 0;
+        (*gBench_Driver)->GetPropertyDataSize(gBench_Driver, theObject->object_id, thePID, &theAddress, 0, NULL, &theSize);
+        if((*gBench_Driver)->GetPropertyData(gBench_Driver, theObject->object_id, thePID, &theAddress, 0, NULL, sizeof(theData), &theSize, theData) == 0)
+        {
+            theAnswered += (i < theObject->count) ? 1 : 0;
+            if(theSelector->is_cf)
+            {
+                CFRelease(*(CFTypeRef*)theData);
+            }
+        }
+    }
+    theObject->answered = theAnswered;
+    gBench_Sink = (float)theData[0];
+}
+
+static AudioObjectID bench_first(AudioObjectID object_id, AudioObjectPropertySelector selector, AudioObjectPropertyScope scope)
+{
+    AudioObjectID theObjects[64] = { kAudioObjectUnknown };
+    vac_host_get(object_id, selector, scope, sizeof(theObjects), theObjects);
+    return theObjects[0];
+}
+
+int main(void)
+{
+    gBench_Driver = vac_host_load();
+
+    AudioObjectID theDevice = bench_first(kAudioObjectPlugInObject, kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal);
+    AudioObjectID theStream = bench_first(theDevice, kAudioDevicePropertyStreams, kAudioObjectPropertyScopeOutput);
+    AudioObjectID theControls[64] = { kAudioObjectUnknown };
+    vac_host_get(theDevice, kAudioObjectPropertyControlList, kAudioObjectPropertyScopeGlobal, sizeof(theControls), theControls);
+    AudioObjectID theVolume = kAudioObjectUnknown;
+    AudioObjectID theMute = kAudioObjectUnknown;
+    for(uint32_t i = 0; (i < 64) && (theControls[i] != kAudioObjectUnknown); ++i)
+    {
+        UInt32 theClass = 0;
+        vac_host_get(theControls[i], kAudioObjectPropertyClass, kAudioObjectPropertyScopeGlobal, sizeof(theClass), &theClass);
+        theVolume = ((theVolume == kAudioObjectUnknown) && (theClass == kAudioVolumeControlClassID)) ? theControls[i] : theVolume;
+        theMute = ((theMute == kAudioObjectUnknown) && (theClass == kAudioMuteControlClassID)) ? theControls[i] : theMute;
+    }
+
+    const AudioObjectPropertyScope kGlobal = kAudioObjectPropertyScopeGlobal;
+    const AudioObjectPropertyScope kOutput = kAudioObjectPropertyScopeOutput;
+    struct BenchObject theObjects[] = {
+        { "plug-in", kAudioObjectPlugInObject, 4, 0, {
+            { kAudioObjectPropertyClass, kGlobal, false }, { kAudioObjectPropertyManufacturer, kGlobal, true },
+            { kAudioObjectPropertyOwnedObjects, kGlobal, false }, { kAudioPlugInPropertyDeviceList, kGlobal, false } } },
+        { "device", theDevice, 14, 0, {
+            { kAudioObjectPropertyName, kGlobal, true }, { kAudioDevicePropertyDeviceUID, kGlobal, true },
+            { kAudioDevicePropertyTransportType, kGlobal, false }, { kAudioDevicePropertyDeviceIsRunning, kGlobal, false },
+            { kAudioDevicePropertyNominalSampleRate, kGlobal, false }, { kAudioDevicePropertyAvailableNominalSampleRates, kGlobal, false },
+            { kAudioDevicePropertyZeroTimeStampPeriod, kGlobal, false }, { kAudioDevicePropertyLatency, kOutput, false },
+            { kAudioDevicePropertySafetyOffset, kOutput, false }, { kAudioDevicePropertyStreams, kOutput, false },
+            { kAudioObjectPropertyControlList, kGlobal, false }, { kAudioObjectPropertyOwnedObjects, kGlobal, false },
+            { kAudioDevicePropertyPreferredChannelsForStereo, kOutput, false }, { kAudioDevicePropertyIsHidden, kGlobal, false } } },
+        { "stream", theStream, 5, 0, {
+            { kAudioStreamPropertyIsActive, kGlobal, false }, { kAudioStreamPropertyDirection, kGlobal, false },
+            { kAudioStreamPropertyStartingChannel, kGlobal, false }, { kAudioStreamPropertyVirtualFormat, kGlobal, false },
+            { kAudioStreamPropertyLatency, kGlobal, false } } },
+        { "volume", theVolume, 4, 0, {
+            { kAudioLevelControlPropertyScalarValue, kGlobal, false }, { kAudioLevelControlPropertyDecibelValue, kGlobal, false },
+            { kAudioLevelControlPropertyDecibelRange, kGlobal, false }, { kAudioObjectPropertyClass, kGlobal, false } } },
+        { "mute", theMute, 2, 0, {
+            { kAudioBooleanControlPropertyValue, kGlobal, false }, { kAudioObjectPropertyClass, kGlobal, false } } },
+        { "device, unknown", theDevice, 4, 0, {
+            { 'nope', kGlobal, false }, { kAudioStreamPropertyVirtualFormat, kGlobal, false },
+            { kAudioLevelControlPropertyScalarValue, kGlobal, false }, { kAudioDevicePropertySafetyOffset, kGlobal, false } } },
+    };
+
+    printf("%16s %9s %12s %14s\n", "object", "answered", "ns/query", "queries/s");
+    for(uint32_t i = 0; i < sizeof(theObjects) / sizeof(theObjects[0]); ++i)
+    {
+        double theTime = bench_run(bench_query, &theObjects[i], 200000);
+        printf("%16s %5u/%-3u %12.1f %14.0f\n", theObjects[i].name, theObjects[i].answered, theObjects[i].count, theTime, 1e9 / theTime);
+    }
+    return 0;
+}
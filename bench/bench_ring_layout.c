@@ -0,0 +1,117 @@
+//	What the mirrored mapping buys: a transfer out of the ring is one contiguous copy wherever it
+//	starts, where a plain ring has to split the copies that wrap around its end in two. Both are timed
+//	with the selected copy kernel over 32 to 4096 frame transfers at every alignment, so about
+//	frames / ring_frames of them wrap, and next to them the whole ring_buffer_read, tags and lap check
+//	included.
+
+#include "VACbench.h"
+#include "VACcore.h"
+
+#include <stdlib.h>
+
+#define                             kBench_Channels                     2
+#define                             kBench_RingFrames                   16384
+#define                             kBench_Positions                    4096
+
+struct BenchLayout {
+    struct RingBuffer*              ring;
+    float*                          out;
+    uint32_t                        frames;
+    uint32_t                        positions[kBench_Positions];
+};
+
+static void bench_mirrored(void* context, uint32_t iterations)
+{
+    struct BenchLayout* theBench = (struct BenchLayout*)context;
+    uint32_t theChannels = theBench->ring->channels;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        uint32_t thePosition = theBench->positions[i % kBench_Positions];
+        gKernels.copy(theBench->out, theBench->ring->samples + (size_t)thePosition * theChannels, theBench->frames * theChannels, 1.0f);
+    }
+    gBench_Sink = theBench->out[0];
+}
+
+static void bench_split(void* context, uint32_t iterations)
+{
+    struct BenchLayout* theBench = (struct BenchLayout*)context;
+    uint32_t theChannels = theBench->ring->channels;
+    uint32_t theRingFrames = theBench->ring->frame_count;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        uint32_t thePosition = theBench->positions[i % kBench_Positions];
+        uint32_t theFirst = theRingFrames - thePosition;
+        if(theFirst >= theBench->frames)
+        {
+            gKernels.copy(theBench->out, theBench->ring->samples + (size_t)thePosition * theChannels, theBench->frames * theChannels, 1.0f);
+        }
+        else
+        {
+            gKernels.copy(theBench->out, theBench->ring->samples + (size_t)thePosition * theChannels, theFirst * theChannels, 1.0f);
+            gKernels.copy(theBench->out + (size_t)theFirst * theChannels, theBench->ring->samples, (theBench->frames - theFirst) * theChannels, 1.0f);
+        }
+    }
+    gBench_Sink = theBench->out[0];
+}
+
+static void bench_ring_read(void* context, uint32_t iterations)
+{
+    struct BenchLayout* theBench = (struct BenchLayout*)context;
+    struct RingGain theGain = ring_gain_steady(1.0f);
+    int64_t theLap = (int64_t)theBench->ring->frame_count;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        ring_buffer_read(theBench->ring, theLap + theBench->positions[i % kBench_Positions], theBench->frames, &theGain, theBench->out);
+    }
+    gBench_Sink = theBench->out[0];
+}
+
+int main(void)
+{
+    kernels_select();
+    struct RingBuffer theRing;
+    if(!ring_buffer_allocate(&theRing, kBench_RingFrames, kBench_Channels, false))
+    {
+        fprintf(stderr, "could not allocate the ring\n");
+        return 1;
+    }
+
+    //	fill two laps with sound so every read is a real copy
+    float* theSound = (float*)malloc((size_t)theRing.frame_count * kBench_Channels * sizeof(float));
+    for(uint32_t i = 0; i < theRing.frame_count * kBench_Channels; ++i)
+    {
+        theSound[i] = 0.25f;
+    }
+    struct RingGain theGain = ring_gain_steady(1.0f);
+    ring_buffer_reset(&theRing);
+    ring_buffer_write(&theRing, 0, theRing.frame_count, &theGain, theSound);
+    ring_buffer_write(&theRing, theRing.frame_count, theRing.frame_count, &theGain, theSound);
+
+    struct BenchLayout theBench;
+    theBench.ring = &theRing;
+    theBench.out = (float*)malloc(4096 * kBench_Channels * sizeof(float));
+    srand(1);
+    printf("kernels %s, %u channels, ring of %u frames\n", gKernels.name, kBench_Channels, theRing.frame_count);
+    printf("%8s %8s %14s %14s %14s %14s\n", "frames", "wrap %", "mirrored ns", "split ns", "mirrored GB/s", "ring read ns");
+    for(uint32_t theFrames = 32; theFrames <= 4096; theFrames *= 2)
+    {
+        uint32_t theWraps = 0;
+        theBench.frames = theFrames;
+        for(uint32_t i = 0; i < kBench_Positions; ++i)
+        {
+            theBench.positions[i] = (uint32_t)rand() % theRing.frame_count;
+            theWraps += (theBench.positions[i] + theFrames > theRing.frame_count) ? 1 : 0;
+        }
+        uint32_t theIterations = (1u << 24) / theFrames;
+        double theMirrored = bench_run(bench_mirrored, &theBench, theIterations);
+        double theSplit = bench_run(bench_split, &theBench, theIterations);
+        double theRead = bench_run(bench_ring_read, &theBench, theIterations);
+        double theBytes = (double)theFrames * kBench_Channels * sizeof(float) * 2.0;
+        printf("%8u %8.2f %14.1f %14.1f %14.2f %14.1f\n", theFrames, 100.0 * theWraps / kBench_Positions, theMirrored, theSplit, bench_gigabytes_per_second(theBytes, theMirrored), theRead);
+    }
+
+    free(theBench.out);
+    free(theSound);
+    ring_buffer_free(&theRing);
+    return 0;
+}
@@ -0,0 +1,169 @@
+//	What device_state costs when several threads read the same device at once: 1 to 8 readers copy a
+//	block the size of a DeviceState out of a Snapshot, with no writer and with one publishing as fast
+//	as it can, next to the same reads under a pthread rwlock. Every reader bumps the shared reader
+//	count, so the cost per read grows with the number of readers; this shows by how much, and how
+//	often the writer still gets to publish. Each copy is checked, a torn one would be a bug.
+
+#include "VACbench.h"
+#include "VACcore.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define                             kBench_MaxReaders                   8
+#define                             kBench_StateWords                   48
+#define                             kBench_Nanoseconds                  200000000ULL
+
+struct BenchState {
+    uint32_t                        words[kBench_StateWords];
+};
+
+enum BenchLock {
+    kBenchLock_Snapshot,
+    kBenchLock_RWLock,
+};
+
+struct BenchSnapshot {
+    enum BenchLock                  lock;
+    struct Snapshot                 snapshot;
+    pthread_rwlock_t                rwlock;
+    struct BenchState               states[2];
+    _Atomic bool                    is_done;
+    _Atomic uint64_t                reads;
+    _Atomic uint64_t                torn;
+    _Atomic uint64_t                publishes;
+};
+
+static bool bench_state_is_whole(const struct BenchState* state)
+{
+    bool theIsWhole = true;
+    for(uint32_t i = 1; i < kBench_StateWords; ++i)
+    {
+        theIsWhole &= (state->words[i] == state->words[0]);
+    }
+    return theIsWhole;
+}
+
+static void bench_state_fill(struct BenchState* state, uint32_t value)
+{
+    for(uint32_t i = 0; i < kBench_StateWords; ++i)
+    {
+        state->words[i] = value;
+    }
+}
+
+static void* bench_reader(void* context)
+{
+    struct BenchSnapshot* theBench = (struct BenchSnapshot*)context;
+    uint64_t theReads = 0;
+    uint64_t theTorn = 0;
+    struct BenchState theState;
+    while(!atomic_load_explicit(&theBench->is_done, memory_order_relaxed))
+    {
+        for(uint32_t i = 0; i < 1024; ++i)
+        {
+            if(theBench->lock == kBenchLock_Snapshot)
+            {
+                uint32_t theIndex;
+                uint32_t theTicket = snapshot_read_begin(&theBench->snapshot, &theIndex);
+                theState = theBench->states[theIndex];
+                snapshot_read_end(&theBench->snapshot, theTicket);
+            }
+            else
+            {
+                pthread_rwlock_rdlock(&theBench->rwlock);
+                theState = theBench->states[0];
+                pthread_rwlock_unlock(&theBench->rwlock);
+            }
+            theTorn += bench_state_is_whole(&theState) ? 0 : 1;
+        }
+        theReads += 1024;
+    }
+    atomic_fetch_add(&theBench->reads, theReads);
+    atomic_fetch_add(&theBench->torn, theTorn);
+    return NULL;
+}
+
+static void* bench_writer(void* context)
+{
+    struct BenchSnapshot* theBench = (struct BenchSnapshot*)context;
+    uint64_t thePublishes = 0;
+    for(uint32_t theValue = 1; !atomic_load_explicit(&theBench->is_done, memory_order_relaxed); ++theValue)
+    {
+        if(theBench->lock == kBenchLock_Snapshot)
+        {
+            bench_state_fill(&theBench->states[snapshot_write_index(&theBench->snapshot)], theValue);
+            snapshot_publish(&theBench->snapshot);
+        }
+        else
+        {
+            pthread_rwlock_wrlock(&theBench->rwlock);
+            bench_state_fill(&theBench->states[0], theValue);
+            pthread_rwlock_unlock(&theBench->rwlock);
+        }
+        ++thePublishes;
+    }
+    atomic_store(&theBench->publishes, thePublishes);
+    return NULL;
+}
+
+static uint64_t bench_measure(struct BenchSnapshot* bench, enum BenchLock lock, uint32_t readers, bool has_writer)
+{
+    bench->lock = lock;
+    snapshot_init(&bench->snapshot);
+    bench_state_fill(&bench->states[0], 0);
+    bench_state_fill(&bench->states[1], 0);
+    atomic_store(&bench->is_done, false);
+    atomic_store(&bench->reads, 0);
+    atomic_store(&bench->torn, 0);
+    atomic_store(&bench->publishes, 0);
+
+    pthread_t theThreads[kBench_MaxReaders + 1];
+    uint64_t theStart = bench_now();
+    for(uint32_t i = 0; i < readers; ++i)
+    {
+        pthread_create(&theThreads[i], NULL, bench_reader, bench);
+    }
+    if(has_writer)
+    {
+        pthread_create(&theThreads[readers], NULL, bench_writer, bench);
+    }
+    while(bench_now() - theStart < kBench_Nanoseconds)
+    {
+        sched_yield();
+    }
+    atomic_store(&bench->is_done, true);
+    for(uint32_t i = 0; i < readers + (has_writer ? 1 : 0); ++i)
+    {
+        pthread_join(theThreads[i], NULL);
+    }
+    double theSeconds = (double)(bench_now() - theStart) / 1e9;
+
+    uint64_t theReads = atomic_load(&bench->reads);
+    printf("%10s %8u %8s %16.1f %16.1f %16.0f %8llu\n", (lock == kBenchLock_Snapshot) ? "snapshot" : "rwlock", readers, has_writer ? "yes" : "no",
+           (double)theReads / theSeconds / 1e6, (double)theReads / theSeconds / 1e6 / readers,
+           (double)atomic_load(&bench->publishes) / theSeconds, (unsigned long long)atomic_load(&bench->torn));
+    return atomic_load(&bench->torn);
+}
+
+int main(void)
+{
+    static struct BenchSnapshot theBench;
+    pthread_rwlock_init(&theBench.rwlock, NULL);
+    uint64_t theTorn = 0;
+
+    printf("%zu byte state, %.1f s per row\n", sizeof(struct BenchState), (double)kBench_Nanoseconds / 1e9);
+    printf("%10s %8s %8s %16s %16s %16s %8s\n", "lock", "readers", "writer", "M reads/s", "M reads/s each", "publishes/s", "torn");
+    for(uint32_t theLock = kBenchLock_Snapshot; theLock <= kBenchLock_RWLock; ++theLock)
+    {
+        for(uint32_t theReaders = 1; theReaders <= kBench_MaxReaders; theReaders *= 2)
+        {
+            theTorn += bench_measure(&theBench, (enum BenchLock)theLock, theReaders, false);
+            theTorn += bench_measure(&theBench, (enum BenchLock)theLock, theReaders, true);
+        }
+    }
+
+    pthread_rwlock_destroy(&theBench.rwlock);
+    return (theTorn == 0) ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+//	The worst IO cycle at 64 channels: the reader has got ahead of the writer and nothing it asks for
+//	is in the ring. Before block tags, recovering meant clearing the whole ring inside the cycle, as
+//	the original driver did with vDSP_vclr over its 65536 frame ring; with tags the read only clears
+//	the host's buffer. Both are timed for 32 to 4096 frame buffers, with a read of valid frames of the
+//	same size for scale and the clear a reset does once in 65536 generations.
+
+#include "VACbench.h"
+#include "VACcore.h"
+
+#include <stdlib.h>
+
+#define                             kBench_Channels                     64
+#define                             kBench_RingFrames                   65536
+
+struct BenchUnderrun {
+    struct RingBuffer*              ring;
+    float*                          out;
+    uint32_t                        frames;
+    int64_t                         sample_time;
+};
+
+//	the original recovery: clear the ring, then hand out the (now silent) frames
+static void bench_clear_ring(void* context, uint32_t iterations)
+{
+    struct BenchUnderrun* theBench = (struct BenchUnderrun*)context;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        gKernels.clear(theBench->ring->samples, theBench->ring->frame_count * kBench_Channels);
+        gKernels.copy(theBench->out, theBench->ring->samples, theBench->frames * kBench_Channels, 1.0f);
+    }
+    gBench_Sink = theBench->out[0];
+}
+
+static void bench_read(void* context, uint32_t iterations)
+{
+    struct BenchUnderrun* theBench = (struct BenchUnderrun*)context;
+    struct RingGain theGain = ring_gain_steady(1.0f);
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        ring_buffer_read(theBench->ring, theBench->sample_time, theBench->frames, &theGain, theBench->out);
+    }
+    gBench_Sink = theBench->out[0];
+}
+
+static void bench_clear_tags(void* context, uint32_t iterations)
+{
+    struct BenchUnderrun* theBench = (struct BenchUnderrun*)context;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        for(uint32_t theBlock = 0; theBlock < theBench->ring->block_count; ++theBlock)
+        {
+            atomic_store_explicit(&theBench->ring->block_tags[theBlock], 0, memory_order_relaxed);
+        }
+    }
+}
+
+int main(void)
+{
+    kernels_select();
+    struct RingBuffer theRing;
+    if(!ring_buffer_allocate(&theRing, kBench_RingFrames, kBench_Channels, false))
+    {
+        fprintf(stderr, "could not allocate the ring\n");
+        return 1;
+    }
+    struct BenchUnderrun theBench = { &theRing, (float*)calloc(4096 * kBench_Channels, sizeof(float)), 0, 0 };
+
+    //	sound in the first 8192 frames, nothing after them
+    float* theSound = (float*)malloc(8192 * kBench_Channels * sizeof(float));
+    for(uint32_t i = 0; i < 8192 * kBench_Channels; ++i)
+    {
+        theSound[i] = 0.25f;
+    }
+    struct RingGain theGain = ring_gain_steady(1.0f);
+    ring_buffer_reset(&theRing);
+    ring_buffer_write(&theRing, 0, 8192, &theGain, theSound);
+
+    printf("kernels %s, %u channels, ring of %u frames (%zu MB)\n", gKernels.name, kBench_Channels, theRing.frame_count, theRing.mapped_size >> 20);
+    printf("%8s %20s %20s %20s\n", "frames", "clear ring us", "tagged underrun us", "valid read us");
+    for(uint32_t theFrames = 32; theFrames <= 4096; theFrames *= 2)
+    {
+        theBench.frames = theFrames;
+        double theBefore = bench_run(bench_clear_ring, &theBench, 20);
+        theBench.sample_time = 16384;
+        double theAfter = bench_run(bench_read, &theBench, 2000);
+        theBench.sample_time = 0;
+        double theValid = bench_run(bench_read, &theBench, 2000);
+        printf("%8u %20.2f %20.3f %20.3f\n", theFrames, theBefore / 1000.0, theAfter / 1000.0, theValid / 1000.0);
+    }
+    printf("clearing the tags on the 65536th reset: %.3f us\n", bench_run(bench_clear_tags, &theBench, 200) / 1000.0);
+
+    free(theSound);
+    free(theBench.out);
+    ring_buffer_free(&theRing);
+    return 0;
+}
@@ -0,0 +1,159 @@
+//	The volume conversions against the libm expressions they replace: the worst error of each over the
+//	control range, measured against double precision libm, and the time per value one call at a time
+//	and through the batch versions. Errors are relative for volumes and absolute for decibels and
+//	scalars, the same measures VACcore.h gives its bounds in.
+
+#include "VACbench.h"
+#include "VACcore.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#define                             kBench_Values                       4096
+#define                             kBench_Points                       (1u << 22)
+
+struct BenchVolume {
+    float                           (*convert)(float);
+    void                            (*batch)(float*, const float*, uint32_t);
+    const float*                    in;
+    float*                          out;
+};
+
+static float bench_libm_to_decibel(float volume)
+{
+    return (volume > 6.3095734448e-4f) ? 20.0f * log10f(volume) : kVolume_MinDB;
+}
+
+static float bench_libm_from_decibel(float decibel)
+{
+    return (decibel > kVolume_MinDB) ? powf(10.0f, decibel / 20.0f) : 0.0f;
+}
+
+static float bench_libm_to_scalar(float volume)
+{
+    return (bench_libm_to_decibel(volume) - kVolume_MinDB) / (kVolume_MaxDB - kVolume_MinDB);
+}
+
+static float bench_libm_from_scalar(float scalar)
+{
+    return bench_libm_from_decibel(scalar * (kVolume_MaxDB - kVolume_MinDB) + kVolume_MinDB);
+}
+
+static void bench_each(void* context, uint32_t iterations)
+{
+    struct BenchVolume* theBench = (struct BenchVolume*)context;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        for(uint32_t theValue = 0; theValue < kBench_Values; ++theValue)
+        {
+            theBench->out[theValue] = theBench->convert(theBench->in[theValue]);
+        }
+    }
+    gBench_Sink = theBench->out[0];
+}
+
+static void bench_batch(void* context, uint32_t iterations)
+{
+    struct BenchVolume* theBench = (struct BenchVolume*)context;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        theBench->batch(theBench->out, theBench->in, kBench_Values);
+    }
+    gBench_Sink = theBench->out[0];
+}
+
+static double bench_value_time(void (*body)(void*, uint32_t), struct BenchVolume* bench)
+{
+    return bench_run(body, bench, 256) / kBench_Values;
+}
+
+//	worst error over the range: is_volume_in steps volumes geometrically up to unity, otherwise the
+//	input is a fraction of the range, and is_relative picks the measure
+static double bench_error(float (*convert)(float), double (*expected)(double), bool is_volume_in, bool is_relative)
+{
+    double theWorst = 0.0;
+    for(uint32_t i = 1; i <= kBench_Points; ++i)
+    {
+        double theFraction = (double)i / (double)kBench_Points;
+        float theIn = is_volume_in ? (float)(6.3095734448e-4 * pow(1.0 / 6.3095734448e-4, theFraction)) : (float)theFraction;
+        double theExpected = expected(theIn);
+        double theError = fabs(convert(theIn) - theExpected);
+        theWorst = fmax(theWorst, is_relative ? theError / theExpected : theError);
+    }
+    return theWorst;
+}
+
+static double bench_expected_decibel(double volume)
+{
+    return fmax(20.0 * log10(volume), kVolume_MinDB);
+}
+
+static double bench_expected_scalar(double volume)
+{
+    return (bench_expected_decibel(volume) - kVolume_MinDB) / (kVolume_MaxDB - kVolume_MinDB);
+}
+
+//	the input here is a fraction of the decibel range
+static double bench_expected_volume(double fraction)
+{
+    return pow(10.0, (kVolume_MinDB + (kVolume_MaxDB - kVolume_MinDB) * fraction) / 20.0);
+}
+
+static float bench_fast_from_fraction(float fraction)
+{
+    return volume_from_decibel(kVolume_MinDB + (kVolume_MaxDB - kVolume_MinDB) * fraction);
+}
+
+static float bench_libm_from_fraction(float fraction)
+{
+    return bench_libm_from_decibel(kVolume_MinDB + (kVolume_MaxDB - kVolume_MinDB) * fraction);
+}
+
+int main(void)
+{
+    static const struct {
+        const char*                 name;
+        float                       (*fast)(float);
+        float                       (*libm)(float);
+        void                        (*batch)(float*, const float*, uint32_t);
+        float                       (*fast_error)(float);
+        float                       (*libm_error)(float);
+        double                      (*expected)(double);
+        bool                        is_volume_in;
+        bool                        is_relative;
+        float                       scale;
+        float                       offset;
+    } kConversions[] = {
+        { "to_decibel",     volume_to_decibel,      bench_libm_to_decibel,      volume_to_decibel_batch,
+          volume_to_decibel,            bench_libm_to_decibel,      bench_expected_decibel, true,   false,  1.0f,   0.0f },
+        { "from_decibel",   volume_from_decibel,    bench_libm_from_decibel,    volume_from_decibel_batch,
+          bench_fast_from_fraction,     bench_libm_from_fraction,   bench_expected_volume,  false,  true,   64.0f,  -64.0f },
+        { "to_scalar",      volume_to_scalar,       bench_libm_to_scalar,       volume_to_scalar_batch,
+          volume_to_scalar,             bench_libm_to_scalar,       bench_expected_scalar,  true,   false,  1.0f,   0.0f },
+        { "from_scalar",    volume_from_scalar,     bench_libm_from_scalar,     volume_from_scalar_batch,
+          volume_from_scalar,           bench_libm_from_scalar,     bench_expected_volume,  false,  true,   1.0f,   0.0f },
+    };
+
+    float* theIn = (float*)malloc(kBench_Values * sizeof(float));
+    float* theOut = (float*)malloc(kBench_Values * sizeof(float));
+
+    printf("%14s %12s %12s %12s %12s %12s\n", "conversion", "error", "libm error", "ns each", "ns batch", "ns libm");
+    for(uint32_t c = 0; c < sizeof(kConversions) / sizeof(kConversions[0]); ++c)
+    {
+        for(uint32_t i = 0; i < kBench_Values; ++i)
+        {
+            float theFraction = (float)(i + 1) / (float)kBench_Values;
+            theIn[i] = kConversions[c].is_volume_in ? theFraction : theFraction * kConversions[c].scale + kConversions[c].offset;
+        }
+        struct BenchVolume theFast = { kConversions[c].fast, kConversions[c].batch, theIn, theOut };
+        struct BenchVolume theLibm = { kConversions[c].libm, NULL, theIn, theOut };
+        printf("%14s %12.3g %12.3g %12.2f %12.2f %12.2f\n", kConversions[c].name,
+            bench_error(kConversions[c].fast_error, kConversions[c].expected, kConversions[c].is_volume_in, kConversions[c].is_relative),
+            bench_error(kConversions[c].libm_error, kConversions[c].expected, kConversions[c].is_volume_in, kConversions[c].is_relative),
+            bench_value_time(bench_each, &theFast), bench_value_time(bench_batch, &theFast), bench_value_time(bench_each, &theLibm));
+    }
+
+    free(theIn);
+    free(theOut);
+    return 0;
+}
@@ -0,0 +1,127 @@
+//	How long the IO thread's GetZeroTimeStamp takes while other threads change the device: idle, with a
+//	thread setting the volume as fast as it can (a state publication per call), with one changing the
+//	sample rate as fast as it can (a clock publication per change, far more often than any HAL would
+//	ask), and with both. Runs on real time and reports the median and the tail of every call, since
+//	the tail is what a lock on the IO thread would have shown.
+
+#include "VACbench.h"
+#include "VAChost.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define                             kBench_Calls                        1000000
+
+enum BenchWriter {
+    kBenchWriter_Volume                 = 1 << 0,
+    kBenchWriter_SampleRate             = 1 << 1,
+};
+
+struct BenchZeroTimeStamp {
+    AudioServerPlugInDriverRef      driver;
+    AudioObjectID                   device_id;
+    AudioObjectID                   volume_id;
+    _Atomic bool                    is_done;
+    uint32_t                        latencies[kBench_Calls];
+};
+
+static void* bench_volume_writer(void* context)
+{
+    struct BenchZeroTimeStamp* theBench = (struct BenchZeroTimeStamp*)context;
+    for(uint32_t i = 0; !atomic_load_explicit(&theBench->is_done, memory_order_relaxed); ++i)
+    {
+        Float32 theVolume = (i & 1) ? 0.5f : 1.0f;
+        vac_host_set(theBench->volume_id, kAudioLevelControlPropertyScalarValue, kAudioObjectPropertyScopeGlobal, sizeof(theVolume), &theVolume);
+    }
+    return NULL;
+}
+
+//	the host performs the change as soon as it is asked for, without stopping IO first
+static void* bench_sample_rate_writer(void* context)
+{
+    struct BenchZeroTimeStamp* theBench = (struct BenchZeroTimeStamp*)context;
+    for(uint32_t i = 0; !atomic_load_explicit(&theBench->is_done, memory_order_relaxed); ++i)
+    {
+        Float64 theRate = (i & 1) ? 44100.0 : 48000.0;
+        vac_host_set(theBench->device_id, kAudioDevicePropertyNominalSampleRate, kAudioObjectPropertyScopeGlobal, sizeof(theRate), &theRate);
+        vac_host_drain();
+    }
+    return NULL;
+}
+
+static int bench_compare(const void* a, const void* b)
+{
+    uint32_t theA = *(const uint32_t*)a;
+    uint32_t theB = *(const uint32_t*)b;
+    return (theA > theB) - (theA < theB);
+}
+
+static void bench_measure(struct BenchZeroTimeStamp* bench, const char* name, uint32_t writers)
+{
+    pthread_t theThreads[2];
+    uint32_t theThreadCount = 0;
+    atomic_store(&bench->is_done, false);
+    if(writers & kBenchWriter_Volume)
+    {
+        pthread_create(&theThreads[theThreadCount++], NULL, bench_volume_writer, bench);
+    }
+    if(writers & kBenchWriter_SampleRate)
+    {
+        pthread_create(&theThreads[theThreadCount++], NULL, bench_sample_rate_writer, bench);
+    }
+
+    Float64 theSampleTime = 0;
+    UInt64 theHostTime = 0;
+    UInt64 theSeed = 0;
+    for(uint32_t i = 0; i < kBench_Calls; ++i)
+    {
+        uint64_t theStart = bench_now();
+        (*bench->driver)->GetZeroTimeStamp(bench->driver, bench->device_id, 1, &theSampleTime, &theHostTime, &theSeed);
+        bench->latencies[i] = (uint32_t)(bench_now() - theStart);
+    }
+    gBench_Sink = (float)theSampleTime;
+
+    atomic_store(&bench->is_done, true);
+    for(uint32_t i = 0; i < theThreadCount; ++i)
+    {
+        pthread_join(theThreads[i], NULL);
+    }
+
+    qsort(bench->latencies, kBench_Calls, sizeof(uint32_t), bench_compare);
+    printf("%22s %10u %10u %10u %10u %10u\n", name, bench->latencies[kBench_Calls / 2], bench->latencies[kBench_Calls / 100 * 99], bench->latencies[kBench_Calls / 1000 * 999], bench->latencies[kBench_Calls / 10000 * 9999], bench->latencies[kBench_Calls - 1]);
+}
+
+int main(void)
+{
+    static struct BenchZeroTimeStamp theBench;
+    theBench.driver = vac_host_load();
+    vac_host_use_real_time(true);
+
+    AudioObjectID theDevices[8];
+    vac_host_get(kAudioObjectPlugInObject, kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, sizeof(theDevices), theDevices);
+    theBench.device_id = theDevices[0];
+    AudioObjectID theControls[64];
+    vac_host_get(theBench.device_id, kAudioObjectPropertyControlList, kAudioObjectPropertyScopeGlobal, sizeof(theControls), theControls);
+    for(uint32_t i = 0; i < 64; ++i)
+    {
+        Float32 theVolume = 0;
+        if(vac_host_get(theControls[i], kAudioLevelControlPropertyScalarValue, kAudioObjectPropertyScopeGlobal, sizeof(theVolume), &theVolume) == 0)
+        {
+            theBench.volume_id = theControls[i];
+            break;
+        }
+    }
+
+    struct VACHostIO theIO;
+    vac_host_io_start(&theIO, theBench.device_id, 1, 512);
+
+    printf("GetZeroTimeStamp, ns per call\n%22s %10s %10s %10s %10s %10s\n", "writers", "median", "99%", "99.9%", "99.99%", "max");
+    bench_measure(&theBench, "none", 0);
+    bench_measure(&theBench, "volume", kBenchWriter_Volume);
+    bench_measure(&theBench, "sample rate", kBenchWriter_SampleRate);
+    bench_measure(&theBench, "volume, sample rate", kBenchWriter_Volume | kBenchWriter_SampleRate);
+
+    vac_host_io_stop(&theIO);
+    return 0;
+}
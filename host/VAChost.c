@@ -0,0 +1,1019 @@
+#include "VAChost.h"
+
+#include <dispatch/dispatch.h>
+#include <mach/mach_time.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+//	the driver's factory, exported from VACdummy.c the way CFPlugIn finds it by name
+extern void* _Create(CFAllocatorRef inAllocator, CFUUIDRef inRequestedTypeUUID);
+
+static void vac_host_fail(const char* message)
+{
+    fprintf(stderr, "VAChost: %s\n", message);
+    abort();
+}
+
+//==================================================================================================
+#pragma mark -
+#pragma mark CoreFoundation
+//==================================================================================================
+
+enum {
+    kVACType_String                 = 1,
+    kVACType_Number                 = 2,
+    kVACType_Boolean                = 3,
+    kVACType_Dictionary             = 4,
+    kVACType_UUID                   = 5
+};
+
+//	every object starts with this; a retain count below zero marks an immortal one
+struct VACObject {
+    CFTypeID                        type;
+    _Atomic long                    retain_count;
+};
+
+struct __CFString {
+    struct VACObject                base;
+    const char*                     literal;
+    struct __CFString*              next_constant;
+    size_t                          length;
+    char                            bytes[];
+};
+
+struct __CFNumber {
+    struct VACObject                base;
+    bool                            is_float;
+    SInt64                          integer;
+    Float64                         real;
+};
+
+struct __CFBoolean {
+    struct VACObject                base;
+    Boolean                         value;
+};
+
+struct __CFDictionary {
+    struct VACObject                base;
+    CFIndex                         count;
+    const void**                    keys;
+    const void**                    values;
+};
+
+struct __CFUUID {
+    struct VACObject                base;
+    CFUUIDBytes                     bytes;
+    struct __CFUUID*                next_constant;
+};
+
+static void* vac_object_create(CFTypeID type, size_t size)
+{
+    struct VACObject* theObject = (struct VACObject*)calloc(1, size);
+    if(theObject == NULL)
+    {
+        vac_host_fail("out of memory");
+    }
+    theObject->type = type;
+    atomic_init(&theObject->retain_count, 1);
+    return theObject;
+}
+
+CFTypeID CFGetTypeID(CFTypeRef cf)
+{
+    if(cf == NULL)
+    {
+        vac_host_fail("CFGetTypeID(NULL)");
+    }
+    return ((const struct VACObject*)cf)->type;
+}
+
+CFTypeRef CFRetain(CFTypeRef cf)
+{
+    if(cf == NULL)
+    {
+        vac_host_fail("CFRetain(NULL)");
+    }
+    struct VACObject* theObject = (struct VACObject*)cf;
+    if(atomic_load_explicit(&theObject->retain_count, memory_order_relaxed) >= 0)
+    {
+        atomic_fetch_add_explicit(&theObject->retain_count, 1, memory_order_relaxed);
+    }
+    return cf;
+}
+
+void CFRelease(CFTypeRef cf)
+{
+    if(cf == NULL)
+    {
+        vac_host_fail("CFRelease(NULL)");
+    }
+    struct VACObject* theObject = (struct VACObject*)cf;
+    if(atomic_load_explicit(&theObject->retain_count, memory_order_relaxed) < 0)
+    {
+        return;
+    }
+    long theCount = atomic_fetch_sub_explicit(&theObject->retain_count, 1, memory_order_acq_rel);
+    if(theCount <= 0)
+    {
+        vac_host_fail("CFRelease of a released object");
+    }
+    if(theCount == 1)
+    {
+        if(theObject->type == kVACType_Dictionary)
+        {
+            struct __CFDictionary* theDictionary = (struct __CFDictionary*)theObject;
+            for(CFIndex i = 0; i < theDictionary->count; ++i)
+            {
+                CFRelease(theDictionary->keys[i]);
+                CFRelease(theDictionary->values[i]);
+            }
+            free(theDictionary->keys);
+            free(theDictionary->values);
+        }
+        free(theObject);
+    }
+}
+
+CFIndex CFGetRetainCount(CFTypeRef cf)
+{
+    long theCount = atomic_load_explicit(&((const struct VACObject*)cf)->retain_count, memory_order_relaxed);
+    return (theCount < 0) ? INT32_MAX : theCount;
+}
+
+Boolean CFEqual(CFTypeRef cf1, CFTypeRef cf2)
+{
+    if(cf1 == cf2)
+    {
+        return true;
+    }
+    if(CFGetTypeID(cf1) != CFGetTypeID(cf2))
+    {
+        return false;
+    }
+    switch(CFGetTypeID(cf1))
+    {
+        case kVACType_String:
+            return CFStringCompare((CFStringRef)cf1, (CFStringRef)cf2, 0) == kCFCompareEqualTo;
+
+        case kVACType_Number:
+        {
+            const struct __CFNumber* theNumber1 = (const struct __CFNumber*)cf1;
+            const struct __CFNumber* theNumber2 = (const struct __CFNumber*)cf2;
+            if(theNumber1->is_float || theNumber2->is_float)
+            {
+                return theNumber1->real == theNumber2->real;
+            }
+            return theNumber1->integer == theNumber2->integer;
+        }
+
+        case kVACType_UUID:
+            return memcmp(&((const struct __CFUUID*)cf1)->bytes, &((const struct __CFUUID*)cf2)->bytes, sizeof(CFUUIDBytes)) == 0;
+
+        default:
+            return false;
+    }
+}
+
+//	strings
+
+static pthread_mutex_t              gVACHost_ConstantMutex              = PTHREAD_MUTEX_INITIALIZER;
+static struct __CFString*           gVACHost_ConstantStrings            = NULL;
+static struct __CFUUID*             gVACHost_ConstantUUIDs              = NULL;
+
+static struct __CFString* vac_string_create(const char* bytes, size_t length)
+{
+    struct __CFString* theString = (struct __CFString*)vac_object_create(kVACType_String, sizeof(struct __CFString) + length + 1);
+    memcpy(theString->bytes, bytes, length);
+    theString->bytes[length] = 0;
+    theString->length = length;
+    return theString;
+}
+
+CFStringRef __CFStringMakeConstantString(const char* cStr)
+{
+    //	the same literal always comes back as the same object, which never goes away
+    pthread_mutex_lock(&gVACHost_ConstantMutex);
+    struct __CFString* theString = gVACHost_ConstantStrings;
+    while((theString != NULL) && (theString->literal != cStr) && (strcmp(theString->bytes, cStr) != 0))
+    {
+        theString = theString->next_constant;
+    }
+    if(theString == NULL)
+    {
+        theString = vac_string_create(cStr, strlen(cStr));
+        atomic_store_explicit(&theString->base.retain_count, -1, memory_order_relaxed);
+        theString->literal = cStr;
+        theString->next_constant = gVACHost_ConstantStrings;
+        gVACHost_ConstantStrings = theString;
+    }
+    pthread_mutex_unlock(&gVACHost_ConstantMutex);
+    return theString;
+}
+
+CFTypeID CFStringGetTypeID(void)
+{
+    return kVACType_String;
+}
+
+CFStringRef CFStringCreateWithCString(CFAllocatorRef alloc, const char* cStr, CFStringEncoding encoding)
+{
+    (void)alloc;
+    (void)encoding;
+    return vac_string_create(cStr, strlen(cStr));
+}
+
+//	printf, plus %@ for a CF object's description, which is all the driver asks of it
+CFStringRef CFStringCreateWithFormat(CFAllocatorRef alloc, CFDictionaryRef formatOptions, CFStringRef format, ...)
+{
+    (void)alloc;
+    (void)formatOptions;
+    char theResult[1024];
+    size_t theLength = 0;
+    const char* theFormat = format->bytes;
+    va_list theArguments;
+    va_start(theArguments, format);
+    while((*theFormat != 0) && (theLength < sizeof(theResult) - 1))
+    {
+        if(*theFormat != '%')
+        {
+            theResult[theLength++] = *theFormat++;
+            continue;
+        }
+
+        //	copy out one conversion, flags, width, precision and length modifiers included
+        char theSpec[32];
+        size_t theSpecLength = 0;
+        theSpec[theSpecLength++] = *theFormat++;
+        while((*theFormat != 0) && (strchr("-+ #0123456789.hlzjt", *theFormat) != NULL) && (theSpecLength < sizeof(theSpec) - 2))
+        {
+            theSpec[theSpecLength++] = *theFormat++;
+        }
+        char theConversion = *theFormat++;
+        theSpec[theSpecLength++] = theConversion;
+        theSpec[theSpecLength] = 0;
+        bool isLong = strstr(theSpec, "l") != NULL;
+        bool isSize = strstr(theSpec, "z") != NULL;
+
+        size_t theRoom = sizeof(theResult) - theLength;
+        int theWritten = 0;
+        switch(theConversion)
+        {
+            case '@':
+            {
+                CFTypeRef theObject = va_arg(theArguments, CFTypeRef);
+                if(CFGetTypeID(theObject) == kVACType_String)
+                {
+                    theWritten = snprintf(theResult + theLength, theRoom, "%s", ((CFStringRef)theObject)->bytes);
+                }
+                else
+                {
+                    theWritten = snprintf(theResult + theLength, theRoom, "<%p>", theObject);
+                }
+                break;
+            }
+            case 'd': case 'i': case 'c':
+                theWritten = isSize ? snprintf(theResult + theLength, theRoom, theSpec, va_arg(theArguments, ssize_t))
+                           : isLong ? snprintf(theResult + theLength, theRoom, theSpec, va_arg(theArguments, long long))
+                           : snprintf(theResult + theLength, theRoom, theSpec, va_arg(theArguments, int));
+                break;
+            case 'u': case 'x': case 'X': case 'o':
+                theWritten = isSize ? snprintf(theResult + theLength, theRoom, theSpec, va_arg(theArguments, size_t))
+                           : isLong ? snprintf(theResult + theLength, theRoom, theSpec, va_arg(theArguments, unsigned long long))
+                           : snprintf(theResult + theLength, theRoom, theSpec, va_arg(theArguments, unsigned int));
+                break;
+            case 'f': case 'g': case 'e':
+                theWritten = snprintf(theResult + theLength, theRoom, theSpec, va_arg(theArguments, double));
+                break;
+            case 's':
+                theWritten = snprintf(theResult + theLength, theRoom, theSpec, va_arg(theArguments, const char*));
+                break;
+            case 'p':
+                theWritten = snprintf(theResult + theLength, theRoom, theSpec, va_arg(theArguments, void*));
+                break;
+            case '%':
+                theWritten = snprintf(theResult + theLength, theRoom, "%%");
+                break;
+            default:
+                vac_host_fail("CFStringCreateWithFormat: unsupported conversion");
+        }
+        theLength += (theWritten > 0) ? ((size_t)theWritten < theRoom ? (size_t)theWritten : theRoom - 1) : 0;
+    }
+    va_end(theArguments);
+    return vac_string_create(theResult, theLength);
+}
+
+CFComparisonResult CFStringCompare(CFStringRef theString1, CFStringRef theString2, CFOptionFlags compareOptions)
+{
+    (void)compareOptions;
+    int theOrder = strcmp(theString1->bytes, theString2->bytes);
+    return (theOrder < 0) ? kCFCompareLessThan : ((theOrder > 0) ? kCFCompareGreaterThan : kCFCompareEqualTo);
+}
+
+Boolean CFStringGetCString(CFStringRef theString, char* buffer, CFIndex bufferSize, CFStringEncoding encoding)
+{
+    (void)encoding;
+    if((CFIndex)theString->length >= bufferSize)
+    {
+        return false;
+    }
+    memcpy(buffer, theString->bytes, theString->length + 1);
+    return true;
+}
+
+const char* CFStringGetCStringPtr(CFStringRef theString, CFStringEncoding encoding)
+{
+    (void)encoding;
+    return theString->bytes;
+}
+
+//	numbers and booleans
+
+CFTypeID CFNumberGetTypeID(void)
+{
+    return kVACType_Number;
+}
+
+CFNumberRef CFNumberCreate(CFAllocatorRef allocator, CFNumberType theType, const void* valuePtr)
+{
+    (void)allocator;
+    struct __CFNumber* theNumber = (struct __CFNumber*)vac_object_create(kVACType_Number, sizeof(struct __CFNumber));
+    switch(theType)
+    {
+        case kCFNumberSInt8Type:    theNumber->integer = *(const SInt8*)valuePtr; break;
+        case kCFNumberSInt16Type:   theNumber->integer = *(const SInt16*)valuePtr; break;
+        case kCFNumberSInt32Type:   theNumber->integer = *(const SInt32*)valuePtr; break;
+        case kCFNumberIntType:      theNumber->integer = *(const int*)valuePtr; break;
+        case kCFNumberLongType:     theNumber->integer = *(const long*)valuePtr; break;
+        case kCFNumberSInt64Type:   theNumber->integer = *(const SInt64*)valuePtr; break;
+        case kCFNumberLongLongType: theNumber->integer = *(const long long*)valuePtr; break;
+        case kCFNumberFloat32Type:
+        case kCFNumberFloatType:    theNumber->real = *(const Float32*)valuePtr; theNumber->is_float = true; break;
+        case kCFNumberFloat64Type:
+        case kCFNumberDoubleType:   theNumber->real = *(const Float64*)valuePtr; theNumber->is_float = true; break;
+        default:                    vac_host_fail("CFNumberCreate: unsupported type");
+    }
+    if(theNumber->is_float)
+    {
+        theNumber->integer = (SInt64)theNumber->real;
+    }
+    else
+    {
+        theNumber->real = (Float64)theNumber->integer;
+    }
+    return theNumber;
+}
+
+//	like CoreFoundation, converts to the type asked for and returns false if that lost anything
+Boolean CFNumberGetValue(CFNumberRef number, CFNumberType theType, void* valuePtr)
+{
+    switch(theType)
+    {
+        case kCFNumberSInt8Type:    *(SInt8*)valuePtr = (SInt8)number->integer; return (number->real == *(SInt8*)valuePtr);
+        case kCFNumberSInt16Type:   *(SInt16*)valuePtr = (SInt16)number->integer; return (number->real == *(SInt16*)valuePtr);
+        case kCFNumberSInt32Type:
+        case kCFNumberIntType:      *(SInt32*)valuePtr = (SInt32)number->integer; return (number->real == *(SInt32*)valuePtr);
+        case kCFNumberLongType:
+        case kCFNumberSInt64Type:
+        case kCFNumberLongLongType: *(SInt64*)valuePtr = number->integer; return (number->real == (Float64)number->integer);
+        case kCFNumberFloat32Type:
+        case kCFNumberFloatType:    *(Float32*)valuePtr = (Float32)number->real; return (number->real == *(Float32*)valuePtr);
+        case kCFNumberFloat64Type:
+        case kCFNumberDoubleType:   *(Float64*)valuePtr = number->real; return true;
+        default:                    vac_host_fail("CFNumberGetValue: unsupported type");
+    }
+    return false;
+}
+
+static struct __CFBoolean           gVACHost_True                       = { { kVACType_Boolean, -1 }, true };
+static struct __CFBoolean           gVACHost_False                      = { { kVACType_Boolean, -1 }, false };
+const CFBooleanRef                  kCFBooleanTrue                      = &gVACHost_True;
+const CFBooleanRef                  kCFBooleanFalse                     = &gVACHost_False;
+
+CFTypeID CFBooleanGetTypeID(void)
+{
+    return kVACType_Boolean;
+}
+
+Boolean CFBooleanGetValue(CFBooleanRef boolean)
+{
+    return boolean->value;
+}
+
+//	dictionaries
+
+const CFDictionaryKeyCallBacks      kCFTypeDictionaryKeyCallBacks       = { 0 };
+const CFDictionaryValueCallBacks    kCFTypeDictionaryValueCallBacks     = { 0 };
+
+CFTypeID CFDictionaryGetTypeID(void)
+{
+    return kVACType_Dictionary;
+}
+
+CFDictionaryRef CFDictionaryCreate(CFAllocatorRef allocator, const void** keys, const void** values, CFIndex numValues, const CFDictionaryKeyCallBacks* keyCallBacks, const CFDictionaryValueCallBacks* valueCallBacks)
+{
+    (void)allocator;
+    (void)keyCallBacks;
+    (void)valueCallBacks;
+    struct __CFDictionary* theDictionary = (struct __CFDictionary*)vac_object_create(kVACType_Dictionary, sizeof(struct __CFDictionary));
+    theDictionary->count = numValues;
+    theDictionary->keys = (const void**)calloc((size_t)numValues + 1, sizeof(void*));
+    theDictionary->values = (const void**)calloc((size_t)numValues + 1, sizeof(void*));
+    for(CFIndex i = 0; i < numValues; ++i)
+    {
+        theDictionary->keys[i] = CFRetain(keys[i]);
+        theDictionary->values[i] = CFRetain(values[i]);
+    }
+    return theDictionary;
+}
+
+const void* CFDictionaryGetValue(CFDictionaryRef theDict, const void* key)
+{
+    for(CFIndex i = 0; i < theDict->count; ++i)
+    {
+        if(CFEqual(theDict->keys[i], key))
+        {
+            return theDict->values[i];
+        }
+    }
+    return NULL;
+}
+
+CFIndex CFDictionaryGetCount(CFDictionaryRef theDict)
+{
+    return theDict->count;
+}
+
+//	UUIDs
+
+CFTypeID CFUUIDGetTypeID(void)
+{
+    return kVACType_UUID;
+}
+
+CFUUIDRef CFUUIDGetConstantUUIDWithBytes(CFAllocatorRef alloc, UInt8 byte0, UInt8 byte1, UInt8 byte2, UInt8 byte3, UInt8 byte4, UInt8 byte5, UInt8 byte6, UInt8 byte7, UInt8 byte8, UInt8 byte9, UInt8 byte10, UInt8 byte11, UInt8 byte12, UInt8 byte13, UInt8 byte14, UInt8 byte15)
+{
+    (void)alloc;
+    CFUUIDBytes theBytes = { byte0, byte1, byte2, byte3, byte4, byte5, byte6, byte7, byte8, byte9, byte10, byte11, byte12, byte13, byte14, byte15 };
+    pthread_mutex_lock(&gVACHost_ConstantMutex);
+    struct __CFUUID* theUUID = gVACHost_ConstantUUIDs;
+    while((theUUID != NULL) && (memcmp(&theUUID->bytes, &theBytes, sizeof(CFUUIDBytes)) != 0))
+    {
+        theUUID = theUUID->next_constant;
+    }
+    if(theUUID == NULL)
+    {
+        theUUID = (struct __CFUUID*)vac_object_create(kVACType_UUID, sizeof(struct __CFUUID));
+        atomic_store_explicit(&theUUID->base.retain_count, -1, memory_order_relaxed);
+        theUUID->bytes = theBytes;
+        theUUID->next_constant = gVACHost_ConstantUUIDs;
+        gVACHost_ConstantUUIDs = theUUID;
+    }
+    pthread_mutex_unlock(&gVACHost_ConstantMutex);
+    return theUUID;
+}
+
+CFUUIDRef CFUUIDCreateFromUUIDBytes(CFAllocatorRef alloc, CFUUIDBytes bytes)
+{
+    (void)alloc;
+    struct __CFUUID* theUUID = (struct __CFUUID*)vac_object_create(kVACType_UUID, sizeof(struct __CFUUID));
+    theUUID->bytes = bytes;
+    return theUUID;
+}
+
+CFUUIDBytes CFUUIDGetUUIDBytes(CFUUIDRef uuid)
+{
+    return uuid->bytes;
+}
+
+//	bundles
+
+CFBundleRef CFBundleGetBundleWithIdentifier(CFStringRef bundleID)
+{
+    (void)bundleID;
+    return NULL;
+}
+
+CFURLRef CFBundleCopyResourceURL(CFBundleRef bundle, CFStringRef resourceName, CFStringRef resourceType, CFStringRef subDirName)
+{
+    (void)bundle;
+    (void)resourceName;
+    (void)resourceType;
+    (void)subDirName;
+    return NULL;
+}
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Time
+//==================================================================================================
+
+static _Atomic bool                 gVACHost_UseRealTime                = false;
+static _Atomic uint64_t             gVACHost_Time                       = 1000000000ULL;
+
+void vac_host_use_real_time(bool use_real_time)
+{
+    atomic_store(&gVACHost_UseRealTime, use_real_time);
+}
+
+uint64_t vac_host_time(void)
+{
+    if(atomic_load_explicit(&gVACHost_UseRealTime, memory_order_relaxed))
+    {
+        struct timespec theTime;
+        clock_gettime(CLOCK_MONOTONIC, &theTime);
+        return (uint64_t)theTime.tv_sec * 1000000000ULL + (uint64_t)theTime.tv_nsec;
+    }
+    return atomic_load_explicit(&gVACHost_Time, memory_order_relaxed);
+}
+
+void vac_host_set_time(uint64_t host_time)
+{
+    atomic_store_explicit(&gVACHost_Time, host_time, memory_order_relaxed);
+}
+
+kern_return_t mach_timebase_info(mach_timebase_info_t info)
+{
+    info->numer = 1;
+    info->denom = 1;
+    return 0;
+}
+
+uint64_t mach_absolute_time(void)
+{
+    return vac_host_time();
+}
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Dispatch
+//==================================================================================================
+
+//	One queue stands in for all of them. Work waits in it, oldest first, until vac_host_drain.
+struct dispatch_queue_s {
+    int                             unused;
+};
+
+struct VACHostWork {
+    dispatch_function_t             function;
+    void*                           context;
+    struct VACHostWork*             next;
+};
+
+static struct dispatch_queue_s      gVACHost_Queue;
+static pthread_mutex_t              gVACHost_QueueMutex                 = PTHREAD_MUTEX_INITIALIZER;
+static struct VACHostWork*          gVACHost_QueueHead                  = NULL;
+static struct VACHostWork**         gVACHost_QueueTail                  = &gVACHost_QueueHead;
+
+dispatch_queue_t dispatch_get_global_queue(long identifier, unsigned long flags)
+{
+    (void)identifier;
+    (void)flags;
+    return &gVACHost_Queue;
+}
+
+dispatch_time_t dispatch_time(dispatch_time_t when, int64_t delta)
+{
+    return ((when == DISPATCH_TIME_NOW) ? vac_host_time() : when) + (uint64_t)delta;
+}
+
+void dispatch_async_f(dispatch_queue_t queue, void* context, dispatch_function_t work)
+{
+    (void)queue;
+    struct VACHostWork* theWork = (struct VACHostWork*)malloc(sizeof(struct VACHostWork));
+    if(theWork == NULL)
+    {
+        vac_host_fail("out of memory");
+    }
+    theWork->function = work;
+    theWork->context = context;
+    theWork->next = NULL;
+    pthread_mutex_lock(&gVACHost_QueueMutex);
+    *gVACHost_QueueTail = theWork;
+    gVACHost_QueueTail = &theWork->next;
+    pthread_mutex_unlock(&gVACHost_QueueMutex);
+}
+
+//	the delay is dropped: a test that drains the queue doesn't want to wait for it
+void dispatch_after_f(dispatch_time_t when, dispatch_queue_t queue, void* context, dispatch_function_t work)
+{
+    (void)when;
+    dispatch_async_f(queue, context, work);
+}
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Host Interface
+//==================================================================================================
+
+#define                             kVACHost_MaxStorage                 32
+#define                             kVACHost_MaxNotifications           4096
+#define                             kVACHost_MaxConfigurationChanges    64
+
+struct VACHostNotification {
+    AudioObjectID                   object_id;
+    AudioObjectPropertySelector     selector;
+};
+
+struct VACHostConfigurationChange {
+    AudioObjectID                   device_id;
+    UInt64                          action;
+};
+
+static pthread_mutex_t              gVACHost_StateMutex                 = PTHREAD_MUTEX_INITIALIZER;
+static CFStringRef                  gVACHost_StorageKeys[kVACHost_MaxStorage];
+static CFPropertyListRef            gVACHost_StorageValues[kVACHost_MaxStorage];
+static struct VACHostNotification   gVACHost_Notifications[kVACHost_MaxNotifications];
+static uint32_t                     gVACHost_NotificationCount          = 0;
+static struct VACHostConfigurationChange gVACHost_ConfigurationChanges[kVACHost_MaxConfigurationChanges];
+static uint32_t                     gVACHost_ConfigurationChangeCount   = 0;
+
+static OSStatus vac_host_properties_changed(AudioServerPlugInHostRef inHost, AudioObjectID inObjectID, UInt32 inNumberAddresses, const AudioObjectPropertyAddress* inAddresses)
+{
+    (void)inHost;
+    pthread_mutex_lock(&gVACHost_StateMutex);
+    for(UInt32 i = 0; (i < inNumberAddresses) && (gVACHost_NotificationCount < kVACHost_MaxNotifications); ++i)
+    {
+        gVACHost_Notifications[gVACHost_NotificationCount].object_id = inObjectID;
+        gVACHost_Notifications[gVACHost_NotificationCount].selector = inAddresses[i].mSelector;
+        ++gVACHost_NotificationCount;
+    }
+    pthread_mutex_unlock(&gVACHost_StateMutex);
+    return 0;
+}
+
+static OSStatus vac_host_copy_from_storage(AudioServerPlugInHostRef inHost, CFStringRef inKey, CFPropertyListRef* outData)
+{
+    (void)inHost;
+    *outData = NULL;
+    pthread_mutex_lock(&gVACHost_StateMutex);
+    for(UInt32 i = 0; i < kVACHost_MaxStorage; ++i)
+    {
+        if((gVACHost_StorageKeys[i] != NULL) && CFEqual(gVACHost_StorageKeys[i], inKey))
+        {
+            *outData = CFRetain(gVACHost_StorageValues[i]);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&gVACHost_StateMutex);
+    return 0;
+}
+
+static OSStatus vac_host_delete_from_storage(AudioServerPlugInHostRef inHost, CFStringRef inKey)
+{
+    (void)inHost;
+    pthread_mutex_lock(&gVACHost_StateMutex);
+    for(UInt32 i = 0; i < kVACHost_MaxStorage; ++i)
+    {
+        if((gVACHost_StorageKeys[i] != NULL) && CFEqual(gVACHost_StorageKeys[i], inKey))
+        {
+            CFRelease(gVACHost_StorageKeys[i]);
+            CFRelease(gVACHost_StorageValues[i]);
+            gVACHost_StorageKeys[i] = NULL;
+            gVACHost_StorageValues[i] = NULL;
+        }
+    }
+    pthread_mutex_unlock(&gVACHost_StateMutex);
+    return 0;
+}
+
+static OSStatus vac_host_write_to_storage(AudioServerPlugInHostRef inHost, CFStringRef inKey, CFPropertyListRef inData)
+{
+    vac_host_delete_from_storage(inHost, inKey);
+    OSStatus theError = kAudioHardwareUnspecifiedError;
+    pthread_mutex_lock(&gVACHost_StateMutex);
+    for(UInt32 i = 0; i < kVACHost_MaxStorage; ++i)
+    {
+        if(gVACHost_StorageKeys[i] == NULL)
+        {
+            gVACHost_StorageKeys[i] = CFRetain(inKey);
+            gVACHost_StorageValues[i] = CFRetain(inData);
+            theError = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&gVACHost_StateMutex);
+    return theError;
+}
+
+static OSStatus vac_host_request_configuration_change(AudioServerPlugInHostRef inHost, AudioObjectID inDeviceObjectID, UInt64 inChangeAction, void* inChangeInfo)
+{
+    (void)inHost;
+    (void)inChangeInfo;
+    OSStatus theError = kAudioHardwareUnspecifiedError;
+    pthread_mutex_lock(&gVACHost_StateMutex);
+    if(gVACHost_ConfigurationChangeCount < kVACHost_MaxConfigurationChanges)
+    {
+        gVACHost_ConfigurationChanges[gVACHost_ConfigurationChangeCount].device_id = inDeviceObjectID;
+        gVACHost_ConfigurationChanges[gVACHost_ConfigurationChangeCount].action = inChangeAction;
+        ++gVACHost_ConfigurationChangeCount;
+        theError = 0;
+    }
+    pthread_mutex_unlock(&gVACHost_StateMutex);
+    return theError;
+}
+
+static const AudioServerPlugInHostInterface gVACHost_Interface = {
+    vac_host_properties_changed,
+    vac_host_copy_from_storage,
+    vac_host_write_to_storage,
+    vac_host_delete_from_storage,
+    vac_host_request_configuration_change
+};
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Driver
+//==================================================================================================
+
+static pthread_mutex_t              gVACHost_LoadMutex                  = PTHREAD_MUTEX_INITIALIZER;
+static AudioServerPlugInDriverRef   gVACHost_Driver                     = NULL;
+static pid_t                        gVACHost_Process                    = 0;
+
+AudioServerPlugInDriverRef vac_host_load(void)
+{
+    pthread_mutex_lock(&gVACHost_LoadMutex);
+    if(gVACHost_Driver == NULL)
+    {
+        AudioServerPlugInDriverRef theFactory = (AudioServerPlugInDriverRef)_Create(NULL, kAudioServerPlugInTypeUUID);
+        if(theFactory == NULL)
+        {
+            vac_host_fail("_Create didn't return the driver for the AudioServerPlugIn type");
+        }
+        AudioServerPlugInDriverRef theDriver = NULL;
+        if((*theFactory)->QueryInterface(theFactory, CFUUIDGetUUIDBytes(kAudioServerPlugInDriverInterfaceUUID), (LPVOID*)&theDriver) != S_OK)
+        {
+            vac_host_fail("the driver doesn't implement the AudioServerPlugIn driver interface");
+        }
+        if((*theDriver)->Initialize(theDriver, &gVACHost_Interface) != 0)
+        {
+            vac_host_fail("Initialize failed");
+        }
+        gVACHost_Driver = theDriver;
+    }
+    pthread_mutex_unlock(&gVACHost_LoadMutex);
+    return gVACHost_Driver;
+}
+
+void vac_host_set_process(pid_t pid)
+{
+    gVACHost_Process = pid;
+}
+
+static pid_t vac_host_process(void)
+{
+    return (gVACHost_Process != 0) ? gVACHost_Process : getpid();
+}
+
+uint32_t vac_host_drain(void)
+{
+    //	the work may dispatch more work, which runs in the same drain
+    for(;;)
+    {
+        pthread_mutex_lock(&gVACHost_QueueMutex);
+        struct VACHostWork* theWork = gVACHost_QueueHead;
+        if(theWork != NULL)
+        {
+            gVACHost_QueueHead = theWork->next;
+            if(gVACHost_QueueHead == NULL)
+            {
+                gVACHost_QueueTail = &gVACHost_QueueHead;
+            }
+        }
+        pthread_mutex_unlock(&gVACHost_QueueMutex);
+        if(theWork == NULL)
+        {
+            break;
+        }
+        theWork->function(theWork->context);
+        free(theWork);
+    }
+
+    pthread_mutex_lock(&gVACHost_StateMutex);
+    uint32_t theCount = gVACHost_ConfigurationChangeCount;
+    struct VACHostConfigurationChange theChanges[kVACHost_MaxConfigurationChanges];
+    memcpy(theChanges, gVACHost_ConfigurationChanges, theCount * sizeof(struct VACHostConfigurationChange));
+    gVACHost_ConfigurationChangeCount = 0;
+    pthread_mutex_unlock(&gVACHost_StateMutex);
+
+    for(uint32_t i = 0; i < theCount; ++i)
+    {
+        (*gVACHost_Driver)->PerformDeviceConfigurationChange(gVACHost_Driver, theChanges[i].device_id, theChanges[i].action, NULL);
+    }
+    return theCount;
+}
+
+uint32_t vac_host_notifications(AudioObjectID object_id, AudioObjectPropertySelector selector)
+{
+    uint32_t theCount = 0;
+    pthread_mutex_lock(&gVACHost_StateMutex);
+    for(uint32_t i = 0; i < gVACHost_NotificationCount; ++i)
+    {
+        if(((object_id == kAudioObjectUnknown) || (gVACHost_Notifications[i].object_id == object_id)) && (gVACHost_Notifications[i].selector == selector))
+        {
+            ++theCount;
+        }
+    }
+    pthread_mutex_unlock(&gVACHost_StateMutex);
+    return theCount;
+}
+
+void vac_host_reset_notifications(void)
+{
+    pthread_mutex_lock(&gVACHost_StateMutex);
+    gVACHost_NotificationCount = 0;
+    pthread_mutex_unlock(&gVACHost_StateMutex);
+}
+
+OSStatus vac_host_get(AudioObjectID object_id, AudioObjectPropertySelector selector, AudioObjectPropertyScope scope, UInt32 size, void* out_data)
+{
+    AudioObjectPropertyAddress theAddress = { selector, scope, kAudioObjectPropertyElementMain };
+    UInt32 theSize = 0;
+    return (*gVACHost_Driver)->GetPropertyData(gVACHost_Driver, object_id, vac_host_process(), &theAddress, 0, NULL, size, &theSize, out_data);
+}
+
+OSStatus vac_host_set(AudioObjectID object_id, AudioObjectPropertySelector selector, AudioObjectPropertyScope scope, UInt32 size, const void* data)
+{
+    AudioObjectPropertyAddress theAddress = { selector, scope, kAudioObjectPropertyElementMain };
+    return (*gVACHost_Driver)->SetPropertyData(gVACHost_Driver, object_id, vac_host_process(), &theAddress, 0, NULL, size, data);
+}
+
+OSStatus vac_host_create_device(const char* uid, const char* bus_uid, bool low_latency, AudioObjectID* out_device_id)
+{
+    const void* theKeys[3];
+    const void* theValues[3];
+    CFIndex theCount = 0;
+    theKeys[theCount] = CFSTR("uid");
+    theValues[theCount++] = CFStringCreateWithCString(NULL, uid, kCFStringEncodingUTF8);
+    if(bus_uid != NULL)
+    {
+        theKeys[theCount] = CFSTR("bus");
+        theValues[theCount++] = CFStringCreateWithCString(NULL, bus_uid, kCFStringEncodingUTF8);
+    }
+    if(low_latency)
+    {
+        theKeys[theCount] = CFSTR("low latency");
+        theValues[theCount++] = kCFBooleanTrue;
+    }
+    CFDictionaryRef theDescription = CFDictionaryCreate(NULL, theKeys, theValues, theCount, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    for(CFIndex i = 0; i < theCount; ++i)
+    {
+        CFRelease(theValues[i]);
+    }
+    AudioServerPlugInClientInfo theClient = { 0, vac_host_process(), true, NULL };
+    OSStatus theError = (*gVACHost_Driver)->CreateDevice(gVACHost_Driver, theDescription, &theClient, out_device_id);
+    CFRelease(theDescription);
+    return theError;
+}
+
+//==================================================================================================
+#pragma mark -
+#pragma mark IO
+//==================================================================================================
+
+static AudioObjectID vac_host_stream(AudioObjectID device_id, AudioObjectPropertyScope scope)
+{
+    AudioObjectID theStreams[1] = { kAudioObjectUnknown };
+    AudioObjectPropertyAddress theAddress = { kAudioDevicePropertyStreams, scope, kAudioObjectPropertyElementMain };
+    UInt32 theSize = 0;
+    (*gVACHost_Driver)->GetPropertyData(gVACHost_Driver, device_id, vac_host_process(), &theAddress, 0, NULL, sizeof(theStreams), &theSize, theStreams);
+    return (theSize >= sizeof(AudioObjectID)) ? theStreams[0] : kAudioObjectUnknown;
+}
+
+OSStatus vac_host_io_start(struct VACHostIO* io, AudioObjectID device_id, UInt32 client_id, UInt32 frame_size)
+{
+    memset(io, 0, sizeof(struct VACHostIO));
+    io->driver = vac_host_load();
+    io->device_id = device_id;
+    io->client_id = client_id;
+    io->process = vac_host_process();
+    io->frame_size = frame_size;
+    io->input_stream_id = vac_host_stream(device_id, kAudioObjectPropertyScopeInput);
+    io->output_stream_id = vac_host_stream(device_id, kAudioObjectPropertyScopeOutput);
+
+    OSStatus theError = vac_host_get(device_id, kAudioDevicePropertyNominalSampleRate, kAudioObjectPropertyScopeGlobal, sizeof(Float64), &io->sample_rate);
+    if(theError != 0)
+    {
+        return theError;
+    }
+    vac_host_get(device_id, kAudioDevicePropertySafetyOffset, kAudioObjectPropertyScopeInput, sizeof(UInt32), &io->input_offset);
+    vac_host_get(device_id, kAudioDevicePropertySafetyOffset, kAudioObjectPropertyScopeOutput, sizeof(UInt32), &io->output_offset);
+
+    AudioStreamBasicDescription theFormat;
+    AudioObjectID theStream = (io->output_stream_id != kAudioObjectUnknown) ? io->output_stream_id : io->input_stream_id;
+    theError = vac_host_get(theStream, kAudioStreamPropertyVirtualFormat, kAudioObjectPropertyScopeGlobal, sizeof(theFormat), &theFormat);
+    if(theError != 0)
+    {
+        return theError;
+    }
+    io->channel_count = theFormat.mChannelsPerFrame;
+    io->input = (float*)calloc((size_t)frame_size * io->channel_count, sizeof(float));
+    io->output = (float*)calloc((size_t)frame_size * io->channel_count, sizeof(float));
+
+    AudioServerPlugInClientInfo theClient = { client_id, io->process, true, NULL };
+    theError = (*io->driver)->AddDeviceClient(io->driver, device_id, &theClient);
+    if(theError == 0)
+    {
+        io->start_host_time = vac_host_time();
+        theError = (*io->driver)->StartIO(io->driver, device_id, client_id);
+    }
+    return theError;
+}
+
+static OSStatus vac_host_io_operation(struct VACHostIO* io, UInt32 operation, AudioObjectID stream_id, const AudioServerPlugInIOCycleInfo* cycle_info, float* buffer, Boolean* out_did)
+{
+    Boolean theWillDo = false;
+    Boolean theWillDoInPlace = true;
+    OSStatus theError = (*io->driver)->WillDoIOOperation(io->driver, io->device_id, io->client_id, operation, &theWillDo, &theWillDoInPlace);
+    *out_did = false;
+    if((theError != 0) || !theWillDo)
+    {
+        return theError;
+    }
+    *out_did = true;
+    theError = (*io->driver)->BeginIOOperation(io->driver, io->device_id, io->client_id, operation, io->frame_size, cycle_info);
+    if(theError == 0)
+    {
+        theError = (*io->driver)->DoIOOperation(io->driver, io->device_id, stream_id, io->client_id, operation, io->frame_size, cycle_info, buffer, NULL);
+    }
+    OSStatus theEndError = (*io->driver)->EndIOOperation(io->driver, io->device_id, io->client_id, operation, io->frame_size, cycle_info);
+    return (theError != 0) ? theError : theEndError;
+}
+
+OSStatus vac_host_io_cycle(struct VACHostIO* io, UInt32 late_frames)
+{
+    ++io->cycle;
+    Float64 theTicksPerFrame = 1000000000.0 / io->sample_rate;
+    if(!atomic_load_explicit(&gVACHost_UseRealTime, memory_order_relaxed))
+    {
+        //	exact, however many cycles have run
+        uint64_t theFrames = io->cycle * io->frame_size + late_frames;
+        vac_host_set_time(io->start_host_time + (uint64_t)((theFrames * 1000000000ULL + (uint64_t)io->sample_rate - 1) / (uint64_t)io->sample_rate));
+    }
+
+    //	like the HAL, work out where the device is from its zero time stamps rather than from how many
+    //	cycles have gone by
+    Float64 theZeroSampleTime = 0;
+    UInt64 theZeroHostTime = 0;
+    UInt64 theSeed = 0;
+    OSStatus theError = (*io->driver)->GetZeroTimeStamp(io->driver, io->device_id, io->client_id, &theZeroSampleTime, &theZeroHostTime, &theSeed);
+    if(theError != 0)
+    {
+        return theError;
+    }
+    uint64_t theNow = vac_host_time();
+
+    AudioServerPlugInIOCycleInfo theCycle;
+    memset(&theCycle, 0, sizeof(theCycle));
+    theCycle.mIOCycleCounter = io->cycle;
+    theCycle.mNominalIOBufferFrameSize = io->frame_size;
+    theCycle.mCurrentTime.mHostTime = theNow;
+    theCycle.mCurrentTime.mSampleTime = (Float64)(SInt64)(theZeroSampleTime + (Float64)(SInt64)(theNow - theZeroHostTime) / theTicksPerFrame);
+    theCycle.mCurrentTime.mRateScalar = 1.0;
+    if(io->cycle == 1)
+    {
+        io->schedule_sample_time = theCycle.mCurrentTime.mSampleTime - io->frame_size;
+    }
+    Float64 theScheduledSampleTime = io->schedule_sample_time + (Float64)(io->cycle * io->frame_size);
+    theCycle.mInputTime = theCycle.mCurrentTime;
+    theCycle.mInputTime.mSampleTime = theScheduledSampleTime - io->frame_size - io->input_offset;
+    theCycle.mInputTime.mHostTime = theZeroHostTime + (UInt64)(SInt64)((theCycle.mInputTime.mSampleTime - theZeroSampleTime) * theTicksPerFrame);
+    theCycle.mOutputTime = theCycle.mCurrentTime;
+    theCycle.mOutputTime.mSampleTime = theScheduledSampleTime + io->output_offset;
+    theCycle.mOutputTime.mHostTime = theZeroHostTime + (UInt64)(SInt64)((theCycle.mOutputTime.mSampleTime - theZeroSampleTime) * theTicksPerFrame);
+    theCycle.mDeviceHostTicksPerFrame.mSampleTime = theTicksPerFrame;
+    theCycle.mMainHostTicksPerFrame.mSampleTime = theTicksPerFrame;
+    io->cycle_info = theCycle;
+
+    theError = vac_host_io_operation(io, kAudioServerPlugInIOOperationReadInput, io->input_stream_id, &theCycle, io->input, &io->did_read_input);
+    if(theError == 0)
+    {
+        theError = vac_host_io_operation(io, kAudioServerPlugInIOOperationProcessInput, io->input_stream_id, &theCycle, io->input, &io->did_process_input);
+    }
+    if((theError == 0) && (io->render != NULL))
+    {
+        io->render(io);
+    }
+    if(theError == 0)
+    {
+        theError = vac_host_io_operation(io, kAudioServerPlugInIOOperationWriteMix, io->output_stream_id, &theCycle, io->output, &io->did_write_mix);
+    }
+    return theError;
+}
+
+OSStatus vac_host_io_stop(struct VACHostIO* io)
+{
+    OSStatus theError = (*io->driver)->StopIO(io->driver, io->device_id, io->client_id);
+    AudioServerPlugInClientInfo theClient = { io->client_id, io->process, true, NULL };
+    (*io->driver)->RemoveDeviceClient(io->driver, io->device_id, &theClient);
+    free(io->input);
+    free(io->output);
+    io->input = NULL;
+    io->output = NULL;
+    return theError;
+}
@@ -0,0 +1,112 @@
+#ifndef VAChost_h
+#define VAChost_h
+
+//	A stand-in for coreaudiod, for running VACdummy.c off macOS. It loads the driver through its
+//	factory the way the HAL does, implements the host interface, and drives IO cycles built the way the
+//	HAL builds them: GetZeroTimeStamp, then WillDo, Begin, Do and End for ReadInput, ProcessInput and
+//	WriteMix, with AudioServerPlugInIOCycleInfo time stamps derived from the device's own latency and
+//	safety offset. The CoreFoundation, libdispatch and mach calls the driver makes are implemented here
+//	as well, see the headers under host/include.
+//
+//	Host time is in nanoseconds. By default it is simulated: it only moves when the harness moves it,
+//	either by hand or by running IO cycles, so a test sees exactly the same time stamps on every run.
+//	vac_host_use_real_time switches to the monotonic clock for measurements that need a real IO thread.
+
+#include <CoreAudio/AudioServerPlugIn.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Driver
+//==================================================================================================
+
+//	Finds the driver interface through _Create and QueryInterface and initializes it against the stub
+//	host. The driver keeps global state, so this happens once per process and later calls return the
+//	same reference.
+AudioServerPlugInDriverRef  vac_host_load(void);
+
+//	The process the calls after this one come from, for the property calls and the clients that IO
+//	adds, so a test can stand in for several processes. 0, the default, is this one.
+void        vac_host_set_process(pid_t pid);
+
+//	Runs whatever the driver handed to a dispatch queue, oldest first, then performs the configuration
+//	changes it asked for. Like the HAL, the caller has to have stopped IO on a device before a change to
+//	it is performed. Returns the number of configuration changes performed.
+uint32_t    vac_host_drain(void);
+
+//	How often the driver has told the host that a property of an object changed since the last
+//	vac_host_reset_notifications. Pass kAudioObjectUnknown to count every object.
+uint32_t    vac_host_notifications(AudioObjectID object_id, AudioObjectPropertySelector selector);
+void        vac_host_reset_notifications(void);
+
+//	Shorthands for the property calls of the tests, all with the global scope unless one is given.
+OSStatus    vac_host_get(AudioObjectID object_id, AudioObjectPropertySelector selector, AudioObjectPropertyScope scope, UInt32 size, void* out_data);
+OSStatus    vac_host_set(AudioObjectID object_id, AudioObjectPropertySelector selector, AudioObjectPropertyScope scope, UInt32 size, const void* data);
+
+//	Creates a device from a description with the given UID and, if not NULL, bus UID.
+OSStatus    vac_host_create_device(const char* uid, const char* bus_uid, bool low_latency, AudioObjectID* out_device_id);
+
+//==================================================================================================
+#pragma mark -
+#pragma mark Time
+//==================================================================================================
+
+void        vac_host_use_real_time(bool use_real_time);
+uint64_t    vac_host_time(void);
+void        vac_host_set_time(uint64_t host_time);
+
+//==================================================================================================
+#pragma mark -
+#pragma mark IO
+//==================================================================================================
+
+struct VACHostIO {
+    AudioServerPlugInDriverRef      driver;
+    AudioObjectID                   device_id;
+    AudioObjectID                   input_stream_id;
+    AudioObjectID                   output_stream_id;
+    UInt32                          client_id;
+    pid_t                           process;
+    UInt32                          frame_size;
+    UInt32                          channel_count;
+    Float64                         sample_rate;
+    UInt32                          input_offset;
+    UInt32                          output_offset;
+    uint64_t                        start_host_time;
+    UInt64                          cycle;
+    //	the current sample time of the first cycle less one buffer, every cycle's time stamps are this
+    //	plus cycle buffers
+    Float64                         schedule_sample_time;
+
+    //	frame_size interleaved frames each, the input filled by the last cycle's ReadInput and
+    //	ProcessInput, the output handed to the next cycle's WriteMix
+    float*                          input;
+    float*                          output;
+
+    //	called in every cycle between the input and the output operations to fill output, with
+    //	cycle_info already describing the cycle
+    void                            (*render)(struct VACHostIO* io);
+    void*                           refcon;
+    AudioServerPlugInIOCycleInfo    cycle_info;
+
+    //	what WillDoIOOperation answered in the last cycle
+    Boolean                         did_read_input;
+    Boolean                         did_process_input;
+    Boolean                         did_write_mix;
+};
+
+//	Adds a client to the device and starts IO for it, anchoring the cycles at the current host time.
+OSStatus    vac_host_io_start(struct VACHostIO* io, AudioObjectID device_id, UInt32 client_id, UInt32 frame_size);
+
+//	Runs the next IO cycle. As with the HAL the cycles are scheduled back to back from the first one:
+//	however late the IO thread is, the input and output times are the ones of the schedule and only
+//	the current time says how late it is. With simulated time the cycle happens when the device has
+//	played cycle * frame_size frames plus late_frames, late_frames being how late the IO thread woke
+//	up; with real time it happens whenever it is called and late_frames is ignored.
+OSStatus    vac_host_io_cycle(struct VACHostIO* io, UInt32 late_frames);
+
+OSStatus    vac_host_io_stop(struct VACHostIO* io);
+
+#endif
@@ -0,0 +1,310 @@
+#ifndef AudioServerPlugIn_h
+#define AudioServerPlugIn_h
+
+//	The subset of the AudioServerPlugIn SDK VACdummy.c uses, for building the driver off macOS against
+//	the stub host in VAChost.c. The types are laid out and the constants valued as in the macOS SDK, so
+//	that the driver compiles the same code either way.
+
+#include <CoreFoundation/CoreFoundation.h>
+
+typedef UInt32                      AudioObjectID;
+typedef UInt32                      AudioClassID;
+typedef UInt32                      AudioObjectPropertySelector;
+typedef UInt32                      AudioObjectPropertyScope;
+typedef UInt32                      AudioObjectPropertyElement;
+typedef UInt32                      AudioFormatID;
+typedef UInt32                      AudioFormatFlags;
+typedef UInt32                      AudioChannelLabel;
+typedef UInt32                      AudioChannelLayoutTag;
+typedef UInt32                      AudioChannelBitmap;
+typedef UInt32                      AudioChannelFlags;
+
+//==================================================================================================
+#pragma mark Types
+//==================================================================================================
+
+typedef struct AudioObjectPropertyAddress {
+    AudioObjectPropertySelector     mSelector;
+    AudioObjectPropertyScope        mScope;
+    AudioObjectPropertyElement      mElement;
+} AudioObjectPropertyAddress;
+
+typedef struct AudioValueRange {
+    Float64                         mMinimum;
+    Float64                         mMaximum;
+} AudioValueRange;
+
+typedef struct AudioStreamBasicDescription {
+    Float64                         mSampleRate;
+    AudioFormatID                   mFormatID;
+    AudioFormatFlags                mFormatFlags;
+    UInt32                          mBytesPerPacket;
+    UInt32                          mFramesPerPacket;
+    UInt32                          mBytesPerFrame;
+    UInt32                          mChannelsPerFrame;
+    UInt32                          mBitsPerChannel;
+    UInt32                          mReserved;
+} AudioStreamBasicDescription;
+
+typedef struct AudioStreamRangedDescription {
+    AudioStreamBasicDescription     mFormat;
+    AudioValueRange                 mSampleRateRange;
+} AudioStreamRangedDescription;
+
+typedef struct AudioChannelDescription {
+    AudioChannelLabel               mChannelLabel;
+    AudioChannelFlags               mChannelFlags;
+    Float32                         mCoordinates[3];
+} AudioChannelDescription;
+
+typedef struct AudioChannelLayout {
+    AudioChannelLayoutTag           mChannelLayoutTag;
+    AudioChannelBitmap              mChannelBitmap;
+    UInt32                          mNumberChannelDescriptions;
+    AudioChannelDescription         mChannelDescriptions[1];
+} AudioChannelLayout;
+
+typedef struct AudioTimeStamp {
+    Float64                         mSampleTime;
+    UInt64                          mHostTime;
+    Float64                         mRateScalar;
+    UInt64                          mWordClockTime;
+    UInt64                          mSMPTETime[3];
+    UInt32                          mFlags;
+    UInt32                          mReserved;
+} AudioTimeStamp;
+
+typedef struct AudioServerPlugInIOCycleInfo {
+    UInt64                          mIOCycleCounter;
+    UInt32                          mNominalIOBufferFrameSize;
+    AudioTimeStamp                  mCurrentTime;
+    AudioTimeStamp                  mInputTime;
+    AudioTimeStamp                  mOutputTime;
+    AudioTimeStamp                  mMainHostTicksPerFrame;
+    AudioTimeStamp                  mDeviceHostTicksPerFrame;
+} AudioServerPlugInIOCycleInfo;
+
+typedef struct AudioServerPlugInClientInfo {
+    UInt32                          mClientID;
+    pid_t                           mProcessID;
+    Boolean                         mIsNativeEndian;
+    CFStringRef                     mBundleID;
+} AudioServerPlugInClientInfo;
+
+typedef struct AudioServerPlugInCustomPropertyInfo {
+    AudioObjectPropertySelector     mSelector;
+    UInt32                          mPropertyDataType;
+    UInt32                          mQualifierDataType;
+} AudioServerPlugInCustomPropertyInfo;
+
+//==================================================================================================
+#pragma mark Interfaces
+//==================================================================================================
+
+typedef struct AudioServerPlugInHostInterface AudioServerPlugInHostInterface;
+typedef const AudioServerPlugInHostInterface* AudioServerPlugInHostRef;
+
+struct AudioServerPlugInHostInterface {
+    OSStatus (*PropertiesChanged)(AudioServerPlugInHostRef inHost, AudioObjectID inObjectID, UInt32 inNumberAddresses, const AudioObjectPropertyAddress* inAddresses);
+    OSStatus (*CopyFromStorage)(AudioServerPlugInHostRef inHost, CFStringRef inKey, CFPropertyListRef* outData);
+    OSStatus (*WriteToStorage)(AudioServerPlugInHostRef inHost, CFStringRef inKey, CFPropertyListRef inData);
+    OSStatus (*DeleteFromStorage)(AudioServerPlugInHostRef inHost, CFStringRef inKey);
+    OSStatus (*RequestDeviceConfigurationChange)(AudioServerPlugInHostRef inHost, AudioObjectID inDeviceObjectID, UInt64 inChangeAction, void* inChangeInfo);
+};
+
+typedef struct AudioServerPlugInDriverInterface AudioServerPlugInDriverInterface;
+typedef AudioServerPlugInDriverInterface** AudioServerPlugInDriverRef;
+
+struct AudioServerPlugInDriverInterface {
+    void*       _reserved;
+    HRESULT     (*QueryInterface)(void* inDriver, REFIID inUUID, LPVOID* outInterface);
+    ULONG       (*AddRef)(void* inDriver);
+    ULONG       (*Release)(void* inDriver);
+    OSStatus    (*Initialize)(AudioServerPlugInDriverRef inDriver, AudioServerPlugInHostRef inHost);
+    OSStatus    (*CreateDevice)(AudioServerPlugInDriverRef inDriver, CFDictionaryRef inDescription, const AudioServerPlugInClientInfo* inClientInfo, AudioObjectID* outDeviceObjectID);
+    OSStatus    (*DestroyDevice)(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID);
+    OSStatus    (*AddDeviceClient)(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, const AudioServerPlugInClientInfo* inClientInfo);
+    OSStatus    (*RemoveDeviceClient)(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, const AudioServerPlugInClientInfo* inClientInfo);
+    OSStatus    (*PerformDeviceConfigurationChange)(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt64 inChangeAction, void* inChangeInfo);
+    OSStatus    (*AbortDeviceConfigurationChange)(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt64 inChangeAction, void* inChangeInfo);
+    Boolean     (*HasProperty)(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress);
+    OSStatus    (*IsPropertySettable)(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, Boolean* outIsSettable);
+    OSStatus    (*GetPropertyDataSize)(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32* outDataSize);
+    OSStatus    (*GetPropertyData)(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, UInt32* outDataSize, void* outData);
+    OSStatus    (*SetPropertyData)(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress* inAddress, UInt32 inQualifierDataSize, const void* inQualifierData, UInt32 inDataSize, const void* inData);
+    OSStatus    (*StartIO)(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt32 inClientID);
+    OSStatus    (*StopIO)(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt32 inClientID);
+    OSStatus    (*GetZeroTimeStamp)(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt32 inClientID, Float64* outSampleTime, UInt64* outHostTime, UInt64* outSeed);
+    OSStatus    (*WillDoIOOperation)(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt32 inClientID, UInt32 inOperationID, Boolean* outWillDo, Boolean* outWillDoInPlace);
+    OSStatus    (*BeginIOOperation)(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt32 inClientID, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo* inIOCycleInfo);
+    OSStatus    (*DoIOOperation)(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, AudioObjectID inStreamObjectID, UInt32 inClientID, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo* inIOCycleInfo, void* ioMainBuffer, void* ioSecondaryBuffer);
+    OSStatus    (*EndIOOperation)(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt32 inClientID, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo* inIOCycleInfo);
+};
+
+#define kAudioServerPlugInTypeUUID                                      CFUUIDGetConstantUUIDWithBytes(NULL, 0x44, 0x3A, 0xBA, 0xB8, 0xE7, 0xB3, 0x49, 0x1A, 0xB9, 0x85, 0xBE, 0xB9, 0x18, 0x70, 0x30, 0xDB)
+#define kAudioServerPlugInDriverInterfaceUUID                           CFUUIDGetConstantUUIDWithBytes(NULL, 0xEE, 0xA5, 0x77, 0x3D, 0xCC, 0x43, 0x49, 0xF1, 0x8E, 0x00, 0x8F, 0x96, 0xE7, 0xD2, 0x3B, 0x17)
+
+//==================================================================================================
+#pragma mark Constants
+//==================================================================================================
+
+enum {
+    kAudioHardwareNoError                               = 0,
+    kAudioHardwareNotRunningError                       = 'stop',
+    kAudioHardwareUnspecifiedError                      = 'what',
+    kAudioHardwareUnknownPropertyError                  = 'who?',
+    kAudioHardwareBadPropertySizeError                  = '!siz',
+    kAudioHardwareIllegalOperationError                 = 'nope',
+    kAudioHardwareBadObjectError                        = '!obj',
+    kAudioHardwareBadDeviceError                        = '!dev',
+    kAudioHardwareBadStreamError                        = '!str',
+    kAudioHardwareUnsupportedOperationError             = 'unop'
+};
+
+enum {
+    kAudioObjectUnknown                                 = 0,
+    kAudioObjectPlugInObject                            = 1,
+    kAudioObjectPropertyScopeGlobal                     = 'glob',
+    kAudioObjectPropertyScopeInput                      = 'inpt',
+    kAudioObjectPropertyScopeOutput                     = 'outp',
+    kAudioObjectPropertyElementMain                     = 0
+};
+
+enum {
+    kAudioObjectClassID                                 = 'aobj',
+    kAudioPlugInClassID                                 = 'aplg',
+    kAudioBoxClassID                                    = 'abox',
+    kAudioDeviceClassID                                 = 'adev',
+    kAudioStreamClassID                                 = 'astr',
+    kAudioControlClassID                                = 'actl',
+    kAudioLevelControlClassID                           = 'levl',
+    kAudioVolumeControlClassID                          = 'vlme',
+    kAudioBooleanControlClassID                         = 'togl',
+    kAudioMuteControlClassID                            = 'mute'
+};
+
+enum {
+    kAudioObjectPropertyBaseClass                       = 'bcls',
+    kAudioObjectPropertyClass                           = 'clas',
+    kAudioObjectPropertyOwner                           = 'stdv',
+    kAudioObjectPropertyName                            = 'lnam',
+    kAudioObjectPropertyModelName                       = 'lmod',
+    kAudioObjectPropertyManufacturer                    = 'lmak',
+    kAudioObjectPropertyElementName                     = 'lchn',
+    kAudioObjectPropertyOwnedObjects                    = 'ownd',
+    kAudioObjectPropertyIdentify                        = 'iden',
+    kAudioObjectPropertySerialNumber                    = 'snum',
+    kAudioObjectPropertyFirmwareVersion                 = 'fwvn',
+    kAudioObjectPropertyControlList                     = 'ctrl',
+    kAudioObjectPropertyCustomPropertyInfoList          = 'cust'
+};
+
+enum {
+    kAudioPlugInPropertyBoxList                         = 'box#',
+    kAudioPlugInPropertyTranslateUIDToBox               = 'uidb',
+    kAudioPlugInPropertyDeviceList                      = 'dev#',
+    kAudioPlugInPropertyTranslateUIDToDevice            = 'uidd',
+    kAudioPlugInPropertyResourceBundle                  = 'rsrc'
+};
+
+enum {
+    kAudioBoxPropertyBoxUID                             = 'buid',
+    kAudioBoxPropertyTransportType                      = 'tran',
+    kAudioBoxPropertyHasAudio                           = 'bhau',
+    kAudioBoxPropertyHasVideo                           = 'bhvi',
+    kAudioBoxPropertyHasMIDI                            = 'bhmi',
+    kAudioBoxPropertyIsProtected                        = 'bpro',
+    kAudioBoxPropertyAcquired                           = 'bxon',
+    kAudioBoxPropertyAcquisitionFailed                  = 'bxof',
+    kAudioBoxPropertyDeviceList                         = 'bdv#'
+};
+
+enum {
+    kAudioDevicePropertyConfigurationApplication        = 'capp',
+    kAudioDevicePropertyDeviceUID                       = 'uid ',
+    kAudioDevicePropertyModelUID                        = 'muid',
+    kAudioDevicePropertyTransportType                   = 'tran',
+    kAudioDevicePropertyRelatedDevices                  = 'akin',
+    kAudioDevicePropertyClockDomain                     = 'clkd',
+    kAudioDevicePropertyDeviceIsAlive                   = 'livn',
+    kAudioDevicePropertyDeviceIsRunning                 = 'goin',
+    kAudioDevicePropertyDeviceCanBeDefaultDevice        = 'dflt',
+    kAudioDevicePropertyDeviceCanBeDefaultSystemDevice  = 'sflt',
+    kAudioDevicePropertyLatency                         = 'ltnc',
+    kAudioDevicePropertyStreams                         = 'stm#',
+    kAudioDevicePropertySafetyOffset                    = 'saft',
+    kAudioDevicePropertyBufferFrameSizeRange            = 'fsz#',
+    kAudioDevicePropertyNominalSampleRate               = 'nsrt',
+    kAudioDevicePropertyAvailableNominalSampleRates     = 'nsr#',
+    kAudioDevicePropertyIcon                            = 'icon',
+    kAudioDevicePropertyIsHidden                        = 'hidn',
+    kAudioDevicePropertyPreferredChannelsForStereo      = 'dch2',
+    kAudioDevicePropertyPreferredChannelLayout          = 'srnd',
+    kAudioDevicePropertyZeroTimeStampPeriod             = 'ring'
+};
+
+enum {
+    kAudioDeviceTransportTypeVirtual                    = 'virt'
+};
+
+enum {
+    kAudioStreamPropertyIsActive                        = 'sact',
+    kAudioStreamPropertyDirection                       = 'sdir',
+    kAudioStreamPropertyTerminalType                    = 'term',
+    kAudioStreamPropertyStartingChannel                 = 'schn',
+    kAudioStreamPropertyLatency                         = 'ltnc',
+    kAudioStreamPropertyVirtualFormat                   = 'sfmt',
+    kAudioStreamPropertyAvailableVirtualFormats         = 'sfma',
+    kAudioStreamPropertyPhysicalFormat                  = 'pft ',
+    kAudioStreamPropertyAvailablePhysicalFormats        = 'pfta'
+};
+
+enum {
+    kAudioStreamTerminalTypeMicrophone                  = 'micr',
+    kAudioStreamTerminalTypeSpeaker                     = 'spkr'
+};
+
+enum {
+    kAudioControlPropertyScope                          = 'cscp',
+    kAudioControlPropertyElement                        = 'celm',
+    kAudioLevelControlPropertyScalarValue               = 'lcsv',
+    kAudioLevelControlPropertyDecibelValue              = 'lcdv',
+    kAudioLevelControlPropertyDecibelRange              = 'lcdr',
+    kAudioLevelControlPropertyConvertScalarToDecibels   = 'lcsd',
+    kAudioLevelControlPropertyConvertDecibelsToScalar   = 'lcds',
+    kAudioBooleanControlPropertyValue                   = 'bcvl'
+};
+
+enum {
+    kAudioFormatLinearPCM                               = 'lpcm',
+    kAudioFormatFlagIsFloat                             = (1U << 0),
+    kAudioFormatFlagIsBigEndian                         = (1U << 1),
+    kAudioFormatFlagIsPacked                            = (1U << 3),
+    kAudioFormatFlagsNativeEndian                       = 0
+};
+
+enum {
+    kAudioChannelLabel_Left                             = 1,
+    kAudioChannelLayoutTag_UseChannelDescriptions       = (0U << 16) | 0
+};
+
+enum {
+    kAudioServerPlugInIOOperationThread                 = 'thrd',
+    kAudioServerPlugInIOOperationCycle                  = 'cycl',
+    kAudioServerPlugInIOOperationReadInput              = 'read',
+    kAudioServerPlugInIOOperationConvertInput           = 'cinp',
+    kAudioServerPlugInIOOperationProcessInput           = 'pinp',
+    kAudioServerPlugInIOOperationProcessOutput          = 'pout',
+    kAudioServerPlugInIOOperationMixOutput              = 'mixo',
+    kAudioServerPlugInIOOperationProcessMix             = 'pmix',
+    kAudioServerPlugInIOOperationConvertMix             = 'cmix',
+    kAudioServerPlugInIOOperationWriteMix               = 'rite'
+};
+
+enum {
+    kAudioServerPlugInCustomPropertyDataTypeNone        = 0,
+    kAudioServerPlugInCustomPropertyDataTypeCFString    = 'cfst',
+    kAudioServerPlugInCustomPropertyDataTypeCFPropertyList = 'plst'
+};
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef CoreFoundation_h
+#define CoreFoundation_h
+
+//	The subset of CoreFoundation VACdummy.c uses, for building it off macOS against the stub host.
+//	The objects are implemented in VAChost.c: reference counted, thread safe, and with CFSTR strings
+//	interned and immortal like the real ones. CFRetain and CFRelease abort on NULL instead of crashing
+//	somewhere later, so a race that hands out a released string shows up where it happens.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define TARGET_RT_BIG_ENDIAN                                            0
+
+typedef uint8_t                     UInt8;
+typedef uint16_t                    UInt16;
+typedef uint32_t                    UInt32;
+typedef uint64_t                    UInt64;
+typedef int8_t                      SInt8;
+typedef int16_t                     SInt16;
+typedef int32_t                     SInt32;
+typedef int64_t                     SInt64;
+typedef float                       Float32;
+typedef double                      Float64;
+typedef unsigned char               Boolean;
+typedef SInt32                      OSStatus;
+
+typedef unsigned long               CFTypeID;
+typedef unsigned long               CFOptionFlags;
+typedef long                        CFIndex;
+typedef UInt32                      CFStringEncoding;
+typedef const void*                 CFTypeRef;
+typedef CFTypeRef                   CFPropertyListRef;
+typedef const struct __CFAllocator* CFAllocatorRef;
+typedef const struct __CFString*    CFStringRef;
+typedef const struct __CFNumber*    CFNumberRef;
+typedef const struct __CFBoolean*   CFBooleanRef;
+typedef const struct __CFDictionary* CFDictionaryRef;
+typedef const struct __CFUUID*      CFUUIDRef;
+typedef const struct __CFURL*       CFURLRef;
+typedef struct __CFBundle*          CFBundleRef;
+
+#define kCFAllocatorDefault                                             ((CFAllocatorRef)NULL)
+#define kCFAllocatorSystemDefault                                       ((CFAllocatorRef)NULL)
+
+typedef enum {
+    kCFCompareLessThan              = -1,
+    kCFCompareEqualTo               = 0,
+    kCFCompareGreaterThan           = 1
+} CFComparisonResult;
+
+enum {
+    kCFStringEncodingUTF8           = 0x08000100
+};
+
+typedef enum {
+    kCFNumberSInt8Type              = 1,
+    kCFNumberSInt16Type             = 2,
+    kCFNumberSInt32Type             = 3,
+    kCFNumberSInt64Type             = 4,
+    kCFNumberFloat32Type            = 5,
+    kCFNumberFloat64Type            = 6,
+    kCFNumberIntType                = 9,
+    kCFNumberLongType               = 10,
+    kCFNumberLongLongType           = 11,
+    kCFNumberFloatType              = 12,
+    kCFNumberDoubleType             = 13
+} CFNumberType;
+
+CFTypeID        CFGetTypeID(CFTypeRef cf);
+CFTypeRef       CFRetain(CFTypeRef cf);
+void            CFRelease(CFTypeRef cf);
+CFIndex         CFGetRetainCount(CFTypeRef cf);
+Boolean         CFEqual(CFTypeRef cf1, CFTypeRef cf2);
+
+//	strings
+#define CFSTR(cStr)                                                     __CFStringMakeConstantString("" cStr "")
+CFStringRef     __CFStringMakeConstantString(const char* cStr);
+CFTypeID        CFStringGetTypeID(void);
+CFStringRef     CFStringCreateWithCString(CFAllocatorRef alloc, const char* cStr, CFStringEncoding encoding);
+CFStringRef     CFStringCreateWithFormat(CFAllocatorRef alloc, CFDictionaryRef formatOptions, CFStringRef format, ...);
+CFComparisonResult CFStringCompare(CFStringRef theString1, CFStringRef theString2, CFOptionFlags compareOptions);
+Boolean         CFStringGetCString(CFStringRef theString, char* buffer, CFIndex bufferSize, CFStringEncoding encoding);
+const char*     CFStringGetCStringPtr(CFStringRef theString, CFStringEncoding encoding);
+
+//	numbers and booleans
+CFTypeID        CFNumberGetTypeID(void);
+CFNumberRef     CFNumberCreate(CFAllocatorRef allocator, CFNumberType theType, const void* valuePtr);
+Boolean         CFNumberGetValue(CFNumberRef number, CFNumberType theType, void* valuePtr);
+
+extern const CFBooleanRef           kCFBooleanTrue;
+extern const CFBooleanRef           kCFBooleanFalse;
+CFTypeID        CFBooleanGetTypeID(void);
+Boolean         CFBooleanGetValue(CFBooleanRef boolean);
+
+//	dictionaries, which always retain their keys and values whatever call backs are passed
+typedef struct { CFIndex version; } CFDictionaryKeyCallBacks;
+typedef struct { CFIndex version; } CFDictionaryValueCallBacks;
+extern const CFDictionaryKeyCallBacks kCFTypeDictionaryKeyCallBacks;
+extern const CFDictionaryValueCallBacks kCFTypeDictionaryValueCallBacks;
+CFTypeID        CFDictionaryGetTypeID(void);
+CFDictionaryRef CFDictionaryCreate(CFAllocatorRef allocator, const void** keys, const void** values, CFIndex numValues, const CFDictionaryKeyCallBacks* keyCallBacks, const CFDictionaryValueCallBacks* valueCallBacks);
+const void*     CFDictionaryGetValue(CFDictionaryRef theDict, const void* key);
+CFIndex         CFDictionaryGetCount(CFDictionaryRef theDict);
+
+//	UUIDs, and the COM plumbing that plug-in factories are written against
+typedef struct {
+    UInt8 byte0, byte1, byte2, byte3, byte4, byte5, byte6, byte7;
+    UInt8 byte8, byte9, byte10, byte11, byte12, byte13, byte14, byte15;
+} CFUUIDBytes;
+CFTypeID        CFUUIDGetTypeID(void);
+CFUUIDRef       CFUUIDGetConstantUUIDWithBytes(CFAllocatorRef alloc, UInt8 byte0, UInt8 byte1, UInt8 byte2, UInt8 byte3, UInt8 byte4, UInt8 byte5, UInt8 byte6, UInt8 byte7, UInt8 byte8, UInt8 byte9, UInt8 byte10, UInt8 byte11, UInt8 byte12, UInt8 byte13, UInt8 byte14, UInt8 byte15);
+CFUUIDRef       CFUUIDCreateFromUUIDBytes(CFAllocatorRef alloc, CFUUIDBytes bytes);
+CFUUIDBytes     CFUUIDGetUUIDBytes(CFUUIDRef uuid);
+
+typedef SInt32                      HRESULT;
+typedef UInt32                      ULONG;
+typedef void*                       LPVOID;
+typedef CFUUIDBytes                 REFIID;
+#define S_OK                                                            ((HRESULT)0x00000000L)
+#define E_NOINTERFACE                                                   ((HRESULT)0x80000004L)
+#define IUnknownUUID                                                    CFUUIDGetConstantUUIDWithBytes(kCFAllocatorSystemDefault, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46)
+
+//	bundles, of which the stub host has none
+CFBundleRef     CFBundleGetBundleWithIdentifier(CFStringRef bundleID);
+CFURLRef        CFBundleCopyResourceURL(CFBundleRef bundle, CFStringRef resourceName, CFStringRef resourceType, CFStringRef subDirName);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef dispatch_h
+#define dispatch_h
+
+//	The function flavored libdispatch calls VACdummy.c makes. The stub host doesn't run a thread pool:
+//	work handed to a queue waits until the harness calls vac_host_drain, so tests see notifications and
+//	configuration change requests at a point of their choosing.
+
+#include <stdint.h>
+
+typedef struct dispatch_queue_s*    dispatch_queue_t;
+typedef uint64_t                    dispatch_time_t;
+typedef void                        (*dispatch_function_t)(void*);
+
+#define DISPATCH_TIME_NOW                                               (0ull)
+#define DISPATCH_QUEUE_PRIORITY_DEFAULT                                 0
+
+dispatch_queue_t    dispatch_get_global_queue(long identifier, unsigned long flags);
+dispatch_time_t     dispatch_time(dispatch_time_t when, int64_t delta);
+void                dispatch_async_f(dispatch_queue_t queue, void* context, dispatch_function_t work);
+void                dispatch_after_f(dispatch_time_t when, dispatch_queue_t queue, void* context, dispatch_function_t work);
+
+#endif
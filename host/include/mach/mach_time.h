@@ -0,0 +1,21 @@
+#ifndef mach_time_h
+#define mach_time_h
+
+//	Host time for the stub host. A tick is a nanosecond, and the clock is either the system's
+//	monotonic clock or one the harness sets by hand, see vac_host_set_time.
+
+#include <stdint.h>
+
+typedef int                         kern_return_t;
+
+struct mach_timebase_info {
+    uint32_t                        numer;
+    uint32_t                        denom;
+};
+typedef struct mach_timebase_info   mach_timebase_info_data_t;
+typedef struct mach_timebase_info*  mach_timebase_info_t;
+
+kern_return_t   mach_timebase_info(mach_timebase_info_t info);
+uint64_t        mach_absolute_time(void);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef VACtest_h
+#define VACtest_h
+
+//	The little the tests need: CHECK reports a failed condition with its location and carries on, and
+//	a test's main returns vac_test_result() so ctest sees the failures.
+
+#include <stdio.h>
+
+static int gVACTest_Failures = 0;
+
+#define CHECK(inCondition, ...)                                                                     \
+do                                                                                                  \
+{                                                                                                   \
+    if(!(inCondition))                                                                              \
+    {                                                                                               \
+        fprintf(stderr, "%s:%d: check failed: %s: ", __FILE__, __LINE__, #inCondition);             \
+        fprintf(stderr, __VA_ARGS__);                                                               \
+        fputc('\n', stderr);                                                                        \
+        ++gVACTest_Failures;                                                                        \
+    }                                                                                               \
+} while(0)
+
+static inline int vac_test_result(const char* name)
+{
+    if(gVACTest_Failures != 0)
+    {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, gVACTest_Failures);
+        return 1;
+    }
+    printf("%s: passed\n", name);
+    return 0;
+}
+
+#endif
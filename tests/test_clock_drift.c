@@ -0,0 +1,104 @@
+//	Runs the zero time stamp clock for 30 days at 44.1kHz and 48kHz, on the 1/1 timebase of Intel Macs
+//	and the 125/3 one of Apple silicon, and checks every time stamp against the exact host time of its
+//	sample time worked out independently in 128 bits. Any rounding that accumulated would show up as a
+//	time stamp off by a tick; after 30 days the last one has to land exactly 30 days after the anchor.
+//
+//	The standard 16384 frame period is walked one call per period, the whole 30 days. Walking the low
+//	latency 512 frame period would take a quarter of a billion calls per case, so that one walks its
+//	first periods, then moves the reader's period count to just before the 30 days and walks the rest.
+
+#include "VACcore.h"
+#include "VACtest.h"
+
+#define                             kTest_Days                          30
+#define                             kTest_WalkPeriods                   100000
+
+struct TestTimebase {
+    uint32_t                        numerator;
+    uint32_t                        denominator;
+};
+
+static const struct TestTimebase    kTest_Timebases[]                   = { { 1, 1 }, { 125, 3 } };
+static const uint32_t               kTest_SampleRates[]                 = { 44100, 48000 };
+static const uint32_t               kTest_Periods[]                     = { 16384, 512 };
+
+//	the host tick sample_time falls on, rounded down, without the clock's arithmetic
+static uint64_t test_host_ticks(const struct TestTimebase* timebase, uint32_t sample_rate, uint64_t sample_time)
+{
+    unsigned __int128 theNanoseconds = (unsigned __int128)sample_time * 1000000000u;
+    return (uint64_t)((theNanoseconds * timebase->denominator) / ((unsigned __int128)timebase->numerator * sample_rate));
+}
+
+static uint32_t test_random(uint32_t* seed)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return *seed >> 8;
+}
+
+//	one call somewhere inside period n, which has to come back as period n
+static bool test_period(struct DeviceClock* clock, const struct TestTimebase* timebase, uint32_t sample_rate, uint32_t period, uint64_t anchor, uint64_t n, uint32_t* seed)
+{
+    uint64_t theStart = anchor + test_host_ticks(timebase, sample_rate, n * period);
+    uint64_t theEnd = anchor + test_host_ticks(timebase, sample_rate, (n + 1) * period);
+    uint64_t theNow = theStart + test_random(seed) % (theEnd - theStart);
+
+    double theSampleTime = 0;
+    uint64_t theHostTime = 0;
+    device_clock_zero_time_stamp(clock, theNow, period, &theSampleTime, &theHostTime);
+    if((theSampleTime != (double)(n * period)) || (theHostTime != theStart))
+    {
+        CHECK(false, "%u/%u timebase, %u Hz, period %u: period %llu came back as sample time %.0f at host time %llu, expected %llu at %llu", timebase->numerator, timebase->denominator, sample_rate, period, (unsigned long long)n, theSampleTime, (unsigned long long)theHostTime, (unsigned long long)(n * period), (unsigned long long)theStart);
+        return false;
+    }
+    return true;
+}
+
+static void test_drift(const struct TestTimebase* timebase, uint32_t sample_rate, uint32_t period)
+{
+    const uint64_t kAnchor = 123456789;
+    struct DeviceClock theClock = { 0 };
+    device_clock_set_rate(&theClock, timebase->numerator, timebase->denominator, sample_rate, kAnchor);
+
+    uint64_t theDaySamples = (uint64_t)kTest_Days * 86400 * sample_rate;
+    uint64_t theLastPeriod = theDaySamples / period;
+    uint32_t theSeed = sample_rate ^ period;
+    uint64_t n = 0;
+    bool isExact = true;
+
+    //	the first call is the anchor itself
+    isExact = test_period(&theClock, timebase, sample_rate, period, kAnchor, 0, &theSeed);
+    for(n = 1; isExact && (n < theLastPeriod); ++n)
+    {
+        if((period < 16384) && (n == kTest_WalkPeriods))
+        {
+            n = theLastPeriod - kTest_WalkPeriods;
+            theClock.number_time_stamps = n - 1;
+        }
+        isExact = test_period(&theClock, timebase, sample_rate, period, kAnchor, n, &theSeed);
+    }
+
+    //	30 days on, the time stamp is the last period that started by then, exactly where it should be;
+    //	when the period divides 30 days that is exactly 30 days after the anchor
+    double theSampleTime = 0;
+    uint64_t theHostTime = 0;
+    uint64_t the30Days = (uint64_t)kTest_Days * 86400 * 1000000000ULL * timebase->denominator / timebase->numerator;
+    uint64_t theExpectedHostTime = kAnchor + test_host_ticks(timebase, sample_rate, theLastPeriod * period);
+    device_clock_zero_time_stamp(&theClock, kAnchor + the30Days, period, &theSampleTime, &theHostTime);
+    CHECK(isExact && (theSampleTime == (double)(theLastPeriod * period)) && (theHostTime == theExpectedHostTime), "%u/%u timebase, %u Hz, period %u: after %u days the time stamp is sample time %.0f at host time %llu, expected %llu at %llu", timebase->numerator, timebase->denominator, sample_rate, period, kTest_Days, theSampleTime, (unsigned long long)theHostTime, (unsigned long long)(theLastPeriod * period), (unsigned long long)theExpectedHostTime);
+    CHECK(!isExact || ((theDaySamples % period) != 0) || (theHostTime == kAnchor + the30Days), "%u/%u timebase, %u Hz, period %u: the last period is %lld ticks off 30 days", timebase->numerator, timebase->denominator, sample_rate, period, (long long)(theHostTime - (kAnchor + the30Days)));
+}
+
+int main(void)
+{
+    for(uint32_t t = 0; t < sizeof(kTest_Timebases) / sizeof(kTest_Timebases[0]); ++t)
+    {
+        for(uint32_t r = 0; r < sizeof(kTest_SampleRates) / sizeof(kTest_SampleRates[0]); ++r)
+        {
+            for(uint32_t p = 0; p < sizeof(kTest_Periods) / sizeof(kTest_Periods[0]); ++p)
+            {
+                test_drift(&kTest_Timebases[t], kTest_SampleRates[r], kTest_Periods[p]);
+            }
+        }
+    }
+    return vac_test_result("test_clock_drift");
+}
@@ -0,0 +1,208 @@
+//	Neither the IO path nor the property calls the HAL makes over and over may touch the allocator:
+//	the IO thread can't afford it, and the property values that never change are built once. Counts
+//	every malloc, calloc, realloc and aligned allocation in the process while IO cycles run and while
+//	every property of every object is enumerated and read, and expects none.
+//
+//	The counting replaces the allocator entry points and forwards to glibc's own, so it only runs on
+//	glibc; elsewhere the test passes without checking.
+
+#include "VAChost.h"
+#include "VACtest.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define                             kTest_FrameSize                     512
+#define                             kTest_Cycles                        10000
+#define                             kTest_Enumerations                  1000
+
+#if defined(__GLIBC__)
+
+extern void*                        __libc_malloc(size_t size);
+extern void*                        __libc_calloc(size_t count, size_t size);
+extern void*                        __libc_realloc(void* pointer, size_t size);
+extern void*                        __libc_memalign(size_t alignment, size_t size);
+
+static _Atomic bool                 gTest_IsCounting                    = false;
+static _Atomic uint64_t             gTest_Allocations                   = 0;
+
+static inline void test_count(void)
+{
+    if(atomic_load_explicit(&gTest_IsCounting, memory_order_relaxed))
+    {
+        atomic_fetch_add_explicit(&gTest_Allocations, 1, memory_order_relaxed);
+    }
+}
+
+void* malloc(size_t size)                               { test_count(); return __libc_malloc(size); }
+void* calloc(size_t count, size_t size)                 { test_count(); return __libc_calloc(count, size); }
+void* realloc(void* pointer, size_t size)               { test_count(); return __libc_realloc(pointer, size); }
+void* memalign(size_t alignment, size_t size)           { test_count(); return __libc_memalign(alignment, size); }
+void* aligned_alloc(size_t alignment, size_t size)      { test_count(); return __libc_memalign(alignment, size); }
+
+int posix_memalign(void** out_pointer, size_t alignment, size_t size)
+{
+    test_count();
+    *out_pointer = __libc_memalign(alignment, size);
+    return (*out_pointer != NULL) ? 0 : 12;
+}
+
+static void test_begin_counting(void)
+{
+    atomic_store(&gTest_Allocations, 0);
+    atomic_store(&gTest_IsCounting, true);
+}
+
+static uint64_t test_end_counting(void)
+{
+    atomic_store(&gTest_IsCounting, false);
+    return atomic_load(&gTest_Allocations);
+}
+
+struct TestSelector {
+    AudioObjectPropertySelector     selector;
+    //	the value is a CF object the caller releases
+    bool                            is_cf;
+    //	takes the device's UID as its qualifier
+    bool                            takes_uid;
+};
+
+//	Every standard selector the driver implements on some object. The device's custom properties are
+//	left out: their values are property lists, which are created for every call by design.
+static const struct TestSelector    kTest_Selectors[] = {
+    { kAudioObjectPropertyBaseClass, false, false }, { kAudioObjectPropertyClass, false, false },
+    { kAudioObjectPropertyOwner, false, false }, { kAudioObjectPropertyName, true, false },
+    { kAudioObjectPropertyModelName, true, false }, { kAudioObjectPropertyManufacturer, true, false },
+    { kAudioObjectPropertyElementName, true, false }, { kAudioObjectPropertyOwnedObjects, false, false },
+    { kAudioObjectPropertyIdentify, false, false }, { kAudioObjectPropertySerialNumber, true, false },
+    { kAudioObjectPropertyFirmwareVersion, true, false }, { kAudioObjectPropertyControlList, false, false },
+    { kAudioObjectPropertyCustomPropertyInfoList, false, false },
+    { kAudioPlugInPropertyBoxList, false, false }, { kAudioPlugInPropertyTranslateUIDToBox, false, true },
+    { kAudioPlugInPropertyDeviceList, false, false }, { kAudioPlugInPropertyTranslateUIDToDevice, false, true },
+    { kAudioPlugInPropertyResourceBundle, true, false },
+    { kAudioBoxPropertyBoxUID, true, false }, { kAudioBoxPropertyTransportType, false, false },
+    { kAudioBoxPropertyHasAudio, false, false }, { kAudioBoxPropertyHasVideo, false, false },
+    { kAudioBoxPropertyHasMIDI, false, false }, { kAudioBoxPropertyIsProtected, false, false },
+    { kAudioBoxPropertyAcquired, false, false }, { kAudioBoxPropertyAcquisitionFailed, false, false },
+    { kAudioBoxPropertyDeviceList, false, false },
+    { kAudioDevicePropertyConfigurationApplication, true, false }, { kAudioDevicePropertyDeviceUID, true, false },
+    { kAudioDevicePropertyModelUID, true, false }, { kAudioDevicePropertyRelatedDevices, false, false },
+    { kAudioDevicePropertyClockDomain, false, false }, { kAudioDevicePropertyDeviceIsAlive, false, false },
+    { kAudioDevicePropertyDeviceIsRunning, false, false }, { kAudioDevicePropertyDeviceCanBeDefaultDevice, false, false },
+    { kAudioDevicePropertyDeviceCanBeDefaultSystemDevice, false, false }, { kAudioDevicePropertyLatency, false, false },
+    { kAudioDevicePropertyStreams, false, false }, { kAudioDevicePropertySafetyOffset, false, false },
+    { kAudioDevicePropertyNominalSampleRate, false, false }, { kAudioDevicePropertyAvailableNominalSampleRates, false, false },
+    { kAudioDevicePropertyIcon, true, false }, { kAudioDevicePropertyIsHidden, false, false },
+    { kAudioDevicePropertyPreferredChannelsForStereo, false, false }, { kAudioDevicePropertyPreferredChannelLayout, false, false },
+    { kAudioDevicePropertyZeroTimeStampPeriod, false, false },
+    { kAudioStreamPropertyIsActive, false, false }, { kAudioStreamPropertyDirection, false, false },
+    { kAudioStreamPropertyTerminalType, false, false }, { kAudioStreamPropertyStartingChannel, false, false },
+    { kAudioStreamPropertyVirtualFormat, false, false }, { kAudioStreamPropertyAvailableVirtualFormats, false, false },
+    { kAudioStreamPropertyPhysicalFormat, false, false }, { kAudioStreamPropertyAvailablePhysicalFormats, false, false },
+    { kAudioControlPropertyScope, false, false }, { kAudioControlPropertyElement, false, false },
+    { kAudioLevelControlPropertyScalarValue, false, false }, { kAudioLevelControlPropertyDecibelValue, false, false },
+    { kAudioLevelControlPropertyDecibelRange, false, false }, { kAudioLevelControlPropertyConvertScalarToDecibels, false, false },
+    { kAudioLevelControlPropertyConvertDecibelsToScalar, false, false }, { kAudioBooleanControlPropertyValue, false, false },
+};
+
+static const AudioObjectPropertyScope kTest_Scopes[] = { kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyScopeInput, kAudioObjectPropertyScopeOutput };
+
+//	Reads every property every object has, in every scope, and returns how many it read.
+static uint32_t test_enumerate(AudioServerPlugInDriverRef driver, const AudioObjectID* objects, uint32_t object_count, CFStringRef uid)
+{
+    uint32_t theCount = 0;
+    for(uint32_t o = 0; o < object_count; ++o)
+    {
+        for(uint32_t s = 0; s < sizeof(kTest_Selectors) / sizeof(kTest_Selectors[0]); ++s)
+        {
+            for(uint32_t c = 0; c < sizeof(kTest_Scopes) / sizeof(kTest_Scopes[0]); ++c)
+            {
+                const struct TestSelector* theSelector = &kTest_Selectors[s];
+                AudioObjectPropertyAddress theAddress = { theSelector->selector, kTest_Scopes[c], kAudioObjectPropertyElementMain };
+                if(!(*driver)->HasProperty(driver, objects[o], getpid(), &theAddress))
+                {
+                    continue;
+                }
+                Boolean theIsSettable = false;
+                (*driver)->IsPropertySettable(driver, objects[o], getpid(), &theAddress, &theIsSettable);
+                UInt32 theQualifierSize = theSelector->takes_uid ? sizeof(CFStringRef) : 0;
+                const void* theQualifier = theSelector->takes_uid ? &uid : NULL;
+                UInt32 theSize = 0;
+                (*driver)->GetPropertyDataSize(driver, objects[o], getpid(), &theAddress, theQualifierSize, theQualifier, &theSize);
+                UInt8 theData[4096] = { 0 };
+                OSStatus theError = (*driver)->GetPropertyData(driver, objects[o], getpid(), &theAddress, theQualifierSize, theQualifier, sizeof(theData), &theSize, theData);
+                if((theError == 0) && theSelector->is_cf && (*(CFTypeRef*)theData != NULL))
+                {
+                    CFRelease(*(CFTypeRef*)theData);
+                }
+                theCount += (theError == 0) ? 1 : 0;
+            }
+        }
+    }
+    return theCount;
+}
+
+int main(void)
+{
+    AudioServerPlugInDriverRef theDriver = vac_host_load();
+    CHECK(theDriver != NULL, "no driver");
+
+    AudioObjectID theDevice = kAudioObjectUnknown;
+    vac_host_get(kAudioObjectPlugInObject, kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, sizeof(theDevice), &theDevice);
+    CFStringRef theUID = NULL;
+    vac_host_get(theDevice, kAudioDevicePropertyDeviceUID, kAudioObjectPropertyScopeGlobal, sizeof(theUID), &theUID);
+
+    //	the plug-in, the box, the device and everything the device owns
+    AudioObjectID theObjects[64] = { kAudioObjectPlugInObject, kAudioObjectUnknown, theDevice };
+    vac_host_get(kAudioObjectPlugInObject, kAudioPlugInPropertyBoxList, kAudioObjectPropertyScopeGlobal, sizeof(AudioObjectID), &theObjects[1]);
+    AudioObjectPropertyAddress theAddress = { kAudioObjectPropertyOwnedObjects, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+    UInt32 theSize = 0;
+    (*theDriver)->GetPropertyData(theDriver, theDevice, getpid(), &theAddress, 0, NULL, sizeof(theObjects) - 3 * sizeof(AudioObjectID), &theSize, &theObjects[3]);
+    uint32_t theObjectCount = 3 + theSize / sizeof(AudioObjectID);
+
+    //	once before counting, for whatever is built on first use
+    uint32_t theProperties = test_enumerate(theDriver, theObjects, theObjectCount, theUID);
+    CHECK(theProperties > 100, "only %u properties read on %u objects", theProperties, theObjectCount);
+    test_begin_counting();
+    for(uint32_t i = 0; i < kTest_Enumerations; ++i)
+    {
+        test_enumerate(theDriver, theObjects, theObjectCount, theUID);
+    }
+    uint64_t theAllocations = test_end_counting();
+    CHECK(theAllocations == 0, "reading %u properties of %u objects %u times allocated %llu times", theProperties, theObjectCount, kTest_Enumerations, (unsigned long long)theAllocations);
+
+    struct VACHostIO theIO;
+    OSStatus theError = vac_host_io_start(&theIO, theDevice, 1, kTest_FrameSize);
+    CHECK(theError == 0, "StartIO failed with %d", (int)theError);
+    for(uint32_t theCycle = 0; theCycle < 16; ++theCycle)
+    {
+        vac_host_io_cycle(&theIO, 0);
+    }
+    test_begin_counting();
+    for(uint32_t theCycle = 0; theCycle < kTest_Cycles; ++theCycle)
+    {
+        theError = vac_host_io_cycle(&theIO, 0);
+        if(theError != 0)
+        {
+            break;
+        }
+    }
+    theAllocations = test_end_counting();
+    CHECK(theError == 0, "a cycle failed with %d", (int)theError);
+    CHECK(theAllocations == 0, "%u IO cycles allocated %llu times", kTest_Cycles, (unsigned long long)theAllocations);
+    vac_host_io_stop(&theIO);
+
+    CFRelease(theUID);
+    return vac_test_result("test_host_allocations");
+}
+
+#else
+
+int main(void)
+{
+    printf("test_host_allocations: not glibc, nothing checked\n");
+    return 0;
+}
+
+#endif
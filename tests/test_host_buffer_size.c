@@ -0,0 +1,87 @@
+//	The device holds IO buffers to half its ring. On a low latency cable and a standard one, checks
+//	that the buffer frame size range tops out at half the profile's ring, that a buffer of exactly that
+//	size loops back whole, and that one frame more is turned away with an error and silence on the way
+//	in instead of wrapping round the ring onto itself.
+
+#include "VAChost.h"
+#include "VACtest.h"
+
+#include <stdlib.h>
+
+//	from VACdummy.c, the ring of each latency profile
+#define                             kTest_StandardRingFrames            65536
+#define                             kTest_LowLatencyRingFrames          (16 * 512)
+#define                             kTest_Cycles                        8
+
+static void test_render(struct VACHostIO* io)
+{
+    for(UInt32 i = 0; i < io->frame_size * io->channel_count; ++i)
+    {
+        io->output[i] = 0.5f;
+    }
+}
+
+static void test_device(const char* name, AudioObjectID device_id, UInt32 ring_frames)
+{
+    AudioValueRange theRange = { 0, 0 };
+    OSStatus theError = vac_host_get(device_id, kAudioDevicePropertyBufferFrameSizeRange, kAudioObjectPropertyScopeGlobal, sizeof(theRange), &theRange);
+    CHECK(theError == 0, "%s: getting the buffer frame size range failed with %d", name, (int)theError);
+    CHECK((theRange.mMinimum >= 1) && (theRange.mMinimum <= theRange.mMaximum), "%s: the range starts at %g", name, theRange.mMinimum);
+    CHECK(theRange.mMaximum == ring_frames / 2, "%s: buffers go up to %g frames in a ring of %u", name, theRange.mMaximum, ring_frames);
+    UInt32 theLargest = (UInt32)theRange.mMaximum;
+
+    //	the largest buffer allowed comes back whole once the input time has caught up with the output
+    struct VACHostIO theIO;
+    theError = vac_host_io_start(&theIO, device_id, 1, theLargest);
+    CHECK(theError == 0, "%s: StartIO at %u frames failed with %d", name, theLargest, (int)theError);
+    theIO.render = test_render;
+    bool isWhole = false;
+    for(UInt32 theCycle = 0; (theError == 0) && (theCycle < kTest_Cycles); ++theCycle)
+    {
+        theError = vac_host_io_cycle(&theIO, 0);
+        isWhole = true;
+        for(UInt32 i = 0; i < theLargest * theIO.channel_count; ++i)
+        {
+            isWhole &= (theIO.input[i] == 0.5f);
+        }
+    }
+    CHECK(theError == 0, "%s: a cycle of %u frames failed with %d", name, theLargest, (int)theError);
+    CHECK(isWhole, "%s: %u frame buffers didn't loop back whole", name, theLargest);
+    vac_host_io_stop(&theIO);
+
+    //	one frame more is refused, with nothing left in the input buffer
+    theError = vac_host_io_start(&theIO, device_id, 2, theLargest + 1);
+    CHECK(theError == 0, "%s: StartIO at %u frames failed with %d", name, theLargest + 1, (int)theError);
+    theIO.render = test_render;
+    for(UInt32 i = 0; i < (theLargest + 1) * theIO.channel_count; ++i)
+    {
+        theIO.input[i] = 1.0f;
+    }
+    theError = vac_host_io_cycle(&theIO, 0);
+    CHECK(theError == kAudioHardwareIllegalOperationError, "%s: a cycle of %u frames returned %d", name, theLargest + 1, (int)theError);
+    bool isSilent = true;
+    for(UInt32 i = 0; i < (theLargest + 1) * theIO.channel_count; ++i)
+    {
+        isSilent &= (theIO.input[i] == 0.0f);
+    }
+    CHECK(isSilent, "%s: the refused ReadInput left samples in the buffer", name);
+    vac_host_io_stop(&theIO);
+}
+
+int main(void)
+{
+    AudioServerPlugInDriverRef theDriver = vac_host_load();
+    CHECK(theDriver != NULL, "no driver");
+
+    AudioObjectID theDevices[8];
+    vac_host_get(kAudioObjectPlugInObject, kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, sizeof(theDevices), theDevices);
+    test_device("standard", theDevices[0], kTest_StandardRingFrames);
+
+    AudioObjectID theLowLatency = kAudioObjectUnknown;
+    OSStatus theError = vac_host_create_device("test.low_latency", NULL, true, &theLowLatency);
+    CHECK(theError == 0, "creating a low latency device failed with %d", (int)theError);
+    vac_host_drain();
+    test_device("low latency", theLowLatency, kTest_LowLatencyRingFrames);
+
+    return vac_test_result("test_host_buffer_size");
+}
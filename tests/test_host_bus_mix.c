@@ -0,0 +1,132 @@
+//	A bus mixes the output of its sources into its input, each scaled by its bus gain. Creates a bus
+//	fed by three cables with different gains, runs IO on all four in lockstep with every source writing
+//	its own signal at the same times, and checks that the bus reads exactly the sum of the sources
+//	times their gains, then again after one source's gain is taken to zero while IO is running. The
+//	signals and gains are chosen so that every sum is exact in single precision.
+
+#include "VAChost.h"
+#include "VACtest.h"
+
+#include <stdlib.h>
+
+//	from VACdummy.c
+#define                             kVACDevicePropertyBusGain           'vbgn'
+
+#define                             kTest_FrameSize                     512
+#define                             kTest_Sources                       3
+//	enough cycles for the bus to read nothing but what the sources wrote
+#define                             kTest_SettleCycles                  16
+#define                             kTest_Cycles                        64
+
+struct TestBus {
+    struct VACHostIO                io[kTest_Sources + 1];
+    Float64                         gains[kTest_Sources];
+};
+
+static float test_signal(SInt64 sample_time, UInt32 channel, UInt32 source)
+{
+    return (float)((sample_time * (source + 3) + channel) % 64 + 1) / 64.0f;
+}
+
+//	every source writes its signal, the bus silence
+static void test_render(struct VACHostIO* io)
+{
+    const struct TestBus* theBus = (const struct TestBus*)io->refcon;
+    UInt32 theSource = (UInt32)(io - theBus->io);
+    SInt64 theOutputTime = (SInt64)io->cycle_info.mOutputTime.mSampleTime;
+    for(UInt32 i = 0; i < io->frame_size; ++i)
+    {
+        for(UInt32 c = 0; c < io->channel_count; ++c)
+        {
+            io->output[i * io->channel_count + c] = (theSource < kTest_Sources) ? test_signal(theOutputTime + i, c, theSource) : 0.0f;
+        }
+    }
+}
+
+static OSStatus test_set_gain(struct TestBus* bus, AudioObjectID source_id, UInt32 source, Float64 gain)
+{
+    bus->gains[source] = gain;
+    CFNumberRef theGain = CFNumberCreate(NULL, kCFNumberFloat64Type, &gain);
+    OSStatus theError = vac_host_set(source_id, kVACDevicePropertyBusGain, kAudioObjectPropertyScopeGlobal, sizeof(CFPropertyListRef), &theGain);
+    CFRelease(theGain);
+    return theError;
+}
+
+static void test_run(const char* name, struct TestBus* bus)
+{
+    const struct VACHostIO* theBusIO = &bus->io[kTest_Sources];
+    for(UInt32 theCycle = 0; theCycle < kTest_SettleCycles + kTest_Cycles; ++theCycle)
+    {
+        for(UInt32 theDevice = 0; theDevice <= kTest_Sources; ++theDevice)
+        {
+            OSStatus theError = vac_host_io_cycle(&bus->io[theDevice], 0);
+            CHECK(theError == 0, "%s: cycle %u of device %u failed with %d", name, theCycle, theDevice, (int)theError);
+        }
+        if(theCycle < kTest_SettleCycles)
+        {
+            continue;
+        }
+        SInt64 theInputTime = (SInt64)theBusIO->cycle_info.mInputTime.mSampleTime;
+        UInt32 theMismatches = 0;
+        for(UInt32 i = 0; i < theBusIO->frame_size; ++i)
+        {
+            for(UInt32 c = 0; c < theBusIO->channel_count; ++c)
+            {
+                float theExpected = 0.0f;
+                for(UInt32 theSource = 0; theSource < kTest_Sources; ++theSource)
+                {
+                    theExpected += (float)bus->gains[theSource] * test_signal(theInputTime + i, c, theSource);
+                }
+                theMismatches += (theBusIO->input[i * theBusIO->channel_count + c] != theExpected) ? 1 : 0;
+            }
+        }
+        CHECK(theMismatches == 0, "%s: cycle %u: %u samples of the bus aren't the sum of its sources times their gains", name, theCycle, theMismatches);
+    }
+}
+
+int main(void)
+{
+    AudioServerPlugInDriverRef theDriver = vac_host_load();
+    CHECK(theDriver != NULL, "no driver");
+
+    static struct TestBus theBus;
+    AudioObjectID theBusID = kAudioObjectUnknown;
+    AudioObjectID theSourceIDs[kTest_Sources];
+    OSStatus theError = vac_host_create_device("test.bus", NULL, false, &theBusID);
+    CHECK(theError == 0, "creating the bus failed with %d", (int)theError);
+    for(UInt32 theSource = 0; theSource < kTest_Sources; ++theSource)
+    {
+        char theUID[32];
+        snprintf(theUID, sizeof(theUID), "test.bus.source.%u", theSource);
+        theError = vac_host_create_device(theUID, "test.bus", false, &theSourceIDs[theSource]);
+        CHECK(theError == 0, "creating source %u failed with %d", theSource, (int)theError);
+    }
+    vac_host_drain();
+
+    static const Float64 kGains[kTest_Sources] = { 0.5, 1.0, 2.0 };
+    for(UInt32 theSource = 0; theSource < kTest_Sources; ++theSource)
+    {
+        theError = test_set_gain(&theBus, theSourceIDs[theSource], theSource, kGains[theSource]);
+        CHECK(theError == 0, "setting the gain of source %u failed with %d", theSource, (int)theError);
+    }
+
+    for(UInt32 theDevice = 0; theDevice <= kTest_Sources; ++theDevice)
+    {
+        theError = vac_host_io_start(&theBus.io[theDevice], (theDevice < kTest_Sources) ? theSourceIDs[theDevice] : theBusID, 1, kTest_FrameSize);
+        CHECK(theError == 0, "StartIO on device %u failed with %d", theDevice, (int)theError);
+        theBus.io[theDevice].render = test_render;
+        theBus.io[theDevice].refcon = &theBus;
+    }
+
+    test_run("three sources", &theBus);
+
+    theError = test_set_gain(&theBus, theSourceIDs[1], 1, 0.0);
+    CHECK(theError == 0, "taking the gain of source 1 to zero failed with %d", (int)theError);
+    test_run("source 1 at zero", &theBus);
+
+    for(UInt32 theDevice = 0; theDevice <= kTest_Sources; ++theDevice)
+    {
+        vac_host_io_stop(&theBus.io[theDevice]);
+    }
+    return vac_test_result("test_host_bus_mix");
+}
@@ -0,0 +1,126 @@
+//	Two clients of different processes run IO on the first built-in cable, both writing the same signal
+//	at the same times, since the ring keeps whatever the last WriteMix put there. Gives the second process a delay and checks that its client, and only it, takes part
+//	in ProcessInput and reads exactly that many frames behind what the first one reads in the same
+//	cycle, that taking the delay away brings it back level with the first, and that only those two
+//	changes asked the host to restart IO.
+
+#include "VAChost.h"
+#include "VACtest.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+//	from VACdummy.c
+#define                             kVACDevicePropertyClientDelay       'vcdl'
+
+#define                             kTest_FrameSize                     512
+#define                             kTest_Delay                         1000
+//	enough cycles for both clients to read nothing but what the first one wrote
+#define                             kTest_SettleCycles                  16
+#define                             kTest_Cycles                        64
+
+static float test_signal(SInt64 sample_time, UInt32 channel)
+{
+    return (float)((sample_time * 7 + channel) % 4096 + 1) / 4096.0f;
+}
+
+static void test_render(struct VACHostIO* io)
+{
+    SInt64 theOutputTime = (SInt64)io->cycle_info.mOutputTime.mSampleTime;
+    for(UInt32 i = 0; i < io->frame_size; ++i)
+    {
+        for(UInt32 c = 0; c < io->channel_count; ++c)
+        {
+            io->output[i * io->channel_count + c] = test_signal(theOutputTime + i, c);
+        }
+    }
+}
+
+//	the process of the next property calls has to be the one whose clients get the delay
+static OSStatus test_set_delay(AudioObjectID device_id, SInt32 delay)
+{
+    CFNumberRef theDelay = CFNumberCreate(NULL, kCFNumberSInt32Type, &delay);
+    OSStatus theError = vac_host_set(device_id, kVACDevicePropertyClientDelay, kAudioObjectPropertyScopeGlobal, sizeof(CFPropertyListRef), &theDelay);
+    CFRelease(theDelay);
+    return theError;
+}
+
+//	whether the input of io in its last cycle is the signal from delay frames before its input time
+static bool test_reads(const struct VACHostIO* io, UInt32 delay)
+{
+    SInt64 theInputTime = (SInt64)io->cycle_info.mInputTime.mSampleTime - delay;
+    bool isMatch = true;
+    for(UInt32 i = 0; i < io->frame_size; ++i)
+    {
+        for(UInt32 c = 0; c < io->channel_count; ++c)
+        {
+            isMatch &= (io->input[i * io->channel_count + c] == test_signal(theInputTime + i, c));
+        }
+    }
+    return isMatch;
+}
+
+static void test_run(const char* name, struct VACHostIO* writer, struct VACHostIO* reader, UInt32 delay)
+{
+    for(UInt32 theCycle = 0; theCycle < kTest_SettleCycles + kTest_Cycles; ++theCycle)
+    {
+        OSStatus theError = vac_host_io_cycle(writer, 0);
+        CHECK(theError == 0, "%s: cycle %u of the first client failed with %d", name, theCycle, (int)theError);
+        theError = vac_host_io_cycle(reader, 0);
+        CHECK(theError == 0, "%s: cycle %u of the second client failed with %d", name, theCycle, (int)theError);
+        CHECK(!writer->did_process_input, "%s: cycle %u: the first client took part in ProcessInput", name, theCycle);
+        CHECK(reader->did_process_input == (delay > 0), "%s: cycle %u: ProcessInput %s for the second client", name, theCycle, reader->did_process_input ? "done" : "left out");
+        if(theCycle >= kTest_SettleCycles)
+        {
+            CHECK(writer->cycle_info.mInputTime.mSampleTime == reader->cycle_info.mInputTime.mSampleTime, "%s: cycle %u: the clients ran at different input times", name, theCycle);
+            CHECK(test_reads(writer, 0), "%s: cycle %u: the first client didn't read its own input time", name, theCycle);
+            CHECK(test_reads(reader, delay), "%s: cycle %u: the second client didn't read %u frames behind the first", name, theCycle, delay);
+        }
+    }
+}
+
+int main(void)
+{
+    AudioServerPlugInDriverRef theDriver = vac_host_load();
+    CHECK(theDriver != NULL, "no driver");
+
+    AudioObjectID theDevices[8];
+    vac_host_get(kAudioObjectPlugInObject, kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, sizeof(theDevices), theDevices);
+    AudioObjectID theDevice = theDevices[0];
+
+    //	a process without a client of the device can't be given a delay
+    vac_host_set_process(getpid() + 1);
+    OSStatus theError = test_set_delay(theDevice, kTest_Delay);
+    CHECK(theError == kAudioHardwareIllegalOperationError, "delaying a process without clients returned %d", (int)theError);
+
+    struct VACHostIO theWriter;
+    struct VACHostIO theReader;
+    vac_host_set_process(0);
+    theError = vac_host_io_start(&theWriter, theDevice, 1, kTest_FrameSize);
+    CHECK(theError == 0, "StartIO for the first client failed with %d", (int)theError);
+    theWriter.render = test_render;
+    vac_host_set_process(getpid() + 1);
+    theError = vac_host_io_start(&theReader, theDevice, 2, kTest_FrameSize);
+    CHECK(theError == 0, "StartIO for the second client failed with %d", (int)theError);
+    theReader.render = test_render;
+
+    test_run("no delay", &theWriter, &theReader, 0);
+
+    theError = test_set_delay(theDevice, kTest_Delay);
+    CHECK(theError == 0, "delaying the second process failed with %d", (int)theError);
+    //	which doesn't change which clients take part in ProcessInput, so asks for no restart
+    theError = test_set_delay(theDevice, kTest_Delay);
+    CHECK(theError == 0, "setting the same delay again failed with %d", (int)theError);
+    test_run("delayed", &theWriter, &theReader, kTest_Delay);
+
+    theError = test_set_delay(theDevice, 0);
+    CHECK(theError == 0, "taking the delay away failed with %d", (int)theError);
+    test_run("delay taken away", &theWriter, &theReader, 0);
+
+    vac_host_io_stop(&theReader);
+    vac_host_io_stop(&theWriter);
+    UInt32 theChanges = vac_host_drain();
+    CHECK(theChanges == 2, "giving the delay and taking it away asked for %u configuration changes", theChanges);
+    vac_host_set_process(0);
+    return vac_test_result("test_host_client_delay");
+}
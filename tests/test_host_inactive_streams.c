@@ -0,0 +1,179 @@
+//	A stream that isn't active keeps its direction off the ring: runs IO on the first built-in cable
+//	with each direction deactivated in turn, and both, and counts the kernel calls that move samples
+//	between the ring and the host's input or output buffer. Also calls DoIOOperation for an inactive
+//	direction directly, as a host still holding the old WillDoIOOperation answer would, which must
+//	neither touch the ring nor leave stale samples in the input buffer.
+
+#include "VAChost.h"
+#include "VACkernels.h"
+#include "VACtest.h"
+
+#include <stdlib.h>
+
+#define                             kTest_FrameSize                     512
+#define                             kTest_Cycles                        64
+
+static struct Kernels               gTest_Kernels;
+static struct VACHostIO             gTest_IO;
+static uint32_t                     gTest_RingReads;
+static uint32_t                     gTest_RingWrites;
+
+static bool test_is_in(const float* pointer, const float* buffer)
+{
+    return (pointer >= buffer) && (pointer < buffer + (size_t)gTest_IO.frame_size * gTest_IO.channel_count);
+}
+
+//	a transfer between one of the host's buffers and memory that is neither, which on this path is the
+//	device's ring
+static void test_count(const float* out, const float* in)
+{
+    bool isHostOut = test_is_in(out, gTest_IO.input) || test_is_in(out, gTest_IO.output);
+    bool isHostIn = (in != NULL) && (test_is_in(in, gTest_IO.input) || test_is_in(in, gTest_IO.output));
+    if((in == NULL) || (isHostOut == isHostIn))
+    {
+        return;
+    }
+    if(test_is_in(out, gTest_IO.input))
+    {
+        ++gTest_RingReads;
+    }
+    if(test_is_in(in, gTest_IO.output))
+    {
+        ++gTest_RingWrites;
+    }
+}
+
+static void test_clear(float* out, uint32_t sample_count)
+{
+    test_count(out, NULL);
+    gTest_Kernels.clear(out, sample_count);
+}
+
+static void test_copy(float* out, const float* in, uint32_t sample_count, float gain)
+{
+    test_count(out, in);
+    gTest_Kernels.copy(out, in, sample_count, gain);
+}
+
+static void test_gain(float* out, const float* in, uint32_t sample_count, float gain)
+{
+    test_count(out, in);
+    gTest_Kernels.gain(out, in, sample_count, gain);
+}
+
+static void test_gain_ramp(float* out, const float* in, uint32_t frame_count, uint32_t channels, float start, float step)
+{
+    test_count(out, in);
+    gTest_Kernels.gain_ramp(out, in, frame_count, channels, start, step);
+}
+
+static void test_channel_gain(float* out, const float* in, uint32_t frame_count, uint32_t channels, const float* gains)
+{
+    test_count(out, in);
+    gTest_Kernels.channel_gain(out, in, frame_count, channels, gains);
+}
+
+static void test_channel_gain_ramp(float* out, const float* in, uint32_t frame_count, uint32_t channels, const float* start, const float* step)
+{
+    test_count(out, in);
+    gTest_Kernels.channel_gain_ramp(out, in, frame_count, channels, start, step);
+}
+
+static void test_sum(float* out, const float* in, uint32_t sample_count, float gain)
+{
+    test_count(out, in);
+    gTest_Kernels.sum(out, in, sample_count, gain);
+}
+
+static void test_render(struct VACHostIO* io)
+{
+    for(UInt32 i = 0; i < io->frame_size * io->channel_count; ++i)
+    {
+        io->output[i] = 0.25f;
+    }
+}
+
+static void test_set_active(AudioObjectID stream_id, bool is_active)
+{
+    UInt32 theIsActive = is_active ? 1 : 0;
+    OSStatus theError = vac_host_set(stream_id, kAudioStreamPropertyIsActive, kAudioObjectPropertyScopeGlobal, sizeof(theIsActive), &theIsActive);
+    CHECK(theError == 0, "setting stream %u active to %u failed with %d", (unsigned)stream_id, (unsigned)theIsActive, (int)theError);
+}
+
+static void test_run(const char* name, bool is_input_active, bool is_output_active)
+{
+    test_set_active(gTest_IO.input_stream_id, is_input_active);
+    test_set_active(gTest_IO.output_stream_id, is_output_active);
+    gTest_RingReads = 0;
+    gTest_RingWrites = 0;
+    for(UInt32 theCycle = 0; theCycle < kTest_Cycles; ++theCycle)
+    {
+        OSStatus theError = vac_host_io_cycle(&gTest_IO, 0);
+        CHECK(theError == 0, "%s: cycle %u failed with %d", name, theCycle, (int)theError);
+        CHECK(gTest_IO.did_read_input == is_input_active, "%s: cycle %u: ReadInput %s", name, theCycle, gTest_IO.did_read_input ? "done" : "left out");
+        //	no delay is set, so there is nothing for ProcessInput to do either way
+        CHECK(!gTest_IO.did_process_input, "%s: cycle %u: ProcessInput done", name, theCycle);
+        CHECK(gTest_IO.did_write_mix == is_output_active, "%s: cycle %u: WriteMix %s", name, theCycle, gTest_IO.did_write_mix ? "done" : "left out");
+    }
+
+    //	the operations the host skipped, done anyway
+    AudioServerPlugInDriverRef theDriver = gTest_IO.driver;
+    if(!is_input_active)
+    {
+        for(UInt32 i = 0; i < gTest_IO.frame_size * gTest_IO.channel_count; ++i)
+        {
+            gTest_IO.input[i] = 1.0f;
+        }
+        (*theDriver)->DoIOOperation(theDriver, gTest_IO.device_id, gTest_IO.input_stream_id, gTest_IO.client_id, kAudioServerPlugInIOOperationReadInput, gTest_IO.frame_size, &gTest_IO.cycle_info, gTest_IO.input, NULL);
+        (*theDriver)->DoIOOperation(theDriver, gTest_IO.device_id, gTest_IO.input_stream_id, gTest_IO.client_id, kAudioServerPlugInIOOperationProcessInput, gTest_IO.frame_size, &gTest_IO.cycle_info, gTest_IO.input, NULL);
+        bool isSilent = true;
+        for(UInt32 i = 0; i < gTest_IO.frame_size * gTest_IO.channel_count; ++i)
+        {
+            isSilent &= (gTest_IO.input[i] == 0.0f);
+        }
+        CHECK(isSilent, "%s: ReadInput on the inactive input left samples in the buffer", name);
+        CHECK(gTest_RingReads == 0, "%s: the inactive input read the ring %u times", name, gTest_RingReads);
+    }
+    if(!is_output_active)
+    {
+        test_render(&gTest_IO);
+        (*theDriver)->DoIOOperation(theDriver, gTest_IO.device_id, gTest_IO.output_stream_id, gTest_IO.client_id, kAudioServerPlugInIOOperationWriteMix, gTest_IO.frame_size, &gTest_IO.cycle_info, gTest_IO.output, NULL);
+        CHECK(gTest_RingWrites == 0, "%s: the inactive output wrote the ring %u times", name, gTest_RingWrites);
+    }
+
+    //	and the active directions did get to the ring, or the counting proves nothing
+    CHECK(!is_input_active || (gTest_RingReads > 0), "%s: the active input never read the ring", name);
+    CHECK(!is_output_active || (gTest_RingWrites > 0), "%s: the active output never wrote the ring", name);
+}
+
+int main(void)
+{
+    AudioServerPlugInDriverRef theDriver = vac_host_load();
+    CHECK(theDriver != NULL, "no driver");
+
+    //	_Initialize has selected the kernels, count every transfer from here on
+    gTest_Kernels = gKernels;
+    gKernels.clear = test_clear;
+    gKernels.copy = test_copy;
+    gKernels.gain = test_gain;
+    gKernels.gain_ramp = test_gain_ramp;
+    gKernels.channel_gain = test_channel_gain;
+    gKernels.channel_gain_ramp = test_channel_gain_ramp;
+    gKernels.sum = test_sum;
+
+    AudioObjectID theDevices[8];
+    vac_host_get(kAudioObjectPlugInObject, kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, sizeof(theDevices), theDevices);
+    OSStatus theError = vac_host_io_start(&gTest_IO, theDevices[0], 1, kTest_FrameSize);
+    CHECK(theError == 0, "StartIO failed with %d", (int)theError);
+    gTest_IO.render = test_render;
+
+    test_run("both active", true, true);
+    test_run("input inactive", false, true);
+    test_run("output inactive", true, false);
+    test_run("both inactive", false, false);
+    test_run("both active again", true, true);
+
+    vac_host_io_stop(&gTest_IO);
+    gKernels = gTest_Kernels;
+    return vac_test_result("test_host_inactive_streams");
+}
@@ -0,0 +1,96 @@
+//	Loads the driver into the stub host, runs IO on the first built-in cable, and checks that what
+//	WriteMix puts in comes back out of ReadInput at the sample times the HAL would ask for, and that
+//	the zero time stamps advance by whole periods.
+
+#include "VAChost.h"
+#include "VACtest.h"
+
+#include <stdlib.h>
+
+#define                             kTest_FrameSize                     512
+#define                             kTest_Cycles                        2000
+
+static float test_signal(SInt64 sample_time, UInt32 channel)
+{
+    return (float)((sample_time * 7 + channel) % 4096 + 1) / 4096.0f;
+}
+
+static SInt64 gTest_FirstOutputTime = -1;
+
+static void test_render(struct VACHostIO* io)
+{
+    SInt64 theOutputTime = (SInt64)io->cycle_info.mOutputTime.mSampleTime;
+    if(gTest_FirstOutputTime < 0)
+    {
+        gTest_FirstOutputTime = theOutputTime;
+    }
+    for(UInt32 i = 0; i < io->frame_size; ++i)
+    {
+        for(UInt32 c = 0; c < io->channel_count; ++c)
+        {
+            io->output[i * io->channel_count + c] = test_signal(theOutputTime + i, c);
+        }
+    }
+}
+
+int main(void)
+{
+    AudioServerPlugInDriverRef theDriver = vac_host_load();
+    CHECK(theDriver != NULL, "no driver");
+
+    AudioObjectID theDevices[8];
+    AudioObjectPropertyAddress theAddress = { kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain };
+    UInt32 theSize = 0;
+    OSStatus theError = (*theDriver)->GetPropertyData(theDriver, kAudioObjectPlugInObject, 0, &theAddress, 0, NULL, sizeof(theDevices), &theSize, theDevices);
+    CHECK((theError == 0) && (theSize >= sizeof(AudioObjectID)), "no device list, error %d", (int)theError);
+
+    UInt32 thePeriod = 0;
+    vac_host_get(theDevices[0], kAudioDevicePropertyZeroTimeStampPeriod, kAudioObjectPropertyScopeGlobal, sizeof(thePeriod), &thePeriod);
+    CHECK(thePeriod > 0, "no zero time stamp period");
+
+    struct VACHostIO theIO;
+    theError = vac_host_io_start(&theIO, theDevices[0], 1, kTest_FrameSize);
+    CHECK(theError == 0, "StartIO failed with %d", (int)theError);
+    theIO.render = test_render;
+
+    UInt64 theCheckedFrames = 0;
+    Float64 theLastZeroSampleTime = 0;
+    for(UInt32 theCycle = 0; theCycle < kTest_Cycles; ++theCycle)
+    {
+        theError = vac_host_io_cycle(&theIO, 0);
+        CHECK(theError == 0, "cycle %u failed with %d", theCycle, (int)theError);
+        CHECK(theIO.did_read_input && theIO.did_write_mix, "cycle %u left out a direction", theCycle);
+
+        SInt64 theInputTime = (SInt64)theIO.cycle_info.mInputTime.mSampleTime;
+        for(UInt32 i = 0; i < kTest_FrameSize; ++i)
+        {
+            SInt64 theTime = theInputTime + i;
+            bool isWritten = (gTest_FirstOutputTime >= 0) && (theTime >= gTest_FirstOutputTime);
+            for(UInt32 c = 0; c < theIO.channel_count; ++c)
+            {
+                float theExpected = isWritten ? test_signal(theTime, c) : 0.0f;
+                float theActual = theIO.input[i * theIO.channel_count + c];
+                if(theActual != theExpected)
+                {
+                    CHECK(false, "cycle %u sample time %lld channel %u: read %g, wrote %g", theCycle, (long long)theTime, c, theActual, theExpected);
+                    return vac_test_result("test_host_loopback");
+                }
+            }
+            theCheckedFrames += isWritten ? 1 : 0;
+        }
+
+        Float64 theZeroSampleTime = 0;
+        UInt64 theZeroHostTime = 0;
+        UInt64 theSeed = 0;
+        (*theDriver)->GetZeroTimeStamp(theDriver, theDevices[0], 1, &theZeroSampleTime, &theZeroHostTime, &theSeed);
+        CHECK(theZeroSampleTime >= theLastZeroSampleTime, "the zero time stamp went back from %f to %f", theLastZeroSampleTime, theZeroSampleTime);
+        CHECK((SInt64)theZeroSampleTime % thePeriod == 0, "zero time stamp %f is not on a period", theZeroSampleTime);
+        theLastZeroSampleTime = theZeroSampleTime;
+    }
+    CHECK(theCheckedFrames > (UInt64)kTest_FrameSize * (kTest_Cycles - 4), "only %llu frames came back", (unsigned long long)theCheckedFrames);
+    CHECK(theLastZeroSampleTime > 0, "the zero time stamp never moved");
+
+    theError = vac_host_io_stop(&theIO);
+    CHECK(theError == 0, "StopIO failed with %d", (int)theError);
+    return vac_test_result("test_host_loopback");
+}
@@ -0,0 +1,155 @@
+//	Every kernel set this CPU can run against the scalar reference, bit for bit, over lengths and
+//	channel counts that hit the vector bodies, their tails and the kernels specialized per channel count.
+
+#include "VACkernels.h"
+#include "VACtest.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define                             kTest_MaxSamples                    (4096 * 64)
+
+static float*                       gTest_In;
+static float*                       gTest_Expected;
+static float*                       gTest_Actual;
+
+static float test_random(uint32_t* seed)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return (float)((int32_t)(*seed >> 8) - (1 << 23)) / (float)(1 << 21);
+}
+
+static bool test_same(const float* a, const float* b, uint32_t count)
+{
+    return memcmp(a, b, count * sizeof(float)) == 0;
+}
+
+static void test_set(const struct Kernels* reference, const struct Kernels* set)
+{
+    static const uint32_t kLengths[] = { 0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 33, 63, 64, 65, 127, 128, 129, 255, 1000, 4096 };
+    static const uint32_t kChannels[] = { 1, 2, 3, 5, 6, 8, 9, 16, 32, 64 };
+    float theGains[64];
+    float theSteps[64];
+    uint32_t theSeed = 7;
+    for(uint32_t c = 0; c < 64; ++c)
+    {
+        theGains[c] = test_random(&theSeed);
+        theSteps[c] = test_random(&theSeed) / 1024.0f;
+    }
+
+    for(uint32_t l = 0; l < sizeof(kLengths) / sizeof(kLengths[0]); ++l)
+    {
+        uint32_t theCount = kLengths[l];
+
+        reference->gain(gTest_Expected, gTest_In, theCount, 0.3f);
+        set->gain(gTest_Actual, gTest_In, theCount, 0.3f);
+        CHECK(test_same(gTest_Expected, gTest_Actual, theCount), "%s gain differs at %u samples", set->name, theCount);
+
+        set->copy(gTest_Actual, gTest_In, theCount, 0.3f);
+        CHECK(test_same(gTest_In, gTest_Actual, theCount), "%s copy differs at %u samples", set->name, theCount);
+
+        memcpy(gTest_Expected, gTest_In + 7, theCount * sizeof(float));
+        memcpy(gTest_Actual, gTest_In + 7, theCount * sizeof(float));
+        reference->sum(gTest_Expected, gTest_In, theCount, 0.7f);
+        set->sum(gTest_Actual, gTest_In, theCount, 0.7f);
+        CHECK(test_same(gTest_Expected, gTest_Actual, theCount), "%s sum differs at %u samples", set->name, theCount);
+
+        set->clear(gTest_Actual, theCount);
+        memset(gTest_Expected, 0, theCount * sizeof(float));
+        CHECK(test_same(gTest_Expected, gTest_Actual, theCount), "%s clear differs at %u samples", set->name, theCount);
+
+        CHECK(reference->is_silent(gTest_In, theCount) == set->is_silent(gTest_In, theCount), "%s is_silent differs at %u samples", set->name, theCount);
+        CHECK(set->is_silent(gTest_Expected, theCount), "%s is_silent misses silence at %u samples", set->name, theCount);
+        if(theCount > 0)
+        {
+            //	negative zero is silence, the quietest sounds there are are not
+            static const float kQuiet[] = { 1e-30f, -1e-30f, 1e-45f, -1e-45f };
+            gTest_Expected[theCount / 2] = -0.0f;
+            CHECK(set->is_silent(gTest_Expected, theCount), "%s is_silent misses silence with a negative zero at %u samples", set->name, theCount);
+            for(uint32_t q = 0; q < sizeof(kQuiet) / sizeof(kQuiet[0]); ++q)
+            {
+                gTest_Expected[theCount - 1] = kQuiet[q];
+                CHECK(!set->is_silent(gTest_Expected, theCount), "%s is_silent takes %g for silence at %u samples", set->name, kQuiet[q], theCount);
+            }
+            gTest_Expected[theCount / 2] = 0.0f;
+            gTest_Expected[theCount - 1] = 0.0f;
+        }
+
+        for(uint32_t c = 0; c < sizeof(kChannels) / sizeof(kChannels[0]); ++c)
+        {
+            uint32_t theChannels = kChannels[c];
+            uint32_t theSamples = theCount * theChannels;
+            if(theSamples > kTest_MaxSamples)
+            {
+                continue;
+            }
+
+            reference->gain_ramp(gTest_Expected, gTest_In, theCount, theChannels, 0.25f, 1.0f / 4096.0f);
+            set->gain_ramp(gTest_Actual, gTest_In, theCount, theChannels, 0.25f, 1.0f / 4096.0f);
+            CHECK(test_same(gTest_Expected, gTest_Actual, theSamples), "%s gain_ramp differs at %u frames of %u channels", set->name, theCount, theChannels);
+
+            reference->channel_gain(gTest_Expected, gTest_In, theCount, theChannels, theGains);
+            set->channel_gain(gTest_Actual, gTest_In, theCount, theChannels, theGains);
+            CHECK(test_same(gTest_Expected, gTest_Actual, theSamples), "%s channel_gain differs at %u frames of %u channels", set->name, theCount, theChannels);
+
+            reference->channel_gain_ramp(gTest_Expected, gTest_In, theCount, theChannels, theGains, theSteps);
+            set->channel_gain_ramp(gTest_Actual, gTest_In, theCount, theChannels, theGains, theSteps);
+            CHECK(test_same(gTest_Expected, gTest_Actual, theSamples), "%s channel_gain_ramp differs at %u frames of %u channels", set->name, theCount, theChannels);
+
+            const float* theIn[64];
+            float* theOut[64];
+            for(uint32_t i = 0; i < theChannels; ++i)
+            {
+                theIn[i] = gTest_In + (size_t)i * theCount;
+                theOut[i] = gTest_Actual + (size_t)i * theCount;
+            }
+            reference->interleave(gTest_Expected, theIn, theCount, theChannels);
+            set->deinterleave(theOut, gTest_Expected, theCount, theChannels);
+            CHECK(test_same(gTest_In, gTest_Actual, theSamples), "%s deinterleave differs at %u frames of %u channels", set->name, theCount, theChannels);
+            set->interleave(gTest_Actual, theIn, theCount, theChannels);
+            CHECK(test_same(gTest_Expected, gTest_Actual, theSamples), "%s interleave differs at %u frames of %u channels", set->name, theCount, theChannels);
+        }
+
+        for(uint32_t f = 0; (set->frames != NULL) && (f < kFrameKernels_Count); ++f)
+        {
+            const struct FrameKernels* theFrames = &set->frames[f];
+            uint32_t theSamples = theCount * theFrames->channels;
+            if(theSamples > kTest_MaxSamples)
+            {
+                continue;
+            }
+            reference->channel_gain(gTest_Expected, gTest_In, theCount, theFrames->channels, theGains);
+            theFrames->channel_gain(gTest_Actual, gTest_In, theCount, theFrames->channels, theGains);
+            CHECK(test_same(gTest_Expected, gTest_Actual, theSamples), "%s %u channel channel_gain differs at %u frames", set->name, theFrames->channels, theCount);
+
+            reference->channel_gain_ramp(gTest_Expected, gTest_In, theCount, theFrames->channels, theGains, theSteps);
+            theFrames->channel_gain_ramp(gTest_Actual, gTest_In, theCount, theFrames->channels, theGains, theSteps);
+            CHECK(test_same(gTest_Expected, gTest_Actual, theSamples), "%s %u channel channel_gain_ramp differs at %u frames", set->name, theFrames->channels, theCount);
+        }
+    }
+}
+
+int main(void)
+{
+    gTest_In = (float*)malloc(kTest_MaxSamples * sizeof(float));
+    gTest_Expected = (float*)malloc(kTest_MaxSamples * sizeof(float));
+    gTest_Actual = (float*)malloc(kTest_MaxSamples * sizeof(float));
+    uint32_t theSeed = 1;
+    for(uint32_t i = 0; i < kTest_MaxSamples; ++i)
+    {
+        gTest_In[i] = test_random(&theSeed);
+    }
+
+    const struct Kernels* theSets[8];
+    uint32_t theCount = kernels_available(theSets, 8);
+    for(uint32_t i = 0; i < theCount; ++i)
+    {
+        printf("checking %s\n", theSets[i]->name);
+        test_set(theSets[0], theSets[i]);
+    }
+
+    free(gTest_In);
+    free(gTest_Expected);
+    free(gTest_Actual);
+    return vac_test_result("test_kernels");
+}
@@ -0,0 +1,44 @@
+//	A reset makes everything in the ring stale by starting a new generation, and the tags only keep 16
+//	bits of it. Writes a block, resets the ring 65536 times, which brings those bits back round to the
+//	block's generation, and checks that the block still reads as silence.
+
+#include "VACcore.h"
+#include "VACtest.h"
+
+#define                             kTest_Channels                      2
+#define                             kTest_Frames                        64
+
+int main(void)
+{
+    kernels_select();
+    struct RingBuffer theRing;
+    CHECK(ring_buffer_allocate(&theRing, 4096, kTest_Channels, false), "could not allocate the ring");
+
+    float theFrames[kTest_Frames * kTest_Channels];
+    for(uint32_t i = 0; i < kTest_Frames * kTest_Channels; ++i)
+    {
+        theFrames[i] = 0.5f;
+    }
+    struct RingGain theGain = ring_gain_steady(1.0f);
+    ring_buffer_reset(&theRing);
+    ring_buffer_write(&theRing, 0, kTest_Frames, &theGain, theFrames);
+
+    float theOut[kTest_Frames * kTest_Channels];
+    CHECK(ring_buffer_read(&theRing, 0, kTest_Frames, &theGain, theOut) && (theOut[0] == 0.5f), "the block didn't read back before the resets");
+
+    for(uint32_t theReset = 1; theReset <= 65536; ++theReset)
+    {
+        ring_buffer_reset(&theRing);
+
+        //	the cursors are rewound too, so move the write end past the block again without touching it
+        atomic_store_explicit(&theRing.write_end, kTest_Frames, memory_order_release);
+        if((theReset % 4096 == 0) || (theReset >= 65534))
+        {
+            bool theReadAnything = ring_buffer_read(&theRing, 0, kTest_Frames, &theGain, theOut);
+            CHECK(!theReadAnything && (theOut[0] == 0.0f), "a block from before %u resets read as %g", theReset, theOut[0]);
+        }
+    }
+
+    ring_buffer_free(&theRing);
+    return vac_test_result("test_ring_generation");
+}
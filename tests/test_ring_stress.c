@@ -0,0 +1,250 @@
+//	A writer and a reader thread on one ring, the way the WriteMix and ReadInput sides of two cables
+//	share one. Every sample encodes the sample time and channel it was written for, so the reader can
+//	tell a torn frame (channels from different laps) and stale data from the real thing.
+//
+//	The first phase paces the writer at kTest_CycleRate IO cycles a second, faster than any real
+//	device, with the reader a few cycles behind it. Nothing the reader asks for is ever overwritten
+//	then, so every frame has to come back exactly: a silent one would be a false underrun. The second
+//	phase lets the writer run flat out and has the reader chase frames about to be overwritten, to
+//	check that a read the writer laps comes back as whole frames of silence and never as a mix. The
+//	third phase has the writer reset the ring every kTest_ResetCycles cycles and start again from sample
+//	time zero, the way StartIO does while a bus is reading the cable, with the lap folded into what it
+//	writes: a read a reset overlaps has to come back as silence, not as frames from two laps.
+
+#include "VACcore.h"
+#include "VACtest.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define                             kTest_Channels                      8
+#define                             kTest_RingFrames                    1024
+#define                             kTest_CycleFrames                   32
+#define                             kTest_CycleRate                     20000
+#define                             kTest_PacedCycles                   20000
+#define                             kTest_LappedCycles                  400000
+#define                             kTest_ResettingCycles               400000
+#define                             kTest_ResetCycles                   64
+//	long enough that the reader is often preempted mid-copy even on one CPU
+#define                             kTest_ResetReadFrames               512
+#define                             kTest_ReaderLag                     4
+
+static struct RingBuffer            gTest_Ring;
+static _Atomic uint64_t             gTest_WriterCycles;
+static _Atomic bool                 gTest_WriterPaced;
+static _Atomic bool                 gTest_WriterResetting;
+static _Atomic bool                 gTest_WriterDone;
+
+static uint64_t test_now(void)
+{
+    struct timespec theTime;
+    clock_gettime(CLOCK_MONOTONIC, &theTime);
+    return (uint64_t)theTime.tv_sec * 1000000000ULL + (uint64_t)theTime.tv_nsec;
+}
+
+//	exact in a float, and different for every channel and for every frame within 2^20 of each other
+static float test_sample(int64_t sample_time, uint32_t channel)
+{
+    return (float)((((uint32_t)sample_time & 0xFFFFF) << 3) | channel) + 1.0f;
+}
+
+//	the lap a sample read at sample_time was written in, or -1 if it isn't one test_sample wrote for
+//	that time and channel in any lap
+static int32_t test_sample_lap(float sample, int64_t sample_time, uint32_t channel)
+{
+    uint32_t theBits = (uint32_t)(sample - 1.0f);
+    uint32_t theTime = theBits >> 3;
+    if(((theBits & 7) != channel) || ((theTime & 0xFFFF) != ((uint32_t)sample_time & 0xFFFF)))
+    {
+        return -1;
+    }
+    return (int32_t)(theTime >> 16);
+}
+
+static void* test_writer(void* context)
+{
+    (void)context;
+    float theFrames[kTest_CycleFrames * kTest_Channels];
+    struct RingGain theGain = ring_gain_steady(1.0f);
+    uint64_t theCycles = (uint64_t)kTest_PacedCycles + kTest_LappedCycles + kTest_ResettingCycles;
+    uint64_t theLap = 0;
+    uint64_t theStart = test_now();
+    for(uint64_t theCycle = 0; theCycle < theCycles; ++theCycle)
+    {
+        bool isPaced = theCycle < kTest_PacedCycles;
+        if(!isPaced && atomic_load_explicit(&gTest_WriterPaced, memory_order_relaxed))
+        {
+            atomic_store(&gTest_WriterPaced, false);
+        }
+        while(isPaced && (test_now() - theStart < theCycle * 1000000000ULL / kTest_CycleRate))
+        {
+            sched_yield();
+        }
+
+        int64_t theSampleTime = (int64_t)theCycle * kTest_CycleFrames;
+        int64_t theLapTime = 0;
+        if(theCycle >= (uint64_t)kTest_PacedCycles + kTest_LappedCycles)
+        {
+            uint64_t theLapCycle = (theCycle - kTest_PacedCycles - kTest_LappedCycles) % kTest_ResetCycles;
+            if(theLapCycle == 0)
+            {
+                ring_buffer_reset(&gTest_Ring);
+                ++theLap;
+                atomic_store(&gTest_WriterResetting, true);
+            }
+            theSampleTime = (int64_t)theLapCycle * kTest_CycleFrames;
+            theLapTime = ((int64_t)(theLap & 0xF) << 16);
+        }
+        for(uint32_t i = 0; i < kTest_CycleFrames; ++i)
+        {
+            for(uint32_t c = 0; c < kTest_Channels; ++c)
+            {
+                theFrames[i * kTest_Channels + c] = test_sample(theLapTime + theSampleTime + i, c);
+            }
+        }
+        ring_buffer_write(&gTest_Ring, theSampleTime, kTest_CycleFrames, &theGain, theFrames);
+        atomic_store_explicit(&gTest_WriterCycles, theCycle + 1, memory_order_release);
+    }
+    atomic_store(&gTest_WriterDone, true);
+    return NULL;
+}
+
+//	how many frames are neither exactly what was written nor whole frames of silence, and how many are
+//	silence
+static void test_check_frames(const float* frames, int64_t sample_time, uint32_t frame_count, uint64_t* io_torn, uint64_t* io_silent)
+{
+    for(uint32_t i = 0; i < frame_count; ++i)
+    {
+        const float* theFrame = frames + i * kTest_Channels;
+        bool isExact = true;
+        bool isSilent = true;
+        for(uint32_t c = 0; c < kTest_Channels; ++c)
+        {
+            isExact = isExact && (theFrame[c] == test_sample(sample_time + i, c));
+            isSilent = isSilent && (theFrame[c] == 0.0f);
+        }
+        *io_torn += (!isExact && !isSilent) ? 1 : 0;
+        *io_silent += isSilent ? 1 : 0;
+    }
+}
+
+//	the same for a read while the writer resets, where any lap will do as long as every frame that
+//	isn't silence is from the same one
+static void test_check_lapped_frames(const float* frames, int64_t sample_time, uint32_t frame_count, uint64_t* io_torn, uint64_t* io_sound)
+{
+    int32_t theLap = -1;
+    for(uint32_t i = 0; i < frame_count; ++i)
+    {
+        const float* theFrame = frames + i * kTest_Channels;
+        if(theFrame[0] == 0.0f)
+        {
+            bool isSilent = true;
+            for(uint32_t c = 1; c < kTest_Channels; ++c)
+            {
+                isSilent = isSilent && (theFrame[c] == 0.0f);
+            }
+            *io_torn += isSilent ? 0 : 1;
+            continue;
+        }
+        bool isWhole = true;
+        for(uint32_t c = 0; c < kTest_Channels; ++c)
+        {
+            int32_t theSampleLap = test_sample_lap(theFrame[c], sample_time + i, c);
+            isWhole = isWhole && (theSampleLap >= 0) && ((theLap < 0) || (theSampleLap == theLap));
+            theLap = (theLap < 0) ? theSampleLap : theLap;
+        }
+        *io_torn += isWhole ? 0 : 1;
+        *io_sound += isWhole ? 1 : 0;
+    }
+}
+
+int main(void)
+{
+    kernels_select();
+    CHECK(ring_buffer_allocate(&gTest_Ring, kTest_RingFrames, kTest_Channels, false), "could not allocate the ring");
+    ring_buffer_reset(&gTest_Ring);
+    atomic_store(&gTest_WriterPaced, true);
+
+    pthread_t theWriter;
+    uint64_t theStart = test_now();
+    pthread_create(&theWriter, NULL, test_writer, NULL);
+
+    float theFrames[kTest_ResetReadFrames * kTest_Channels];
+    struct RingGain theGain = ring_gain_steady(1.0f);
+    uint64_t theTorn = 0;
+    uint64_t theFalseSilence = 0;
+    uint64_t thePacedReads = 0;
+    uint64_t thePacedDuration = 0;
+    uint64_t theLappedReads = 0;
+    uint64_t theLappedSilence = 0;
+    uint64_t theResetReads = 0;
+    uint64_t theResetSound = 0;
+    uint64_t theNextCycle = 0;
+    uint32_t theSeed = 1;
+    while(!atomic_load(&gTest_WriterDone))
+    {
+        uint64_t theWritten = atomic_load_explicit(&gTest_WriterCycles, memory_order_acquire);
+        if(atomic_load_explicit(&gTest_WriterPaced, memory_order_relaxed))
+        {
+            //	follow the writer kTest_ReaderLag cycles behind, as ReadInput follows WriteMix
+            if(theNextCycle + kTest_ReaderLag > theWritten)
+            {
+                sched_yield();
+                continue;
+            }
+            int64_t theSampleTime = (int64_t)theNextCycle * kTest_CycleFrames;
+            ring_buffer_read(&gTest_Ring, theSampleTime, kTest_CycleFrames, &theGain, theFrames);
+            int64_t theOverwritten = atomic_load_explicit(&gTest_Ring.write_pending, memory_order_acquire) - (int64_t)gTest_Ring.frame_count;
+
+            uint64_t theSilent = 0;
+            test_check_frames(theFrames, theSampleTime, kTest_CycleFrames, &theTorn, &theSilent);
+            if(theSampleTime >= theOverwritten)
+            {
+                theFalseSilence += theSilent;
+            }
+            ++theNextCycle;
+            ++thePacedReads;
+            thePacedDuration = test_now() - theStart;
+        }
+        else if(atomic_load_explicit(&gTest_WriterResetting, memory_order_relaxed))
+        {
+            //	anywhere in the stretch the writer fills between resets
+            theSeed = theSeed * 1664525u + 1013904223u;
+            int64_t theSampleTime = (int64_t)((theSeed >> 8) % (kTest_ResetCycles * kTest_CycleFrames - kTest_ResetReadFrames));
+            ring_buffer_read(&gTest_Ring, theSampleTime, kTest_ResetReadFrames, &theGain, theFrames);
+            test_check_lapped_frames(theFrames, theSampleTime, kTest_ResetReadFrames, &theTorn, &theResetSound);
+            ++theResetReads;
+        }
+        else
+        {
+            //	chase the oldest frames the ring still has, which the writer is about to reuse
+            int64_t theEnd = (int64_t)theWritten * kTest_CycleFrames;
+            theSeed = theSeed * 1664525u + 1013904223u;
+            int64_t theSampleTime = theEnd - (int64_t)gTest_Ring.frame_count + (int64_t)((theSeed >> 8) % (2 * kTest_CycleFrames));
+            if(theSampleTime < 0)
+            {
+                continue;
+            }
+            uint64_t theSilent = 0;
+            ring_buffer_read(&gTest_Ring, theSampleTime, kTest_CycleFrames, &theGain, theFrames);
+            test_check_frames(theFrames, theSampleTime, kTest_CycleFrames, &theTorn, &theSilent);
+            theLappedSilence += theSilent;
+            ++theLappedReads;
+        }
+    }
+    pthread_join(theWriter, NULL);
+
+    double theRate = (thePacedDuration > 0) ? (double)thePacedReads * 1e9 / (double)thePacedDuration : 0.0;
+    printf("paced: %llu cycles at %.0f cycles/s, lapped: %llu reads, %llu frames overwritten mid-read, resetting: %llu reads, %llu frames of sound\n", (unsigned long long)thePacedReads, theRate, (unsigned long long)theLappedReads, (unsigned long long)theLappedSilence, (unsigned long long)theResetReads, (unsigned long long)theResetSound);
+    CHECK(thePacedReads + kTest_ReaderLag >= kTest_PacedCycles, "the reader only kept up for %llu cycles", (unsigned long long)thePacedReads);
+    CHECK(theRate >= 10000.0, "only %.0f cycles/s", theRate);
+    CHECK(theTorn == 0, "%llu torn or stale frames", (unsigned long long)theTorn);
+    CHECK(theFalseSilence == 0, "%llu frames read as silence that were written and not yet overwritten", (unsigned long long)theFalseSilence);
+    CHECK(theLappedReads > 0, "the lapping phase never read");
+    CHECK(theResetSound > 0, "the resetting phase never read anything back");
+
+    ring_buffer_free(&gTest_Ring);
+    return vac_test_result("test_ring_stress");
+}
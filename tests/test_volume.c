@@ -0,0 +1,92 @@
+//	The volume conversions against libm in double precision, across the control range, to the bounds
+//	VACcore.h documents, with the clamps at the bottom of the range and every batch version bit for
+//	bit against its scalar one.
+
+#include "VACcore.h"
+#include "VACtest.h"
+
+#include <math.h>
+#include <string.h>
+
+#define                             kTest_Points                        (1u << 20)
+
+//	10^(kVolume_MinDB / 20)
+#define                             kTest_MinAmplitude                  6.3095734448e-4
+
+static float                        gTest_In[kTest_Points];
+static float                        gTest_Batch[kTest_Points];
+
+static double test_volume(double decibel)
+{
+    return pow(10.0, decibel / 20.0);
+}
+
+int main(void)
+{
+    double theWorstVolume = 0.0;
+    double theWorstScalarVolume = 0.0;
+    double theWorstDecibel = 0.0;
+    double theWorstScalar = 0.0;
+    for(uint32_t i = 1; i <= kTest_Points; ++i)
+    {
+        float theFraction = (float)i / (float)kTest_Points;
+
+        float theDecibel = kVolume_MinDB + (kVolume_MaxDB - kVolume_MinDB) * theFraction;
+        double theExpected = test_volume(theDecibel);
+        theWorstVolume = fmax(theWorstVolume, fabs(volume_from_decibel(theDecibel) - theExpected) / theExpected);
+
+        theExpected = test_volume(kVolume_MinDB + (kVolume_MaxDB - kVolume_MinDB) * (double)theFraction);
+        theWorstScalarVolume = fmax(theWorstScalarVolume, fabs(volume_from_scalar(theFraction) - theExpected) / theExpected);
+
+        //	geometric steps from just above the bottom of the range up to unity
+        float theVolume = (float)(kTest_MinAmplitude * pow(1.0 / kTest_MinAmplitude, theFraction));
+        double theExpectedDecibel = 20.0 * log10(theVolume);
+        if(theExpectedDecibel > kVolume_MinDB)
+        {
+            theWorstDecibel = fmax(theWorstDecibel, fabs(volume_to_decibel(theVolume) - theExpectedDecibel));
+            theWorstScalar = fmax(theWorstScalar, fabs(volume_to_scalar(theVolume) - (theExpectedDecibel - kVolume_MinDB) / (kVolume_MaxDB - kVolume_MinDB)));
+        }
+        gTest_In[i - 1] = theVolume;
+    }
+    CHECK(theWorstVolume < 5e-7, "volume_from_decibel is off by %g relative", theWorstVolume);
+    CHECK(theWorstScalarVolume < 5e-7, "volume_from_scalar is off by %g relative", theWorstScalarVolume);
+    CHECK(theWorstDecibel < 1e-5, "volume_to_decibel is off by %g dB", theWorstDecibel);
+    CHECK(theWorstScalar < 1e-5 / (kVolume_MaxDB - kVolume_MinDB), "volume_to_scalar is off by %g", theWorstScalar);
+
+    CHECK(volume_to_decibel(0.0f) == kVolume_MinDB, "silence is %g dB", volume_to_decibel(0.0f));
+    CHECK(volume_to_scalar(0.0f) == 0.0f, "silence is at %g", volume_to_scalar(0.0f));
+    CHECK(volume_from_decibel(kVolume_MinDB) == 0.0f, "the bottom of the range is %g", volume_from_decibel(kVolume_MinDB));
+    CHECK(volume_from_decibel(-200.0f) == 0.0f, "below the range is %g", volume_from_decibel(-200.0f));
+    CHECK(volume_from_scalar(0.0f) == 0.0f, "scalar 0 is %g", volume_from_scalar(0.0f));
+    CHECK(fabsf(volume_from_scalar(1.0f) - 1.0f) < 5e-7f, "scalar 1 is %g", volume_from_scalar(1.0f));
+
+    //	volumes, then the same values read as decibels and as scalars, through each batch version
+    static const struct {
+        const char*                 name;
+        float                       (*scalar)(float);
+        void                        (*batch)(float*, const float*, uint32_t);
+        float                       scale;
+        float                       offset;
+    } kConversions[] = {
+        { "volume_to_decibel",      volume_to_decibel,      volume_to_decibel_batch,    1.0f,   0.0f },
+        { "volume_to_scalar",       volume_to_scalar,       volume_to_scalar_batch,     1.0f,   0.0f },
+        { "volume_from_decibel",    volume_from_decibel,    volume_from_decibel_batch,  80.0f,  -70.0f },
+        { "volume_from_scalar",     volume_from_scalar,     volume_from_scalar_batch,   1.2f,   -0.1f },
+    };
+    for(uint32_t c = 0; c < sizeof(kConversions) / sizeof(kConversions[0]); ++c)
+    {
+        float theIn[1000];
+        float theExpected[1000];
+        for(uint32_t i = 0; i < 1000; ++i)
+        {
+            theIn[i] = gTest_In[i * (kTest_Points / 1000)] * kConversions[c].scale + kConversions[c].offset;
+            theExpected[i] = kConversions[c].scalar(theIn[i]);
+        }
+        kConversions[c].batch(gTest_Batch, theIn, 1000);
+        CHECK(memcmp(gTest_Batch, theExpected, sizeof(theExpected)) == 0, "%s_batch differs from %s", kConversions[c].name, kConversions[c].name);
+        kConversions[c].batch(theIn, theIn, 1000);
+        CHECK(memcmp(theIn, theExpected, sizeof(theExpected)) == 0, "%s_batch in place differs from %s", kConversions[c].name, kConversions[c].name);
+    }
+
+    return vac_test_result("test_volume");
+}